@@ -17,7 +17,9 @@ SOURCES += common.cpp \
     MeshColor.cpp \
     configure.cpp \
     mbb.cpp \
-    cube.cpp
+    cube.cpp \
+    gmmkernel.cpp \
+    bundlefile.cpp
 
 HEADERS += common.h\
         common_global.h \
@@ -32,7 +34,10 @@ HEADERS += common.h\
     voxelgraph.hpp \
     extractmesh.hpp \
     fn_eigs_sym_custom.hpp \
-    cube.h
+    cube.h \
+    gmmkernel.h \
+    bundlefile.h \
+    meshbundle.hpp
 
 unix {
     target.path = /usr/lib
@@ -3,6 +3,11 @@
 #include <QColor>
 #include <random>
 #include <cassert>
+#include <cmath>
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define COLORARRAY_X86
+#include <immintrin.h>
+#endif
 const float ColorArray::Lab_L_min = 0;
 const float ColorArray::Lab_L_max = 100;
 const float ColorArray::Lab_ab_min = -120;
@@ -114,115 +119,186 @@ void ColorArray::Lab2RGB(const arma::fmat& Lab, arma::Mat<uint8_t>& rgb)
     rgb = arma::conv_to<arma::Mat<uint8_t>>::from(frgb);
 }
 
-void ColorArray::RGB2Lab(const arma::Mat<uint8_t>& rgb, arma::fmat& Lab)
+//RGB->Lab for 8-bit input
+//the linear part only sees 256 values per channel so it is tabulated,
+//f(t) = cbrt(t) is evaluated on 8 colors at once when AVX2 is available
+namespace
 {
-    if(3!=rgb.n_rows)std::logic_error("rgb.n_rows!=3");
-    const float T(0.008856);
-    const float m[9] = {
-        0.412453,0.212671,0.019334,
-        0.212671,0.715160,0.072169,
-        0.019224,0.119193,0.950227
-                       };
-    const arma::fmat::fixed<3,3> MAT(&m[0]);
-    arma::fmat XYZ = MAT*(arma::conv_to<arma::fmat>::from(rgb)/255.0);
-    XYZ.row(0) /= 0.950456;
-    XYZ.row(2) /= 1.088754;
-
-    arma::uvec XT = arma::find( XYZ.row(1) > T );
-    arma::uvec _XT = arma::find( XYZ.row(1) <= T );
-
-    arma::frowvec fX = XYZ.row(0);
-    fX(XT) = arma::pow(fX(XT),1.0/3.0);
-    fX(_XT) *= 7.787;
-    fX(_XT) += 16.0/116.0;
-
-    arma::uvec YT = arma::find( XYZ.row(0) > T );
-    arma::uvec _YT = arma::find( XYZ.row(0) <= T );
-
-    arma::frowvec fY = XYZ.row(1);
-    fY(YT) = arma::pow(fY(YT),1.0/3.0);
-    fY(_YT) *= 7.787;
-    fY(_YT) += 16.0/116.0;
-
-    arma::frowvec Y = XYZ.row(1);
-    Y(_YT) *= 903.3;
-    Y(YT) = fY(YT);
-    Y(YT) *= 116.0;
-    Y(YT) -= 16.0;
-
-    arma::uvec ZT = arma::find( XYZ.row(2) > T );
-    arma::uvec _ZT = arma::find( XYZ.row(2) <= T );
-
-    arma::frowvec fZ = XYZ.row(2);
-    fZ(ZT) = arma::pow(fZ(ZT),1.0/3.0);
-    fZ(_ZT) *= 7.787;
-    fZ(_ZT) += 16.0/116.0;
-
+const float Lab_T = 0.008856f;
+struct RGB2LabLUT
+{
+    //xyz[c][ch][v]: contribution of value v in channel ch to X/Xn, Y, Z/Zn
+    float xyz[3][3][256];
+    //the same as coefficients for the vectorized path ( value in 0-255 )
+    float coeff[3][3];
+    RGB2LabLUT()
+    {
+        //column major as the former arma::fmat::fixed<3,3> MAT
+        const float m[9] = {
+            0.412453,0.212671,0.019334,
+            0.212671,0.715160,0.072169,
+            0.019224,0.119193,0.950227
+                           };
+        const float white[3] = {0.950456f,1.0f,1.088754f};
+        for(int c=0;c<3;++c)
+        {
+            for(int ch=0;ch<3;++ch)
+            {
+                coeff[c][ch] = m[3*ch+c] / 255.0f / white[c];
+                for(int v=0;v<256;++v)xyz[c][ch][v] = m[3*ch+c]*( float(v) / 255.0f ) / white[c];
+            }
+        }
+    }
+};
+const RGB2LabLUT lab_lut_;
 
-    Lab = arma::fmat(rgb.n_rows,rgb.n_cols);
-    Lab.row(0) = Y;
-    Lab.row(1) = 500*( fX - fY );
-    Lab.row(2) = 200*( fY - fZ );
+inline float Lab_f(float t)
+{
+    return t > Lab_T ? std::cbrt(t) : 7.787f*t + 16.0f/116.0f;
 }
 
-void ColorArray::RGB2Lab(const arma::Col<uint8_t>& rgb, arma::fvec& Lab)
+//c is interleaved with channel stride 3, ri and bi are the offsets of red and blue
+void rgb2lab_scalar(const uint8_t* c,arma::uword n,int ri,int bi,float* L,float* a,float* b,arma::uword ld)
 {
-    if(3!=rgb.n_rows)std::logic_error("rgb.n_rows!=3");
-    const float T(0.008856);
-    const float m[9] = {
-        0.412453,0.212671,0.019334,
-        0.212671,0.715160,0.072169,
-        0.019224,0.119193,0.950227
-                       };
-    const arma::fmat::fixed<3,3> MAT(&m[0]);
-    arma::fvec XYZ = MAT*(arma::conv_to<arma::fvec>::from(rgb)/255.0);
-    XYZ(0) /= 0.950456;
-    XYZ(2) /= 1.088754;
-
-    float fX;
-    fX = XYZ(0);
-    if( fX > T )
+    const RGB2LabLUT& lut = lab_lut_;
+    for(arma::uword i=0;i<n;++i)
     {
-        fX = std::pow(fX,1.0/3.0);
-    }else{
-        fX *= 7.787;
-        fX += 16.0/116.0;
+        const uint8_t r = c[3*i+ri];
+        const uint8_t g = c[3*i+1];
+        const uint8_t bl = c[3*i+bi];
+        const float X = lut.xyz[0][0][r] + lut.xyz[0][1][g] + lut.xyz[0][2][bl];
+        const float Y = lut.xyz[1][0][r] + lut.xyz[1][1][g] + lut.xyz[1][2][bl];
+        const float Z = lut.xyz[2][0][r] + lut.xyz[2][1][g] + lut.xyz[2][2][bl];
+        const float fX = Lab_f(X);
+        const float fY = Lab_f(Y);
+        const float fZ = Lab_f(Z);
+        L[i*ld] = Y > Lab_T ? 116.0f*fY - 16.0f : 903.3f*Y;
+        a[i*ld] = 500.0f*( fX - fY );
+        b[i*ld] = 200.0f*( fY - fZ );
     }
+}
 
-    float fY;
-    fY = XYZ(1);
-    if( fY > T )
+#ifdef COLORARRAY_X86
+__attribute__((target("avx2,fma")))
+inline __m256 Lab_f_avx2(__m256 t)
+{
+    const __m256 T = _mm256_set1_ps(Lab_T);
+    const __m256 third = _mm256_set1_ps(1.0f/3.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    //keep the cube root away from 0, those lanes take the linear branch anyway
+    __m256 x = _mm256_max_ps(t,T);
+    //bit level estimate of cbrt then three Newton steps
+    __m256 bits = _mm256_cvtepi32_ps(_mm256_castps_si256(x));
+    __m256i yi = _mm256_add_epi32(_mm256_cvtps_epi32(_mm256_mul_ps(bits,third)),_mm256_set1_epi32(709921077));
+    __m256 y = _mm256_castsi256_ps(yi);
+    for(int k=0;k<3;++k)
     {
-        fY = std::pow(fY,1.0/3.0);
-    }else{
-        fY *= 7.787;
-        fY += 16.0/116.0;
+        y = _mm256_mul_ps(third,_mm256_fmadd_ps(two,y,_mm256_div_ps(x,_mm256_mul_ps(y,y))));
     }
+    __m256 lin = _mm256_fmadd_ps(_mm256_set1_ps(7.787f),t,_mm256_set1_ps(16.0f/116.0f));
+    return _mm256_blendv_ps(lin,y,_mm256_cmp_ps(t,T,_CMP_GT_OQ));
+}
 
-    float fZ;
-    fZ = XYZ(2);
-    if( fZ > T )
+__attribute__((target("avx2,fma")))
+void rgb2lab_avx2(const uint8_t* c,arma::uword n,int ri,int bi,float* L,float* a,float* b,arma::uword ld)
+{
+    const RGB2LabLUT& lut = lab_lut_;
+    __m256 cf[3][3];
+    for(int i=0;i<3;++i)for(int j=0;j<3;++j)cf[i][j] = _mm256_set1_ps(lut.coeff[i][j]);
+    const __m256 T = _mm256_set1_ps(Lab_T);
+    const arma::uword n8 = n - n % 8;
+    int32_t r[8],g[8],bl[8];
+    float tL[8],ta[8],tb[8];
+    for(arma::uword i=0;i<n8;i+=8)
     {
-        fZ = std::pow(fZ,1.0/3.0);
-    }else{
-        fZ *= 7.787;
-        fZ += 16.0/116.0;
+        const uint8_t* ci = c + 3*i;
+        for(int k=0;k<8;++k)
+        {
+            r[k] = ci[3*k+ri];
+            g[k] = ci[3*k+1];
+            bl[k] = ci[3*k+bi];
+        }
+        __m256 vr = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)r));
+        __m256 vg = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)g));
+        __m256 vb = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)bl));
+        __m256 X = _mm256_fmadd_ps(cf[0][0],vr,_mm256_fmadd_ps(cf[0][1],vg,_mm256_mul_ps(cf[0][2],vb)));
+        __m256 Y = _mm256_fmadd_ps(cf[1][0],vr,_mm256_fmadd_ps(cf[1][1],vg,_mm256_mul_ps(cf[1][2],vb)));
+        __m256 Z = _mm256_fmadd_ps(cf[2][0],vr,_mm256_fmadd_ps(cf[2][1],vg,_mm256_mul_ps(cf[2][2],vb)));
+        __m256 fX = Lab_f_avx2(X);
+        __m256 fY = Lab_f_avx2(Y);
+        __m256 fZ = Lab_f_avx2(Z);
+        __m256 vL = _mm256_blendv_ps(
+                    _mm256_mul_ps(_mm256_set1_ps(903.3f),Y),
+                    _mm256_fmsub_ps(_mm256_set1_ps(116.0f),fY,_mm256_set1_ps(16.0f)),
+                    _mm256_cmp_ps(Y,T,_CMP_GT_OQ)
+                    );
+        __m256 va = _mm256_mul_ps(_mm256_set1_ps(500.0f),_mm256_sub_ps(fX,fY));
+        __m256 vlb = _mm256_mul_ps(_mm256_set1_ps(200.0f),_mm256_sub_ps(fY,fZ));
+        if(1==ld)
+        {
+            _mm256_storeu_ps(L+i,vL);
+            _mm256_storeu_ps(a+i,va);
+            _mm256_storeu_ps(b+i,vlb);
+        }else{
+            _mm256_storeu_ps(tL,vL);
+            _mm256_storeu_ps(ta,va);
+            _mm256_storeu_ps(tb,vlb);
+            for(int k=0;k<8;++k)
+            {
+                L[(i+k)*ld] = tL[k];
+                a[(i+k)*ld] = ta[k];
+                b[(i+k)*ld] = tb[k];
+            }
+        }
     }
+    rgb2lab_scalar(c+3*n8,n-n8,ri,bi,L+n8*ld,a+n8*ld,b+n8*ld,ld);
+}
+
+bool detect_avx2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+const bool has_avx2_ = detect_avx2();
+#endif
 
-    float Y = XYZ(1);
-    if( Y > T )
+void rgb2lab(const uint8_t* c,arma::uword n,int ri,int bi,float* L,float* a,float* b,arma::uword ld)
+{
+#ifdef COLORARRAY_X86
+    if(has_avx2_)
     {
-        Y = std::pow(Y,1.0/3.0);
-        Y *= 116.0;
-        Y -= 16.0;
-    }else{
-        Y*=903.3;
+        rgb2lab_avx2(c,n,ri,bi,L,a,b,ld);
+        return;
     }
+#endif
+    rgb2lab_scalar(c,n,ri,bi,L,a,b,ld);
+}
+}
 
-    Lab = arma::fvec(3);
-    Lab(0) = Y;
-    Lab(1) = 500*( fX - fY );
-    Lab(2) = 200*( fY - fZ );
+void ColorArray::RGB2Lab(const uint8_t* rgb,arma::uword n,float* L,float* a,float* b)
+{
+    rgb2lab(rgb,n,0,2,L,a,b,1);
+}
+
+void ColorArray::BGR2Lab(const uint8_t* bgr,arma::uword n,float* L,float* a,float* b)
+{
+    rgb2lab(bgr,n,2,0,L,a,b,1);
+}
+
+void ColorArray::RGB2Lab(const arma::Mat<uint8_t>& rgb, arma::fmat& Lab)
+{
+    if(3!=rgb.n_rows)std::logic_error("rgb.n_rows!=3");
+    Lab.set_size(3,rgb.n_cols);
+    float* p = Lab.memptr();
+    rgb2lab(rgb.memptr(),rgb.n_cols,0,2,p,p+1,p+2,3);
+}
+
+void ColorArray::RGB2Lab(const arma::Col<uint8_t>& rgb, arma::fvec& Lab)
+{
+    if(3!=rgb.n_rows)std::logic_error("rgb.n_rows!=3");
+    Lab.set_size(3);
+    float* p = Lab.memptr();
+    rgb2lab_scalar(rgb.memptr(),1,0,2,p,p+1,p+2,3);
 }
 
 void ColorArray::Lab2BGR(const arma::fmat& Lab, arma::Mat<uint8_t>& bgr)
@@ -233,16 +309,18 @@ void ColorArray::Lab2BGR(const arma::fmat& Lab, arma::Mat<uint8_t>& bgr)
 
 void ColorArray::BGR2Lab(const arma::Mat<uint8_t>& bgr, arma::fmat& Lab)
 {
-    arma::Mat<uint8_t> rgb = bgr;
-    rgb.swap_rows(0,2);
-    RGB2Lab(rgb,Lab);
+    if(3!=bgr.n_rows)std::logic_error("bgr.n_rows!=3");
+    Lab.set_size(3,bgr.n_cols);
+    float* p = Lab.memptr();
+    rgb2lab(bgr.memptr(),bgr.n_cols,2,0,p,p+1,p+2,3);
 }
 
 void ColorArray::BGR2Lab(const arma::Col<uint8_t>& bgr, arma::fvec& Lab)
 {
-    arma::Col<uint8_t> rgb = bgr;
-    rgb.swap_rows(0,2);
-    RGB2Lab(rgb,Lab);
+    if(3!=bgr.n_rows)std::logic_error("bgr.n_rows!=3");
+    Lab.set_size(3);
+    float* p = Lab.memptr();
+    rgb2lab_scalar(bgr.memptr(),1,2,0,p,p+1,p+2,3);
 }
 
 void ColorArray::colorfromlabel(uint32_t* ptr,arma::uword size,const arma::uvec& label)
@@ -53,6 +53,9 @@ namespace ColorArray
     void COMMONSHARED_EXPORT Lab2BGR(const arma::fmat& Lab, arma::Mat<uint8_t>& rgb);
     void COMMONSHARED_EXPORT BGR2Lab(const arma::Mat<uint8_t>& rgb, arma::fmat& Lab);
     void COMMONSHARED_EXPORT BGR2Lab(const arma::Col<uint8_t>& rgb, arma::fvec& Lab);
+    //n interleaved 8-bit colors into caller provided L,a,b arrays of n floats, nothing is allocated
+    void COMMONSHARED_EXPORT RGB2Lab(const uint8_t* rgb,arma::uword n,float* L,float* a,float* b);
+    void COMMONSHARED_EXPORT BGR2Lab(const uint8_t* bgr,arma::uword n,float* L,float* a,float* b);
 
     void COMMONSHARED_EXPORT colorfromValue(uint32_t* ptr,arma::uword size,const arma::vec& value);
     void COMMONSHARED_EXPORT colorfromValue(RGB888*   ptr,arma::uword size,const arma::vec& value);
@@ -7,6 +7,7 @@
 #include <armadillo>
 #include "MeshColor.h"
 #include "voxelgraph.h"
+class BundleFile;
 struct Traits : public OpenMesh::DefaultTraits
 {
   HalfedgeAttributes(OpenMesh::Attributes::PrevHalfedge);
@@ -27,12 +28,19 @@ public:
         strips_(mesh_)
     {}
     MeshPtr mesh_ptr(){return std::shared_ptr<M>(&mesh_);}
+    //single binary file holding the points, the supervoxel graph and p_feature_ ( see bundlefile.h )
+    //after load the graph and p_feature_ are views into the file, which stays mapped with the bundle
+    bool save(const std::string&,const arma::uvec& label=arma::uvec());
+    bool load(const std::string&);
+    bool load(const std::string&,arma::uvec& label);
     std::string name_;
     arma::fmat                  p_feature_;
     M                           mesh_;
     MeshColor<M>        custom_color_;
     VoxelGraph<M>              graph_;
     OpenMesh::StripifierT<M>  strips_;
+protected:
+    std::shared_ptr<BundleFile> file_;
 };
 #endif // MESHTYPE
 
@@ -22,6 +22,8 @@
 // IN THE SOFTWARE.
 
 #include <vector>
+#include <algorithm>
+#include <functional>
 #include <stdint.h>
 #include <limits>
 #include <cmath>
@@ -74,6 +76,9 @@ public:
     OctreeVoxelAdjacency(const Octree&octree):octree_(octree){}
     template<typename Voxel>
     inline void computeNeighbor(std::vector<typename Voxel::Ptr>& voxel_vec)const;
+    //CSR adjacency among the occupied leafs (in occupied leaf order)
+    //the neighbors of leaf i are indices[offsets[i]] ... indices[offsets[i+1]-1]
+    inline void computeNeighbor(arma::Col<uint32_t>& offsets,arma::Col<uint32_t>& indices)const;
 private:
     const Octree& octree_;
 };
@@ -875,6 +880,676 @@ int Octree<PointT, ContainerT>::getPointofLeafAt(uint32_t index, arma::uvec &poi
     return point_index.size();
 }
 
+/** \brief Linear Octree keyed by Morton codes.
+ *
+ * Same subdivision rules as Octree (bucket size or resolution), but the points are sorted once by their
+ * Morton code with a parallel radix sort, so every octant covers a contiguous range of the sorted points.
+ * The octants are kept in one array with the children of an octant stored next to each other,
+ * the coordinates are copied in Morton order, and no successor list or per octant allocation is needed.
+ * The input container is not referenced after initialize.
+ *
+ * Besides radius queries it offers k nearest neighbor queries and batched versions of both,
+ * so the same structure can replace the extra KD-trees that were built next to the Octree.
+ * Distances are reported in the "squared" units of the Distance (as in Octree::radiusNeighbors).
+ */
+template<typename PointT, typename ContainerT = std::vector<PointT> >
+class LinearOctree
+{
+  public:
+    LinearOctree();
+    ~LinearOctree();
+
+    /** \brief initialize octree with all points **/
+    void initialize(const ContainerT& pts, const OctreeParams& params = OctreeParams());
+
+    /** \brief initialize octree only from pts that are inside indexes. **/
+    void initialize(const ContainerT& pts, const std::vector<uint32_t>& indexes, const OctreeParams& params =
+        OctreeParams());
+
+    /** \brief remove all data inside the octree. **/
+    void clear();
+
+    /** \brief radius neighbor queries where radius determines the maximal radius of reported indices of points in resultIndices **/
+    template<typename Distance>
+    void radiusNeighbors(const PointT& query, float radius, std::vector<uint32_t>& resultIndices) const;
+
+    /** \brief radius neighbor queries with explicit (squared) distance computation. **/
+    template<typename Distance>
+    void radiusNeighbors(const PointT& query, float radius, std::vector<uint32_t>& resultIndices,
+        std::vector<float>& distances) const;
+
+    /** \brief k nearest neighbors sorted by increasing (squared) distance. **/
+    template<typename Distance>
+    void knnNeighbors(const PointT& query, uint32_t k, std::vector<uint32_t>& resultIndices,
+        std::vector<float>& distances) const;
+
+    /** \brief radius queries for every point of a container (operator[] and size()), run in parallel. **/
+    template<typename Distance, typename QueryContainerT>
+    void batchRadiusNeighbors(const QueryContainerT& queries, float radius,
+        std::vector<std::vector<uint32_t> >& resultIndices) const;
+
+    /** \brief k nearest neighbors for every point of a container, one column per query, run in parallel.
+     *
+     * k is clipped to the number of points in the octree.
+     */
+    template<typename Distance, typename QueryContainerT>
+    void batchKnnNeighbors(const QueryContainerT& queries, uint32_t k, arma::Mat<uint32_t>& resultIndices,
+        arma::fmat& distances) const;
+
+    /** \brief get centers of the occupied leafs. **/
+    int getLeafCenters(ContainerT& leaf_pts);
+
+    int getLeafNum(void){return occupied_leafs.size();}
+
+    int getPointofLeafAt(uint32_t index, arma::uvec& point_index);
+
+    uint32_t size(void)const{return order_.size();}
+
+  protected:
+
+    class Octant
+    {
+      public:
+        Octant();
+
+        // bounding box of the octant needed for overlap and contains tests...
+        float x, y, z; // center
+        float extent;  // half of side-length
+
+        uint32_t start;  // first point in Morton order
+        uint32_t size;  // number of points
+        uint32_t child;  // index of the first child, the others follow it
+        uint8_t childNum;  // 0 for a leaf
+    };
+
+    // not copyable, not assignable ...
+    LinearOctree(LinearOctree&);
+    LinearOctree& operator=(const LinearOctree& oct);
+
+    /** \brief sort the copied points by Morton code and build the octants. **/
+    void build();
+
+    /** \brief split the octant at level until the bucket size or resolution is reached. **/
+    void createOctant(uint32_t octant, uint32_t level, std::vector<uint32_t>& leafs);
+
+    template<typename Distance>
+    void radiusNeighbors(const Octant* octant, const float* query, float radius, float sqrRadius,
+        std::vector<uint32_t>& resultIndices, std::vector<float>* distances) const;
+
+    template<typename Distance>
+    static bool overlaps(const float* query, float radius, float sqRadius, const Octant* o);
+
+    template<typename Distance>
+    static bool contains(const float* query, float sqRadius, const Octant* o);
+
+    template<typename Distance>
+    static float minDistance(const float* query, const Octant* o);
+
+    template<typename Distance>
+    static inline float distance(const float* query, const float* p)
+    {
+      return Distance::norm(std::abs(query[0] - p[0]), std::abs(query[1] - p[1]), std::abs(query[2] - p[2]));
+    }
+
+    static uint64_t expandBits(uint64_t v);
+
+    // stable LSD radix sort of the codes carrying the point indices along
+    static void radixSort(std::vector<uint64_t>& codes, std::vector<uint32_t>& indices, uint32_t bits);
+
+    OctreeParams params_;
+    uint32_t depth_; // level of the finest cell used for the Morton codes
+
+    std::vector<Octant> octants_; // octants_[0] is the root
+    std::vector<uint64_t> codes_; // Morton codes in sorted order
+    std::vector<uint32_t> order_; // original index of the sorted points
+    arma::fmat points_; // 3 x N coordinates in sorted order
+
+    std::vector<Octant*> occupied_leafs;//occupied leafs
+    friend class OctreeMeshInterface<LinearOctree<PointT, ContainerT>>;
+    friend class OctreeVoxelAdjacency<LinearOctree<PointT, ContainerT>>;
+};
+
+template<typename PointT, typename ContainerT>
+LinearOctree<PointT, ContainerT>::Octant::Octant() :
+    x(0.0f), y(0.0f), z(0.0f), extent(0.0f), start(0), size(0), child(0), childNum(0)
+{
+}
+
+template<typename PointT, typename ContainerT>
+LinearOctree<PointT, ContainerT>::LinearOctree():depth_(0)
+{
+
+}
+
+template<typename PointT, typename ContainerT>
+LinearOctree<PointT, ContainerT>::~LinearOctree()
+{
+
+}
+
+template<typename PointT, typename ContainerT>
+void LinearOctree<PointT, ContainerT>::initialize(const ContainerT& pts, const OctreeParams& params)
+{
+  clear();
+  params_ = params;
+  const uint32_t N = pts.size();
+  points_ = arma::fmat(3, N);
+  order_.resize(N);
+  #pragma omp parallel for
+  for (int64_t i = 0; i < int64_t(N); ++i)
+  {
+    const PointT& p = pts[i];
+    points_(0, i) = get<0>(p);
+    points_(1, i) = get<1>(p);
+    points_(2, i) = get<2>(p);
+    order_[i] = i;
+  }
+  build();
+}
+
+template<typename PointT, typename ContainerT>
+void LinearOctree<PointT, ContainerT>::initialize(const ContainerT& pts, const std::vector<uint32_t>& indexes,
+    const OctreeParams& params)
+{
+  clear();
+  params_ = params;
+  const uint32_t N = indexes.size();
+  points_ = arma::fmat(3, N);
+  order_.resize(N);
+  #pragma omp parallel for
+  for (int64_t i = 0; i < int64_t(N); ++i)
+  {
+    const PointT& p = pts[indexes[i]];
+    points_(0, i) = get<0>(p);
+    points_(1, i) = get<1>(p);
+    points_(2, i) = get<2>(p);
+    order_[i] = indexes[i];
+  }
+  build();
+}
+
+template<typename PointT, typename ContainerT>
+void LinearOctree<PointT, ContainerT>::clear()
+{
+  depth_ = 0;
+  octants_.clear();
+  codes_.clear();
+  order_.clear();
+  points_.reset();
+  occupied_leafs.clear();
+}
+
+template<typename PointT, typename ContainerT>
+uint64_t LinearOctree<PointT, ContainerT>::expandBits(uint64_t v)
+{
+  // spread the lower 21 bits so that two zeros follow each bit
+  v &= 0x1fffff;
+  v = (v | v << 32) & 0x1f00000000ffffULL;
+  v = (v | v << 16) & 0x1f0000ff0000ffULL;
+  v = (v | v << 8) & 0x100f00f00f00f00fULL;
+  v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+  v = (v | v << 2) & 0x1249249249249249ULL;
+  return v;
+}
+
+template<typename PointT, typename ContainerT>
+void LinearOctree<PointT, ContainerT>::radixSort(std::vector<uint64_t>& codes, std::vector<uint32_t>& indices,
+    uint32_t bits)
+{
+  const size_t N = codes.size();
+  // each block keeps its own histogram so that the scatter stays stable
+  const size_t blockNum = std::max<size_t>(1, std::min<size_t>(64, N / 16384));
+  const size_t blockSize = (N + blockNum - 1) / blockNum;
+  std::vector<uint64_t> tmpCodes(N);
+  std::vector<uint32_t> tmpIndices(N);
+  std::vector<size_t> hist(blockNum * 256);
+  for (uint32_t shift = 0; shift < bits; shift += 8)
+  {
+    #pragma omp parallel for
+    for (int64_t b = 0; b < int64_t(blockNum); ++b)
+    {
+      size_t* h = &hist[b * 256];
+      std::fill(h, h + 256, 0);
+      const size_t end = std::min(N, (b + 1) * blockSize);
+      for (size_t i = b * blockSize; i < end; ++i)
+        ++h[(codes[i] >> shift) & 0xff];
+    }
+    // all codes share this digit, nothing to move
+    bool skip = false;
+    for (size_t d = 0; d < 256 && !skip; ++d)
+    {
+      size_t count = 0;
+      for (size_t b = 0; b < blockNum; ++b) count += hist[b * 256 + d];
+      skip = (count == N);
+    }
+    if (skip) continue;
+    size_t offset = 0;
+    for (size_t d = 0; d < 256; ++d)
+    {
+      for (size_t b = 0; b < blockNum; ++b)
+      {
+        size_t count = hist[b * 256 + d];
+        hist[b * 256 + d] = offset;
+        offset += count;
+      }
+    }
+    #pragma omp parallel for
+    for (int64_t b = 0; b < int64_t(blockNum); ++b)
+    {
+      size_t* h = &hist[b * 256];
+      const size_t end = std::min(N, (b + 1) * blockSize);
+      for (size_t i = b * blockSize; i < end; ++i)
+      {
+        size_t o = h[(codes[i] >> shift) & 0xff]++;
+        tmpCodes[o] = codes[i];
+        tmpIndices[o] = indices[i];
+      }
+    }
+    codes.swap(tmpCodes);
+    indices.swap(tmpIndices);
+  }
+}
+
+template<typename PointT, typename ContainerT>
+void LinearOctree<PointT, ContainerT>::build()
+{
+  const uint32_t N = order_.size();
+  if (N == 0) return;
+
+  // determine axis-aligned bounding box.
+  float minx = points_(0, 0), miny = points_(1, 0), minz = points_(2, 0);
+  float maxx = minx, maxy = miny, maxz = minz;
+  #pragma omp parallel for reduction(min:minx,miny,minz) reduction(max:maxx,maxy,maxz)
+  for (int64_t i = 0; i < int64_t(N); ++i)
+  {
+    const float* p = points_.colptr(i);
+    minx = std::min(minx, p[0]);
+    miny = std::min(miny, p[1]);
+    minz = std::min(minz, p[2]);
+    maxx = std::max(maxx, p[0]);
+    maxy = std::max(maxy, p[1]);
+    maxz = std::max(maxz, p[2]);
+  }
+  float min[3] = { minx, miny, minz };
+  float max[3] = { maxx, maxy, maxz };
+
+  float ctr[3] =
+  { min[0], min[1], min[2] };
+
+  float maxextent = 0.5f * (max[0] - min[0]);
+  ctr[0] += maxextent;
+  for (uint32_t i = 1; i < 3; ++i)
+  {
+    float extent = 0.5f * (max[i] - min[i]);
+    ctr[i] += extent;
+    if (extent > maxextent) maxextent = extent;
+  }
+
+  // with a resolution all leafs are at the first level whose extent is below it,
+  // otherwise the codes go as deep as 64 bits allow and the bucket size stops the split.
+  const uint32_t maxDepth = 21;
+  depth_ = maxDepth;
+  if (params_.resolution_ > 0.0)
+  {
+    depth_ = 0;
+    float extent = maxextent;
+    while (extent >= params_.resolution_ && depth_ < maxDepth)
+    {
+      extent *= 0.5f;
+      ++depth_;
+    }
+  }
+
+  // Morton codes of the finest cells, x y z bits interleaved as the child numbering of Octree
+  const float lo[3] = { ctr[0] - maxextent, ctr[1] - maxextent, ctr[2] - maxextent };
+  const uint64_t cells = uint64_t(1) << depth_;
+  const float scale = maxextent > 0.0f ? float(cells) / (2.0f * maxextent) : 0.0f;
+  codes_.resize(N);
+  #pragma omp parallel for
+  for (int64_t i = 0; i < int64_t(N); ++i)
+  {
+    const float* p = points_.colptr(i);
+    uint64_t k[3];
+    for (int d = 0; d < 3; ++d)
+    {
+      float c = (p[d] - lo[d]) * scale;
+      k[d] = c <= 0.0f ? 0 : std::min(cells - 1, uint64_t(c));
+    }
+    codes_[i] = expandBits(k[0]) | (expandBits(k[1]) << 1) | (expandBits(k[2]) << 2);
+  }
+  std::vector<uint32_t> pos(N);
+  for (uint32_t i = 0; i < N; ++i) pos[i] = i;
+  radixSort(codes_, pos, 3 * depth_);
+
+  // permute the coordinates once so that the queries walk contiguous memory
+  arma::fmat unsorted;
+  unsorted.swap(points_);
+  points_ = arma::fmat(3, N);
+  std::vector<uint32_t> unsortedOrder;
+  unsortedOrder.swap(order_);
+  order_.resize(N);
+  #pragma omp parallel for
+  for (int64_t i = 0; i < int64_t(N); ++i)
+  {
+    std::memcpy(points_.colptr(i), unsorted.colptr(pos[i]), 3 * sizeof(float));
+    order_[i] = unsortedOrder[pos[i]];
+  }
+
+
+  octants_.push_back(Octant());
+  Octant& root = octants_[0];
+  root.x = ctr[0];
+  root.y = ctr[1];
+  root.z = ctr[2];
+  root.extent = maxextent;
+  root.start = 0;
+  root.size = N;
+  std::vector<uint32_t> leafs;
+  createOctant(0, 0, leafs);
+  // the octant array does not grow any more, the leaf pointers stay valid
+  occupied_leafs.reserve(leafs.size());
+  for (std::vector<uint32_t>::const_iterator iter = leafs.begin(); iter != leafs.end(); ++iter)
+    occupied_leafs.push_back(&octants_[*iter]);
+}
+
+template<typename PointT, typename ContainerT>
+void LinearOctree<PointT, ContainerT>::createOctant(uint32_t octant, uint32_t level, std::vector<uint32_t>& leafs)
+{
+  const uint32_t start = octants_[octant].start;
+  const uint32_t size = octants_[octant].size;
+
+  bool split = false;
+  if (level < depth_)
+  {
+    if (params_.resolution_ < 0.0)
+      split = (size > params_.bucketSize);
+    else
+      split = (size > 0);
+  }
+  if (!split)
+  {
+    if (size > 0) leafs.push_back(octant);
+    return;
+  }
+
+  // the points of the octant are sorted by their child digit at this level
+  const uint32_t shift = 3 * (depth_ - level - 1);
+  std::vector<uint64_t>::const_iterator first = codes_.begin() + start;
+  std::vector<uint64_t>::const_iterator last = first + size;
+  uint32_t childStarts[9];
+  childStarts[0] = start;
+  childStarts[8] = start + size;
+  for (uint32_t c = 1; c < 8; ++c)
+  {
+    first = std::lower_bound(first, last, c, [shift](uint64_t code, uint32_t c){ return ((code >> shift) & 7) < c; });
+    childStarts[c] = first - codes_.begin();
+  }
+
+  static const float factor[] =
+  { -0.5f, 0.5f };
+
+  // children of an octant are stored next to each other
+  const uint32_t firstChild = octants_.size();
+  const float x = octants_[octant].x;
+  const float y = octants_[octant].y;
+  const float z = octants_[octant].z;
+  const float extent = octants_[octant].extent;
+  uint8_t childNum = 0;
+  for (uint32_t i = 0; i < 8; ++i)
+  {
+    if (childStarts[i + 1] == childStarts[i]) continue;
+    Octant child;
+    child.x = x + factor[(i & 1) > 0] * extent;
+    child.y = y + factor[(i & 2) > 0] * extent;
+    child.z = z + factor[(i & 4) > 0] * extent;
+    child.extent = 0.5f * extent;
+    child.start = childStarts[i];
+    child.size = childStarts[i + 1] - childStarts[i];
+    octants_.push_back(child);
+    ++childNum;
+  }
+  octants_[octant].child = firstChild;
+  octants_[octant].childNum = childNum;
+
+  for (uint32_t c = 0; c < childNum; ++c)
+    createOctant(firstChild + c, level + 1, leafs);
+}
+
+template<typename PointT, typename ContainerT>
+template<typename Distance>
+void LinearOctree<PointT, ContainerT>::radiusNeighbors(const Octant* octant, const float* query, float radius,
+    float sqrRadius, std::vector<uint32_t>& resultIndices, std::vector<float>* distances) const
+{
+// if search ball S(q,r) contains octant, simply add point indexes.
+  if (contains<Distance>(query, sqrRadius, octant))
+  {
+    resultIndices.insert(resultIndices.end(), order_.begin() + octant->start,
+        order_.begin() + octant->start + octant->size);
+    if (distances)
+    {
+      for (uint32_t i = octant->start; i < octant->start + octant->size; ++i)
+        distances->push_back(distance<Distance>(query, points_.colptr(i)));
+    }
+    return; // early pruning.
+  }
+
+  if (octant->childNum == 0)
+  {
+    for (uint32_t i = octant->start; i < octant->start + octant->size; ++i)
+    {
+      float dist = distance<Distance>(query, points_.colptr(i));
+      if (dist < sqrRadius)
+      {
+        resultIndices.push_back(order_[i]);
+        if (distances) distances->push_back(dist);
+      }
+    }
+    return;
+  }
+
+// check whether child nodes are in range.
+  for (uint32_t c = 0; c < octant->childNum; ++c)
+  {
+    const Octant* child = &octants_[octant->child + c];
+    if (!overlaps<Distance>(query, radius, sqrRadius, child)) continue;
+    radiusNeighbors<Distance>(child, query, radius, sqrRadius, resultIndices, distances);
+  }
+}
+
+template<typename PointT, typename ContainerT>
+template<typename Distance>
+void LinearOctree<PointT, ContainerT>::radiusNeighbors(const PointT& query, float radius,
+    std::vector<uint32_t>& resultIndices) const
+{
+  resultIndices.clear();
+  if (octants_.empty()) return;
+
+  const float q[3] = { get<0>(query), get<1>(query), get<2>(query) };
+  float sqrRadius = Distance::sqr(radius); // "squared" radius
+  radiusNeighbors<Distance>(&octants_[0], q, radius, sqrRadius, resultIndices, 0);
+}
+
+template<typename PointT, typename ContainerT>
+template<typename Distance>
+void LinearOctree<PointT, ContainerT>::radiusNeighbors(const PointT& query, float radius,
+    std::vector<uint32_t>& resultIndices, std::vector<float>& distances) const
+{
+  resultIndices.clear();
+  distances.clear();
+  if (octants_.empty()) return;
+
+  const float q[3] = { get<0>(query), get<1>(query), get<2>(query) };
+  float sqrRadius = Distance::sqr(radius); // "squared" radius
+  radiusNeighbors<Distance>(&octants_[0], q, radius, sqrRadius, resultIndices, &distances);
+}
+
+template<typename PointT, typename ContainerT>
+template<typename Distance>
+void LinearOctree<PointT, ContainerT>::knnNeighbors(const PointT& query, uint32_t k,
+    std::vector<uint32_t>& resultIndices, std::vector<float>& distances) const
+{
+  resultIndices.clear();
+  distances.clear();
+  if (octants_.empty() || k == 0) return;
+
+  const float q[3] = { get<0>(query), get<1>(query), get<2>(query) };
+  typedef std::pair<float, uint32_t> Entry;
+  // octants ordered by their distance to the query, nearest first
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry> > octants;
+  // current k best points, farthest on top
+  std::priority_queue<Entry> best;
+  octants.push(Entry(minDistance<Distance>(q, &octants_[0]), 0));
+  while (!octants.empty())
+  {
+    const Entry top = octants.top();
+    octants.pop();
+    if (best.size() == k && top.first >= best.top().first) break;
+    const Octant* o = &octants_[top.second];
+    if (o->childNum == 0)
+    {
+      for (uint32_t i = o->start; i < o->start + o->size; ++i)
+      {
+        float dist = distance<Distance>(q, points_.colptr(i));
+        if (best.size() < k)
+          best.push(Entry(dist, i));
+        else if (dist < best.top().first)
+        {
+          best.pop();
+          best.push(Entry(dist, i));
+        }
+      }
+      continue;
+    }
+    for (uint32_t c = 0; c < o->childNum; ++c)
+    {
+      const uint32_t child = o->child + c;
+      float dist = minDistance<Distance>(q, &octants_[child]);
+      if (best.size() < k || dist < best.top().first) octants.push(Entry(dist, child));
+    }
+  }
+
+  resultIndices.resize(best.size());
+  distances.resize(best.size());
+  for (size_t i = best.size(); i > 0; --i)
+  {
+    resultIndices[i - 1] = order_[best.top().second];
+    distances[i - 1] = best.top().first;
+    best.pop();
+  }
+}
+
+template<typename PointT, typename ContainerT>
+template<typename Distance, typename QueryContainerT>
+void LinearOctree<PointT, ContainerT>::batchRadiusNeighbors(const QueryContainerT& queries, float radius,
+    std::vector<std::vector<uint32_t> >& resultIndices) const
+{
+  const int64_t N = queries.size();
+  resultIndices.resize(N);
+  #pragma omp parallel for schedule(dynamic,256)
+  for (int64_t i = 0; i < N; ++i)
+  {
+    radiusNeighbors<Distance>(queries[i], radius, resultIndices[i]);
+  }
+}
+
+template<typename PointT, typename ContainerT>
+template<typename Distance, typename QueryContainerT>
+void LinearOctree<PointT, ContainerT>::batchKnnNeighbors(const QueryContainerT& queries, uint32_t k,
+    arma::Mat<uint32_t>& resultIndices, arma::fmat& distances) const
+{
+  const int64_t N = queries.size();
+  k = std::min<uint32_t>(k, size());
+  resultIndices = arma::Mat<uint32_t>(k, N);
+  distances = arma::fmat(k, N);
+  #pragma omp parallel for schedule(dynamic,256)
+  for (int64_t i = 0; i < N; ++i)
+  {
+    std::vector<uint32_t> idx;
+    std::vector<float> dist;
+    knnNeighbors<Distance>(queries[i], k, idx, dist);
+    std::copy(idx.begin(), idx.end(), resultIndices.colptr(i));
+    std::copy(dist.begin(), dist.end(), distances.colptr(i));
+  }
+}
+
+template<typename PointT, typename ContainerT>
+template<typename Distance>
+bool LinearOctree<PointT, ContainerT>::overlaps(const float* query, float radius, float sqRadius, const Octant* o)
+{
+// we exploit the symmetry to reduce the test to testing if its inside the Minkowski sum around the positive quadrant.
+  float x = std::abs(query[0] - o->x);
+  float y = std::abs(query[1] - o->y);
+  float z = std::abs(query[2] - o->z);
+
+// (1) checking the line region.
+  float maxdist = radius + o->extent;
+
+// a. completely outside, since q' is outside the relevant area.
+  if (x > maxdist || y > maxdist || z > maxdist) return false;
+
+// b. inside the line region, one of the coordinates is inside the square.
+  if (x < o->extent || y < o->extent || z < o->extent) return true;
+
+// (2) checking the corner region...
+  x -= o->extent;
+  y -= o->extent;
+  z -= o->extent;
+
+  return (Distance::norm(x, y, z) < sqRadius);
+}
+
+template<typename PointT, typename ContainerT>
+template<typename Distance>
+bool LinearOctree<PointT, ContainerT>::contains(const float* query, float sqRadius, const Octant* o)
+{
+// the farthest corner is inside the search ball.
+  float x = std::abs(query[0] - o->x) + o->extent;
+  float y = std::abs(query[1] - o->y) + o->extent;
+  float z = std::abs(query[2] - o->z) + o->extent;
+
+  return (Distance::norm(x, y, z) < sqRadius);
+}
+
+template<typename PointT, typename ContainerT>
+template<typename Distance>
+float LinearOctree<PointT, ContainerT>::minDistance(const float* query, const Octant* o)
+{
+// distance to the nearest point of the box, 0 inside it.
+  float x = std::max(0.0f, std::abs(query[0] - o->x) - o->extent);
+  float y = std::max(0.0f, std::abs(query[1] - o->y) - o->extent);
+  float z = std::max(0.0f, std::abs(query[2] - o->z) - o->extent);
+
+  return Distance::norm(x, y, z);
+}
+
+template<typename PointT, typename ContainerT>
+int LinearOctree<PointT, ContainerT>::getLeafCenters(ContainerT& leaf_pts)
+{
+    typename std::vector<Octant*>::iterator iter;
+    for(iter=occupied_leafs.begin();iter!=occupied_leafs.end();++iter)
+    {
+        float p[3];
+        p[0] = (*iter)->x;
+        p[1] = (*iter)->y;
+        p[2] = (*iter)->z;
+        leaf_pts.add(&p[0]);
+    }
+    return occupied_leafs.size();
+}
+
+template<typename PointT, typename ContainerT>
+int LinearOctree<PointT, ContainerT>::getPointofLeafAt(uint32_t index, arma::uvec &point_index)
+{
+    const Octant* octant = occupied_leafs[index];
+    point_index = arma::uvec(octant->size);
+    for (uint32_t i = 0; i < octant->size; ++i)
+    {
+      point_index(i) = order_[octant->start + i];
+    }
+    return point_index.size();
+}
+
+
 }
 
 template<typename Octree>
@@ -1008,4 +1683,78 @@ inline void OctreeVoxelAdjacency<Octree>::computeNeighbor(std::vector<typename V
     }
 }
 
+template<typename Octree>
+inline void OctreeVoxelAdjacency<Octree>::computeNeighbor(arma::Col<uint32_t>& offsets,arma::Col<uint32_t>& indices)const
+{
+    typedef typename Octree::Octant Octant;
+    const std::vector<Octant*>& leafs = octree_.occupied_leafs;
+    const int64_t N = leafs.size();
+    offsets = arma::Col<uint32_t>(N+1,arma::fill::zeros);
+    indices.reset();
+    if(0==N)return;
+    //leafs share one resolution, so each is keyed by its integer cell coordinates
+    const float res = 2.0*leafs[0]->extent;
+    float min_x_ = std::numeric_limits<float>::max();
+    float min_y_ = std::numeric_limits<float>::max();
+    float min_z_ = std::numeric_limits<float>::max();
+    for(int64_t i=0;i<N;++i)
+    {
+        min_x_ = std::min(min_x_,leafs[i]->x - leafs[i]->extent);
+        min_y_ = std::min(min_y_,leafs[i]->y - leafs[i]->extent);
+        min_z_ = std::min(min_z_,leafs[i]->z - leafs[i]->extent);
+    }
+    arma::Mat<arma::sword> k(3,N);
+    #pragma omp parallel for
+    for(int64_t i=0;i<N;++i)
+    {
+        k(0,i) = static_cast<arma::sword>( ( leafs[i]->x - min_x_ ) / res );
+        k(1,i) = static_cast<arma::sword>( ( leafs[i]->y - min_y_ ) / res );
+        k(2,i) = static_cast<arma::sword>( ( leafs[i]->z - min_z_ ) / res );
+    }
+    const int64_t dimx = k.row(0).max() + 3;
+    const int64_t dimy = k.row(1).max() + 3;
+    //sorted keys replace the hash map, a cell is found by binary search
+    //keys are shifted by one so that the -1 neighbors stay positive
+    std::vector<std::pair<int64_t,uint32_t>> keys(N);
+    #pragma omp parallel for
+    for(int64_t i=0;i<N;++i)
+    {
+        keys[i].first = ( ( k(2,i) + 1 )*dimy + ( k(1,i) + 1 ) )*dimx + ( k(0,i) + 1 );
+        keys[i].second = i;
+    }
+    std::sort(keys.begin(),keys.end());
+    auto find = [&keys](int64_t key)->int64_t{
+        std::vector<std::pair<int64_t,uint32_t>>::const_iterator iter =
+                std::lower_bound(keys.begin(),keys.end(),std::make_pair(key,uint32_t(0)));
+        if( iter==keys.end() || iter->first!=key )return -1;
+        return iter->second;
+    };
+    //pass 1 counts, pass 2 fills
+    for(int pass=0;pass<2;++pass)
+    {
+        #pragma omp parallel for
+        for(int64_t i=0;i<N;++i)
+        {
+            const int64_t key = ( ( k(2,i) + 1 )*dimy + ( k(1,i) + 1 ) )*dimx + ( k(0,i) + 1 );
+            uint32_t n = 0;
+            for(int dz=-1;dz<=1;++dz)
+            for(int dy=-1;dy<=1;++dy)
+            for(int dx=-1;dx<=1;++dx)
+            {
+                if( 0==dx && 0==dy && 0==dz )continue;
+                int64_t j = find( key + ( dz*dimy + dy )*dimx + dx );
+                if( j < 0 )continue;
+                if(1==pass)indices(offsets(i)+n) = j;
+                ++n;
+            }
+            if(0==pass)offsets(i+1) = n;
+        }
+        if(0==pass)
+        {
+            for(int64_t i=0;i<N;++i)offsets(i+1) += offsets(i);
+            indices = arma::Col<uint32_t>(offsets(N));
+        }
+    }
+}
+
 #endif /* OCTREE_HPP_ */
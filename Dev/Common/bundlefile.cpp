@@ -0,0 +1,214 @@
+#include "bundlefile.h"
+#include <fstream>
+#include <cstring>
+#include <iostream>
+#include <cstdio>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+uint64_t Bundle::elem_size(uint32_t type)
+{
+    switch(type)
+    {
+    case U8:return 1;
+    case U32:return 4;
+    case U64:return 8;
+    case F32:return 4;
+    case F64:return 8;
+    default:return 0;
+    }
+}
+
+static inline uint64_t align_up(uint64_t x)
+{
+    return ( x + Bundle::alignment - 1 ) / Bundle::alignment * Bundle::alignment;
+}
+
+void BundleWriter::add(uint32_t id,uint32_t type,const void* data,uint64_t n_rows,uint64_t n_cols)
+{
+    Bundle::Section s;
+    s.id_ = id;
+    s.type_ = type;
+    s.n_rows_ = n_rows;
+    s.n_cols_ = n_cols;
+    s.offset_ = 0;
+    sections_.push_back(s);
+    data_.push_back(data);
+}
+
+bool BundleWriter::write(const std::string& path)
+{
+    Bundle::Header h;
+    std::memcpy(h.magic_,Bundle::magic,sizeof(h.magic_));
+    h.version_ = Bundle::version;
+    h.n_sections_ = sections_.size();
+    uint64_t offset = align_up( sizeof(Bundle::Header) + sections_.size()*sizeof(Bundle::Section) );
+    for(std::vector<Bundle::Section>::iterator iter = sections_.begin() ; iter != sections_.end() ; ++iter )
+    {
+        iter->offset_ = offset;
+        offset = align_up( offset + iter->n_rows_*iter->n_cols_*Bundle::elem_size(iter->type_) );
+    }
+    //written aside and renamed, the data may be a view into the file that is replaced
+    const std::string tmp = path + ".tmp";
+    std::ofstream out(tmp,std::ios::out|std::ios::binary|std::ios::trunc);
+    if(!out.is_open())
+    {
+        std::cerr<<"can't open "<<tmp<<std::endl;
+        return false;
+    }
+    out.write((const char*)&h,sizeof(h));
+    if(!sections_.empty())out.write((const char*)sections_.data(),sections_.size()*sizeof(Bundle::Section));
+    const char zeros[Bundle::alignment] = {0};
+    uint64_t pos = sizeof(Bundle::Header) + sections_.size()*sizeof(Bundle::Section);
+    for(size_t i = 0 ; i < sections_.size() ; ++i )
+    {
+        const Bundle::Section& s = sections_[i];
+        out.write(zeros,s.offset_ - pos);
+        uint64_t bytes = s.n_rows_*s.n_cols_*Bundle::elem_size(s.type_);
+        out.write((const char*)data_[i],bytes);
+        pos = s.offset_ + bytes;
+    }
+    out.write(zeros,align_up(pos) - pos);
+    out.close();
+    if(!out.good())
+    {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    if( 0 != std::rename(tmp.c_str(),path.c_str()) )
+    {
+        std::remove(path.c_str());
+        if( 0 != std::rename(tmp.c_str(),path.c_str()) )
+        {
+            std::cerr<<"can't replace "<<path<<std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+BundleFile::BundleFile():
+    base_(0),size_(0),sections_(0),n_sections_(0)
+#ifdef _WIN32
+  ,file_(0),mapping_(0)
+#endif
+{
+}
+
+BundleFile::~BundleFile()
+{
+    close();
+}
+
+bool BundleFile::open(const std::string& path)
+{
+    close();
+#ifdef _WIN32
+    HANDLE f = CreateFileA(path.c_str(),GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+    if( INVALID_HANDLE_VALUE == f )return false;
+    LARGE_INTEGER sz;
+    if( !GetFileSizeEx(f,&sz) || 0 == sz.QuadPart )
+    {
+        CloseHandle(f);
+        return false;
+    }
+    HANDLE m = CreateFileMappingA(f,NULL,PAGE_WRITECOPY,0,0,NULL);
+    if(!m)
+    {
+        CloseHandle(f);
+        return false;
+    }
+    void* p = MapViewOfFile(m,FILE_MAP_COPY,0,0,0);
+    if(!p)
+    {
+        CloseHandle(m);
+        CloseHandle(f);
+        return false;
+    }
+    file_ = f;
+    mapping_ = m;
+    base_ = (char*)p;
+    size_ = sz.QuadPart;
+#else
+    int fd = ::open(path.c_str(),O_RDONLY);
+    if( fd < 0 )return false;
+    struct stat st;
+    if( 0 != fstat(fd,&st) || 0 == st.st_size )
+    {
+        ::close(fd);
+        return false;
+    }
+    void* p = mmap(0,st.st_size,PROT_READ|PROT_WRITE,MAP_PRIVATE,fd,0);
+    ::close(fd);
+    if( MAP_FAILED == p )return false;
+    base_ = (char*)p;
+    size_ = st.st_size;
+#endif
+    const Bundle::Header* h = (const Bundle::Header*)base_;
+    if( size_ < sizeof(Bundle::Header) || 0 != std::memcmp(h->magic_,Bundle::magic,sizeof(h->magic_)) )
+    {
+        std::cerr<<path<<" is not a bundle file"<<std::endl;
+        close();
+        return false;
+    }
+    if( h->version_ > Bundle::version )
+    {
+        std::cerr<<path<<" is of bundle version "<<h->version_<<" ( "<<Bundle::version<<" supported )"<<std::endl;
+        close();
+        return false;
+    }
+    n_sections_ = h->n_sections_;
+    sections_ = (const Bundle::Section*)( base_ + sizeof(Bundle::Header) );
+    if( size_ < sizeof(Bundle::Header) + uint64_t(n_sections_)*sizeof(Bundle::Section) )
+    {
+        std::cerr<<path<<" is truncated"<<std::endl;
+        close();
+        return false;
+    }
+    for( uint32_t i = 0 ; i < n_sections_ ; ++i )
+    {
+        const Bundle::Section& s = sections_[i];
+        uint64_t bytes = s.n_rows_*s.n_cols_*Bundle::elem_size(s.type_);
+        if( 0 == Bundle::elem_size(s.type_) || s.offset_ % Bundle::alignment != 0 || s.offset_ + bytes > size_ )
+        {
+            std::cerr<<path<<" has an invalid section "<<s.id_<<std::endl;
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void BundleFile::close(void)
+{
+    if(base_)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(base_);
+        CloseHandle((HANDLE)mapping_);
+        CloseHandle((HANDLE)file_);
+        mapping_ = 0;
+        file_ = 0;
+#else
+        munmap(base_,size_);
+#endif
+    }
+    base_ = 0;
+    size_ = 0;
+    sections_ = 0;
+    n_sections_ = 0;
+}
+
+const Bundle::Section* BundleFile::find(uint32_t id)const
+{
+    for( uint32_t i = 0 ; i < n_sections_ ; ++i )
+    {
+        if( sections_[i].id_ == id )return &sections_[i];
+    }
+    return 0;
+}
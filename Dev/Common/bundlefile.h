@@ -0,0 +1,157 @@
+#ifndef BUNDLEFILE_H
+#define BUNDLEFILE_H
+#include "common_global.h"
+#include <armadillo>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <new>
+//single binary container for one frame
+//layout: Header | Section x n_sections | data blocks aligned to 64 bytes
+//every block is a column major matrix, so it can be viewed in place as arma::Mat
+namespace Bundle
+{
+    const char magic[8] = {'D','V','B','U','N','D','L','E'};
+    const uint32_t version = 1;
+    const uint64_t alignment = 64;
+    typedef enum{
+        Points = 1,
+        Normals,
+        Colors,
+        Labels,
+        Feature,
+        Name,
+        VoxelCenters = 16,
+        VoxelColors,
+        VoxelNormals,
+        VoxelSizes,
+        VoxelLabels,
+        VoxelNeighbors,
+        VoxelAdjOffsets,
+        VoxelAdjIndices,
+        VoxelAdjEdges
+    }SectionID;
+    typedef enum{
+        U8 = 1,
+        U32,
+        U64,
+        F32,
+        F64
+    }ElemType;
+    struct Header
+    {
+        char magic_[8];
+        uint32_t version_;
+        uint32_t n_sections_;
+    };
+    struct Section
+    {
+        uint32_t id_;
+        uint32_t type_;
+        uint64_t n_rows_;
+        uint64_t n_cols_;
+        uint64_t offset_;
+    };
+    template<typename eT> struct Type;
+    template<> struct Type<uint8_t>{ static const uint32_t value = U8; };
+    template<> struct Type<float>{ static const uint32_t value = F32; };
+    template<> struct Type<double>{ static const uint32_t value = F64; };
+    template<> struct Type<unsigned int>{ static const uint32_t value = sizeof(unsigned int)==8?U64:U32; };
+    template<> struct Type<unsigned long>{ static const uint32_t value = sizeof(unsigned long)==8?U64:U32; };
+    template<> struct Type<unsigned long long>{ static const uint32_t value = sizeof(unsigned long long)==8?U64:U32; };
+    uint64_t COMMONSHARED_EXPORT elem_size(uint32_t type);
+}
+
+class COMMONSHARED_EXPORT BundleWriter
+{
+public:
+    //the data is not copied, it must stay alive until write()
+    void add(uint32_t id,uint32_t type,const void* data,uint64_t n_rows,uint64_t n_cols);
+    template<typename eT>
+    void add(uint32_t id,const arma::Mat<eT>& m)
+    {
+        if(!m.is_empty())add(id,Bundle::Type<eT>::value,m.memptr(),m.n_rows,m.n_cols);
+    }
+    bool write(const std::string&);
+private:
+    std::vector<Bundle::Section> sections_;
+    std::vector<const void*> data_;
+};
+
+//the whole file is mapped copy-on-write:
+//views may be modified without touching the file and stay valid until close()
+class COMMONSHARED_EXPORT BundleFile
+{
+public:
+    BundleFile();
+    ~BundleFile();
+    BundleFile(const BundleFile&) = delete;
+    BundleFile& operator=(const BundleFile&) = delete;
+    bool open(const std::string&);
+    void close(void);
+    bool is_open(void)const{return 0!=base_;}
+    bool has(uint32_t id)const{return 0!=find(id);}
+    //pointer into the mapped file, 0 if the section is missing or has another element type
+    template<typename eT>
+    eT* ptr(uint32_t id,arma::uword& n_rows,arma::uword& n_cols)const
+    {
+        const Bundle::Section* s = find(id);
+        if( !s || s->type_ != Bundle::Type<eT>::value )return 0;
+        n_rows = s->n_rows_;
+        n_cols = s->n_cols_;
+        return (eT*)(base_ + s->offset_);
+    }
+    //rebind m to the section in place without copying, m is valid while the file is mapped
+    //the pages are copy-on-write and a size change makes m allocate its own memory
+    template<typename eT>
+    bool view(uint32_t id,arma::Mat<eT>& m)const
+    {
+        arma::uword r,c;
+        eT* p = ptr<eT>(id,r,c);
+        if(!p)return false;
+        m.~Mat<eT>();
+        new (&m) arma::Mat<eT>(p,r,c,false,false);
+        return true;
+    }
+    template<typename eT>
+    bool view(uint32_t id,arma::Col<eT>& m)const
+    {
+        arma::uword r,c;
+        eT* p = ptr<eT>(id,r,c);
+        if(!p)return false;
+        m.~Col<eT>();
+        new (&m) arma::Col<eT>(p,r*c,false,false);
+        return true;
+    }
+    //copy a section out of the file, for data that has to be owned
+    template<typename eT>
+    bool get(uint32_t id,arma::Mat<eT>& m)const
+    {
+        arma::uword r,c;
+        eT* p = ptr<eT>(id,r,c);
+        if(!p)return false;
+        m = arma::Mat<eT>(p,r,c,true,false);
+        return true;
+    }
+    template<typename eT>
+    bool get(uint32_t id,arma::Col<eT>& m)const
+    {
+        arma::uword r,c;
+        eT* p = ptr<eT>(id,r,c);
+        if(!p)return false;
+        m = arma::Col<eT>(p,r*c,true,false);
+        return true;
+    }
+protected:
+    const Bundle::Section* find(uint32_t id)const;
+private:
+    char* base_;
+    uint64_t size_;
+    const Bundle::Section* sections_;
+    uint32_t n_sections_;
+#ifdef _WIN32
+    void* file_;
+    void* mapping_;
+#endif
+};
+#endif // BUNDLEFILE_H
@@ -3,6 +3,7 @@
 #include "MeshType.h"
 #include "MeshColor.h"
 #include "voxelgraph.hpp"
+#include "meshbundle.hpp"
 void ColorArray::hsv2rgb(float h,float s,float v,RGB32&rgba)
 {
 int hi = (int(h) / 60) % 6;
@@ -9,6 +9,7 @@
 #include "configure.h"
 #include "mbb.h"
 #include "voxelgraph.h"
+#include "gmmkernel.h"
 #include <cassert>
 #ifndef M_PI
 #  define M_PI 3.1415926535897932
@@ -22,6 +23,8 @@ template class COMMONSHARED_EXPORT MeshBundle<DefaultMesh>;
 typedef MeshOctreeContainer<DefaultMesh> DefaultOctreeContainer;
 template class COMMONSHARED_EXPORT unibn::Octree<arma::fvec,DefaultOctreeContainer>;
 typedef unibn::Octree<arma::fvec,DefaultOctreeContainer> DefaultOctree;
+template class COMMONSHARED_EXPORT unibn::LinearOctree<arma::fvec,DefaultOctreeContainer>;
+typedef unibn::LinearOctree<arma::fvec,DefaultOctreeContainer> DefaultLinearOctree;
 void COMMONSHARED_EXPORT getRotationFromZY(const arma::fvec&,const arma::fvec&,arma::fmat&);
 void COMMONSHARED_EXPORT getRotationFromXY(const arma::fvec&,const arma::fvec&,arma::fmat&);
 void COMMONSHARED_EXPORT init_resouce();
@@ -0,0 +1,257 @@
+#include "gmmkernel.h"
+#include <cmath>
+#include <algorithm>
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define GMMKERNEL_X86
+#include <immintrin.h>
+#endif
+namespace GMMKernel
+{
+//rows of a block stay in L1 while all the centroids are swept over them
+static const size_t row_block_ = 512;
+
+//exponents are clamped here, exp(exp_lo_) is the smallest normal float
+//so far points keep a tiny weight instead of a zero alpha ( -log(alpha) stays finite )
+static const float exp_lo_ = -87.3365447f;
+
+template<typename T>
+static inline void store_scalar(T* out,float v){*out = T(v);}
+
+template<typename T>
+static void weight_block_scalar(
+        const float* vx,const float* vy,const float* vz,size_t r0,size_t r1,
+        const float* xx,const float* xy,const float* xz,size_t K,
+        const float* k,const float* w,
+        T* out,size_t ld
+        )
+{
+    for(size_t c = 0 ; c < K ; ++c )
+    {
+        const float cx = xx[c];
+        const float cy = xy[c];
+        const float cz = xz[c];
+        const float ck = -k[c];
+        const float cw = w[c];
+        T* o = out + c*ld;
+        for(size_t r = r0 ; r < r1 ; ++r )
+        {
+            const float d0 = vx[r] - cx;
+            const float d1 = vy[r] - cy;
+            const float d2 = vz[r] - cz;
+            const float e = ck*( d0*d0 + d1*d1 + d2*d2 );
+            store_scalar(o+r, cw*std::exp(std::max(e,exp_lo_)) );
+        }
+    }
+}
+
+#ifdef GMMKERNEL_X86
+//cephes style expf for non-positive input, ~1ulp on [-87,0], clamped below at exp_lo_
+__attribute__((target("avx2,fma")))
+static inline __m256 exp_avx2(__m256 x)
+{
+    x = _mm256_max_ps(x,_mm256_set1_ps(exp_lo_));
+    __m256 n = _mm256_round_ps(
+                _mm256_mul_ps(x,_mm256_set1_ps(1.44269504088896341f)),
+                _MM_FROUND_TO_NEAREST_INT|_MM_FROUND_NO_EXC
+                );
+    __m256 r = _mm256_fnmadd_ps(n,_mm256_set1_ps(0.693359375f),x);
+    r = _mm256_fnmadd_ps(n,_mm256_set1_ps(-2.12194440e-4f),r);
+    __m256 p = _mm256_set1_ps(1.9875691500e-4f);
+    p = _mm256_fmadd_ps(p,r,_mm256_set1_ps(1.3981999507e-3f));
+    p = _mm256_fmadd_ps(p,r,_mm256_set1_ps(8.3334519073e-3f));
+    p = _mm256_fmadd_ps(p,r,_mm256_set1_ps(4.1665795894e-2f));
+    p = _mm256_fmadd_ps(p,r,_mm256_set1_ps(1.6666665459e-1f));
+    p = _mm256_fmadd_ps(p,r,_mm256_set1_ps(5.0000001201e-1f));
+    p = _mm256_fmadd_ps(p,_mm256_mul_ps(r,r),r);
+    p = _mm256_add_ps(p,_mm256_set1_ps(1.0f));
+    __m256i e = _mm256_add_epi32(_mm256_cvtps_epi32(n),_mm256_set1_epi32(127));
+    e = _mm256_slli_epi32(e,23);
+    return _mm256_mul_ps(p,_mm256_castsi256_ps(e));
+}
+
+__attribute__((target("avx2,fma")))
+static inline void store_avx2(float* o,__m256 v){_mm256_storeu_ps(o,v);}
+
+__attribute__((target("avx2,fma")))
+static inline void store_avx2(double* o,__m256 v)
+{
+    _mm256_storeu_pd(o,_mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+    _mm256_storeu_pd(o+4,_mm256_cvtps_pd(_mm256_extractf128_ps(v,1)));
+}
+
+template<typename T>
+__attribute__((target("avx2,fma")))
+static void weight_block_avx2(
+        const float* vx,const float* vy,const float* vz,size_t r0,size_t r1,
+        const float* xx,const float* xy,const float* xz,size_t K,
+        const float* k,const float* w,
+        T* out,size_t ld
+        )
+{
+    const size_t r_simd = r0 + ( ( r1 - r0 ) / 8 ) * 8;
+    for(size_t c = 0 ; c < K ; ++c )
+    {
+        const __m256 cx = _mm256_set1_ps(xx[c]);
+        const __m256 cy = _mm256_set1_ps(xy[c]);
+        const __m256 cz = _mm256_set1_ps(xz[c]);
+        const __m256 ck = _mm256_set1_ps(-k[c]);
+        const __m256 cw = _mm256_set1_ps(w[c]);
+        T* o = out + c*ld;
+        for(size_t r = r0 ; r < r_simd ; r += 8 )
+        {
+            __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(vx+r),cx);
+            __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(vy+r),cy);
+            __m256 d2 = _mm256_sub_ps(_mm256_loadu_ps(vz+r),cz);
+            __m256 d = _mm256_mul_ps(d0,d0);
+            d = _mm256_fmadd_ps(d1,d1,d);
+            d = _mm256_fmadd_ps(d2,d2,d);
+            store_avx2(o+r,_mm256_mul_ps(cw,exp_avx2(_mm256_mul_ps(ck,d))));
+        }
+    }
+    if( r_simd < r1 )weight_block_scalar(vx,vy,vz,r_simd,r1,xx,xy,xz,K,k,w,out,ld);
+}
+
+__attribute__((target("avx512f")))
+static inline __m512 exp_avx512(__m512 x)
+{
+    x = _mm512_max_ps(x,_mm512_set1_ps(exp_lo_));
+    __m512 n = _mm512_roundscale_ps(
+                _mm512_mul_ps(x,_mm512_set1_ps(1.44269504088896341f)),
+                _MM_FROUND_TO_NEAREST_INT|_MM_FROUND_NO_EXC
+                );
+    __m512 r = _mm512_fnmadd_ps(n,_mm512_set1_ps(0.693359375f),x);
+    r = _mm512_fnmadd_ps(n,_mm512_set1_ps(-2.12194440e-4f),r);
+    __m512 p = _mm512_set1_ps(1.9875691500e-4f);
+    p = _mm512_fmadd_ps(p,r,_mm512_set1_ps(1.3981999507e-3f));
+    p = _mm512_fmadd_ps(p,r,_mm512_set1_ps(8.3334519073e-3f));
+    p = _mm512_fmadd_ps(p,r,_mm512_set1_ps(4.1665795894e-2f));
+    p = _mm512_fmadd_ps(p,r,_mm512_set1_ps(1.6666665459e-1f));
+    p = _mm512_fmadd_ps(p,r,_mm512_set1_ps(5.0000001201e-1f));
+    p = _mm512_fmadd_ps(p,_mm512_mul_ps(r,r),r);
+    p = _mm512_add_ps(p,_mm512_set1_ps(1.0f));
+    __m512i e = _mm512_add_epi32(_mm512_cvtps_epi32(n),_mm512_set1_epi32(127));
+    e = _mm512_slli_epi32(e,23);
+    return _mm512_mul_ps(p,_mm512_castsi512_ps(e));
+}
+
+__attribute__((target("avx512f")))
+static inline void store_avx512(float* o,__m512 v){_mm512_storeu_ps(o,v);}
+
+__attribute__((target("avx512f")))
+static inline void store_avx512(double* o,__m512 v)
+{
+    _mm512_storeu_pd(o,_mm512_cvtps_pd(_mm512_castps512_ps256(v)));
+    _mm512_storeu_pd(o+8,_mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v),1))));
+}
+
+template<typename T>
+__attribute__((target("avx512f")))
+static void weight_block_avx512(
+        const float* vx,const float* vy,const float* vz,size_t r0,size_t r1,
+        const float* xx,const float* xy,const float* xz,size_t K,
+        const float* k,const float* w,
+        T* out,size_t ld
+        )
+{
+    const size_t r_simd = r0 + ( ( r1 - r0 ) / 16 ) * 16;
+    for(size_t c = 0 ; c < K ; ++c )
+    {
+        const __m512 cx = _mm512_set1_ps(xx[c]);
+        const __m512 cy = _mm512_set1_ps(xy[c]);
+        const __m512 cz = _mm512_set1_ps(xz[c]);
+        const __m512 ck = _mm512_set1_ps(-k[c]);
+        const __m512 cw = _mm512_set1_ps(w[c]);
+        T* o = out + c*ld;
+        for(size_t r = r0 ; r < r_simd ; r += 16 )
+        {
+            __m512 d0 = _mm512_sub_ps(_mm512_loadu_ps(vx+r),cx);
+            __m512 d1 = _mm512_sub_ps(_mm512_loadu_ps(vy+r),cy);
+            __m512 d2 = _mm512_sub_ps(_mm512_loadu_ps(vz+r),cz);
+            __m512 d = _mm512_mul_ps(d0,d0);
+            d = _mm512_fmadd_ps(d1,d1,d);
+            d = _mm512_fmadd_ps(d2,d2,d);
+            store_avx512(o+r,_mm512_mul_ps(cw,exp_avx512(_mm512_mul_ps(ck,d))));
+        }
+    }
+    if( r_simd < r1 )weight_block_scalar(vx,vy,vz,r_simd,r1,xx,xy,xz,K,k,w,out,ld);
+}
+#endif
+
+typedef enum{
+    Scalar,
+    AVX2,
+    AVX512
+}ISA;
+
+static ISA detect_isa()
+{
+#ifdef GMMKERNEL_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f"))return AVX512;
+    if(__builtin_cpu_supports("avx2")&&__builtin_cpu_supports("fma"))return AVX2;
+#endif
+    return Scalar;
+}
+
+static const ISA isa_ = detect_isa();
+
+template<typename T>
+static void weight_impl(
+        const float* vx,const float* vy,const float* vz,size_t N,
+        const float* xx,const float* xy,const float* xz,size_t K,
+        const float* k,const float* w,
+        T* out,size_t ld
+        )
+{
+    const long long block_num = ( N + row_block_ - 1 ) / row_block_;
+    #pragma omp parallel for schedule(dynamic)
+    for(long long b = 0 ; b < block_num ; ++b )
+    {
+        const size_t r0 = size_t(b)*row_block_;
+        const size_t r1 = std::min(N,r0+row_block_);
+        switch(isa_)
+        {
+#ifdef GMMKERNEL_X86
+        case AVX512:
+            weight_block_avx512(vx,vy,vz,r0,r1,xx,xy,xz,K,k,w,out,ld);
+            break;
+        case AVX2:
+            weight_block_avx2(vx,vy,vz,r0,r1,xx,xy,xz,K,k,w,out,ld);
+            break;
+#endif
+        default:
+            weight_block_scalar(vx,vy,vz,r0,r1,xx,xy,xz,K,k,w,out,ld);
+        }
+    }
+}
+
+void weight(
+        const float* vx,const float* vy,const float* vz,size_t N,
+        const float* xx,const float* xy,const float* xz,size_t K,
+        const float* k,const float* w,
+        float* out,size_t ld
+        )
+{
+    weight_impl(vx,vy,vz,N,xx,xy,xz,K,k,w,out,ld);
+}
+
+void weight(
+        const float* vx,const float* vy,const float* vz,size_t N,
+        const float* xx,const float* xy,const float* xz,size_t K,
+        const float* k,const float* w,
+        double* out,size_t ld
+        )
+{
+    weight_impl(vx,vy,vz,N,xx,xy,xz,K,k,w,out,ld);
+}
+
+const char* isa(void)
+{
+    switch(isa_)
+    {
+    case AVX512:return "AVX-512";
+    case AVX2:return "AVX2";
+    default:return "Scalar";
+    }
+}
+}
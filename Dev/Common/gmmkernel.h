@@ -0,0 +1,50 @@
+#ifndef GMMKERNEL_H
+#define GMMKERNEL_H
+#include "common_global.h"
+#include <cstddef>
+#include <armadillo>
+namespace GMMKernel
+{
+    //fused squared distance + exp for the E-step of the GMM based registration
+    //out(r,c) = w[c]*exp( -k[c]*|| x_c - v_r ||^2 ), out is column major with leading dimension ld
+    //v and x are SoA buffers, computation is done in single precision
+    //the exponent is clamped at the float underflow, so no weight is zero unless w[c] is
+    //AVX-512 / AVX2 paths are chosen at runtime, scalar code is the fallback
+    void COMMONSHARED_EXPORT weight(
+            const float* vx,const float* vy,const float* vz,size_t N,
+            const float* xx,const float* xy,const float* xz,size_t K,
+            const float* k,const float* w,
+            float* out,size_t ld
+            );
+    void COMMONSHARED_EXPORT weight(
+            const float* vx,const float* vy,const float* vz,size_t N,
+            const float* xx,const float* xy,const float* xz,size_t K,
+            const float* k,const float* w,
+            double* out,size_t ld
+            );
+    //name of the instruction set used by weight
+    const char* COMMONSHARED_EXPORT isa(void);
+
+    //each col of v and x is a point, out is resized to v.n_cols x x.n_cols
+    template<typename eT>
+    inline void weight(
+            const arma::fmat& v,
+            const arma::fmat& x,
+            const arma::frowvec& k,
+            const arma::frowvec& w,
+            arma::Mat<eT>& out
+            )
+    {
+        //transpose to get SoA ( each col of vt is one coordinate )
+        arma::fmat vt = v.t();
+        arma::fmat xt = x.t();
+        if( ( out.n_rows != v.n_cols ) || ( out.n_cols != x.n_cols ) )out.set_size(v.n_cols,x.n_cols);
+        weight(
+               vt.colptr(0),vt.colptr(1),vt.colptr(2),v.n_cols,
+               xt.colptr(0),xt.colptr(1),xt.colptr(2),x.n_cols,
+               k.memptr(),w.memptr(),
+               out.memptr(),out.n_rows
+               );
+    }
+}
+#endif // GMMKERNEL_H
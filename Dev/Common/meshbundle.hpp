@@ -0,0 +1,96 @@
+#ifndef MESHBUNDLE_HPP
+#define MESHBUNDLE_HPP
+#include "MeshType.h"
+#include "bundlefile.h"
+#include <cstring>
+template<typename M>
+bool MeshBundle<M>::save(const std::string& path,const arma::uvec& label)
+{
+    const arma::uword N = mesh_.n_vertices();
+    BundleWriter w;
+    w.add(Bundle::Points,Bundle::F32,mesh_.points(),3,N);
+    if(mesh_.has_vertex_normals())w.add(Bundle::Normals,Bundle::F32,mesh_.vertex_normals(),3,N);
+    if(mesh_.has_vertex_colors())w.add(Bundle::Colors,Bundle::U8,mesh_.vertex_colors(),3,N);
+    if(label.size()==N)w.add(Bundle::Labels,label);
+    if(!name_.empty())w.add(Bundle::Name,Bundle::U8,name_.data(),name_.size(),1);
+    w.add(Bundle::Feature,p_feature_);
+    if(!graph_.voxel_centers.is_empty())
+    {
+        if(!graph_.has_adjacency())graph_.build_adjacency();
+        w.add(Bundle::VoxelCenters,graph_.voxel_centers);
+        w.add(Bundle::VoxelColors,graph_.voxel_colors);
+        w.add(Bundle::VoxelNormals,graph_.voxel_normals);
+        w.add(Bundle::VoxelSizes,graph_.voxel_size);
+        w.add(Bundle::VoxelLabels,graph_.voxel_label);
+        w.add(Bundle::VoxelNeighbors,graph_.voxel_neighbors);
+        w.add(Bundle::VoxelAdjOffsets,graph_.voxel_adj_offsets);
+        w.add(Bundle::VoxelAdjIndices,graph_.voxel_adj_indices);
+        w.add(Bundle::VoxelAdjEdges,graph_.voxel_adj_edges);
+    }
+    return w.write(path);
+}
+
+template<typename M>
+bool MeshBundle<M>::load(const std::string& path)
+{
+    arma::uvec label;
+    return load(path,label);
+}
+
+template<typename M>
+bool MeshBundle<M>::load(const std::string& path,arma::uvec& label)
+{
+    std::shared_ptr<BundleFile> file(new BundleFile());
+    BundleFile& f = *file;
+    if(!f.open(path))return false;
+    arma::uword r,c;
+    float* v = f.ptr<float>(Bundle::Points,r,c);
+    if( !v || 3 != r )return false;
+    const arma::uword N = c;
+    //the mesh owns its arrays so each block is copied once, no per-vertex parsing
+    mesh_.clear();
+    mesh_.resize(N,0,0);
+    std::memcpy((void*)mesh_.points(),v,3*N*sizeof(float));
+    float* n = f.ptr<float>(Bundle::Normals,r,c);
+    if( n && 3 == r && N == c )
+    {
+        mesh_.request_vertex_normals();
+        std::memcpy((void*)mesh_.vertex_normals(),n,3*N*sizeof(float));
+    }
+    uint8_t* rgb = f.ptr<uint8_t>(Bundle::Colors,r,c);
+    if( rgb && 3 == r && N == c )
+    {
+        mesh_.request_vertex_colors();
+        std::memcpy((void*)mesh_.vertex_colors(),rgb,3*N);
+    }
+    uint8_t* name = f.ptr<uint8_t>(Bundle::Name,r,c);
+    if(name)name_ = std::string((const char*)name,r);
+    if(!f.get(Bundle::Labels,label))label.reset();
+    //the graph and p_feature_ are used in place, nothing may still point into a former file
+    if(!f.view(Bundle::Feature,p_feature_))p_feature_.reset();
+    graph_.voxel_centers.reset();
+    graph_.voxel_colors.reset();
+    graph_.voxel_normals.reset();
+    graph_.voxel_size.reset();
+    graph_.voxel_label.reset();
+    graph_.voxel_neighbors.reset();
+    graph_.voxel_adj_offsets.reset();
+    graph_.voxel_adj_indices.reset();
+    graph_.voxel_adj_edges.reset();
+    file_ = file;
+    if(f.has(Bundle::VoxelCenters))
+    {
+        if(!f.view(Bundle::VoxelCenters,graph_.voxel_centers))return false;
+        if(!f.view(Bundle::VoxelColors,graph_.voxel_colors))return false;
+        if(!f.view(Bundle::VoxelNormals,graph_.voxel_normals))return false;
+        if(!f.view(Bundle::VoxelSizes,graph_.voxel_size))return false;
+        if(!f.view(Bundle::VoxelLabels,graph_.voxel_label))return false;
+        f.view(Bundle::VoxelNeighbors,graph_.voxel_neighbors);
+        bool adj_loaded = f.view(Bundle::VoxelAdjOffsets,graph_.voxel_adj_offsets);
+        adj_loaded = adj_loaded && f.view(Bundle::VoxelAdjIndices,graph_.voxel_adj_indices);
+        adj_loaded = adj_loaded && f.view(Bundle::VoxelAdjEdges,graph_.voxel_adj_edges);
+        if( !adj_loaded || !graph_.has_adjacency() )graph_.build_adjacency();
+    }
+    return true;
+}
+#endif // MESHBUNDLE_HPP
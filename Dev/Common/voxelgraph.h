@@ -20,6 +20,31 @@ public:
     }
     bool save(const std::string&);
     bool load(const std::string&);
+    //compress voxel_neighbors into the CSR adjacency below
+    //call it again whenever voxel_neighbors is changed
+    void build_adjacency(void);
+    bool has_adjacency(void)const
+    {
+        return ( voxel_adj_offsets.size() == size() + 1 ) && ( voxel_adj_indices.size() == voxel_adj_offsets(size()) );
+    }
+    //neighbors of voxel i are [ neighbor_begin(i) , neighbor_end(i) ) in ascending order
+    const uint32_t* neighbor_begin(size_t i)const
+    {
+        return voxel_adj_indices.memptr() + voxel_adj_offsets(i);
+    }
+    const uint32_t* neighbor_end(size_t i)const
+    {
+        return voxel_adj_indices.memptr() + voxel_adj_offsets(i+1);
+    }
+    //column in voxel_neighbors of the edge stored at neighbor_begin(i)[0]
+    const uint32_t* neighbor_edge_begin(size_t i)const
+    {
+        return voxel_adj_edges.memptr() + voxel_adj_offsets(i);
+    }
+    size_t degree(size_t i)const
+    {
+        return voxel_adj_offsets(i+1) - voxel_adj_offsets(i);
+    }
     void sv2pix(const arma::uvec& sv,arma::uvec& pix);//supervoxel label to pixel label
     void sv2pix(arma::Col<uint32_t>&,arma::Col<uint32_t>&);//supervoxel color to pixel color
     void sv2pix(arma::Mat<uint8_t>&,arma::Mat<uint8_t>&);//supervoxel color to pixel color
@@ -54,8 +79,11 @@ public:
     arma::fmat voxel_normals;
     arma::uvec voxel_size;
     arma::uvec voxel_label;//start from one
-    arma::Mat<uint16_t> voxel_neighbors;//start from zero
+    arma::Mat<uint32_t> voxel_neighbors;//start from zero
     arma::Mat<uint8_t> voxel_edge_colors;
+    arma::Col<uint32_t> voxel_adj_offsets;//size()+1
+    arma::Col<uint32_t> voxel_adj_indices;//both directions of each edge
+    arma::Col<uint32_t> voxel_adj_edges;//edge index in voxel_neighbors for each entry in voxel_adj_indices
 private:
     const Mesh& Ref_;//the ref Mesh that bound with this custom color
 };
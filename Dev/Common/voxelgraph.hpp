@@ -6,15 +6,21 @@
 #include "MeshType.h"
 #include <hash_fun.h>
 #include <ext/hash_map>
+#include <unordered_map>
+#include <algorithm>
 template <typename M>
 bool VoxelGraph<M>::save(const std::string&path)
 {
-    if(!voxel_centers.save(path+"\\centers.fvec.arma",arma::arma_binary))return false;
-    if(!voxel_normals.save(path+"\\normals.fvec.arma",arma::arma_binary))return false;
-    if(!voxel_colors.save(path+"\\colors.Mat_uint8_t.arma",arma::arma_binary))return false;
-    if(!voxel_size.save(path+"\\sizes.uvec.arma",arma::arma_binary))return false;
-    if(!voxel_neighbors.save(path+"\\neighbors.Mat_uint16_t.arma",arma::arma_binary))return false;
-    if(!voxel_label.save(path+"\\labels.uvec.arma",arma::arma_binary))return false;
+    if(!voxel_centers.save(path+"/centers.fvec.arma",arma::arma_binary))return false;
+    if(!voxel_normals.save(path+"/normals.fvec.arma",arma::arma_binary))return false;
+    if(!voxel_colors.save(path+"/colors.Mat_uint8_t.arma",arma::arma_binary))return false;
+    if(!voxel_size.save(path+"/sizes.uvec.arma",arma::arma_binary))return false;
+    if(!voxel_neighbors.save(path+"/neighbors.Mat_uint32_t.arma",arma::arma_binary))return false;
+    if(!voxel_label.save(path+"/labels.uvec.arma",arma::arma_binary))return false;
+    if(!has_adjacency())build_adjacency();
+    if(!voxel_adj_offsets.save(path+"/adj_offsets.Col_uint32_t.arma",arma::arma_binary))return false;
+    if(!voxel_adj_indices.save(path+"/adj_indices.Col_uint32_t.arma",arma::arma_binary))return false;
+    if(!voxel_adj_edges.save(path+"/adj_edges.Col_uint32_t.arma",arma::arma_binary))return false;
     M output;
     for( int i=0 ; i < voxel_centers.n_cols ; ++i )
     {
@@ -30,25 +36,97 @@ bool VoxelGraph<M>::save(const std::string&path)
     opt+=OpenMesh::IO::Options::Binary;
     opt+=OpenMesh::IO::Options::VertexColor;
     opt+=OpenMesh::IO::Options::VertexNormal;
-    OpenMesh::IO::write_mesh(output,path+"\\mesh.ply",opt,13);
+    OpenMesh::IO::write_mesh(output,path+"/mesh.ply",opt,13);
     return true;
 }
 
 template <typename M>
 bool VoxelGraph<M>::load(const std::string&path)
 {
-    if(!voxel_centers.load(path+"\\centers.fvec.arma"))return false;
-    if(!voxel_normals.load(path+"\\normals.fvec.arma"))return false;
-    if(!voxel_colors.load(path+"\\colors.Mat_uint8_t.arma"))return false;
-    if(!voxel_size.load(path+"\\sizes.uvec.arma"))return false;
-    if(!voxel_neighbors.load(path+"\\neighbors.Mat_uint16_t.arma"))return false;
-    if(!voxel_label.load(path+"\\labels.uvec.arma"))return false;
+    if(!voxel_centers.load(path+"/centers.fvec.arma"))return false;
+    if(!voxel_normals.load(path+"/normals.fvec.arma"))return false;
+    if(!voxel_colors.load(path+"/colors.Mat_uint8_t.arma"))return false;
+    if(!voxel_size.load(path+"/sizes.uvec.arma"))return false;
+    if(!voxel_neighbors.load(path+"/neighbors.Mat_uint32_t.arma"))
+    {
+        //graphs saved before the 32-bit indices
+        arma::Mat<uint16_t> neighbors;
+        if(!neighbors.load(path+"/neighbors.Mat_uint16_t.arma"))return false;
+        voxel_neighbors = arma::conv_to<arma::Mat<uint32_t>>::from(neighbors);
+    }
+    if(!voxel_label.load(path+"/labels.uvec.arma"))return false;
     if(voxel_centers.n_cols!=voxel_size.size())return false;
     if(voxel_centers.n_cols!=voxel_colors.n_cols)return false;
     if(voxel_centers.n_cols!=voxel_normals.n_cols)return false;
+    bool adj_loaded = voxel_adj_offsets.load(path+"/adj_offsets.Col_uint32_t.arma");
+    adj_loaded = adj_loaded && voxel_adj_indices.load(path+"/adj_indices.Col_uint32_t.arma");
+    adj_loaded = adj_loaded && voxel_adj_edges.load(path+"/adj_edges.Col_uint32_t.arma");
+    adj_loaded = adj_loaded && has_adjacency() && ( voxel_adj_edges.size() == voxel_adj_indices.size() );
+    if(!adj_loaded)build_adjacency();
     return true;
 }
 
+template <typename M>
+void VoxelGraph<M>::build_adjacency(void)
+{
+    const size_t N = size();
+    const size_t E = voxel_neighbors.n_cols;
+    if( ( 0 < E ) && ( voxel_neighbors.n_rows != 2 ) )throw std::logic_error("voxel_neighbors.n_rows!=2");
+    //count the degree
+    voxel_adj_offsets = arma::Col<uint32_t>(N+1,arma::fill::zeros);
+    for(size_t e = 0 ; e < E ; ++e )
+    {
+        const uint32_t i = voxel_neighbors(0,e);
+        const uint32_t j = voxel_neighbors(1,e);
+        if( i >= N || j >= N )throw std::logic_error("voxel_neighbors out of range");
+        if( i == j )continue;
+        ++voxel_adj_offsets(i+1);
+        ++voxel_adj_offsets(j+1);
+    }
+    for(size_t i = 0 ; i < N ; ++i )voxel_adj_offsets(i+1) += voxel_adj_offsets(i);
+    //scatter both directions of each edge
+    voxel_adj_indices = arma::Col<uint32_t>(voxel_adj_offsets(N));
+    voxel_adj_edges = arma::Col<uint32_t>(voxel_adj_offsets(N));
+    arma::Col<uint32_t> pos = voxel_adj_offsets.head(N);
+    for(size_t e = 0 ; e < E ; ++e )
+    {
+        const uint32_t i = voxel_neighbors(0,e);
+        const uint32_t j = voxel_neighbors(1,e);
+        if( i == j )continue;
+        voxel_adj_indices(pos(i)) = j;
+        voxel_adj_edges(pos(i)) = e;
+        ++pos(i);
+        voxel_adj_indices(pos(j)) = i;
+        voxel_adj_edges(pos(j)) = e;
+        ++pos(j);
+    }
+    //sort each row and drop duplicated edges ( the later edge is kept )
+    std::vector<std::pair<uint32_t,uint32_t>> row;
+    uint32_t out = 0;
+    for(size_t i = 0 ; i < N ; ++i )
+    {
+        const uint32_t b = voxel_adj_offsets(i);
+        const uint32_t e = voxel_adj_offsets(i+1);
+        row.clear();
+        for(uint32_t k = b ; k < e ; ++k )row.emplace_back(voxel_adj_indices(k),voxel_adj_edges(k));
+        std::sort(row.begin(),row.end());
+        voxel_adj_offsets(i) = out;
+        for(size_t k = 0 ; k < row.size() ; ++k )
+        {
+            if( ( k + 1 < row.size() ) && ( row[k+1].first == row[k].first ) )continue;
+            voxel_adj_indices(out) = row[k].first;
+            voxel_adj_edges(out) = row[k].second;
+            ++out;
+        }
+    }
+    voxel_adj_offsets(N) = out;
+    if( out < voxel_adj_indices.size() )
+    {
+        voxel_adj_indices.resize(out);
+        voxel_adj_edges.resize(out);
+    }
+}
+
 template <typename M>
 void VoxelGraph<M>::sv2pix(const arma::uvec& sv,arma::uvec& pix)
 {
@@ -92,70 +170,85 @@ typename VoxelGraph<M>::Ptr VoxelGraph<M>::getSubGraphPtr(const VoxelGraph& pare
 {
     extractMesh<M,M>(parent_graph.Ref_,indices,sub_mesh);
     typename VoxelGraph<M>::Ptr sub_graph(new VoxelGraph<M>(sub_mesh));
-    size_t Nsv = parent_graph.voxel_centers.n_cols;
-    arma::sp_umat neighborhood(Nsv,Nsv);
-    for(size_t i = 0 ; i < parent_graph.voxel_neighbors.n_cols ; ++i)
-    {
-        assert(parent_graph.voxel_neighbors(0,i)<Nsv);
-        assert(parent_graph.voxel_neighbors(1,i)<Nsv);
-        if( parent_graph.voxel_neighbors(0,i) <= parent_graph.voxel_neighbors(1,i) )neighborhood( parent_graph.voxel_neighbors(0,i) , parent_graph.voxel_neighbors(1,i) ) = 1;
-        else neighborhood(parent_graph.voxel_neighbors(1,i),parent_graph.voxel_neighbors(0,i)) = 1;
-    }
-    __gnu_cxx::hash_map<int,int> voxel_map;
-    std::vector<size_t> voxel_added;
+    const size_t Nsv = parent_graph.voxel_centers.n_cols;
+    const uint32_t none = std::numeric_limits<uint32_t>::max();
+    //relabel map from parent supervoxel index to sub graph index
+    //hashed and sized to the selection so a call costs O(selection) instead of O(parent)
+    //( patches are cut from the same parent concurrently, so no map is shared )
+    std::unordered_map<uint32_t,uint32_t> voxel_map;
+    voxel_map.reserve(std::min<size_t>(Nsv,indices.size()));
+    auto relabel = [&voxel_map,none](uint32_t sv)->uint32_t{
+        std::unordered_map<uint32_t,uint32_t>::const_iterator iter = voxel_map.find(sv);
+        return iter == voxel_map.end() ? none : iter->second ;
+    };
+    std::vector<arma::uword> voxel_added;
+    voxel_added.reserve(std::min<size_t>(Nsv,indices.size()));
     sub_graph->voxel_label = arma::uvec(indices.size());
     for(size_t i = 0 ; i < indices.size() ; ++ i )
     {
-        size_t c = indices(i);
-        size_t sv = parent_graph.voxel_label(c) - 1;
-        if(voxel_map.find(sv)==voxel_map.end())
-        {
-            size_t N = sub_graph->voxel_centers.n_cols;
-            voxel_map[sv] = N;
-            voxel_added.push_back(sv);
-            sub_graph->voxel_centers.insert_cols( N , parent_graph.voxel_centers.col(sv) );
-            sub_graph->voxel_colors.insert_cols( N , parent_graph.voxel_colors.col(sv) );
-            sub_graph->voxel_normals.insert_cols( N , parent_graph.voxel_normals.col(sv) );
-            sub_graph->voxel_size.insert_rows(N,1);
-            sub_graph->voxel_size(N) = 1;
-            sub_graph->voxel_label(i) = N + 1;
-        }else{
-            sub_graph->voxel_size( voxel_map[sv] ) += 1;
-            sub_graph->voxel_label(i) = voxel_map[sv] + 1;
-        }
+        size_t sv = parent_graph.voxel_label(indices(i)) - 1;
+        assert(sv<Nsv);
+        std::pair<std::unordered_map<uint32_t,uint32_t>::iterator,bool> inserted = voxel_map.emplace(uint32_t(sv),uint32_t(voxel_added.size()));
+        if(inserted.second)voxel_added.push_back(sv);
+        sub_graph->voxel_label(i) = inserted.first->second + 1;
+    }
+    const size_t N = voxel_added.size();
+    arma::uvec added(voxel_added);
+    sub_graph->voxel_centers = parent_graph.voxel_centers.cols(added);
+    sub_graph->voxel_colors = parent_graph.voxel_colors.cols(added);
+    sub_graph->voxel_normals = parent_graph.voxel_normals.cols(added);
+    sub_graph->voxel_size = arma::uvec(N,arma::fill::zeros);
+    for(arma::uvec::const_iterator iter = sub_graph->voxel_label.cbegin() ; iter != sub_graph->voxel_label.cend() ; ++iter )
+    {
+        ++sub_graph->voxel_size( *iter - 1 );
     }
-//    std::cerr<<"neighbors"<<std::endl;
-    std::sort(voxel_added.begin(),voxel_added.end(),std::less<size_t>());
-    std::vector<size_t>::iterator iter;
-    std::vector<size_t>::iterator niter;
-    for(iter=voxel_added.begin();iter!=voxel_added.end();++iter)
+    std::vector<uint32_t> edges;
+    if(parent_graph.has_adjacency())
     {
-        for( niter = iter + 1 ; niter!=voxel_added.end() ; ++niter)
+        //only the neighbors of the selected supervoxels are visited
+        //edges come out in ascending order of their parent indices
+        std::sort(voxel_added.begin(),voxel_added.end());
+        for(std::vector<arma::uword>::const_iterator iter = voxel_added.cbegin() ; iter != voxel_added.cend() ; ++iter )
         {
-            if(*iter<*niter)std::logic_error("*iter<*niter");
-            if(*iter >= neighborhood.n_cols)std::logic_error("*iter >= neighborhood.n_cols");
-            if(*niter >= neighborhood.n_rows)std::logic_error("*niter >= neighborhood.n_rows");
-            if(1!=neighborhood(*iter,*niter))continue;
-            size_t N_neighbor = sub_graph->voxel_neighbors.n_cols;
-            if(sub_graph->voxel_neighbors.is_empty())
+            const uint32_t n0 = relabel(*iter);
+            for(const uint32_t* niter = parent_graph.neighbor_begin(*iter) ; niter != parent_graph.neighbor_end(*iter) ; ++niter )
             {
-                sub_graph->voxel_neighbors = arma::Mat<uint16_t>(2,1);
-            }else{
-                sub_graph->voxel_neighbors.insert_cols(N_neighbor,1);
-            }
-            size_t n0 = voxel_map[*iter];
-            size_t n1 = voxel_map[*niter];
-            if( n0 < n1 )
-            {
-                sub_graph->voxel_neighbors(0,N_neighbor) = n0;
-                sub_graph->voxel_neighbors(1,N_neighbor) = n1;
-            }else{
-                sub_graph->voxel_neighbors(0,N_neighbor) = n1;
-                sub_graph->voxel_neighbors(1,N_neighbor) = n0;
+                if( *niter <= *iter )continue;
+                const uint32_t n1 = relabel(*niter);
+                if( none == n1 )continue;
+                edges.push_back(std::min(n0,n1));
+                edges.push_back(std::max(n0,n1));
             }
         }
+    }else{
+        //single pass over the parent edge list
+        for(size_t i = 0 ; i < parent_graph.voxel_neighbors.n_cols ; ++i)
+        {
+            const uint32_t p0 = parent_graph.voxel_neighbors(0,i);
+            const uint32_t p1 = parent_graph.voxel_neighbors(1,i);
+            assert(p0<Nsv);
+            assert(p1<Nsv);
+            if( p0 == p1 )continue;
+            const uint32_t n0 = relabel(p0);
+            const uint32_t n1 = relabel(p1);
+            if( none == n0 || none == n1 )continue;
+            edges.push_back(std::min(n0,n1));
+            edges.push_back(std::max(n0,n1));
+        }
+        //the parent list may hold an edge more than once, keep one of each
+        std::vector<std::pair<uint32_t,uint32_t>> pairs(edges.size()/2);
+        for(size_t i = 0 ; i < pairs.size() ; ++i )pairs[i] = std::make_pair(edges[2*i],edges[2*i+1]);
+        std::sort(pairs.begin(),pairs.end());
+        pairs.erase(std::unique(pairs.begin(),pairs.end()),pairs.end());
+        edges.resize(2*pairs.size());
+        for(size_t i = 0 ; i < pairs.size() ; ++i )
+        {
+            edges[2*i] = pairs[i].first;
+            edges[2*i+1] = pairs[i].second;
+        }
     }
-//    std::cerr<<"done"<<std::endl;
+    if(!edges.empty())sub_graph->voxel_neighbors = arma::Mat<uint32_t>(edges.data(),2,edges.size()/2);
+    sub_graph->build_adjacency();
     return sub_graph;
 }
 //resulted index start from one
@@ -1,6 +1,5 @@
 #include "graphcutthread.h"
 #include "nanoflann.hpp"
-arma::sp_mat GraphCutThread::smooth_;
 
 bool GraphCutThread::configure(Config::Ptr config)
 {
@@ -20,6 +19,22 @@ bool GraphCutThread::configure(Config::Ptr config)
 //    }
     if(!config_->has("GC_distance_threshold"))return false;
     if(!config_->has("GC_global_mode"))return false;
+    if("Label_Wise"==config_->getString("GC_global_mode"))label_wise_ = true;
+    else if("Pixel_Wise"==config_->getString("GC_global_mode"))label_wise_ = false;
+    else{
+        emit message(tr("Invalid value of GC_global_mode"),0);
+        return false;
+    }
+    iter_num_ = config_->getInt("GC_iter_num");
+    data_weight_ = config_->getDouble("GC_global_data_weight");
+    smooth_weight_ = config_->getDouble("GC_global_smooth_weight");
+    distance_threshold_ = config_->getDouble("GC_distance_threshold");
+    has_color_var_ = config_->has("GC_color_var");
+    color_var_ = has_color_var_ ? config_->getDouble("GC_color_var") : 30.0 ;
+    show_match_ = config_->has("GC_show_match")&&1==config_->getInt("GC_show_match");
+    show_data_ = config_->has("GC_show_data")&&1==config_->getInt("GC_show_data");
+    show_smooth_ = config_->has("GC_show_smooth")&&1==config_->getInt("GC_show_smooth");
+    show_smooth_sec_ = config_->has("GC_show_smooth_sec") ? config_->getInt("GC_show_smooth_sec") : 1 ;
     if(meshes_.empty())return false;
     if(meshes_.front()->graph_.empty())return false;
     if(objects_.empty())return false;
@@ -28,8 +43,8 @@ bool GraphCutThread::configure(Config::Ptr config)
 
 void GraphCutThread::run(void)
 {
-    Segmentation::GraphCut gc;
-    current_frame_ = 0;
+    QTime timer;
+    timer.restart();
     obj_trees_.clear();
     obj_tree_interface_.clear();
     //build obj_trees_
@@ -41,64 +56,89 @@ void GraphCutThread::run(void)
     }
     mesh_trees_.clear();
     mesh_tree_interface_.clear();
-    while( current_frame_ < meshes_.size() )
+    //build mesh_trees_, only the pixel wise data term matches across frames
+    if(!label_wise_)
     {
-        timer.restart();
-        std::cerr<<"Frame:"<<current_frame_<<std::endl;
-        MeshBundle<DefaultMesh>& m = *meshes_[current_frame_];
-        label_number_ = 1 + objects_.size();
-        pix_number_ = m.graph_.voxel_centers.n_cols;
-        gc.setLabelNumber( label_number_ );
-        gc.setPixelNumber( pix_number_ );
-        std::cerr<<"Label Num:"<<label_number_<<std::endl;
-        std::cerr<<"Pix Num:"<<pix_number_<<std::endl;
-        if("Label_Wise"==config_->getString("GC_global_mode"))
+        for(size_t frameIdx=0;frameIdx<meshes_.size();++frameIdx)
         {
-            if(!prepareDataTermLabelWise())
-            {
-                std::cerr<<"Failed in prepareDataTerm"<<std::endl;
-            }
-        }else if("Pixel_Wise"==config_->getString("GC_global_mode"))
-        {
-            if(!prepareDataTermPixWise())
-            {
-                std::cerr<<"Failed in prepareDataTerm"<<std::endl;
-            }
-        }else throw std::logic_error("Invalid value of GC_global_mode");
-        std::cerr<<"Done Data Term:"<<std::endl;
-        if(!current_data_||0==current_data_.use_count())std::logic_error("!current_data_||0==current_data_.use_count()");
-        gc.inputDataTerm(current_data_);
-        if(!prepareSmoothTerm(gc))
+            mesh_tree_interface_.emplace_back(new ATInterface(meshes_[frameIdx]->graph_.voxel_centers));
+            mesh_trees_.emplace_back(new ArmaTree(3,*mesh_tree_interface_.back(),nanoflann::KDTreeSingleIndexAdaptorParams(2)));
+            mesh_trees_.back()->buildIndex();
+        }
+    }
+    //frames are independent once the trees are built
+    //showing intermediate results pauses in between, so the frames are kept in order then
+    const bool show = show_match_ || show_data_ || show_smooth_ ;
+    const int frame_num = meshes_.size();
+    #pragma omp parallel for schedule(dynamic) if(!show)
+    for(int frame=0;frame<frame_num;++frame)
+    {
+        cutFrame(frame);
+    }
+    QString msg;
+    msg = msg.sprintf("%u ms for Global Graph Cut",timer.elapsed());
+    emit message(msg,0);
+}
+
+void GraphCutThread::cutFrame(uint32_t frame)
+{
+    QTime timer;
+    timer.restart();
+    std::cerr<<"Frame:"<<frame<<std::endl;
+    MeshBundle<DefaultMesh>& m = *meshes_[frame];
+    FrameCut cut;
+    cut.frame_ = frame;
+    cut.label_number_ = 1 + objects_.size();
+    cut.pix_number_ = m.graph_.voxel_centers.n_cols;
+    Segmentation::GraphCut gc;
+    gc.setLabelNumber( cut.label_number_ );
+    gc.setPixelNumber( cut.pix_number_ );
+    std::cerr<<"Label Num:"<<cut.label_number_<<std::endl;
+    std::cerr<<"Pix Num:"<<cut.pix_number_<<std::endl;
+    if(label_wise_)
+    {
+        if(!prepareDataTermLabelWise(cut))
         {
-            std::cerr<<"Failed in prepareSmoothTerm"<<std::endl;
+            std::cerr<<"Failed in prepareDataTerm"<<std::endl;
         }
-        gc.inputSmoothTerm(current_smooth_);
-        std::cerr<<"Done Smooth Term:"<<std::endl;
-        gc.init(Segmentation::GraphCut::EXPANSION);
-        if(!prepareNeighbors(gc))
+    }else{
+        if(!prepareDataTermPixWise(cut))
         {
-            std::cerr<<"Failed in prepareNeighbors"<<std::endl;
+            std::cerr<<"Failed in prepareDataTerm"<<std::endl;
         }
-        std::cerr<<"Done Assign Neighbors:"<<std::endl;
-        gc.updateInfo();
-        float t;
-        emit message(QString::fromStdString(gc.info()),0);
-        std::cerr<<gc.info()<<std::endl;
-        gc.optimize(config_->getInt("GC_iter_num"),t);
-        std::cerr<<"Done Optimize:"<<std::endl;
-        emit message(QString::fromStdString(gc.info()),0);
-        std::cerr<<gc.info()<<std::endl;
-        arma::uvec sv_label;
-        gc.getAnswer(sv_label);
-        std::cerr<<"Got Answer"<<std::endl;
-        m.graph_.sv2pix(sv_label,outputs_[current_frame_]);
-        m.custom_color_.fromlabel(outputs_[current_frame_]);
-        QString msg;
-        msg = msg.sprintf("%u ms for F %u",timer.elapsed(),current_frame_);
-        emit message(msg,0);
-        std::cerr<<msg.toStdString()<<std::endl;
-        ++current_frame_;
     }
+    std::cerr<<"Done Data Term:"<<std::endl;
+    if(!cut.data_cost_||0==cut.data_cost_.use_count())std::logic_error("!cut.data_cost_||0==cut.data_cost_.use_count()");
+    gc.inputDataTerm(cut.data_cost_);
+    if(!prepareSmoothTerm(cut))
+    {
+        std::cerr<<"Failed in prepareSmoothTerm"<<std::endl;
+    }
+    gc.inputSmoothTerm(cut.smooth_cost_);
+    std::cerr<<"Done Smooth Term:"<<std::endl;
+    gc.init(Segmentation::GraphCut::DYNAMIC_EXPANSION);
+    if(!prepareNeighbors(cut,gc))
+    {
+        std::cerr<<"Failed in prepareNeighbors"<<std::endl;
+    }
+    std::cerr<<"Done Assign Neighbors:"<<std::endl;
+    gc.updateInfo();
+    float t;
+    emit message(QString::fromStdString(gc.info()),0);
+    std::cerr<<gc.info()<<std::endl;
+    gc.optimize(iter_num_,t);
+    std::cerr<<"Done Optimize:"<<std::endl;
+    emit message(QString::fromStdString(gc.info()),0);
+    std::cerr<<gc.info()<<std::endl;
+    arma::uvec sv_label;
+    gc.getAnswer(sv_label);
+    std::cerr<<"Got Answer"<<std::endl;
+    m.graph_.sv2pix(sv_label,outputs_[frame]);
+    m.custom_color_.fromlabel(outputs_[frame]);
+    QString msg;
+    msg = msg.sprintf("%u ms for F %u",timer.elapsed(),frame);
+    emit message(msg,0);
+    std::cerr<<msg.toStdString()<<std::endl;
 }
 
 void GraphCutThread::showMatch(size_t idx,DefaultMesh& mesh)
@@ -117,12 +157,12 @@ void GraphCutThread::showMatch(size_t idx,DefaultMesh& mesh)
     emit sendMatch(idx,m_ptr);
 }
 
-void GraphCutThread::showData(size_t current_label)
+void GraphCutThread::showData(FrameCut& cut,size_t current_label)
 {
-    if(current_label>=label_number_)return;
-    MeshBundle<DefaultMesh>& m = *meshes_[current_frame_];
-    arma::mat data(data_.get(),label_number_,pix_number_,false,true);
-    arma::Col<uint32_t> cv(pix_number_);
+    if(current_label>=cut.label_number_)return;
+    MeshBundle<DefaultMesh>& m = *meshes_[cut.frame_];
+    arma::mat data(cut.data_.get(),cut.label_number_,cut.pix_number_,false,true);
+    arma::Col<uint32_t> cv(cut.pix_number_);
     arma::Col<uint32_t> cmat(
                 (uint32_t*)m.custom_color_.vertex_colors(),
                 m.mesh_.n_vertices(),
@@ -134,7 +174,6 @@ void GraphCutThread::showData(size_t current_label)
     float h;
     ColorArray::RGB32 tmp;
     int idx;
-    #pragma omp for
     for(idx=0;idx<data.n_cols;++idx)
     {
         if( max_var!=min_var )h = ( data(current_label,idx) - min_var ) / ( max_var - min_var );
@@ -145,13 +184,13 @@ void GraphCutThread::showData(size_t current_label)
     m.graph_.sv2pix(cv,cmat);
 }
 
-void GraphCutThread::showSmooth()
+void GraphCutThread::showSmooth(FrameCut& cut)
 {
-    MeshBundle<DefaultMesh>& m = *meshes_[current_frame_];
-    arma::sp_mat r = arma::sum(smooth_);
-    arma::sp_mat c = arma::sum(smooth_,1);
+    MeshBundle<DefaultMesh>& m = *meshes_[cut.frame_];
+    arma::sp_mat r = arma::sum(cut.smooth_);
+    arma::sp_mat c = arma::sum(cut.smooth_,1);
     arma::sp_mat var = c+r.t();
-    arma::Col<uint32_t> cv(pix_number_);
+    arma::Col<uint32_t> cv(cut.pix_number_);
     arma::Col<uint32_t> cmat(
                 (uint32_t*)m.custom_color_.vertex_colors(),
                 m.mesh_.n_vertices(),
@@ -163,7 +202,6 @@ void GraphCutThread::showSmooth()
     float h;
     ColorArray::RGB32 tmp;
     int idx;
-    #pragma omp for
     for(idx=0;idx<var.size();++idx)
     {
         if( max_var!=min_var )h = ( var(idx) - min_var ) / ( max_var - min_var );
@@ -174,35 +212,35 @@ void GraphCutThread::showSmooth()
     m.graph_.sv2pix(cv,cmat);
 }
 
-bool GraphCutThread::prepareDataTermLabelWise()
+bool GraphCutThread::prepareDataTermLabelWise(FrameCut& cut)
 {
-    MeshBundle<DefaultMesh>& m = *meshes_[current_frame_];
+    MeshBundle<DefaultMesh>& m = *meshes_[cut.frame_];
     try{
-        data_.reset(new double[label_number_*pix_number_]);
+        cut.data_.reset(new double[cut.label_number_*cut.pix_number_],std::default_delete<double[]>());
     }catch(std::bad_alloc& e)
     {
         std::cerr<<"prepareDataTermLabelWise:bad_alloc cought:"<<e.what()<<std::endl;
     }
 
-    arma::mat data_mat(data_.get(),label_number_,pix_number_,false,true);
+    arma::mat data_mat(cut.data_.get(),cut.label_number_,cut.pix_number_,false,true);
     std::vector<ObjModel::Ptr>::iterator oiter;
     uint32_t obj_index = 0;
     for(oiter=objects_.begin();oiter!=objects_.end();++oiter)
     {
         ObjModel& model = **oiter;
         DefaultMesh obj_mesh;
-        if(model.transform(obj_mesh,current_frame_))
+        if(model.transform(obj_mesh,cut.frame_))
         {
             if(obj_mesh.n_vertices()==0)std::logic_error("obj_mesh.n_vertices()==0");
-            if(config_->has("GC_show_match")&&1==config_->getInt("GC_show_match"))
+            if(show_match_)
             {
-                showMatch(current_frame_,obj_mesh);
+                showMatch(cut.frame_,obj_mesh);
                 QThread::sleep(1);
             }
-            prepareDataForLabel(1+obj_index,m.graph_,obj_mesh,model.DistP_,model.NormP_,model.ColorP_);
-            if(config_->has("GC_show_data")&&1==config_->getInt("GC_show_data"))
+            prepareDataForLabel(cut,1+obj_index,m.graph_,obj_mesh,model.DistP_,model.NormP_,model.ColorP_);
+            if(show_data_)
             {
-                showData(1+obj_index);
+                showData(cut,1+obj_index);
                 QThread::sleep(1);
             }
         }else{
@@ -210,32 +248,34 @@ bool GraphCutThread::prepareDataTermLabelWise()
         }
         ++obj_index;
     }
-    prepareDataForUnknown();
-    if(config_->has("GC_show_data")&&1==config_->getInt("GC_show_data"))
+    prepareDataForUnknown(cut);
+    if(show_data_)
     {
-        showData(0);
+        showData(cut,0);
         QThread::sleep(1);
     }
-    normalizeData();
-    current_data_.reset(new DataCost(data_.get()));
+    normalizeData(cut);
+    cut.data_cost_.reset(new DataCost(cut.data_.get()));
     return true;
 }
 
-void GraphCutThread::prepareDataForLabel(uint32_t l,
+void GraphCutThread::prepareDataForLabel(
+        FrameCut& cut,
+        uint32_t l,
         VoxelGraph<DefaultMesh>& graph,
         DefaultMesh& obj,
         arma::fvec &dist_score,
         arma::fvec &norm_score,
         arma::fvec &color_score)
 {
-    double* data = data_.get();
-    arma::mat data_mat(data,label_number_,pix_number_,false,true);
+    double* data = cut.data_.get();
+    arma::mat data_mat(data,cut.label_number_,cut.pix_number_,false,true);
     arma::vec score;
 //    arma::fvec n_score(norm_score.size(),arma::fill::ones);
 //    arma::fvec d_score(dist_score.size(),arma::fill::ones);
 //    arma::fvec c_score(color_score.size(),arma::fill::ones);
-    if(!config_->has("GC_color_var"))graph.match2(obj,dist_score,norm_score,color_score,score,config_->getDouble("GC_distance_threshold"));
-    else graph.match2(obj,dist_score,norm_score,color_score,score,config_->getDouble("GC_distance_threshold"),config_->getDouble("GC_color_var"));
+    if(!has_color_var_)graph.match2(obj,dist_score,norm_score,color_score,score,distance_threshold_);
+    else graph.match2(obj,dist_score,norm_score,color_score,score,distance_threshold_,color_var_);
     score /= graph.voxel_centers.n_cols;
     data_mat.row(l) = score.t();
     if(!data_mat.row(l).is_finite())
@@ -244,10 +284,10 @@ void GraphCutThread::prepareDataForLabel(uint32_t l,
     }
 }
 
-void GraphCutThread::prepareDataForUnknown()
+void GraphCutThread::prepareDataForUnknown(FrameCut& cut)
 {
-//    MeshBundle<DefaultMesh>& m = *meshes_[current_frame_];
-    arma::mat data((double*)data_.get(),label_number_,pix_number_,false,true);
+//    MeshBundle<DefaultMesh>& m = *meshes_[cut.frame_];
+    arma::mat data((double*)cut.data_.get(),cut.label_number_,cut.pix_number_,false,true);
 //    if(!data.is_finite())
 //    {
 //        std::cerr<<"infinite in data"<<std::endl;
@@ -265,9 +305,9 @@ void GraphCutThread::prepareDataForUnknown()
     data.row(0).fill(0.0);
 }
 
-void GraphCutThread::normalizeData()
+void GraphCutThread::normalizeData(FrameCut& cut)
 {
-    arma::mat data((double*)data_.get(),label_number_,pix_number_,false,true);
+    arma::mat data((double*)cut.data_.get(),cut.label_number_,cut.pix_number_,false,true);
 //    arma::vec row_max = arma::max(data,1);
 //    #pragma omp for
 //    for(size_t i=0 ; i < label_number_ ; ++i )
@@ -275,8 +315,8 @@ void GraphCutThread::normalizeData()
 //        if( row_max(i) !=0 )data.row(i) /= row_max(i);
 //    }
     arma::rowvec col_sum = arma::sum(data);
-    #pragma omp for
-    for(size_t i=0 ; i < pix_number_ ; ++i )
+    #pragma omp parallel for
+    for(size_t i=0 ; i < cut.pix_number_ ; ++i )
     {
         if( col_sum(i) !=0 )data.col(i) /= col_sum(i);
     }
@@ -286,56 +326,55 @@ void GraphCutThread::normalizeData()
 //    arma::uvec choosen_i = sorted_i.head(unknown_num);
 //    unknown_data(choosen_i).fill(1.0);
 //    data.row(0) = unknown_data;
-    data = arma::mat(label_number_,pix_number_,arma::fill::ones) - data;
+    data = arma::mat(cut.label_number_,cut.pix_number_,arma::fill::ones) - data;
 //    unknown_data = data.row(0);
 //    unknown_data(choosen_i).fill(std::numeric_limits<double>::max());
 //    data.row(0) = unnkown_data;
-    data *= config_->getDouble("GC_global_data_weight");
+    data *= data_weight_;
     if(!data.is_finite())
     {
         std::cerr<<"infinite in data after normalized"<<std::endl;
     }
 }
 
-bool GraphCutThread::prepareDataTermPixWise()
+bool GraphCutThread::prepareDataTermPixWise(FrameCut& cut)
 {
-    MeshBundle<DefaultMesh>& m = *meshes_[current_frame_];
     try{
-        data_.reset(new double[label_number_*pix_number_]);
+        cut.data_.reset(new double[cut.label_number_*cut.pix_number_],std::default_delete<double[]>());
     }catch(std::bad_alloc& e)
     {
         std::cerr<<"prepareDataTermLabelWise:bad_alloc cought:"<<e.what()<<std::endl;
     }
-    arma::mat data_mat((double*)data_.get(),label_number_,pix_number_,false,true);
+    arma::mat data_mat((double*)cut.data_.get(),cut.label_number_,cut.pix_number_,false,true);
     data_mat.fill(std::numeric_limits<float>::max());
-    for( uint32_t pix = 0 ; pix < pix_number_ ; ++pix )
+    for( uint32_t pix = 0 ; pix < cut.pix_number_ ; ++pix )
     {
-        prepareDataForPix(pix,data_mat);
+        prepareDataForPix(cut,pix,data_mat);
 //        std::cerr<<"done data for pix "<<pix<<std::endl;
     }
-    data_mat *= config_->getDouble("GC_global_data_weight");
+    data_mat *= data_weight_;
     if(!data_mat.is_finite())
     {
         std::cerr<<"infinite in data term"<<std::endl;
     }
-    current_data_.reset(new DataCost(data_.get()));
+    cut.data_cost_.reset(new DataCost(cut.data_.get()));
     return true;
 }
 
-void GraphCutThread::prepareDataForPix(uint32_t pix, arma::mat& data_mat)
+void GraphCutThread::prepareDataForPix(FrameCut& cut,uint32_t pix, arma::mat& data_mat)
 {
     data_mat(0,pix) = std::numeric_limits<float>::max();
     for( uint32_t oidx = 0 ; oidx < objects_.size() ; ++oidx )
     {
         ObjModel& model = *objects_[oidx];
-        ObjModel::T::Ptr s_ptr = model.GeoT_[current_frame_];
+        ObjModel::T::Ptr s_ptr = model.GeoT_[cut.frame_];
         if(s_ptr && 0 < s_ptr.use_count())
         {
             arma::fmat sR(s_ptr->R,3,3,false,true);
             arma::fvec st(s_ptr->t,3,false,true);
             double object_data;
 //            std::cerr<<"matchPix("<<pix<<")toObject("<<oidx<<")"<<std::endl;
-            matchPixtoObject(pix,oidx,sR,st,object_data);
+            matchPixtoObject(cut,pix,oidx,sR,st,object_data);
             if(object_data<std::numeric_limits<float>::max())
             {
                 arma::vec frame_data(meshes_.size(),arma::fill::zeros);
@@ -349,7 +388,7 @@ void GraphCutThread::prepareDataForPix(uint32_t pix, arma::mat& data_mat)
                         arma::fvec tt(t_ptr->t,3,false,true);
                         arma::fmat R = arma::inv(tR)*sR;
                         arma::fvec t = arma::inv(tR)*(st-tt);
-                        matchPixtoFrame(pix,fidx,R,t,frame_data_ptr[fidx]);
+                        matchPixtoFrame(cut,pix,fidx,R,t,frame_data_ptr[fidx]);
                     }
                 }
                 double tmp_data = object_data + arma::max(frame_data);
@@ -373,6 +412,7 @@ void GraphCutThread::prepareDataForPix(uint32_t pix, arma::mat& data_mat)
 }
 using namespace  nanoflann;
 void GraphCutThread::matchPixtoObject(
+        FrameCut& cut,
         uint32_t pix,
         uint32_t objIdx,
         const arma::fmat &R,
@@ -381,8 +421,8 @@ void GraphCutThread::matchPixtoObject(
         )
 {
 //    std::cerr<<"1"<<std::endl;
-    if(current_frame_>meshes_.size())throw std::logic_error("current_frame_>meshes_.size()");
-    MeshBundle<DefaultMesh>& source = *meshes_[current_frame_];
+    if(cut.frame_>meshes_.size())throw std::logic_error("cut.frame_>meshes_.size()");
+    MeshBundle<DefaultMesh>& source = *meshes_[cut.frame_];
     if(objIdx>objects_.size())throw std::logic_error("objIdx>objects_.size()");
     ObjModel & target = *objects_[objIdx];
     arma::Mat<uint8_t> target_color(
@@ -394,16 +434,10 @@ void GraphCutThread::matchPixtoObject(
                 target.GeoM_->mesh_.n_vertices(),false,true
                 );
 //    std::cerr<<"2"<<std::endl;
-    if(objIdx>obj_trees_.size()){
+    if(objIdx>=obj_trees_.size()){
         std::cerr<<"objIdx:"<<objIdx<<std::endl;
         std::cerr<<"obj_trees_.size():"<<obj_trees_.size()<<std::endl;
-        throw std::logic_error("objIdx>obj_trees_.size()");
-    }
-    if(objIdx==obj_trees_.size())
-    {
-        obj_tree_interface_.emplace_back(new MTInterface(target.GeoM_->mesh_));
-        obj_trees_.emplace_back(new MeshTree(3,*obj_tree_interface_.back(),KDTreeSingleIndexAdaptorParams(2)));
-        obj_trees_.back()->buildIndex();
+        throw std::logic_error("objIdx>=obj_trees_.size()");
     }
     MeshTree& kdtree = *obj_trees_[objIdx];
     arma::fvec source_point = R*source.graph_.voxel_centers.col(pix) + t;
@@ -412,7 +446,7 @@ void GraphCutThread::matchPixtoObject(
     float dist;
 //    std::cerr<<source_point.t()<<std::endl;
     kdtree.knnSearch(source_point.memptr(),1,&indice,&dist);
-    if(dist>1.1*config_->getFloat("GC_distance_threshold"))
+    if(dist>1.1*distance_threshold_)
     {
         score = std::numeric_limits<float>::max();
         return ;
@@ -429,12 +463,13 @@ void GraphCutThread::matchPixtoObject(
     arma::fvec target_n = target_norm.col(indice);
     double norm_similarity = std::abs(arma::dot(source_n,target_n));
 //    if(dist>config_->getFloat("GC_distance_threshold"))score = std::numeric_limits<float>::max();
-    score = target.DistP_(indice)*( 1 + dist / config_->getFloat("GC_distance_threshold") );
+    score = target.DistP_(indice)*( 1 + dist / distance_threshold_ );
     if(!std::isfinite(score))score = std::numeric_limits<float>::max();
     if(score > std::numeric_limits<float>::max())score =  std::numeric_limits<float>::max();
 }
 
 void GraphCutThread::matchPixtoFrame(
+        FrameCut& cut,
         uint32_t pix,
         uint32_t frameIdx,
         const arma::fmat &R,
@@ -443,15 +478,9 @@ void GraphCutThread::matchPixtoFrame(
         )
 {
 //    std::cerr<<"1"<<std::endl;
-    MeshBundle<DefaultMesh>& source = *meshes_[current_frame_];
+    MeshBundle<DefaultMesh>& source = *meshes_[cut.frame_];
     MeshBundle<DefaultMesh>& target = *meshes_[frameIdx];
-    if( frameIdx > mesh_trees_.size() )throw std::logic_error("frameIdx>mesh_trees_.size()");
-    if( frameIdx == mesh_trees_.size() )
-    {
-        mesh_tree_interface_.emplace_back(new ATInterface(target.graph_.voxel_centers));
-        mesh_trees_.emplace_back(new ArmaTree(3,*mesh_tree_interface_.back(),KDTreeSingleIndexAdaptorParams(2)));
-        mesh_trees_.back()->buildIndex();
-    }
+    if( frameIdx >= mesh_trees_.size() )throw std::logic_error("frameIdx>=mesh_trees_.size()");
 //    std::cerr<<"2"<<std::endl;
     ArmaTree& kdtree = *mesh_trees_[frameIdx];
     arma::uword indice;
@@ -477,7 +506,7 @@ void GraphCutThread::matchPixtoFrame(
         return;
     }
     //occlude target
-    if(proj_dist > 0.5*std::sqrt(config_->getFloat("GC_distance_threshold")))
+    if(proj_dist > 0.5*std::sqrt(distance_threshold_))
     {
         score = std::numeric_limits<float>::max();
         return;
@@ -490,10 +519,11 @@ void GraphCutThread::matchPixtoFrame(
 }
 
 
-bool GraphCutThread::prepareSmoothTerm(Segmentation::GraphCut& gc)
+bool GraphCutThread::prepareSmoothTerm(FrameCut& cut)
 {
-    MeshBundle<DefaultMesh>& m = *meshes_[current_frame_];
-    smooth_.clear();
+    MeshBundle<DefaultMesh>& m = *meshes_[cut.frame_];
+    arma::sp_mat& smooth_ = cut.smooth_;
+    const uint32_t pix_number_ = cut.pix_number_;
     smooth_ = arma::sp_mat(pix_number_,pix_number_);
     for( size_t idx = 0 ; idx < m.graph_.voxel_neighbors.n_cols ; ++idx )
     {
@@ -503,36 +533,35 @@ bool GraphCutThread::prepareSmoothTerm(Segmentation::GraphCut& gc)
         if(pix2>=pix_number_)throw std::logic_error("pix2>=pix_number_");
         if( pix1 < pix2 )
         {
-            if(!config_->has("GC_color_var"))smooth_(pix1,pix2) = m.graph_.voxel_similarity2(pix1,pix2);
-            else smooth_(pix1,pix2) = m.graph_.voxel_similarity2(pix1,pix2,config_->getDouble("GC_distance_threshold"),config_->getDouble("GC_color_var"));
+            if(!has_color_var_)smooth_(pix1,pix2) = m.graph_.voxel_similarity2(pix1,pix2);
+            else smooth_(pix1,pix2) = m.graph_.voxel_similarity2(pix1,pix2,distance_threshold_,color_var_);
         }else{
-            if(!config_->has("GC_color_var"))smooth_(pix2,pix1) = m.graph_.voxel_similarity2(pix1,pix2);
-            else smooth_(pix2,pix1) = m.graph_.voxel_similarity2(pix1,pix2,config_->getDouble("GC_distance_threshold"),config_->getDouble("GC_color_var"));
+            if(!has_color_var_)smooth_(pix2,pix1) = m.graph_.voxel_similarity2(pix1,pix2);
+            else smooth_(pix2,pix1) = m.graph_.voxel_similarity2(pix1,pix2,distance_threshold_,color_var_);
         }
     }
-    smooth_ *= config_->getDouble("GC_global_smooth_weight");
-    current_smooth_.reset(new SmoothnessCost(GraphCutThread::fnCost));
-    if(config_->has("GC_show_smooth")&&1==config_->getInt("GC_show_smooth"))
+    smooth_ *= smooth_weight_;
+    cut.smooth_cost_.reset(new SmoothnessCost(GraphCutThread::fnCost,(void*)&cut));
+    if(show_smooth_)
     {
-        showSmooth();
-        if(config_->has("GC_show_smooth_sec"))
-        {
-            QThread::sleep(config_->getInt("GC_show_smooth_sec"));
-        }else QThread::sleep(1);
+        showSmooth(cut);
+        QThread::sleep(show_smooth_sec_);
     }
     return true;
 }
 
-MRF::CostVal GraphCutThread::fnCost(int pix1,int pix2,MRF::Label i,MRF::Label j)
+MRF::CostVal GraphCutThread::fnCost(int pix1,int pix2,MRF::Label i,MRF::Label j,void* cut)
 {
+    const arma::sp_mat& smooth = ((const FrameCut*)cut)->smooth_;
     if(i==j)return 0.0;
-    else if(pix1<pix2)return smooth_(pix1,pix2);
-    else return smooth_(pix2,pix1);
+    else if(pix1<pix2)return smooth(pix1,pix2);
+    else return smooth(pix2,pix1);
 }
 
-bool GraphCutThread::prepareNeighbors(Segmentation::GraphCut& gc)
+bool GraphCutThread::prepareNeighbors(FrameCut& cut,Segmentation::GraphCut& gc)
 {
-    MeshBundle<DefaultMesh>& m = *meshes_[current_frame_];
+    MeshBundle<DefaultMesh>& m = *meshes_[cut.frame_];
+    const uint32_t pix_number_ = cut.pix_number_;
     double w_eps = 1.0 / double( m.mesh_.n_vertices() );
     for( size_t idx = 0 ; idx < m.graph_.voxel_neighbors.n_cols ; ++idx )
     {
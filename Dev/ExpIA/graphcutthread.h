@@ -21,6 +21,18 @@ public:
             3,arma::uword> ArmaTree;
     typedef MeshKDTreeInterface<DefaultMesh> MTInterface;
     typedef ArmaKDTreeInterface<arma::fmat> ATInterface;
+    //everything that belongs to the cut of one frame,
+    //it is handed to the cost callback so that frames can be cut concurrently
+    struct FrameCut
+    {
+        uint32_t frame_;
+        uint32_t label_number_;
+        uint32_t pix_number_;
+        std::shared_ptr<double> data_;
+        std::shared_ptr<DataCost> data_cost_;
+        arma::sp_mat smooth_;
+        std::shared_ptr<SmoothnessCost> smooth_cost_;
+    };
     GraphCutThread(
             MeshBundle<DefaultMesh>::PtrList&inputmesh,
             std::vector<ObjModel::Ptr>& inputobj,
@@ -29,7 +41,6 @@ public:
             ):QThread(parent),meshes_(inputmesh),objects_(inputobj),outputs_(outputlabels)
     {
         setObjectName("GraphCutThread");
-        current_frame_ = 0;
     }
 
 public:
@@ -39,13 +50,15 @@ signals:
     void sendMatch(int,MeshBundle<DefaultMesh>::Ptr);
 protected:
     void run(void);
+    void cutFrame(uint32_t frame);
     void showMatch(size_t,DefaultMesh&);
-    void showData(size_t);
-    void showSmooth();
+    void showData(FrameCut&,size_t);
+    void showSmooth(FrameCut&);
 
     /*match object model to get data term*/
-    bool prepareDataTermLabelWise();
+    bool prepareDataTermLabelWise(FrameCut&);
     void prepareDataForLabel(
+            FrameCut&,
             uint32_t l,
             VoxelGraph<DefaultMesh>& graph,
             DefaultMesh& obj,
@@ -53,13 +66,14 @@ protected:
             arma::fvec &norm_score,
             arma::fvec &color_score
             );
-    void prepareDataForUnknown();
-    void normalizeData();
+    void prepareDataForUnknown(FrameCut&);
+    void normalizeData(FrameCut&);
 
     /*match transformation through object model to data term to get data term*/
-    bool prepareDataTermPixWise();
-    void prepareDataForPix(uint32_t,arma::mat&);
+    bool prepareDataTermPixWise(FrameCut&);
+    void prepareDataForPix(FrameCut&,uint32_t,arma::mat&);
     void matchPixtoObject(
+            FrameCut&,
             uint32_t pix,
             uint32_t objIdx,
             const arma::fmat &R,
@@ -67,6 +81,7 @@ protected:
             double& score
             );
     void matchPixtoFrame(
+            FrameCut&,
             uint32_t pix,
             uint32_t frameIdx,
             const arma::fmat &R,
@@ -74,20 +89,13 @@ protected:
             double& score
          );
 
-    std::shared_ptr<double> data_;
-    std::shared_ptr<DataCost> current_data_;
-
-    bool prepareSmoothTerm(Segmentation::GraphCut&);
-    std::shared_ptr<SmoothnessCost> current_smooth_;
-    static MRF::CostVal fnCost(int pix1,int pix2,MRF::Label i,MRF::Label j);
-    static arma::sp_mat smooth_;
+    bool prepareSmoothTerm(FrameCut&);
+    static MRF::CostVal fnCost(int pix1,int pix2,MRF::Label i,MRF::Label j,void* cut);
 
-    bool prepareNeighbors(Segmentation::GraphCut&);
+    bool prepareNeighbors(FrameCut&,Segmentation::GraphCut&);
 
 protected:
-    uint32_t current_frame_;
-    uint32_t label_number_;
-    uint32_t pix_number_;
+    //trees are all built before the frames are cut and only searched afterwards
     std::vector<std::shared_ptr<ArmaTree>> mesh_trees_;
     std::vector<std::shared_ptr<ATInterface>> mesh_tree_interface_;
     std::vector<std::shared_ptr<MeshTree>> obj_trees_;
@@ -97,7 +105,18 @@ private:
     std::vector<ObjModel::Ptr>& objects_;
     std::vector<arma::uvec>& outputs_;
     Config::Ptr config_;
-    QTime timer;
+    //configuration is read once so that the frames do not query it concurrently
+    bool label_wise_;
+    int iter_num_;
+    double data_weight_;
+    double smooth_weight_;
+    double distance_threshold_;
+    bool has_color_var_;
+    double color_var_;
+    bool show_match_;
+    bool show_data_;
+    bool show_smooth_;
+    int show_smooth_sec_;
 };
 
 #endif // GRAPHCUTTHREAD_H
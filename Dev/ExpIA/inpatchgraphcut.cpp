@@ -72,7 +72,7 @@ void InPatchGraphCut::for_each_frame(void)
         {
             std::cerr<<"Failed to prepare smooth term"<<std::endl;
         }
-        gc.init(Segmentation::GraphCut::EXPANSION);
+        gc.init(Segmentation::GraphCut::DYNAMIC_EXPANSION);
 //        std::cerr<<"prepareNeighbors()"<<std::endl;
         if(!prepareNeighbors(gc))
         {
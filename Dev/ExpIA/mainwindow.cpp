@@ -122,6 +122,7 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->actionLAPACKE_dggsvd,SIGNAL(triggered(bool)),this,SLOT(LAPACKE_dggsvd_test()));
     connect(ui->actionInside_Bounding_Box,SIGNAL(triggered(bool)),this,SLOT(Inside_BBox_test()));
     connect(ui->actionAGD_test,SIGNAL(triggered(bool)),this,SLOT(agd_test()));
+    connect(ui->actionDynamic_Expansion_test,SIGNAL(triggered(bool)),this,SLOT(dynamic_expansion_test()));
     connect(ui->actionJRCS_Plate,SIGNAL(triggered(bool)),this,SLOT(jrcs_plate_test()));
     connect(ui->actionJRCS_Cube,SIGNAL(triggered(bool)),this,SLOT(jrcs_cube_test()));
 
@@ -153,6 +154,7 @@ void MainWindow::open_inputs()
         tr("../Dev_Data/"),
         tr(
         "PLY Files (*.ply);;"
+        "Bundle Files (*.bundle);;"
         "OBJ Files (*.obj);;"
         "OFF Files (*.off);;"
         "STL Files (*.stl);;"
@@ -187,10 +189,21 @@ void MainWindow::open_inputs(QStringList&fileNames)
     {
         ui->statusBar->showMessage(tr("Loading:")+fname,5);
         inputs_.push_back(std::make_shared<MeshBundle<DefaultMesh>>());
-        open_mesh(inputs_.back()->mesh_,fname.toStdString());
         QFileInfo info(fname);
+        if( info.suffix() == "bundle" )
+        {
+            arma::uvec label;
+            if(!inputs_.back()->load(fname.toStdString(),label))
+            {
+                std::cerr<<"can't load: "<<fname.toStdString()<<std::endl;
+            }
+            if(label.size()!=inputs_.back()->mesh_.n_vertices())label = arma::uvec(inputs_.back()->mesh_.n_vertices(),arma::fill::zeros);
+            labels_.push_back(label);
+        }else{
+            open_mesh(inputs_.back()->mesh_,fname.toStdString());
+            labels_.emplace_back(inputs_.back()->mesh_.n_vertices(),arma::fill::zeros);
+        }
         inputs_.back()->name_ = info.completeBaseName().toStdString();
-        labels_.emplace_back(inputs_.back()->mesh_.n_vertices(),arma::fill::zeros);
         QApplication::processEvents();
     }
 }
@@ -213,9 +226,19 @@ void MainWindow::save_aligned()
     }
     std::string path = dirName.toStdString();
     MeshBundle<DefaultMesh>::PtrList::iterator iter;
-    for(iter=inputs_.begin();iter!=inputs_.end();++iter)
+    size_t index = 0;
+    for(iter=inputs_.begin();iter!=inputs_.end();++iter,++index)
     {
         MeshBundle<DefaultMesh>::Ptr ptr = *iter;
+        if(config_->has("bundle"))
+        {
+            const arma::uvec label = index < labels_.size() ? labels_[index] : arma::uvec();
+            if(!ptr->save(path+"/"+ptr->name_+".bundle",label)){
+                std::cerr<<"can't save to:"<<path+"/"+ptr->name_+".bundle"<<std::endl;
+                return;
+            }
+            continue;
+        }
         if(!OpenMesh::IO::write_mesh(ptr->mesh_,path+"/"+ptr->name_+".ply",opt,13)){
             std::cerr<<"can't save to:"<<path+"/"+ptr->name_+".ply"<<std::endl;
             return;
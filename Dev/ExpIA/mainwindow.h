@@ -125,6 +125,7 @@ protected slots:
     void LAPACKE_dggsvd_test(void){TEST::LAPACKE_dggsvd_test();}
     void Inside_BBox_test(void){TEST::Inside_BBox_test();}
     void agd_test(void){TEST::agd_test();}
+    void dynamic_expansion_test(void){TEST::dynamic_expansion_test();}
     void jrcs_plate_test(void){TEST::jrcs_plate_test();}
     void jrcs_cube_test(void){TEST::jrcs_cube_test();}
 
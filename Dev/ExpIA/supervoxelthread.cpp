@@ -38,6 +38,7 @@ void SupervoxelThread::run(void)
         svc.getCentroidNormals(input->graph_.voxel_normals);
         svc.getSizes(input->graph_.voxel_size);
         svc.getSupervoxelAdjacency(input->graph_.voxel_neighbors);
+        input->graph_.build_adjacency();
     }
     QString msg;
     int ms = timer_.elapsed();
@@ -10,6 +10,8 @@
 #include "voxelgraph.h"
 #include "voxelgraph.hpp"
 #include "jrcsplatedialog.h"
+#include "MRF/include/DynamicExpansion.h"
+#include <random>
 namespace TEST {
 void LAPACKE_dggsvd_test()
 {
@@ -91,6 +93,92 @@ void agd_test()
     std::cerr<<"agd_vec:"<<std::endl;
     std::cerr<<adg_vec<<std::endl;
 }
+//costs of the function variant of dynamic_expansion_test
+static std::vector<MRF::CostVal> de_data_;
+static int de_label_num_;
+static MRF::CostVal de_data_fn(int pix,MRF::Label l)
+{
+    return de_data_[pix*de_label_num_+l];
+}
+//symmetric in the pixel pair as the expansion moves assume
+static MRF::CostVal de_smooth_fn(int p,int q,MRF::Label l1,MRF::Label l2)
+{
+    if( l1 == l2 )return 0.0;
+    const int lo = std::min(p,q);
+    const int hi = std::max(p,q);
+    return ( 1.0 + ( lo*7 + hi*13 ) % 5 )*std::min(std::abs(l1-l2),2);
+}
+//every move of DynamicExpansion against the same move of Expansion on random graphs
+//with array and function costs, each graph is solved again with new data costs
+//so that the residuals and the labeling of the last solve are reused
+void dynamic_expansion_test()
+{
+    std::mt19937 gen(1);
+    DynamicGraph graph;
+    int fails = 0;
+    double max_rel = 0.0;
+    for(int trial = 0 ; trial < 20 ; ++trial )
+    {
+        const int N = 20 + gen()%300;
+        de_label_num_ = 2 + gen()%6;
+        const int L = de_label_num_;
+        const bool fn = ( 1 == trial%2 );
+        std::vector<std::pair<int,int>> edges;
+        std::vector<MRF::CostVal> weights;
+        for(int i = 0 ; i < N ; ++i )for(int k = 0 ; k < 3 ; ++k )
+        {
+            const int j = gen()%N;
+            if( j == i )continue;
+            edges.emplace_back(i,j);
+            weights.push_back( ( gen()%100 ) / 10.0 );
+        }
+        std::vector<MRF::CostVal> V(L*L);
+        for(int a = 0 ; a < L ; ++a )for(int b = 0 ; b < L ; ++b )V[a*L+b] = ( a == b ) ? 0.0 : 3.0 + ( a + b )%3 ;
+        for(int solve = 0 ; solve < 3 ; ++solve )
+        {
+            de_data_.resize(N*L);
+            for(size_t i = 0 ; i < de_data_.size() ; ++i )de_data_[i] = ( gen()%1000 ) / 10.0;
+            std::shared_ptr<DataCost> dc( fn ? new DataCost(de_data_fn) : new DataCost(de_data_.data()) );
+            std::shared_ptr<SmoothnessCost> sc( fn ? new SmoothnessCost(de_smooth_fn) : new SmoothnessCost(V.data()) );
+            EnergyFunction eng(dc.get(),sc.get());
+            DynamicExpansion dyn(N,L,&eng,&graph);
+            Expansion ref(N,L,&eng);
+            for(size_t e = 0 ; e < edges.size() ; ++e )
+            {
+                dyn.setNeighbors(edges[e].first,edges[e].second,weights[e]);
+                ref.setNeighbors(edges[e].first,edges[e].second,weights[e]);
+            }
+            dyn.initialize();
+            ref.initialize();
+            dyn.clearAnswer();
+            //the same edges as last time, only the data costs changed
+            const bool kept = graph.end();
+            if( kept != ( solve > 0 ) )
+            {
+                ++fails;
+                std::cerr<<"trial "<<trial<<" solve "<<solve<<": residuals kept "<<kept<<std::endl;
+            }
+            if(kept)graph.restore(dyn.getAnswerPtr());
+            for(int it = 0 ; it < 4*L ; ++it )
+            {
+                const int label = gen()%L;
+                for(int i = 0 ; i < N ; ++i )ref.setLabel(i,dyn.getLabel(i));
+                const double e_dyn = dyn.alpha_expansion(label);
+                const double e_ref = ref.alpha_expansion(label);
+                const double rel = std::abs( e_dyn - e_ref ) / ( 1.0 + std::abs(e_ref) );
+                max_rel = std::max(max_rel,rel);
+                if( rel > 1e-6 )
+                {
+                    ++fails;
+                    std::cerr<<"trial "<<trial<<" solve "<<solve<<" move "<<it<<": "<<e_dyn<<" vs "<<e_ref<<std::endl;
+                }
+            }
+            graph.store(dyn.getAnswerPtr());
+        }
+    }
+    if( 0 == fails )std::cerr<<"Success in dynamic_expansion_test() max relative difference "<<max_rel<<std::endl;
+    else std::cerr<<"Fail in dynamic_expansion_test() "<<fails<<" mismatches"<<std::endl;
+}
 void jrcs_plate_test()
 {
     JRCSPlateDialog dialog;
@@ -4,6 +4,7 @@ namespace TEST{
 void LAPACKE_dggsvd_test();
 void Inside_BBox_test();
 void agd_test();
+void dynamic_expansion_test();
 void jrcs_plate_test();
 void jrcs_cube_test();
 }
@@ -5,17 +5,8 @@
 bool UnifyLabelThread::configure(Config::Ptr config)
 {
     config_ = config;
-    if(!config_->has("Color_Space"))return false;
-    if("RGB"==config_->getString("Color_Space"))
-    {
-        if(!config_->has("RGB_r_bin_num"))return false;
-        if(!config_->has("RGB_g_bin_num"))return false;
-        if(!config_->has("RGB_b_bin_num"))return false;
-    }else if("Lab"==config_->getString("Color_Space")){
-        if(!config_->has("Lab_L_bin_num"))return false;
-        if(!config_->has("Lab_a_bin_num"))return false;
-        if(!config_->has("Lab_b_bin_num"))return false;
-    }else return false;
+    if(!extractor_.configure(config_))return false;
+    feature_dim_ = config_->has("Feature_dim") ? config_->getInt("Feature_dim") : 0 ;
     return true;
 }
 
@@ -43,45 +34,11 @@ void UnifyLabelThread::run()
 
 void UnifyLabelThread::extract_patch_features()
 {
-    input_patch_label_value_.clear();
-    patch_features_.clear();
-    MeshBundle<DefaultMesh>::PtrList::iterator iter;
-    size_t lindex = 0;
-    int feature_dim;
-    for(iter=inputs_.begin();iter!=inputs_.end();++iter)
-    {
-        MeshBundle<DefaultMesh>::Ptr input = *iter;
-        arma::uword label_value = 1;
-        arma::uword label_max = arma::max(labels_[lindex]);
-        while( label_value <= label_max )
-        {
-            arma::uvec extracted_label = arma::find( label_value == labels_[lindex] );
-            DefaultMesh extracted_mesh;
-            if(!extracted_label.is_empty())
-            {
-                extractMesh<DefaultMesh,DefaultMesh>(input->mesh_,extracted_label,extracted_mesh);
-                arma::vec feature;
-                extract_patch_feature(extracted_mesh,feature,config_);
-                feature_dim = feature.size();
-                if( input_patch_label_value_.size() <= lindex )
-                {
-                    input_patch_label_value_.emplace_back(1);
-                    input_patch_label_value_.back()[0] = label_value;
-                    patch_features_.emplace_back(feature.size(),1);
-                    patch_features_.back().col(0) = feature;
-                }else{
-                    input_patch_label_value_.back().insert_cols(0,1);
-                    input_patch_label_value_.back()[0] = label_value;
-                    patch_features_.back().insert_cols(0,feature);
-                }
-            }
-            ++ label_value;
-        }
-        ++lindex;
-    }
+    extractor_.extract(inputs_,labels_,input_patch_label_value_,patch_features_);
+    int feature_dim = extractor_.dim();
     //reduce dimension
-    int custom_dim = config_->getInt("Feature_dim");
-    if(config_->has("Feature_dim")){
+    int custom_dim = feature_dim_;
+    if(custom_dim>0){
         if( feature_dim > custom_dim )
         {
             if(feature_base_.is_empty())
@@ -131,7 +88,8 @@ void UnifyLabelThread::learn()
     size_t feature_dim = 2; //default to reduce dimension to 2
     std::vector<arma::mat>::iterator fiter;
     size_t index = 0;
-    arma::mat data;
+    //the frames are passed to the k-means as blocks instead of being stacked
+    Feature::OnlineGMM::BlockLst blocks;
     for(fiter=patch_features_.begin();fiter!=patch_features_.end();++fiter)
     {
         if((*fiter).n_cols>max_patch_num)
@@ -139,28 +97,43 @@ void UnifyLabelThread::learn()
             max_patch_num=(*fiter).n_cols;
             max_patch_num_index = index;
         }
-        data = arma::join_rows(data,*fiter);
+        if((*fiter).n_cols>0)
+        {
+            feature_dim = (*fiter).n_rows;
+            blocks.push_back(&(*fiter));
+        }
         ++index;
     }
-    feature_dim = data.n_rows;
     if(!check_centers()){
         std::cerr<<"choose frame "<<max_patch_num_index<<" with "<<max_patch_num<<"patches as clustering center"<<std::endl;
         feature_centers_ = patch_features_[max_patch_num_index];
     }
-    gmm_.reset(feature_centers_.n_rows,feature_centers_.n_cols);
-    gmm_.set_means(feature_centers_);
-    arma::mat dcovs(feature_dim,gmm_.n_gaus());
-    dcovs.each_col() = arma::var(data,0,1);
+    arma::mat dcovs(feature_dim,feature_centers_.n_cols);
+    dcovs.each_col() = Feature::OnlineGMM::variance(blocks);
     dcovs += std::numeric_limits<double>::epsilon();
-    gmm_.set_dcovs(dcovs);
-    gmm_.learn(data,max_patch_num,arma::eucl_dist,arma::keep_existing,20,0,1e-10,true);
+    arma::rowvec hefts(feature_centers_.n_cols);
+    hefts.fill(1.0/double(feature_centers_.n_cols));
+    //same as gmm_diag::learn with 20 k-means iterations, no EM and a variance floor of 1e-10
+    Feature::OnlineGMM engine;
+    engine.set_mode(Feature::OnlineGMM::HARD);
+    engine.set_var_floor(1e-10);
+    engine.init(feature_centers_,dcovs,hefts);
+    for(int iter = 0 ; iter < 20 ; ++iter )
+    {
+        engine.clear_stats();
+        for(Feature::OnlineGMM::BlockLst::const_iterator biter=blocks.cbegin();biter!=blocks.cend();++biter)
+        {
+            engine.accumulate(**biter);
+        }
+        if( 0.0 == engine.maximize() )break;
+    }
+    engine.to(gmm_);
     feature_centers_ = gmm_.means;
 }
 
 bool UnifyLabelThread::check_centers()
 {
-    int custom_dim = config_->getInt("Feature_dim");
-    if(feature_centers_.n_rows!=custom_dim)return false;
+    if(feature_centers_.n_rows!=feature_dim_)return false;
     if(feature_centers_.n_cols<2)return false;
     return true;
 }
@@ -194,6 +167,7 @@ void UnifyLabelThread::assign(
     arma::uvec feature_indices = arma::linspace<arma::uvec>(0,N_feature-1,N_feature);
 //    std::cerr<<"0"<<std::endl;
     label_value = arma::urowvec(N_feature,arma::fill::zeros);
+    if(0==N_feature)return;
 //    std::cerr<<"1"<<std::endl;
     for( size_t gindex = 0 ; gindex < gmm_.n_gaus() ; ++gindex )
     {
@@ -2,6 +2,7 @@
 #define UNIFYLABELCOLORSIZETHREAD_H
 #include <QThread>
 #include "common.h"
+#include "featurecore.h"
 #include <armadillo>
 class UnifyLabelThread:public QThread
 {
@@ -14,7 +15,7 @@ public:
             std::vector<arma::uvec>& outputs,
             arma::mat& base,
             arma::mat& center
-            ):inputs_(inputs),labels_(outputs),feature_base_(base),feature_centers_(center)
+            ):inputs_(inputs),labels_(outputs),feature_base_(base),feature_centers_(center),feature_dim_(0)
     {
         setObjectName("UnifyLabelThread");
     }
@@ -41,6 +42,8 @@ private:
     std::vector<arma::mat> patch_features_;//each column is a feature vector for a patch
     std::vector<arma::urowvec> input_patch_label_value_;
     Config::Ptr config_;
+    PatchFeatureExtractor extractor_;
+    int feature_dim_;//0 if the feature is not reduced
     arma::gmm_diag gmm_;
 };
 
@@ -9,10 +9,14 @@ QT       -= gui
 TARGET = FeatureCore
 TEMPLATE = lib
 CONFIG += c++11
+QMAKE_CXXFLAGS += -fopenmp
+LIBS += -lgomp -lpthread
 DEFINES += FEATURECORE_LIBRARY
 
 SOURCES += featurecore.cpp \
-    pointnormal.cpp
+    pointnormal.cpp \
+    spectral.cpp \
+    onlinegmm.cpp
 
 HEADERS += featurecore.h\
         featurecore_global.h \
@@ -28,10 +32,12 @@ HEADERS += featurecore.h\
     agd.hpp \
     hks.h \
     hks.hpp \
+    spectral.h \
     bof.h \
     bof.hpp \
     gdcoord.h \
-    gdcoord.hpp
+    gdcoord.hpp \
+    onlinegmm.h
 
 unix {
     target.path = /usr/lib
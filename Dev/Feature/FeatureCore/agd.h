@@ -9,9 +9,9 @@ class AGD
 public:
     class Pair{
     public:
-        Pair(uint16_t f,uint16_t s,double d):first_(f),second_(s),dist_(d){}
-        uint16_t first_;
-        uint16_t second_;
+        Pair(uint32_t f,uint32_t s,double d):first_(f),second_(s),dist_(d){}
+        uint32_t first_;
+        uint32_t second_;
         double dist_;
         bool operator < (const Pair &a) const {
             return dist_ > a.dist_;//little first
@@ -13,77 +13,62 @@ void AGD<Mesh>::extract(const Mesh&,arma::vec&)
 template<typename Mesh>
 void AGD<Mesh>::extract(const VoxelGraph<Mesh>& graph , arma::vec& agd)
 {
+    if(!graph.has_adjacency())
+    {
+        VoxelGraph<Mesh> g(graph);
+        g.build_adjacency();
+        extract(g,agd);
+        return;
+    }
     arma::uword N = graph.voxel_centers.n_cols;
-    arma::mat gd(N,N,arma::fill::zeros);
-    gd.fill(std::numeric_limits<float>::max());
-    gd.diag().zeros();
-    std::priority_queue<Pair> to_be_update;
-    for(uint32_t index=0;index<graph.voxel_neighbors.n_cols;++index)
+    //edge length for each entry of the CSR adjacency
+    arma::vec w(graph.voxel_adj_indices.size());
+    #pragma omp parallel for
+    for( int i = 0 ; i < int(N) ; ++i )
     {
-        arma::uword i = graph.voxel_neighbors(0,index);
-        arma::uword j = graph.voxel_neighbors(1,index);
-        double dist = arma::norm(graph.voxel_centers.col(i) - graph.voxel_centers.col(j));
-        to_be_update.emplace(i,j,dist);
-        gd(i,j) = dist;
-        gd(j,i) = dist;
+        for(uint32_t k = graph.voxel_adj_offsets(i) ; k < graph.voxel_adj_offsets(i+1) ; ++k )
+        {
+            w(k) = arma::norm(graph.voxel_centers.col(i) - graph.voxel_centers.col(graph.voxel_adj_indices(k)));
+        }
     }
-    while(!to_be_update.empty())
+    //Dijkstra from each voxel, only one row of geodesic distance is kept per thread
+    agd = arma::vec(N,arma::fill::zeros);
+    bool unconnected = false;
+    #pragma omp parallel reduction(||:unconnected)
     {
-        assert( to_be_update.size() < N*N*N );
-        arma::uword i = to_be_update.top().first_;
-        arma::uword j = to_be_update.top().second_;
-        double dist = gd(i,j);
-        to_be_update.pop();
-        arma::uword update_index = 0;
-        while(update_index<N)
+        arma::vec gd(N);
+        std::priority_queue<Pair> q;
+        #pragma omp for
+        for( int s = 0 ; s < int(N) ; ++s )
         {
-//            std::cerr<<"update_index:"<<update_index<<std::endl;
-            if( (update_index==i) || (update_index==j) ){
-                ++update_index;
-                continue;
-            }
-            double gdi = gd(update_index,i);
-            double gdj = gd(update_index,j);
-            if( gdi < double(std::numeric_limits<float>::max()) )
+            gd.fill(std::numeric_limits<float>::max());
+            gd(s) = 0.0;
+            q.emplace(s,s,0.0);
+            while(!q.empty())
             {
-                if( ( gdi + dist ) < gdj ){
-                    gd(update_index,j) = ( gdi + dist );
-                    gd(j,update_index) = ( gdi + dist );
-                    if( update_index < j )
+                uint32_t u = q.top().second_;
+                double dist = q.top().dist_;
+                q.pop();
+                if( dist > gd(u) )continue;
+                for(uint32_t k = graph.voxel_adj_offsets(u) ; k < graph.voxel_adj_offsets(u+1) ; ++k )
+                {
+                    uint32_t v = graph.voxel_adj_indices(k);
+                    double d = dist + w(k);
+                    if( d < gd(v) )
                     {
-                        to_be_update.emplace(update_index,j,gdi+dist);
-                    }else{
-                        to_be_update.emplace(j,update_index,gdi+dist);
-                    }
-                }
-            }else if( gdj < double(std::numeric_limits<float>::max()) )
-            {
-                if( ( gdj + dist ) < gdi ){
-                    gd(update_index,i) = ( gdj + dist );
-                    gd(i,update_index) = ( gdj + dist );
-                    if( update_index < i )
-                    {
-                        to_be_update.emplace(update_index,i,gdj+dist);
-                    }else{
-                        to_be_update.emplace(i,update_index,gdj+dist);
+                        gd(v) = d;
+                        q.emplace(s,v,d);
                     }
                 }
             }
-            ++update_index;
+            arma::uvec mi = arma::find(gd>0);
+            if(!mi.empty())agd(s) = double(arma::mean(gd(mi)));
+            if(gd.max() == std::numeric_limits<float>::max())unconnected = true;
         }
     }
-    if(gd.max() == std::numeric_limits<float>::max())
+    if(unconnected)
     {
         std::cerr<<"Unconnected parts exist"<<std::endl;
-        gd.save("./debug/gd.mat.arma",arma::raw_ascii);
-    }
-    agd = arma::vec(gd.n_rows,arma::fill::zeros);
-    #pragma omp parallel for
-    for( uint32_t r = 0 ; r < gd.n_rows ; ++r )
-    {
-        arma::rowvec rr = gd.row(r);
-        arma::uvec mi = arma::find(rr>0);
-        if(!mi.empty())agd(r) = double(arma::mean(rr(mi)));
     }
 }
 template<typename Mesh>
@@ -93,7 +78,7 @@ void AGD<Mesh>::extract_slow(const VoxelGraph<Mesh>& graph , arma::vec& agd)
     arma::mat gd(N,N,arma::fill::zeros);
     gd.fill(std::numeric_limits<float>::max());
     gd.diag().zeros();
-    std::queue<std::pair<uint16_t,uint16_t>> to_be_update;
+    std::queue<std::pair<uint32_t,uint32_t>> to_be_update;
     for(uint32_t index=0;index<graph.voxel_neighbors.n_cols;++index)
     {
         arma::uword i = graph.voxel_neighbors(0,index);
@@ -101,7 +86,7 @@ void AGD<Mesh>::extract_slow(const VoxelGraph<Mesh>& graph , arma::vec& agd)
         float dist = arma::norm(graph.voxel_centers.col(i) - graph.voxel_centers.col(j));
         gd(i,j) = dist;
         gd(j,i) = dist;
-        to_be_update.push(std::make_pair<uint16_t,uint16_t>(i,j));
+        to_be_update.push(std::make_pair<uint32_t,uint32_t>(i,j));
     }
     while(!to_be_update.empty())
     {
@@ -121,9 +106,9 @@ void AGD<Mesh>::extract_slow(const VoxelGraph<Mesh>& graph , arma::vec& agd)
                     gd(j,update_index) = ( gdi + dist );
                     if( update_index < j )
                     {
-                        to_be_update.push(std::make_pair<uint16_t,uint16_t>(update_index,j));
+                        to_be_update.push(std::make_pair<uint32_t,uint32_t>(update_index,j));
                     }else{
-                        to_be_update.push(std::make_pair<uint16_t,uint16_t>(j,update_index));
+                        to_be_update.push(std::make_pair<uint32_t,uint32_t>(j,update_index));
                     }
                 }
             }else if( gdj < std::numeric_limits<float>::max() )
@@ -133,9 +118,9 @@ void AGD<Mesh>::extract_slow(const VoxelGraph<Mesh>& graph , arma::vec& agd)
                     gd(i,update_index) = ( gdj + dist );
                     if( update_index < i )
                     {
-                        to_be_update.push(std::make_pair<uint16_t,uint16_t>(update_index,i));
+                        to_be_update.push(std::make_pair<uint32_t,uint32_t>(update_index,i));
                     }else{
-                        to_be_update.push(std::make_pair<uint16_t,uint16_t>(i,update_index));
+                        to_be_update.push(std::make_pair<uint32_t,uint32_t>(i,update_index));
                     }
                 }
             }
@@ -164,7 +149,7 @@ void AGD<Mesh>::extract_hash(const VoxelGraph<Mesh>& graph,arma::vec& agd)
     arma::mat gd(N,N,arma::fill::zeros);
     gd.fill(std::numeric_limits<float>::max());
     gd.diag().zeros();
-    QMultiHash<uint16_t,uint16_t> hash;
+    QMultiHash<uint32_t,uint32_t> hash;
     for(uint32_t index=0;index<graph.voxel_neighbors.n_cols;++index)
     {
         arma::uword i = graph.voxel_neighbors(0,index);
@@ -176,8 +161,8 @@ void AGD<Mesh>::extract_hash(const VoxelGraph<Mesh>& graph,arma::vec& agd)
         hash.insert(j,i);
     }
     std::queue<Pair> to_be_update;
-    uint16_t i = hash.keys().first();
-    uint16_t j = hash.values(i).first();
+    uint32_t i = hash.keys().first();
+    uint32_t j = hash.values(i).first();
     if(i<j)to_be_update.emplace(i,j,gd(i,j));
     else if(j<i)to_be_update.emplace(j,i,gd(j,i));
     while(!to_be_update.empty())
@@ -187,9 +172,9 @@ void AGD<Mesh>::extract_hash(const VoxelGraph<Mesh>& graph,arma::vec& agd)
         double dist = gd(i,j);
         to_be_update.pop();
         //expand to i's neighbor
-        for(QMultiHash<uint16_t,uint16_t>::iterator iter = hash.find(i);iter!=hash.end() && iter.key()==i ;++iter)
+        for(QMultiHash<uint32_t,uint32_t>::iterator iter = hash.find(i);iter!=hash.end() && iter.key()==i ;++iter)
         {
-            uint16_t& m = *iter;
+            uint32_t& m = *iter;
             if(m==j)continue;
             double sumd = dist + gd(i,m);
             if( gd(j,m) == std::numeric_limits<float>::max() )
@@ -209,9 +194,9 @@ void AGD<Mesh>::extract_hash(const VoxelGraph<Mesh>& graph,arma::vec& agd)
             }
         }
         //expand to j's neighbor
-        for(QMultiHash<uint16_t,uint16_t>::iterator iter = hash.find(j);iter!=hash.end() && iter.key()==j;++iter)
+        for(QMultiHash<uint32_t,uint32_t>::iterator iter = hash.find(j);iter!=hash.end() && iter.key()==j;++iter)
         {
-            uint16_t& m = *iter;
+            uint32_t& m = *iter;
             if(m==i)continue;
             double sumd = dist + gd(j,m);
             if( gd(i,m) == std::numeric_limits<float>::max() )
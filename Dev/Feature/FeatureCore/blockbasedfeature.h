@@ -8,6 +8,8 @@ class BlockBasedFeature
 public:
     BlockBasedFeature();
     void extract(const Mesh&,arma::vec&);
+    //points is a 3xN matrix, e.g. the gathered points of one patch
+    void extract(arma::fmat& points,arma::vec&);
 };
 }
 #endif // BLOCKBASEDFEATURE_H
@@ -8,11 +8,16 @@ BlockBasedFeature<Mesh>::BlockBasedFeature()
 }
 template<typename Mesh>
 void BlockBasedFeature<Mesh>::extract(const Mesh& mesh, arma::vec& feature)
+{
+    arma::fmat points((float*)mesh.points(),3,mesh.n_vertices(),false,true);
+    extract(points,feature);
+}
+template<typename Mesh>
+void BlockBasedFeature<Mesh>::extract(arma::fmat& points, arma::vec& feature)
 {
     feature = arma::vec(12,arma::fill::zeros);
-    size_t N = mesh.n_vertices();
+    size_t N = points.n_cols;
     assert(N>2);
-    arma::fmat points((float*)mesh.points(),3,N,false,true);
     arma::fmat box;
     get3DMBB(points,2,box);
     //length width height
@@ -2,6 +2,7 @@
 #define BOF_H
 #include "common.h"
 #include "featurecore.h"
+#include "onlinegmm.h"
 /***********************
  * Bag of Feature
  */
@@ -18,6 +19,9 @@ public:
     inline void set_size(const arma::uword& size){codebook_size_=size;}
     void extract(const arma::mat& f,const arma::uvec& l,arma::mat& h);//for a frame
     void learn(const MatPtrLst& f, const LabelLst& l, MatPtrLst &h);
+    //refine the code book with the features of new frames instead of learning it again
+    //the assignment and idf of learn() are not updated
+    void update_code_book(const MatPtrLst& f);
     inline const arma::mat gmm_mean(void)const{ return gmm_.means;}
     inline const VecLst& idf(void)const{return idf_;}
     inline const std::vector<arma::uvec>& assignment()const{return assignment_;}
@@ -26,6 +30,8 @@ protected:
 private:
     arma::uword codebook_size_;
     arma::gmm_diag gmm_;
+    OnlineGMM online_;
+    arma::uword seen_num_;
     VecLst idf_;
     arma::vec g_idf_;
     std::vector<arma::uvec> assignment_;
@@ -3,10 +3,13 @@ namespace Feature {
 BOF::BOF()
 {
     codebook_size_ = 48;
+    seen_num_ = 0;
+    online_.set_mode(OnlineGMM::HARD);
 }
 bool BOF::configure(Config::Ptr config)
 {
     config_ = config;
+    if(config_->has("BOF_batch_size"))online_.set_batch_size(config_->getInt("BOF_batch_size"));
     return true;
 }
 void BOF::extract(const arma::mat& f,const arma::uvec& l,arma::mat& h)
@@ -16,7 +19,8 @@ void BOF::extract(const arma::mat& f,const arma::uvec& l,arma::mat& h)
     h = arma::mat(codebook_size_, label_max - label_min + 1 );
     //calculate idf
     arma::vec idf(gmm_.n_gaus(),arma::fill::zeros);
-    arma::urowvec r = gmm_.assign(f,arma::eucl_dist);
+    arma::urowvec r;
+    online_.assign(f,r,OnlineGMM::EUCL);
     arma::mat counts(gmm_.n_gaus(),label_max,arma::fill::zeros);
     idf = arma::vec(gmm_.n_gaus(),arma::fill::zeros);
     for( arma::uword i=0 ; i < r.n_cols ; ++i )
@@ -46,9 +50,33 @@ void BOF::extract(const arma::mat& f,const arma::uvec& l,arma::mat& h)
     tf.each_col()%=idf;
 }
 
-void BOF::learn(const MatPtrLst& f,const LabelLst& l,MatPtrLst& h)
+void BOF::learn_code_book(const MatPtrLst& f)
 {
     //learn code book by k-means
+    if(config_&&config_->has("BOF_codebook_mode")&&config_->getString("BOF_codebook_mode")=="Online")
+    {
+        //the frames are streamed one block at a time and never stacked
+        OnlineGMM::BlockLst blocks;
+        seen_num_ = 0;
+        for(MatPtrLst::const_iterator iter=f.cbegin() ; iter!=f.cend() ; ++iter )
+        {
+            blocks.push_back(iter->get());
+            seen_num_ += (*iter)->n_cols;
+        }
+        int epoch = 1;
+        if(config_->has("BOF_epoch"))epoch = config_->getInt("BOF_epoch");
+        online_.init(blocks,codebook_size_);
+        for(int e = 0 ; e < epoch ; ++e )
+        {
+            for(OnlineGMM::BlockLst::const_iterator iter=blocks.cbegin();iter!=blocks.cend();++iter)
+            {
+                online_.step(**iter);
+            }
+        }
+        online_.to(gmm_);
+        std::cerr<<"Online code book from "<<seen_num_<<" features"<<std::endl;
+        return;
+    }
     arma::uword num = 0;
     arma::uword dim;
     arma::uvec start(f.size(),arma::fill::zeros);
@@ -67,6 +95,28 @@ void BOF::learn(const MatPtrLst& f,const LabelLst& l,MatPtrLst& h)
         data.cols(start(i),start(i)+f[i]->n_cols - 1) = *f[i];
     }
     gmm_.learn(data,codebook_size_,arma::eucl_dist,arma::random_subset,50,0,1e-12,true);
+    seen_num_ = num;
+    online_.init(gmm_.means,gmm_.dcovs,gmm_.hefts,seen_num_);
+}
+
+void BOF::update_code_book(const MatPtrLst& f)
+{
+    if( 0 == online_.n_gaus() )
+    {
+        learn_code_book(f);
+        return;
+    }
+    for(MatPtrLst::const_iterator iter=f.cbegin() ; iter!=f.cend() ; ++iter )
+    {
+        online_.step(**iter);
+        seen_num_ += (*iter)->n_cols;
+    }
+    online_.to(gmm_);
+}
+
+void BOF::learn(const MatPtrLst& f,const LabelLst& l,MatPtrLst& h)
+{
+    learn_code_book(f);
     //calculate idf
     arma::uword label_max = 0;
     LabelLst::const_iterator liter = l.cbegin();
@@ -84,7 +134,9 @@ void BOF::learn(const MatPtrLst& f,const LabelLst& l,MatPtrLst& h)
     for(MatPtrLst::const_iterator iter = f.cbegin() ; iter != f.cend() ; ++iter )
     {
         arma::uvec &r = assignment_[index];
-        r = gmm_.assign(**iter,arma::eucl_dist).t();
+        arma::urowvec rr;
+        online_.assign(**iter,rr,OnlineGMM::EUCL);
+        r = rr.t();
         arma::mat counts(gmm_.n_gaus(),label_max,arma::fill::zeros);
         idf_[index] = arma::vec(gmm_.n_gaus(),arma::fill::zeros);
         for( arma::uword i=0 ; i < r.n_cols ; ++i )
@@ -114,7 +166,8 @@ void BOF::learn(const MatPtrLst& f,const LabelLst& l,MatPtrLst& h)
     for(MatPtrLst::const_iterator iter = f.cbegin() ; iter != f.cend() ; ++iter )
     {
         h[index].reset(new arma::mat(gmm_.n_gaus(),label_max,arma::fill::zeros));
-        arma::urowvec r = gmm_.assign(**iter,arma::eucl_dist);
+        arma::urowvec r;
+        online_.assign(**iter,r,OnlineGMM::EUCL);
         arma::mat& tf = (*h[index]);
         arma::rowvec word_num(label_max,arma::fill::ones);
         for( arma::uword i=0 ; i < r.n_cols ; ++i )
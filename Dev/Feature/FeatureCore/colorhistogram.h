@@ -16,6 +16,8 @@ public:
     void extract(const Mesh&,arma::vec&);
     void extract(const Mesh&,arma::fvec&);
     void extract(const Mesh&,std::vector<double>&hist);
+    //rgb is a 3xN matrix, e.g. the gathered colors of one patch
+    void extract(const arma::Mat<uint8_t>& rgb,arma::vec&);
 protected:
     inline uint64_t indexL(float L)
     {
@@ -49,6 +51,8 @@ public:
     void extract(const Mesh&,arma::vec&);
     void extract(const Mesh&,arma::fvec&);
     void extract(const Mesh&,std::vector<double>&hist);
+    //rgb is a 3xN matrix, e.g. the gathered colors of one patch
+    void extract(const arma::Mat<uint8_t>& rgb,arma::vec&);
 protected:
     inline uint64_t indexr(float r)
     {
@@ -17,9 +17,13 @@ ColorHistogramLab<Mesh>::ColorHistogramLab(
 template<typename Mesh>
 void ColorHistogramLab<Mesh>::extract(const Mesh&m,arma::vec&hist)
 {
-    hist = arma::vec( (NL_+ 1)*(Na_+1)*(Nb_+1) ,arma::fill::ones);
-
     arma::Mat<uint8_t> rgb_mat((uint8_t*)m.vertex_colors(),3,m.n_vertices(),false,true);
+    extract(rgb_mat,hist);
+}
+template<typename Mesh>
+void ColorHistogramLab<Mesh>::extract(const arma::Mat<uint8_t>& rgb_mat,arma::vec&hist)
+{
+    hist = arma::vec( (NL_+ 1)*(Na_+1)*(Nb_+1) ,arma::fill::ones);
     arma::fmat Lab_mat;
     ColorArray::RGB2Lab(rgb_mat,Lab_mat);
     for( size_t index = 0 ; index < Lab_mat.n_cols ; ++index )
@@ -90,8 +94,13 @@ void ColorHistogramRGB<Mesh>::extract(const Mesh&m,std::vector<double>&hist)
 template<typename Mesh>
 void ColorHistogramRGB<Mesh>::extract(const Mesh&m,arma::vec&hist)
 {
-    hist = arma::vec( Nr_*Ng_*Nb_ ,arma::fill::ones);
     arma::Mat<uint8_t> rgb_mat((uint8_t*)m.vertex_colors(),3,m.n_vertices(),false,true);
+    extract(rgb_mat,hist);
+}
+template<typename Mesh>
+void ColorHistogramRGB<Mesh>::extract(const arma::Mat<uint8_t>& rgb_mat,arma::vec&hist)
+{
+    hist = arma::vec( Nr_*Ng_*Nb_ ,arma::fill::ones);
     arma::fmat frgb_mat = arma::conv_to<arma::fmat>::from(rgb_mat);
     for( size_t index = 0 ; index < frgb_mat.n_cols ; ++index )
     {
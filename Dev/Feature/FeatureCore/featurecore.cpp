@@ -6,6 +6,169 @@
 #include "hks.hpp"
 #include "bof.hpp"
 #include "gdcoord.hpp"
+PatchFeatureExtractor::PatchFeatureExtractor():
+    rgb_(true),hist_dim_(0),height_w_(1.0),length_width_w_(1.0),color_hist_w_(1.0)
+{
+    bins_[0] = 0;
+    bins_[1] = 0;
+    bins_[2] = 0;
+}
+
+bool PatchFeatureExtractor::configure(Config::Ptr config)
+{
+    if(!config->has("Color_Space"))return false;
+    if("RGB"==config->getString("Color_Space"))
+    {
+        if(!config->has("RGB_r_bin_num")||!config->has("RGB_g_bin_num")||!config->has("RGB_b_bin_num"))return false;
+        rgb_ = true;
+        bins_[0] = config->getInt("RGB_r_bin_num");
+        bins_[1] = config->getInt("RGB_g_bin_num");
+        bins_[2] = config->getInt("RGB_b_bin_num");
+        hist_dim_ = bins_[0]*bins_[1]*bins_[2];
+    }else if("Lab"==config->getString("Color_Space")){
+        if(!config->has("Lab_L_bin_num")||!config->has("Lab_a_bin_num")||!config->has("Lab_b_bin_num"))return false;
+        rgb_ = false;
+        bins_[0] = config->getInt("Lab_L_bin_num");
+        bins_[1] = config->getInt("Lab_a_bin_num");
+        bins_[2] = config->getInt("Lab_b_bin_num");
+        hist_dim_ = (bins_[0]+1)*(bins_[1]+1)*(bins_[2]+1);
+    }else return false;
+    height_w_ = config->has("Feature_height_w") ? config->getFloat("Feature_height_w") : 1.0 ;
+    length_width_w_ = config->has("Feature_length_width_w") ? config->getFloat("Feature_length_width_w") : 1.0 ;
+    color_hist_w_ = config->has("Feature_color_hist_w") ? config->getFloat("Feature_color_hist_w") : 1.0 ;
+    return true;
+}
+
+void PatchFeatureExtractor::group(
+        const arma::uvec& label,
+        arma::urowvec& label_value,
+        arma::uvec& offsets,
+        arma::uvec& indices
+        )
+{
+    const arma::uword L = label.is_empty() ? 0 : arma::max(label);
+    arma::uvec count(L+1,arma::fill::zeros);
+    for(arma::uword i=0;i<label.size();++i)++count(label(i));
+    arma::uword P = 0;
+    for(arma::uword l=1;l<=L;++l)if(count(l)>0)++P;
+    label_value = arma::urowvec(P);
+    offsets = arma::uvec(P+1);
+    //count becomes the write position of each label
+    arma::uword p = 0;
+    arma::uword pos = 0;
+    for(arma::uword l=1;l<=L;++l)
+    {
+        if(0==count(l))continue;
+        label_value(p) = l;
+        offsets(p) = pos;
+        pos += count(l);
+        count(l) = offsets(p);
+        ++p;
+    }
+    offsets(P) = pos;
+    indices = arma::uvec(pos);
+    for(arma::uword i=0;i<label.size();++i)
+    {
+        const arma::uword l = label(i);
+        if(l>0)indices(count(l)++) = i;
+    }
+}
+
+void PatchFeatureExtractor::sort(const DefaultMesh&mesh,const arma::uvec& indices,arma::fmat& points,arma::Mat<uint8_t>& colors)
+{
+    const arma::fmat mesh_points((float*)mesh.points(),3,mesh.n_vertices(),false,true);
+    const arma::Mat<uint8_t> mesh_colors((uint8_t*)mesh.vertex_colors(),3,mesh.n_vertices(),false,true);
+    points = mesh_points.cols(indices);
+    colors = mesh_colors.cols(indices);
+}
+
+void PatchFeatureExtractor::extract(arma::fmat& points,arma::Mat<uint8_t>& colors,arma::uword first,arma::uword n,double* feature)const
+{
+    assert(n>0);
+    //views on the columns of the patch, nothing is copied
+    arma::fmat patch_points(points.colptr(first),3,n,false,true);
+    arma::Mat<uint8_t> patch_colors(colors.colptr(first),3,n,false,true);
+    arma::vec block_feature;
+    {
+        Feature::BlockBasedFeature<DefaultMesh> block_feature_extractor;
+        block_feature_extractor.extract(patch_points,block_feature);
+    }
+    assert(block_feature.is_finite());
+    arma::vec hist;
+    if(rgb_)
+    {
+        Feature::ColorHistogramRGB<DefaultMesh> color_hist_extractor(bins_[0],bins_[1],bins_[2]);
+        color_hist_extractor.extract(patch_colors,hist);
+    }else{
+        Feature::ColorHistogramLab<DefaultMesh> color_hist_extractor(bins_[0],bins_[1],bins_[2]);
+        color_hist_extractor.extract(patch_colors,hist);
+    }
+    assert(hist.is_finite());
+    block_feature(0) *= length_width_w_;
+    block_feature(1) *= length_width_w_;
+    block_feature(2) *= height_w_;
+    arma::vec out(feature,dim(),false,true);
+    out.head(hist_dim_) = color_hist_w_*hist;
+    out.tail(12) = block_feature;
+}
+
+void PatchFeatureExtractor::extract(
+        const DefaultMesh& mesh,
+        const arma::uvec& label,
+        arma::urowvec& label_value,
+        arma::mat& features
+        )const
+{
+    arma::uvec offsets,indices;
+    group(label,label_value,offsets,indices);
+    arma::fmat points;
+    arma::Mat<uint8_t> colors;
+    sort(mesh,indices,points,colors);
+    features = arma::mat(dim(),label_value.size());
+    #pragma omp parallel for schedule(dynamic)
+    for(int p=0;p<label_value.size();++p)
+    {
+        extract(points,colors,offsets(p),offsets(p+1)-offsets(p),features.colptr(p));
+    }
+}
+
+void PatchFeatureExtractor::extract(
+        const MeshBundle<DefaultMesh>::PtrList& inputs,
+        const std::vector<arma::uvec>& labels,
+        std::vector<arma::urowvec>& label_values,
+        std::vector<arma::mat>& features
+        )const
+{
+    assert(inputs.size()==labels.size());
+    const int F = inputs.size();
+    label_values.resize(F);
+    features.resize(F);
+    std::vector<arma::uvec> offsets(F);
+    std::vector<arma::fmat> points(F);
+    std::vector<arma::Mat<uint8_t>> colors(F);
+    #pragma omp parallel for
+    for(int f=0;f<F;++f)
+    {
+        arma::uvec indices;
+        group(labels[f],label_values[f],offsets[f],indices);
+        sort(inputs[f]->mesh_,indices,points[f],colors[f]);
+        features[f] = arma::mat(dim(),label_values[f].size());
+    }
+    //one flat list of patches so that frames with few patches do not leave threads idle
+    std::vector<std::pair<int,arma::uword>> patches;
+    for(int f=0;f<F;++f)
+    {
+        for(arma::uword p=0;p<label_values[f].size();++p)patches.emplace_back(f,p);
+    }
+    #pragma omp parallel for schedule(dynamic)
+    for(int i=0;i<patches.size();++i)
+    {
+        const int f = patches[i].first;
+        const arma::uword p = patches[i].second;
+        extract(points[f],colors[f],offsets[f](p),offsets[f](p+1)-offsets[f](p),features[f].colptr(p));
+    }
+}
+
 void extract_patch_feature(DefaultMesh&mesh,arma::vec&feature,Config::Ptr config_)
 {
 //    std::cerr<<"0"<<std::endl;
@@ -19,4 +19,49 @@ template class FEATURECORESHARED_EXPORT Feature::AGD<DefaultMesh>; //Average Geo
 template class FEATURECORESHARED_EXPORT Feature::HKS<DefaultMesh>;
 template class FEATURECORESHARED_EXPORT Feature::GDCoord<DefaultMesh>;
 void FEATURECORESHARED_EXPORT extract_patch_feature(DefaultMesh&, arma::vec&, Config::Ptr);
+//the same feature as extract_patch_feature for every labeled patch of a frame at once
+//points are bucketed by label in one counting sort pass and the frame is permuted once into that order,
+//each patch is then read in place as a contiguous range of columns,
+//patches ( and frames ) are extracted in parallel into a preallocated feature matrix
+class FEATURECORESHARED_EXPORT PatchFeatureExtractor
+{
+public:
+    PatchFeatureExtractor();
+    //reads the color space, bin numbers and weights once
+    bool configure(Config::Ptr);
+    arma::uword dim(void)const{return hist_dim_ + 12;}
+    //label 0 is left out, label_value(i) is the label of the patch in features.col(i) ( ascending )
+    void extract(
+            const DefaultMesh&,
+            const arma::uvec& label,
+            arma::urowvec& label_value,
+            arma::mat& features
+            )const;
+    void extract(
+            const MeshBundle<DefaultMesh>::PtrList&,
+            const std::vector<arma::uvec>& labels,
+            std::vector<arma::urowvec>& label_values,
+            std::vector<arma::mat>& features
+            )const;
+    //counting sort of the point indices by label
+    //indices.subvec(offsets(i),offsets(i+1)-1) are the points of label_value(i)
+    static void group(
+            const arma::uvec& label,
+            arma::urowvec& label_value,
+            arma::uvec& offsets,
+            arma::uvec& indices
+            );
+protected:
+    //points and colors of the mesh in the order of indices
+    static void sort(const DefaultMesh&,const arma::uvec& indices,arma::fmat& points,arma::Mat<uint8_t>& colors);
+    //feature of the columns [first,first+n) of the sorted points and colors written to feature[0,dim())
+    void extract(arma::fmat& points,arma::Mat<uint8_t>& colors,arma::uword first,arma::uword n,double* feature)const;
+private:
+    bool rgb_;
+    uint64_t bins_[3];
+    arma::uword hist_dim_;
+    double height_w_;
+    double length_width_w_;
+    double color_hist_w_;
+};
 #endif // FEATURECORE_H
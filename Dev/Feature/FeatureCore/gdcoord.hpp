@@ -18,19 +18,25 @@ template<typename Mesh>
 void GDCoord<Mesh>::extract(const VoxelGraph<Mesh>& graph, const arma::uvec& axis_index ,arma::fmat& feature)
 {
     std::cerr<<"GDCoord<Mesh>::extract()"<<std::endl;
+    if(!graph.has_adjacency())
+    {
+        VoxelGraph<Mesh> g(graph);
+        g.build_adjacency();
+        extract(g,axis_index,feature);
+        return;
+    }
     if(feature.n_rows!=axis_index.size()||feature.n_cols!=graph.size())feature = arma::fmat(axis_index.size(),graph.size());
     feature.fill( std::numeric_limits<float>::max() - 1.0 );
     arma::uvec axis = axis_index - 1;
-    //build connected matrix
+    //edge length for each entry of the CSR adjacency
     size_t N = graph.size();
-    arma::sp_fmat w(N,N);
-    for(uint32_t index=0;index < graph.voxel_neighbors.n_cols;++index)
+    arma::fvec w(graph.voxel_adj_indices.size());
+    for(size_t i = 0 ; i < N ; ++i )
     {
-        arma::uword i = graph.voxel_neighbors(0,index);
-        arma::uword j = graph.voxel_neighbors(1,index);
-        float dist = arma::norm(graph.voxel_centers.col(i) - graph.voxel_centers.col(j));
-        w(i,j) = dist;
-        w(j,i) = dist;
+        for(uint32_t k = graph.voxel_adj_offsets(i) ; k < graph.voxel_adj_offsets(i+1) ; ++k )
+        {
+            w(k) = arma::norm(graph.voxel_centers.col(i) - graph.voxel_centers.col(graph.voxel_adj_indices(k)));
+        }
     }
     arma::uword dim = axis.size();
     std::cerr<<"dim:"<<dim<<std::endl;
@@ -58,11 +64,12 @@ void GDCoord<Mesh>::extract(const VoxelGraph<Mesh>& graph, const arma::uvec& axi
             if(cd.visited_)
                 continue;
             cd.visited_ = true;
-            for(int v = 0; v < N; v++)
+            for(uint32_t k = graph.voxel_adj_offsets(u) ; k < graph.voxel_adj_offsets(u+1) ; ++k )
             {
-                if(v != u && !d[v].visited_ && w(u,v) != 0 && (*d[v].dist_) > ( *d[u].dist_ + w(u,v) ))
+                uint32_t v = graph.voxel_adj_indices(k);
+                if(!d[v].visited_ && w(k) != 0 && (*d[v].dist_) > ( *d[u].dist_ + w(k) ))
                 {
-                    (*d[v].dist_) = (*d[u].dist_ + w(u,v));
+                    (*d[v].dist_) = (*d[u].dist_ + w(k));
                     q.push(d[v]);
                 }
             }
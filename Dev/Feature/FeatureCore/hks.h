@@ -19,6 +19,10 @@ public:
 protected:
     double d_scale_;
     double convex_scale_;
+    //number of eigenpairs kept for the signature
+    arma::uword eig_num_;
+    //Laplacians up to this size are decomposed densely, larger ones by shift-invert
+    arma::uword dense_limit_;
     inline double distanceAffinity(double x1, double y1, double x2, double y2,double scale)
     {
         return -((x1-x2)*(x1-x2)+(y1-y2)*(y1-y2))/scale;
@@ -39,14 +43,11 @@ protected:
         else if(dif>eps)return 1.0;
         else return 0.5*dif/eps+0.5;
     }
-    void constructL(const typename MeshBundle<Mesh>::Ptr);
-    void constructL(const typename MeshBundle<Mesh>::Ptr,const arma::uvec&);
-    void decomposeL();
-    void computeHKS(arma::mat&);
-private:
-    arma::sp_mat W_;
-    arma::vec lambda_;
-    arma::mat eig_vec_;
+    void constructL(const typename MeshBundle<Mesh>::Ptr,arma::sp_mat&);
+    void constructL(const typename MeshBundle<Mesh>::Ptr,const arma::uvec&,arma::sp_mat&);
+    void constructL(const VoxelGraph<Mesh>&,arma::sp_mat&);
+    bool decomposeL(const arma::sp_mat&,arma::vec&,arma::mat&);
+    void computeHKS(const arma::vec&,const arma::mat&,arma::mat&);
 };
 }
 #endif // HKS_H
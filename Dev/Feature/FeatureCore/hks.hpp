@@ -1,4 +1,5 @@
 #include "hks.h"
+#include "spectral.h"
 #include <armadillo>
 namespace Feature{
 template<typename Mesh>
@@ -6,6 +7,8 @@ HKS<Mesh>::HKS()
 {
     d_scale_ = 9e-4;
     convex_scale_ = 0.01;
+    eig_num_ = 200;
+    dense_limit_ = 1000;
 }
 template<typename Mesh>
 bool HKS<Mesh>::configure(Config::Ptr config)
@@ -15,9 +18,12 @@ bool HKS<Mesh>::configure(Config::Ptr config)
 template<typename Mesh>
 void HKS<Mesh>::extract(const typename MeshBundle<Mesh>::Ptr m,arma::mat& f)
 {
-    constructL(m);
-    decomposeL();
-    computeHKS(f);
+    arma::sp_mat L;
+    arma::vec lambda;
+    arma::mat eig_vec;
+    constructL(m,L);
+    if(!decomposeL(L,lambda,eig_vec))return;
+    computeHKS(lambda,eig_vec,f);
 }
 template<typename Mesh>
 void HKS<Mesh>::extract(const typename MeshBundle<Mesh>::PtrList m,MatPtrLst& f)
@@ -37,36 +43,48 @@ template<typename Mesh>
 void HKS<Mesh>::extract(const typename MeshBundle<Mesh>::Ptr m,const arma::uvec& l,arma::mat& f)
 {
     f = arma::mat(6,m->graph_.size(),arma::fill::zeros);
-    arma::uword label = 1;
-    arma::uword max = arma::max(l);
-    arma::uvec index;
-    while( label <= max )
+    arma::urowvec label_value;
+    arma::uvec offsets;
+    arma::uvec indices;
+    PatchFeatureExtractor::group(l,label_value,offsets,indices);
+    const arma::uword P = label_value.size();
+    std::vector<arma::mat> patch_f(P);
+    std::vector<arma::uvec> vox_index(P);
+    //ARPACK is not reentrant, so the patches too large for a dense decomposition
+    //only get their Laplacian here and are decomposed one by one afterwards
+    std::vector<arma::sp_mat> large_L(P);
+    #pragma omp parallel for schedule(dynamic)
+    for(int64_t p = 0 ; p < int64_t(P) ; ++p )
     {
-        index = arma::find( label == l );
-        if( index.size() < 5 ){
-            ++label;
-            if(label>max)break;
-            else continue;
+        if( offsets(p+1) - offsets(p) < 5 )continue;
+        arma::uvec index = indices.subvec(offsets(p),offsets(p+1)-1);
+        m->graph_.getSvIndex(index,vox_index[p]);
+        arma::sp_mat L;
+        constructL(m,index,L);
+        if( L.n_cols > dense_limit_ )
+        {
+            large_L[p] = L;
+            continue;
         }
-//        std::cerr<<"constructL(m,index);"<<std::endl;
-        constructL(m,index);
-//        std::cerr<<"decomposeL();"<<std::endl;
-        decomposeL();
-        arma::mat patch_f;
-//        std::cerr<<"computeHKS(patch_f);"<<std::endl;
-        computeHKS(patch_f);
-//        std::cerr<<"f.cols(index) = patch_f;"<<std::endl;
-//        std::cerr<<"n:"<<index.size()<<std::endl;
-//        std::cerr<<"n:"<<patch_f.n_cols<<std::endl;
-        arma::uvec vox_index;
-        m->graph_.getSvIndex(index,vox_index);
-//        std::cerr<<"++"<<std::endl;
-        assert(vox_index.size()==patch_f.n_cols);
-        vox_index -= 1; // the voxel label is start from one
-        f.cols(vox_index) = patch_f;
-        std::cerr<<label<<"/"<<max<<std::endl;
-        ++label;
-//        std::cerr<<"__"<<std::endl;
+        arma::vec lambda;
+        arma::mat eig_vec;
+        if(decomposeL(L,lambda,eig_vec))computeHKS(lambda,eig_vec,patch_f[p]);
+    }
+    for(arma::uword p = 0 ; p < P ; ++p )
+    {
+        if(large_L[p].is_empty())continue;
+        arma::vec lambda;
+        arma::mat eig_vec;
+        if(decomposeL(large_L[p],lambda,eig_vec))computeHKS(lambda,eig_vec,patch_f[p]);
+        large_L[p].reset();
+    }
+    //written in label order so a supervoxel shared by two patches keeps the later one
+    for(arma::uword p = 0 ; p < P ; ++p )
+    {
+        if(patch_f[p].is_empty())continue;
+        assert(vox_index[p].size()==patch_f[p].n_cols);
+        arma::uvec cols = vox_index[p] - 1; // the voxel label is start from one
+        f.cols(cols) = patch_f[p];
     }
 }
 
@@ -88,65 +106,43 @@ void HKS<Mesh>::extract(const typename MeshBundle<Mesh>::PtrList m,const LabelLs
 }
 
 template<typename Mesh>
-void HKS<Mesh>::constructL(const typename MeshBundle<Mesh>::Ptr m)
+void HKS<Mesh>::constructL(const typename MeshBundle<Mesh>::Ptr m,arma::sp_mat& L)
 {
-    const MeshBundle<Mesh>& mesh = *m;
-    const VoxelGraph<Mesh>& graph = mesh.graph_;
-    size_t N = graph.size();
-    W_ = arma::speye(N,N);
-    for(arma::Mat<uint16_t>::const_iterator niter=graph.voxel_neighbors.begin();niter!=graph.voxel_neighbors.end();   )
-    {
-        uint16_t wi = *niter;
-        ++niter;
-        uint16_t wj = *niter;
-        ++niter;
-        double affinity = vecAffinity<arma::fvec>(
-                    graph.voxel_centers.col(wi),
-                    graph.voxel_centers.col(wj),
-                    d_scale_
-                    );
-        affinity = std::exp(affinity);
-        affinity += convexity<arma::fvec>(
-                    graph.voxel_centers.col(wi),
-                    graph.voxel_normals.col(wi),
-                    graph.voxel_centers.col(wj),
-                    graph.voxel_normals.col(wj),
-                    convex_scale_
-                    );
-        W_(wi,wj) = 0.5*affinity;
-        W_(wj,wi) = W_(wi,wj);
-    }
-    arma::vec D = arma::vectorise(arma::mat(arma::sum(W_)));
-    arma::sp_mat Dmat = arma::speye<arma::sp_mat>(W_.n_rows,W_.n_cols);
-    Dmat.diag() = D;
-    W_ *= -1.0;
-    W_ += Dmat;
+    constructL(m->graph_,L);
 }
 
 template<typename Mesh>
-void HKS<Mesh>::constructL(const typename MeshBundle<Mesh>::Ptr m,const arma::uvec& index)
+void HKS<Mesh>::constructL(const typename MeshBundle<Mesh>::Ptr m,const arma::uvec& index,arma::sp_mat& L)
 {
     Mesh sub_mesh;
     typename VoxelGraph<Mesh>::Ptr graph_ptr = VoxelGraph<Mesh>::getSubGraphPtr(m->graph_,index,sub_mesh);
-    const VoxelGraph<Mesh>& graph = *graph_ptr;
+    constructL(*graph_ptr,L);
+}
+
+template<typename Mesh>
+void HKS<Mesh>::constructL(const VoxelGraph<Mesh>& graph,arma::sp_mat& L)
+{
+    if(!graph.has_adjacency())
+    {
+        VoxelGraph<Mesh> g(graph);
+        g.build_adjacency();
+        constructL(g,L);
+        return;
+    }
     size_t N = graph.size();
-    W_ = arma::speye(N,N);
-    for(arma::Mat<uint16_t>::const_iterator niter=graph.voxel_neighbors.begin();niter!=graph.voxel_neighbors.end();   )
+    size_t E = graph.voxel_neighbors.n_cols;
+    //affinity of each edge
+    arma::vec w(E);
+    #pragma omp parallel for
+    for(int e = 0 ; e < E ; ++e )
     {
-        uint16_t wi = *niter;
-        ++niter;
-        uint16_t wj = *niter;
-        ++niter;
-        assert(wi<graph.voxel_centers.n_cols);
-        assert(wj<graph.voxel_centers.n_cols);
-//        std::cerr<<"r:"<<graph.voxel_centers.n_rows<<std::endl;
-//        std::cerr<<"c:"<<graph.voxel_centers.n_cols<<std::endl;
+        uint32_t wi = graph.voxel_neighbors(0,e);
+        uint32_t wj = graph.voxel_neighbors(1,e);
         double affinity = vecAffinity<arma::fvec>(
                     graph.voxel_centers.col(wi),
                     graph.voxel_centers.col(wj),
                     d_scale_
                     );
-//        std::cerr<<"ccc"<<std::endl;
         affinity = std::exp(affinity);
         affinity += convexity<arma::fvec>(
                     graph.voxel_centers.col(wi),
@@ -155,49 +151,87 @@ void HKS<Mesh>::constructL(const typename MeshBundle<Mesh>::Ptr m,const arma::uv
                     graph.voxel_normals.col(wj),
                     convex_scale_
                     );
-//        std::cerr<<"ddd"<<std::endl;
-        W_(wi,wj) = 0.5*affinity;
-        W_(wj,wi) = W_(wi,wj);
+        w(e) = 0.5*affinity;
+    }
+    //L = D - W with W = I + affinity, filled column by column from the CSR adjacency
+    arma::uvec colptr(N+1);
+    arma::uvec rowind(graph.voxel_adj_indices.size()+N);
+    arma::vec values(graph.voxel_adj_indices.size()+N);
+    arma::uword k = 0;
+    for(size_t c = 0 ; c < N ; ++c )
+    {
+        colptr(c) = k;
+        const uint32_t* n = graph.neighbor_begin(c);
+        const uint32_t* e = graph.neighbor_edge_begin(c);
+        const uint32_t* end = graph.neighbor_end(c);
+        double d = 0.0;
+        arma::uword diag = k;
+        bool diag_done = false;
+        for( ; n != end ; ++n , ++e )
+        {
+            if( !diag_done && *n > c )
+            {
+                diag = k;
+                ++k;
+                diag_done = true;
+            }
+            rowind(k) = *n;
+            values(k) = - w(*e);
+            d += w(*e);
+            ++k;
+        }
+        if(!diag_done)
+        {
+            diag = k;
+            ++k;
+        }
+        rowind(diag) = c;
+        values(diag) = d;
     }
-    arma::vec D = arma::vectorise(arma::mat(arma::sum(W_)));
-    arma::sp_mat Dmat = arma::speye<arma::sp_mat>(W_.n_rows,W_.n_cols);
-    Dmat.diag() = D;
-    W_ *= -1.0;
-    W_ += Dmat;
+    colptr(N) = k;
+    L = arma::sp_mat(rowind,colptr,values,N,N);
 }
 
 template<typename Mesh>
-void HKS<Mesh>::decomposeL()
+bool HKS<Mesh>::decomposeL(const arma::sp_mat& L,arma::vec& lambda,arma::mat& eig_vec)
 {
-    arma::uword k = 200;
-    k = std::min(k,W_.n_cols-1);
-    bool success = false;
+    const arma::uword N = L.n_cols;
+    if( N < 2 )return false;
+    const arma::uword k = std::min(eig_num_,N-1);
+    if( N <= dense_limit_ )
+    {
+        arma::vec all_lambda;
+        arma::mat all_vec;
+        if(!arma::eig_sym(all_lambda,all_vec,arma::mat(L)))
+        {
+            std::cerr<<"Failed on dense decomposition"<<std::endl;
+            return false;
+        }
+        lambda = all_lambda.head(k);
+        eig_vec = all_vec.head_cols(k);
+        return true;
+    }
+    //L is positive semi-definite, a shift slightly below zero keeps L - sigma*I definite
+    //and its smallest eigenvalues are still the ones closest to the shift
+    const double sigma = -1e-6*std::max(arma::max(arma::vec(L.diag())),1.0);
+    if(eigs_sym_shift_invert(lambda,eig_vec,L,k,sigma,0.0))return true;
+    std::cerr<<"Shift-invert failed, falling back to the smallest magnitude mode"<<std::endl;
     double stol = 50.0;
     double etol = std::numeric_limits<double>::epsilon();
-    success = arma_custom::eigs_sym(lambda_,eig_vec_,W_,k,"sm",stol,etol);
+    bool success = arma_custom::eigs_sym(lambda,eig_vec,L,k,"sm",stol,etol);
     if(!success)std::cerr<<"Failed on decomposition, Please relax the tol"<<std::endl;//failed
+    return success;
 }
 template<typename Mesh>
-void HKS<Mesh>::computeHKS(arma::mat&f)
+void HKS<Mesh>::computeHKS(const arma::vec& lambda,const arma::mat& eig_vec,arma::mat&f)
 {
-    arma::mat sq_phi = arma::square(eig_vec_).t();
     arma::vec alpha_tao = arma::exp2(arma::linspace<arma::vec>(1.0,25.0,(25.0-1.0)*16.0+1.0));
-    arma::mat HKS(alpha_tao.n_rows,W_.n_cols);
-    #pragma omp for
-    for(arma::uword i=0; i < HKS.n_rows ; ++i )
-    {
-        arma::vec lambda_a_tao = -lambda_*alpha_tao(i);
-        HKS.row(i) = arma::sum(sq_phi.each_col()%arma::exp(lambda_a_tao));
-    }
+    //HKS(t,x) = sum_i exp(-lambda_i*t)*phi_i(x)^2 for every time sample in a single GEMM
+    arma::mat HKS = arma::exp( - alpha_tao * lambda.t() ) * arma::square(eig_vec).t();
     //Logarithmic
     HKS = arma::log(HKS);
     //Derivative
-    arma::mat Dif_HKS(HKS.n_rows-1,HKS.n_cols);
-    #pragma omp for
-    for(arma::uword i=0; i < Dif_HKS.n_rows ; ++i )
-    {
-        Dif_HKS.row(i) = HKS.row(i+1) - HKS.row(i);
-    }
+    arma::mat Dif_HKS = HKS.rows(1,HKS.n_rows-1) - HKS.rows(0,HKS.n_rows-2);
     //Fourier Transform
     arma::mat SI_HKS = arma::abs(arma::fft(Dif_HKS));
     f = SI_HKS.rows(0,5);
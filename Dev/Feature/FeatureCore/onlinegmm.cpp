@@ -0,0 +1,326 @@
+#include "onlinegmm.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <limits>
+namespace Feature {
+//columns handed to one thread at a time
+static const arma::uword chunk_cols_ = 1024;
+
+static inline arma::uword chunk_num(arma::uword n){return ( n + chunk_cols_ - 1 ) / chunk_cols_;}
+
+OnlineGMM::OnlineGMM():
+    mode_(SOFT),kappa_(0.6),t0_(2.0),batch_size_(4096),var_floor_(1e-12),t_(0.0),n_acc_(0)
+{
+    ;
+}
+
+void OnlineGMM::init(const BlockLst& blocks,arma::uword n_gaus,unsigned int seed)
+{
+    arma::uword dim = 0;
+    arma::uword N = 0;
+    for(BlockLst::const_iterator iter=blocks.cbegin();iter!=blocks.cend();++iter)
+    {
+        if( (*iter)->n_cols == 0 )continue;
+        dim = (*iter)->n_rows;
+        N += (*iter)->n_cols;
+    }
+    const arma::uword K = std::min(n_gaus,N);
+    means_ = arma::mat(dim,K);
+    if( 0 == K )return;
+    //reservoir sampling, column n replaces a sampled one with probability K/(n+1)
+    std::mt19937 gen(seed);
+    arma::uword n = 0;
+    for(BlockLst::const_iterator iter=blocks.cbegin();iter!=blocks.cend();++iter)
+    {
+        const arma::mat& b = **iter;
+        for(arma::uword c = 0 ; c < b.n_cols ; ++c , ++n )
+        {
+            if( n < K )
+            {
+                means_.col(n) = b.col(c);
+                continue;
+            }
+            std::uniform_int_distribution<arma::uword> pick(0,n);
+            const arma::uword j = pick(gen);
+            if( j < K )means_.col(j) = b.col(c);
+        }
+    }
+    dcovs_ = arma::mat(dim,K);
+    dcovs_.each_col() = variance(blocks);
+    dcovs_ += var_floor_;
+    hefts_ = arma::rowvec(K);
+    hefts_.fill(1.0/double(K));
+    t_ = 0.0;
+    stats_from_params();
+    update_cache();
+}
+
+void OnlineGMM::init(const arma::mat& means,const arma::mat& dcovs,const arma::rowvec& hefts,arma::uword n_seen)
+{
+    means_ = means;
+    dcovs_ = arma::clamp(dcovs,var_floor_,std::numeric_limits<double>::max());
+    hefts_ = hefts;
+    t_ = batch_size_ > 0 ? double(n_seen) / double(batch_size_) : 0.0 ;
+    stats_from_params();
+    update_cache();
+}
+
+void OnlineGMM::stats_from_params()
+{
+    s0_ = hefts_;
+    s1_ = means_;
+    s1_.each_row() %= hefts_;
+    s2_ = dcovs_ + arma::square(means_);
+    s2_.each_row() %= hefts_;
+}
+
+void OnlineGMM::update_cache()
+{
+    const double log_2pi = std::log(2.0*arma::datum::pi);
+    inv_var_ = 1.0 / dcovs_;
+    miv_ = means_ % inv_var_;
+    mm_ = arma::sum(arma::square(means_));
+    log_c_ = arma::log(hefts_);
+    log_c_ -= 0.5*( double(means_.n_rows)*log_2pi + arma::sum(arma::log(dcovs_)) );
+    log_c_ -= 0.5*arma::sum(means_ % miv_);
+}
+
+void OnlineGMM::log_p(const arma::mat& X,arma::mat& L)const
+{
+    L = miv_.t()*X - 0.5*( inv_var_.t()*arma::square(X) );
+    L.each_col() += log_c_.t();
+}
+
+double OnlineGMM::estep(const arma::mat& X,arma::rowvec& s0,arma::mat& s1,arma::mat& s2)const
+{
+    const arma::uword K = n_gaus();
+    const arma::uword d = n_dims();
+    const int nc = chunk_num(X.n_cols);
+    std::vector<arma::rowvec> c0(nc);
+    std::vector<arma::mat> c1(nc);
+    std::vector<arma::mat> c2(nc);
+    std::vector<double> ll(nc,0.0);
+    #pragma omp parallel for schedule(dynamic)
+    for(int c = 0 ; c < nc ; ++c )
+    {
+        const arma::uword first = c*chunk_cols_;
+        const arma::uword m = std::min(chunk_cols_,X.n_cols - first);
+        const arma::mat Xc((double*)X.colptr(first),d,m,false,true);
+        arma::mat G(K,m,arma::fill::zeros);
+        if( HARD == mode_ )
+        {
+            //nearest mean maximizes 2*m'x - m'm
+            arma::mat S = 2.0*( means_.t()*Xc );
+            S.each_col() -= mm_.t();
+            arma::rowvec xx = arma::sum(arma::square(Xc));
+            for(arma::uword j = 0 ; j < m ; ++j )
+            {
+                arma::uword best = 0;
+                for(arma::uword k = 1 ; k < K ; ++k )if( S(k,j) > S(best,j) )best = k;
+                G(best,j) = 1.0;
+                ll[c] -= xx(j) - S(best,j);
+            }
+        }else{
+            arma::mat L;
+            log_p(Xc,L);
+            for(arma::uword j = 0 ; j < m ; ++j )
+            {
+                double* l = L.colptr(j);
+                double mx = l[0];
+                for(arma::uword k = 1 ; k < K ; ++k )mx = std::max(mx,l[k]);
+                double sum = 0.0;
+                for(arma::uword k = 0 ; k < K ; ++k )sum += std::exp(l[k] - mx);
+                const double lse = mx + std::log(sum);
+                for(arma::uword k = 0 ; k < K ; ++k )G(k,j) = std::exp(l[k] - lse);
+                ll[c] += lse;
+            }
+        }
+        c0[c] = arma::sum(G,1).t();
+        c1[c] = Xc*G.t();
+        c2[c] = arma::square(Xc)*G.t();
+    }
+    //reduced in a fixed order so the result does not depend on the scheduling
+    s0 = arma::rowvec(K,arma::fill::zeros);
+    s1 = arma::mat(d,K,arma::fill::zeros);
+    s2 = arma::mat(d,K,arma::fill::zeros);
+    double sum_ll = 0.0;
+    for(int c = 0 ; c < nc ; ++c )
+    {
+        s0 += c0[c];
+        s1 += c1[c];
+        s2 += c2[c];
+        sum_ll += ll[c];
+    }
+    return sum_ll;
+}
+
+double OnlineGMM::mstep(const arma::rowvec& s0,const arma::mat& s1,const arma::mat& s2)
+{
+    const double total = arma::accu(s0);
+    if( total <= 0.0 )return 0.0;
+    double shift = 0.0;
+    for(arma::uword k = 0 ; k < n_gaus() ; ++k )
+    {
+        //a component that got nothing keeps its parameters
+        if( s0(k) <= std::numeric_limits<double>::epsilon()*total )continue;
+        arma::vec m = s1.col(k) / s0(k);
+        shift = std::max(shift,arma::norm(m - means_.col(k)));
+        means_.col(k) = m;
+        dcovs_.col(k) = arma::clamp( s2.col(k) / s0(k) - arma::square(m) , var_floor_ , std::numeric_limits<double>::max() );
+        hefts_(k) = s0(k) / total;
+    }
+    hefts_ /= arma::accu(hefts_);
+    update_cache();
+    return shift;
+}
+
+void OnlineGMM::step(const arma::mat& block)
+{
+    if( means_.is_empty() || block.n_cols == 0 )return;
+    const arma::uword n = block.n_cols;
+    const arma::uword b = batch_size_ > 0 ? std::min(batch_size_,n) : n ;
+    const arma::uword nb = ( n + b - 1 ) / b;
+    arma::rowvec s0;
+    arma::mat s1,s2;
+    for(arma::uword ib = 0 ; ib < nb ; ++ib )
+    {
+        //every nb-th column, so that each mini-batch spans the whole block
+        arma::mat sub;
+        if( nb > 1 )sub = block.cols(arma::regspace<arma::uvec>(ib,nb,n-1));
+        const arma::mat& X = nb > 1 ? sub : block;
+        estep(X,s0,s1,s2);
+        const double eta = std::min(1.0,std::pow(t_ + t0_,-kappa_));
+        const double w = eta / double(X.n_cols);
+        s0_ = (1.0 - eta)*s0_ + w*s0;
+        s1_ = (1.0 - eta)*s1_ + w*s1;
+        s2_ = (1.0 - eta)*s2_ + w*s2;
+        t_ += 1.0;
+        mstep(s0_,s1_,s2_);
+    }
+}
+
+void OnlineGMM::clear_stats()
+{
+    a0_ = arma::rowvec(n_gaus(),arma::fill::zeros);
+    a1_ = arma::mat(n_dims(),n_gaus(),arma::fill::zeros);
+    a2_ = arma::mat(n_dims(),n_gaus(),arma::fill::zeros);
+    n_acc_ = 0;
+}
+
+void OnlineGMM::accumulate(const arma::mat& block)
+{
+    if( means_.is_empty() || block.n_cols == 0 )return;
+    if( a0_.n_elem != n_gaus() )clear_stats();
+    arma::rowvec s0;
+    arma::mat s1,s2;
+    estep(block,s0,s1,s2);
+    a0_ += s0;
+    a1_ += s1;
+    a2_ += s2;
+    n_acc_ += block.n_cols;
+}
+
+double OnlineGMM::maximize()
+{
+    if( 0 == n_acc_ )return 0.0;
+    //later steps go on from the statistics of this pass
+    const double w = 1.0 / double(n_acc_);
+    s0_ = w*a0_;
+    s1_ = w*a1_;
+    s2_ = w*a2_;
+    return mstep(s0_,s1_,s2_);
+}
+
+void OnlineGMM::assign(const arma::mat& X,arma::urowvec& r,Dist dist)const
+{
+    r = arma::urowvec(X.n_cols,arma::fill::zeros);
+    if( means_.is_empty() )return;
+    const arma::uword K = n_gaus();
+    const arma::uword d = n_dims();
+    const int nc = chunk_num(X.n_cols);
+    #pragma omp parallel for schedule(dynamic)
+    for(int c = 0 ; c < nc ; ++c )
+    {
+        const arma::uword first = c*chunk_cols_;
+        const arma::uword m = std::min(chunk_cols_,X.n_cols - first);
+        const arma::mat Xc((double*)X.colptr(first),d,m,false,true);
+        arma::mat S;
+        if( PROB == dist )log_p(Xc,S);
+        else{
+            S = 2.0*( means_.t()*Xc );
+            S.each_col() -= mm_.t();
+        }
+        for(arma::uword j = 0 ; j < m ; ++j )
+        {
+            arma::uword best = 0;
+            for(arma::uword k = 1 ; k < K ; ++k )if( S(k,j) > S(best,j) )best = k;
+            r(first+j) = best;
+        }
+    }
+}
+
+double OnlineGMM::avg_log_p(const arma::mat& X)const
+{
+    if( means_.is_empty() || X.n_cols == 0 )return 0.0;
+    const arma::uword K = n_gaus();
+    const arma::uword d = n_dims();
+    const int nc = chunk_num(X.n_cols);
+    std::vector<double> ll(nc,0.0);
+    #pragma omp parallel for schedule(dynamic)
+    for(int c = 0 ; c < nc ; ++c )
+    {
+        const arma::uword first = c*chunk_cols_;
+        const arma::uword m = std::min(chunk_cols_,X.n_cols - first);
+        const arma::mat Xc((double*)X.colptr(first),d,m,false,true);
+        arma::mat L;
+        log_p(Xc,L);
+        for(arma::uword j = 0 ; j < m ; ++j )
+        {
+            const double* l = L.colptr(j);
+            double mx = l[0];
+            for(arma::uword k = 1 ; k < K ; ++k )mx = std::max(mx,l[k]);
+            double sum = 0.0;
+            for(arma::uword k = 0 ; k < K ; ++k )sum += std::exp(l[k] - mx);
+            ll[c] += mx + std::log(sum);
+        }
+    }
+    double sum_ll = 0.0;
+    for(int c = 0 ; c < nc ; ++c )sum_ll += ll[c];
+    return sum_ll / double(X.n_cols);
+}
+
+void OnlineGMM::to(arma::gmm_diag& gmm)const
+{
+    gmm.set_params(means_,dcovs_,hefts_);
+}
+
+arma::vec OnlineGMM::variance(const BlockLst& blocks)
+{
+    //sums are taken around the first column to keep the cancellation small
+    arma::vec shift;
+    arma::vec sum;
+    arma::vec sum2;
+    arma::uword N = 0;
+    arma::uword dim = 0;
+    for(BlockLst::const_iterator iter=blocks.cbegin();iter!=blocks.cend();++iter)
+    {
+        const arma::mat& b = **iter;
+        if( b.n_cols == 0 )continue;
+        dim = b.n_rows;
+        if( 0 == N )
+        {
+            shift = b.col(0);
+            sum = arma::vec(b.n_rows,arma::fill::zeros);
+            sum2 = arma::vec(b.n_rows,arma::fill::zeros);
+        }
+        arma::mat centered = b.each_col() - shift;
+        sum += arma::sum(centered,1);
+        sum2 += arma::sum(arma::square(centered),1);
+        N += b.n_cols;
+    }
+    if( N < 2 )return arma::vec(dim,arma::fill::zeros);
+    return ( sum2 - arma::square(sum) / double(N) ) / double(N - 1);
+}
+
+}
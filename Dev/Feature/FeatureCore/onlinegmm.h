@@ -0,0 +1,91 @@
+#ifndef ONLINEGMM_H
+#define ONLINEGMM_H
+#include "featurecore_global.h"
+#include <armadillo>
+#include <vector>
+namespace Feature {
+//diagonal GMM learned from a stream of column blocks ( e.g. the features of one frame at a time )
+//nothing is stacked, the model is kept as sufficient statistics so it can go on when more blocks arrive
+//step() is the stepwise ( mini-batch ) EM of Cappe and Moulines with step size (t+t0)^-kappa
+//clear_stats(),accumulate() over all blocks and maximize() is one iteration of the batch EM
+//in HARD mode each column goes to its nearest mean, which turns both into k-means
+class FEATURECORESHARED_EXPORT OnlineGMM
+{
+public:
+    typedef enum{
+        SOFT,
+        HARD
+    }Mode;
+    typedef enum{
+        EUCL,//nearest mean
+        PROB//largest weighted likelihood
+    }Dist;
+    typedef std::vector<const arma::mat*> BlockLst;
+    OnlineGMM();
+    inline void set_mode(Mode mode){mode_=mode;}
+    inline void set_step(double kappa,double t0){kappa_=kappa;t0_=t0;}
+    //columns per mini-batch of step(), 0 to take each block as one
+    inline void set_batch_size(arma::uword n){batch_size_=n;}
+    inline void set_var_floor(double v){var_floor_=v;}
+    //means drawn uniformly from the columns of all blocks ( one reservoir sampling pass )
+    //the variances start at the variance of all the columns and the weights are equal
+    void init(const BlockLst& blocks,arma::uword n_gaus,unsigned int seed=0);
+    //start from a learned model, n_seen is the number of columns it was learned from
+    //so that the following steps weigh the new columns against it
+    void init(const arma::mat& means,const arma::mat& dcovs,const arma::rowvec& hefts,arma::uword n_seen=0);
+    //one stepwise update for each mini-batch of the block
+    void step(const arma::mat& block);
+    void clear_stats();
+    void accumulate(const arma::mat& block);
+    //M-step from the accumulated statistics, returns the largest move of a mean
+    double maximize();
+    //codeword of each column, the columns are split among threads
+    void assign(const arma::mat& X,arma::urowvec& r,Dist dist=EUCL)const;
+    double avg_log_p(const arma::mat& X)const;
+    inline arma::uword n_gaus()const{return means_.n_cols;}
+    inline arma::uword n_dims()const{return means_.n_rows;}
+    inline const arma::mat& means()const{return means_;}
+    inline const arma::mat& dcovs()const{return dcovs_;}
+    inline const arma::rowvec& hefts()const{return hefts_;}
+    //copy the model to an armadillo gmm
+    void to(arma::gmm_diag&)const;
+    //variance of each row over the columns of all blocks
+    static arma::vec variance(const BlockLst& blocks);
+protected:
+    //statistics of a block, s0 is 1 x K, s1 and s2 are d x K, returns the log likelihood
+    double estep(const arma::mat& X,arma::rowvec& s0,arma::mat& s1,arma::mat& s2)const;
+    //log( hefts(k) * N(x|k) ) for the columns of X as a K x n matrix
+    void log_p(const arma::mat& X,arma::mat& L)const;
+    //cached inverse variances and the constant part of the log likelihood of each component
+    void update_cache();
+    //normalized statistics of the current model
+    void stats_from_params();
+    //M-step from normalized statistics, returns the largest move of a mean
+    double mstep(const arma::rowvec& s0,const arma::mat& s1,const arma::mat& s2);
+private:
+    Mode mode_;
+    double kappa_;
+    double t0_;
+    arma::uword batch_size_;
+    double var_floor_;
+    double t_;
+    arma::mat means_;
+    arma::mat dcovs_;
+    arma::rowvec hefts_;
+    //normalized sufficient statistics of step()
+    arma::rowvec s0_;
+    arma::mat s1_;
+    arma::mat s2_;
+    //sums of accumulate()
+    arma::rowvec a0_;
+    arma::mat a1_;
+    arma::mat a2_;
+    arma::uword n_acc_;
+    //cache
+    arma::mat inv_var_;
+    arma::mat miv_;
+    arma::rowvec log_c_;
+    arma::rowvec mm_;
+};
+}
+#endif // ONLINEGMM_H
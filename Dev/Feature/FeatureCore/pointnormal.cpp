@@ -1,5 +1,31 @@
 #include "pointnormal.h"
 #include "featurecore.h"
-
-#include "pointnormal.h"
-
+namespace Feature{
+void computePointNormal(
+        const arma::fmat& v,
+        arma::fmat& n,
+        arma::fvec& curvature,
+        float r,
+        int k
+        )
+{
+    ArmaKDTreeInterface<arma::fmat> points(v);
+    KDTreeSingleIndexAdaptor<
+            L2_Simple_Adaptor<float,ArmaKDTreeInterface<arma::fmat>>,
+            ArmaKDTreeInterface<arma::fmat>,
+            3,arma::uword>
+            kdtree(3,points,KDTreeSingleIndexAdaptorParams(9));
+    kdtree.buildIndex();
+    n = arma::fmat(3,v.n_cols);
+    curvature = arma::fvec(v.n_cols);
+    if( v.n_cols < 5 )
+    {
+        n.fill(std::numeric_limits<float>::quiet_NaN());
+        curvature.fill(std::numeric_limits<float>::quiet_NaN());
+        return;
+    }
+    if( k > ( v.n_cols - 1 ) ) k = v.n_cols - 1;
+    if( k < 4 )k = 4;
+    computePointNormal(kdtree,v,n.memptr(),curvature.memptr(),r,k,true);
+}
+}
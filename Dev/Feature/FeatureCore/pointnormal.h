@@ -5,11 +5,33 @@
 #include "featurecore_global.h"
 namespace Feature
 {
+//r > 0 selects neighbors within radius r, otherwise k nearest neighbors are used
 template<typename M>
 void computePointNormal(M& mesh,float r=0.1,int k=10);
 
 template<typename M>
 void computePointNormal(M& mesh,std::shared_ptr<float>& curvature,float r=0.1,int k=10);
+
+//batched estimation for the cols of v, normals and curvature are written in one pass
+//n has to be 3 x v.n_cols, curvature can be NULL
+template<typename Tree>
+void computePointNormal(
+        const Tree& tree,
+        const arma::fmat& v,
+        float* n,
+        float* curvature,
+        float r,
+        int k,
+        bool flip
+        );
+
+void FEATURECORESHARED_EXPORT computePointNormal(
+        const arma::fmat& v,
+        arma::fmat& n,
+        arma::fvec& curvature,
+        float r=0.1,
+        int k=10
+        );
 }
 #include "pointnormal.hpp"
 #endif // POINTNORMAL_H
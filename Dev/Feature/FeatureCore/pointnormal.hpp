@@ -3,6 +3,103 @@
 #include "featurecore.h"
 using namespace nanoflann;
 namespace Feature{
+//fit plane with the covariance around the center accumulated on the fly
+//same result as fitPlane(center,neighbor,...) without gathering the neighbors
+inline bool fitPlaneFromSums(
+        const float* center,
+        const float* points,
+        const arma::uword* indices,
+        size_t size,
+        float* normal,
+        float& curvature
+        )
+{
+    double c[6] = {0.0,0.0,0.0,0.0,0.0,0.0};
+    for(size_t i = 0 ; i < size ; ++i )
+    {
+        const float* p = points + 3*indices[i];
+        const double d0 = p[0] - center[0];
+        const double d1 = p[1] - center[1];
+        const double d2 = p[2] - center[2];
+        c[0] += d0*d0;
+        c[1] += d0*d1;
+        c[2] += d0*d2;
+        c[3] += d1*d1;
+        c[4] += d1*d2;
+        c[5] += d2*d2;
+    }
+    arma::fmat::fixed<3,3> A;
+    A(0,0) = c[0];A(0,1) = c[1];A(0,2) = c[2];
+    A(1,0) = c[1];A(1,1) = c[3];A(1,2) = c[4];
+    A(2,0) = c[2];A(2,1) = c[4];A(2,2) = c[5];
+    arma::fvec::fixed<3> s;
+    arma::fmat::fixed<3,3> V;
+    if(!arma::eig_sym(s,V,A))return false;
+    //eigenvalues are in ascending order
+    curvature = s(0);
+    arma::fvec n(normal,3,false,true);
+    n = arma::normalise(V.col(0));
+    return true;
+}
+
+template<typename Tree>
+void computePointNormal(
+        const Tree& tree,
+        const arma::fmat& v,
+        float* n,
+        float* curvature,
+        float r,
+        int k,
+        bool flip
+        )
+{
+    const float* points = v.memptr();
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float r2 = r*r;//L2 adaptor works on squared distance
+    #pragma omp parallel
+    {
+        //scratch buffers are reused for all the vertices of one thread
+        std::vector<std::pair<arma::uword,float>> neighbor;
+        std::vector<arma::uword> index(k);
+        std::vector<float> dist(k);
+        nanoflann::SearchParams param(32,0,false);
+        #pragma omp for schedule(dynamic,256)
+        for(int idx = 0 ; idx < v.n_cols ; ++idx )
+        {
+            const float* center = points + 3*idx;
+            float* normal = n + 3*idx;
+            size_t size;
+            if(r!=0.0)
+            {
+                neighbor.clear();
+                tree.radiusSearch(center,r2,neighbor,param);
+                size = neighbor.size();
+                if(index.size()<size)index.resize(size);
+                for(size_t i = 0 ; i < size ; ++i )index[i] = neighbor[i].first;
+            }else{
+                tree.knnSearch(center,k,index.data(),dist.data());
+                size = k;
+            }
+            float c = nan;
+            if( ( size < 4 ) || !fitPlaneFromSums(center,points,index.data(),size,normal,c) )
+            {
+                normal[0] = nan;
+                normal[1] = nan;
+                normal[2] = nan;
+            }else if(flip){
+                //flip normal towards (0,0,0)
+                if( normal[0]*center[0] + normal[1]*center[1] + normal[2]*center[2] > 0 )
+                {
+                    normal[0] *= -1.0;
+                    normal[1] *= -1.0;
+                    normal[2] *= -1.0;
+                }
+            }
+            if(curvature)curvature[idx] = c;
+        }
+    }
+}
+
 template<typename M>
 void computePointNormal(M& mesh,float r,int k)
 {
@@ -17,52 +114,20 @@ void computePointNormal(M& mesh,float r,int k)
     {
         mesh.request_vertex_normals();
     }
-    nanoflann::SearchParams param;
     float* point_ptr = (float*)mesh.points();
     float* normal_ptr = (float*)mesh.vertex_normals();
     arma::fmat X(point_ptr,3,mesh.n_vertices(),false,true);
-    int idx;
-    if( mesh.n_vertices() < 5)std::logic_error("mesh.n_vertices() < 5");
-    if( k > ( mesh.n_vertices() - 1 )) k = mesh.n_vertices() - 1;
-    if( k < 4 )k = 4;
-    for(idx=0;idx<mesh.n_vertices();++idx)
+    arma::fmat N(normal_ptr,3,mesh.n_vertices(),false,true);
+    if( mesh.n_vertices() < 5)
     {
-        std::vector<std::pair<arma::uword,float>> neighbor;
-        std::vector<std::pair<arma::uword,float>>::iterator iter;
-        arma::fmat neighborMat;
-        int neighborSize;
-        if(r!=0.0){
-            neighborSize = kdtree.radiusSearch(point_ptr,r,neighbor,param);
-            arma::uvec indices(neighbor.size());
-            int indicesidx = 0;
-            for (iter==neighbor.begin();iter!=neighbor.end();++iter) {
-                indices(indicesidx) = iter->first;
-                ++indicesidx;
-            }
-            neighborMat = X.cols(indices);
-        }
-        else
-        {
-            arma::uword index[k];
-            float dist[k];
-            kdtree.knnSearch(point_ptr,k,&index[0],&dist[0]);
-            arma::uvec indices(index,k,false,true);
-            neighborMat = X.cols(indices);
-        }
-        arma::fvec center(point_ptr,3,false,true);
-        arma::fvec normal(normal_ptr,3,false,true);
-        if(neighborMat.n_cols<4)
-        {
-            normal.fill(std::numeric_limits<float>::quiet_NaN());
-        }else{
-            float d2o;//distance to origin
-            float curvature;
-            fitPlane(center,neighborMat,normal,curvature,d2o);
-        }
-        point_ptr+=3;
-        normal_ptr+=3;
+        N.fill(std::numeric_limits<float>::quiet_NaN());
+        return;
     }
+    if( k > ( mesh.n_vertices() - 1 )) k = mesh.n_vertices() - 1;
+    if( k < 4 )k = 4;
+    computePointNormal(kdtree,X,normal_ptr,(float*)NULL,r,k,false);
 }
+
 template<typename M>
 void computePointNormal(M& mesh,std::shared_ptr<float>& curvature,float r,int k)
 {
@@ -77,57 +142,18 @@ void computePointNormal(M& mesh,std::shared_ptr<float>& curvature,float r,int k)
     {
         mesh.request_vertex_normals();
     }
-    nanoflann::SearchParams param;
     float* point_ptr = (float*)mesh.points();
     float* normal_ptr = (float*)mesh.vertex_normals();
-    if(!curvature)curvature.reset(new float[mesh.n_vertices()]);
-    float* c_ptr = curvature.get();
+    if(!curvature)curvature.reset(new float[mesh.n_vertices()],std::default_delete<float[]>());
     arma::fmat X(point_ptr,3,mesh.n_vertices(),false,true);
-    int idx;
-    if( mesh.n_vertices() < 5)std::logic_error("mesh.n_vertices() < 5");
-    if( k > ( mesh.n_vertices() - 1 )) k = mesh.n_vertices() - 1;
-    if( k < 4 )k = 4;
-    for(idx=0;idx<mesh.n_vertices();++idx)
+    arma::fmat N(normal_ptr,3,mesh.n_vertices(),false,true);
+    if( mesh.n_vertices() < 5)
     {
-        std::vector<std::pair<arma::uword,float>> neighbor;
-        std::vector<std::pair<arma::uword,float>>::iterator iter;
-        arma::fmat neighborMat;
-        int neighborSize;
-        if(r!=0.0){
-            neighborSize = kdtree.radiusSearch(point_ptr,r,neighbor,param);
-            arma::uvec indices(neighbor.size());
-            int indicesidx = 0;
-            for (iter==neighbor.begin();iter!=neighbor.end();++iter) {
-                indices(indicesidx) = iter->first;
-                ++indicesidx;
-            }
-            neighborMat = X.cols(indices);
-        }
-        else
-        {
-            arma::uword index[k];
-            float dist[k];
-            kdtree.knnSearch(point_ptr,k,&index[0],&dist[0]);
-            arma::uvec indices(index,k,false,true);
-            neighborMat = X.cols(indices);
-        }
-        arma::fvec center(point_ptr,3,false,true);
-        arma::fvec normal(normal_ptr,3,false,true);
-        if(neighborMat.n_cols<4)
-        {
-            normal.fill(std::numeric_limits<float>::quiet_NaN());
-        }else{
-            float d2o;//distance to origin
-            fitPlane(center,neighborMat,normal,c_ptr[idx],d2o);
-            //flip normal towards (0,0,0)
-            if(arma::dot(normal,center)>0)
-            {
-                normal*=-1.0;
-            }
-        }
-        point_ptr+=3;
-        normal_ptr+=3;
+        N.fill(std::numeric_limits<float>::quiet_NaN());
+        return;
     }
+    if( k > ( mesh.n_vertices() - 1 )) k = mesh.n_vertices() - 1;
+    if( k < 4 )k = 4;
+    computePointNormal(kdtree,X,normal_ptr,curvature.get(),r,k,true);
 }
 }
-
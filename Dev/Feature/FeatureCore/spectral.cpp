@@ -0,0 +1,172 @@
+#include "spectral.h"
+#include <slu_ddefs.h>
+#include <vector>
+namespace Feature{
+//LU factors of a sparse matrix for repeated solves
+class SparseLU
+{
+public:
+    SparseLU():factorized_(false){}
+    ~SparseLU(){clear();}
+    bool factorize(const arma::sp_mat& A)
+    {
+        clear();
+        const int n = A.n_rows;
+        //SuperLU keeps pointers to the arrays of A, they have to stay alive until clear()
+        values_.assign(A.values,A.values+A.n_nonzero);
+        rowind_.assign(A.row_indices,A.row_indices+A.n_nonzero);
+        colptr_.assign(A.col_ptrs,A.col_ptrs+A.n_cols+1);
+        perm_c_.resize(n);
+        perm_r_.resize(n);
+        std::vector<int> etree(n);
+        superlu_options_t options;
+        set_default_options(&options);
+        //the matrix is symmetric, a symmetric ordering and diagonal pivoting keep the fill low
+        options.ColPerm = MMD_AT_PLUS_A;
+        options.SymmetricMode = YES;
+        options.DiagPivotThresh = 0.001;
+        StatInit(&stat_);
+        dCreate_CompCol_Matrix(&A_,n,n,A.n_nonzero,values_.data(),rowind_.data(),colptr_.data(),SLU_NC,SLU_D,SLU_GE);
+        get_perm_c(options.ColPerm,&A_,perm_c_.data());
+        SuperMatrix AC;
+        sp_preorder(&options,&A_,perm_c_.data(),etree.data(),&AC);
+        GlobalLU_t glu;
+        int info = 0;
+        dgstrf(&options,&AC,sp_ienv(2),sp_ienv(1),etree.data(),NULL,0,perm_c_.data(),perm_r_.data(),&L_,&U_,&glu,&stat_,&info);
+        Destroy_CompCol_Permuted(&AC);
+        if( 0 != info )
+        {
+            //info > n is a failed allocation and nothing is kept, otherwise the factors exist but are singular
+            if( info <= n )
+            {
+                Destroy_SuperNode_Matrix(&L_);
+                Destroy_CompCol_Matrix(&U_);
+            }
+            Destroy_SuperMatrix_Store(&A_);
+            StatFree(&stat_);
+            return false;
+        }
+        factorized_ = true;
+        return true;
+    }
+    //x = inv(A)*x
+    bool solve(double* x,int n)
+    {
+        SuperMatrix B;
+        int info = 0;
+        dCreate_Dense_Matrix(&B,n,1,x,n,SLU_DN,SLU_D,SLU_GE);
+        dgstrs(NOTRANS,&L_,&U_,perm_c_.data(),perm_r_.data(),&B,&stat_,&info);
+        Destroy_SuperMatrix_Store(&B);
+        return 0 == info;
+    }
+    void clear()
+    {
+        if(!factorized_)return;
+        Destroy_SuperMatrix_Store(&A_);
+        Destroy_SuperNode_Matrix(&L_);
+        Destroy_CompCol_Matrix(&U_);
+        StatFree(&stat_);
+        factorized_ = false;
+    }
+private:
+    bool factorized_;
+    std::vector<double> values_;
+    std::vector<int> rowind_;
+    std::vector<int> colptr_;
+    std::vector<int> perm_c_;
+    std::vector<int> perm_r_;
+    SuperMatrix A_;
+    SuperMatrix L_;
+    SuperMatrix U_;
+    SuperLUStat_t stat_;
+};
+
+bool eigs_sym_shift_invert(
+        arma::vec& eigval,
+        arma::mat& eigvec,
+        const arma::sp_mat& X,
+        arma::uword k,
+        double sigma,
+        double tol
+        )
+{
+#if defined(ARMA_USE_ARPACK)
+    using namespace arma;
+    const blas_int N = X.n_rows;
+    if( X.n_rows != X.n_cols || k == 0 || k >= X.n_rows )return false;
+    SparseLU lu;
+    if(!lu.factorize( X - sigma*arma::speye<arma::sp_mat>(N,N) ))
+    {
+        std::cerr<<"eigs_sym_shift_invert: failed to factorize with sigma="<<sigma<<std::endl;
+        return false;
+    }
+    blas_int ido = 0;
+    char bmat = 'I';
+    char which[3] = "LM";
+    blas_int n = N;
+    blas_int nev = k;
+    blas_int ncv = std::min<blas_int>( std::max<blas_int>( 2*nev + 1 , 20 ) , n );
+    blas_int ldv = n;
+    blas_int lworkl = ncv*( ncv + 8 );
+    blas_int info = 0;
+    podarray<double> resid(n);
+    podarray<double> v(n*ncv);
+    podarray<double> workd(3*n);
+    podarray<double> workl(lworkl);
+    podarray<blas_int> iparam(11);
+    podarray<blas_int> ipntr(14);
+    iparam.zeros();
+    iparam(0) = 1; // exact shifts
+    iparam(2) = 1000; // maximum iterations
+    iparam(6) = 3; // mode 3: OP = inv(X - sigma*I)
+    while( ido != 99 )
+    {
+        arpack::saupd(&ido,&bmat,&n,which,&nev,&tol,resid.memptr(),&ncv,v.memptr(),&ldv,iparam.memptr(),ipntr.memptr(),workd.memptr(),workl.memptr(),&lworkl,&info);
+        if( -1 == ido || 1 == ido )
+        {
+            //y = OP*x, the pointers are FORTRAN ones
+            const double* x = workd.memptr() + ipntr(0) - 1;
+            double* y = workd.memptr() + ipntr(1) - 1;
+            std::copy(x,x+n,y);
+            if(!lu.solve(y,n))
+            {
+                std::cerr<<"eigs_sym_shift_invert: failed to solve"<<std::endl;
+                return false;
+            }
+        }else if( 99 != ido ){
+            break;
+        }
+    }
+    if( 0 != info )
+    {
+        std::cerr<<"eigs_sym_shift_invert: ARPACK error "<<info<<" in saupd()"<<std::endl;
+        return false;
+    }
+    blas_int rvec = 1;
+    char howmny = 'A';
+    podarray<blas_int> select(ncv);
+    blas_int ldz = n;
+    arma::vec d(nev);
+    arma::mat z(n,nev);
+    //seupd maps the Ritz values of OP back to the eigenvalues of X
+    arpack::seupd(&rvec,&howmny,select.memptr(),d.memptr(),z.memptr(),&ldz,&sigma,&bmat,&n,which,&nev,&tol,resid.memptr(),&ncv,v.memptr(),&ldv,iparam.memptr(),ipntr.memptr(),workd.memptr(),workl.memptr(),&lworkl,&info);
+    if( 0 != info )
+    {
+        std::cerr<<"eigs_sym_shift_invert: ARPACK error "<<info<<" in seupd()"<<std::endl;
+        return false;
+    }
+    arma::uvec order = arma::sort_index(d);
+    eigval = d(order);
+    eigvec = z.cols(order);
+    return true;
+#else
+    arma_ignore(eigval);
+    arma_ignore(eigvec);
+    arma_ignore(X);
+    arma_ignore(k);
+    arma_ignore(sigma);
+    arma_ignore(tol);
+    return false;
+#endif
+}
+}
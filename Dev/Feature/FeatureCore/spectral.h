@@ -0,0 +1,20 @@
+#ifndef SPECTRAL_H
+#define SPECTRAL_H
+#include "featurecore_global.h"
+#include <armadillo>
+namespace Feature{
+//the k eigenpairs of the sparse symmetric matrix X closest to sigma by shift-invert Lanczos:
+//X - sigma*I is factorized once with SuperLU and ARPACK iterates on its inverse,
+//so the low end of a Laplacian converges in a few restarts with sigma slightly below zero
+//eigval is in ascending order, returns false if the factorization or the iteration fails
+//ARPACK keeps its state in static storage, this must not be called by two threads at once
+bool FEATURECORESHARED_EXPORT eigs_sym_shift_invert(
+        arma::vec& eigval,
+        arma::mat& eigvec,
+        const arma::sp_mat& X,
+        arma::uword k,
+        double sigma,
+        double tol
+        );
+}
+#endif // SPECTRAL_H
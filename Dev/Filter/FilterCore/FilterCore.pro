@@ -20,6 +20,8 @@ HEADERS += filtercore.h\
     filtercore.hpp \
     octreegrid.h \
     octreegrid.hpp \
+    voxelgrid.h \
+    voxelgrid.hpp \
     filter.h
 
 unix {
@@ -2,5 +2,6 @@
 #define FILTER_H
 #include "filtercore.h"
 #include "octreegrid.h"
+#include "voxelgrid.h"
 #endif // FILTER
 
@@ -7,7 +7,7 @@ class OctreeGrid:public FilterBase<M>
 {
 public:
     typedef MeshOctreeContainer<M> OctreeMesh;
-    typedef unibn::Octree<arma::fvec,MeshOctreeContainer<M>> Octree;
+    typedef unibn::LinearOctree<arma::fvec,MeshOctreeContainer<M>> Octree;
     typedef typename M::VertexHandle MeshVertexHandle;
     typedef typename M::Point MeshPoint;
     typedef typename M::Color MeshColor;
@@ -0,0 +1,59 @@
+#ifndef VOXELGRID_H
+#define VOXELGRID_H
+#include "filtercore.h"
+#include <unordered_map>
+#include <vector>
+namespace Filter {
+//average the points falling in each cell of a regular grid
+//cells are hashed by their integer coordinates and only the per cell sums are kept,
+//so a cloud can be fed in chunks and the memory is bounded by the output
+template<typename M>
+class VoxelGrid:public FilterBase<M>
+{
+public:
+    struct Cell
+    {
+        double p[3];
+        double n[3];
+        uint32_t c[3];
+        uint32_t count;
+    };
+    typedef std::unordered_map<uint64_t,Cell> CellMap;
+    VoxelGrid():
+        FilterBase<M>(),
+        resolution_(0.0),
+        chunk_size_(0),
+        has_normals_(false),
+        has_colors_(false)
+    {}
+    inline void set_resolution(double res){resolution_=res;}
+    //the mesh is reduced chunk_size points at a time, 0 for all at once
+    inline void set_chunk_size(arma::uword n){chunk_size_=n;}
+    //streaming interface: reset(), add() every chunk, then output()
+    void reset(bool normals,bool colors);
+    //points, normals and colors are 3xN column major, normals and colors are ignored if not enabled in reset()
+    void add(const float* points,const float* normals,const uint8_t* colors,arma::uword N);
+    arma::uword size(void)const;
+    //outputs are preallocated 3xsize() arrays, cells are written in the order of their keys
+    void output(float* points,float* normals,uint8_t* colors)const;
+protected:
+    virtual bool initCompute();
+    virtual void deinitCompute();
+    virtual void applyFilter(M&);
+    void addChunk(const float* points,const float* normals,const uint8_t* colors,uint32_t N);
+private:
+    double resolution_;
+    arma::uword chunk_size_;
+    bool has_normals_;
+    bool has_colors_;
+    //cells are split into partitions by key so each partition is reduced by one thread
+    std::vector<CellMap> cells_;
+    std::vector<uint64_t> keys_;
+    std::vector<uint32_t> order_;
+};
+}
+#include "voxelgrid.hpp"
+//the core libraries are only linked on win32, elsewhere this body is compiled in every project that includes filter.h
+//so those projects need -fopenmp ( and -lgomp ) for the parallel passes
+template class FILTERCORESHARED_EXPORT Filter::VoxelGrid<DefaultMesh>;
+#endif // VOXELGRID_H
@@ -0,0 +1,229 @@
+#include "voxelgrid.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+namespace Filter {
+//21 bits per axis, the cell coordinates are offset by 2^20
+static const int64_t voxel_key_bits = 21;
+static const int64_t voxel_key_offset = int64_t(1) << ( voxel_key_bits - 1 );
+static const uint64_t voxel_invalid_key = std::numeric_limits<uint64_t>::max();
+static const uint32_t voxel_partition_bits = 6;
+static const uint32_t voxel_partition_num = 1u << voxel_partition_bits;
+
+static inline uint64_t voxel_key(const float* p,double inv_res)
+{
+    uint64_t key = 0;
+    for(int i=0;i<3;++i)
+    {
+        const double x = std::floor( double(p[i])*inv_res );
+        if( !std::isfinite(x) || x < -voxel_key_offset || x >= voxel_key_offset )return voxel_invalid_key;
+        key = ( key << voxel_key_bits ) | uint64_t( int64_t(x) + voxel_key_offset );
+    }
+    return key;
+}
+
+static inline uint32_t voxel_partition(uint64_t key)
+{
+    if( voxel_invalid_key == key )return voxel_partition_num;
+    return uint32_t( ( key * 0x9E3779B97F4A7C15ULL ) >> ( 64 - voxel_partition_bits ) );
+}
+
+template<typename M>
+bool VoxelGrid<M>::initCompute()
+{
+    if(0>=resolution_)return false;
+    if(!std::isfinite(resolution_))return false;
+    return true;
+}
+
+template<typename M>
+void VoxelGrid<M>::deinitCompute()
+{
+    std::vector<CellMap>().swap(cells_);
+    std::vector<uint64_t>().swap(keys_);
+    std::vector<uint32_t>().swap(order_);
+}
+
+template<typename M>
+void VoxelGrid<M>::reset(bool normals,bool colors)
+{
+    has_normals_ = normals;
+    has_colors_ = colors;
+    cells_.clear();
+    cells_.resize(voxel_partition_num);
+}
+
+template<typename M>
+void VoxelGrid<M>::add(const float* points,const float* normals,const uint8_t* colors,arma::uword N)
+{
+    if(cells_.size()!=voxel_partition_num)reset(has_normals_,has_colors_);
+    //the scratch indices are 32 bits
+    const arma::uword step = std::numeric_limits<int32_t>::max();
+    for( arma::uword s = 0 ; s < N ; s += step )
+    {
+        addChunk(
+                    points + 3*s,
+                    ( has_normals_ && normals ) ? normals + 3*s : 0,
+                    ( has_colors_ && colors ) ? colors + 3*s : 0,
+                    uint32_t(std::min(step,N-s))
+                    );
+    }
+}
+
+template<typename M>
+void VoxelGrid<M>::addChunk(const float* points,const float* normals,const uint8_t* colors,uint32_t N)
+{
+    const double inv_res = 1.0 / resolution_;
+    keys_.resize(N);
+    order_.resize(N);
+    #pragma omp parallel for
+    for(int64_t i=0;i<int64_t(N);++i)
+    {
+        keys_[i] = voxel_key(points+3*i,inv_res);
+    }
+    //bucket the points by partition, each block keeps its own histogram so the scatter is stable
+    const uint32_t P = voxel_partition_num + 1;
+    const size_t blockNum = std::max<size_t>(1, std::min<size_t>(64, N / 16384));
+    const size_t blockSize = ( N + blockNum - 1 ) / blockNum;
+    std::vector<size_t> hist(blockNum*P,0);
+    #pragma omp parallel for
+    for(int64_t b=0;b<int64_t(blockNum);++b)
+    {
+        size_t* h = &hist[b*P];
+        const size_t end = std::min<size_t>(N,(b+1)*blockSize);
+        for(size_t i=b*blockSize;i<end;++i)++h[voxel_partition(keys_[i])];
+    }
+    std::vector<size_t> part_offsets(P+1,0);
+    size_t offset = 0;
+    for(uint32_t p=0;p<P;++p)
+    {
+        part_offsets[p] = offset;
+        for(size_t b=0;b<blockNum;++b)
+        {
+            const size_t count = hist[b*P+p];
+            hist[b*P+p] = offset;
+            offset += count;
+        }
+    }
+    part_offsets[P] = offset;
+    #pragma omp parallel for
+    for(int64_t b=0;b<int64_t(blockNum);++b)
+    {
+        size_t* h = &hist[b*P];
+        const size_t end = std::min<size_t>(N,(b+1)*blockSize);
+        for(size_t i=b*blockSize;i<end;++i)order_[h[voxel_partition(keys_[i])]++] = i;
+    }
+    const size_t dropped = part_offsets[P] - part_offsets[P-1];
+    if(dropped>0)std::cerr<<"VoxelGrid: "<<dropped<<" points are out of the grid range"<<std::endl;
+    //each partition is owned by one thread, so the sums need no lock
+    #pragma omp parallel for schedule(dynamic)
+    for(int p=0;p<int(voxel_partition_num);++p)
+    {
+        CellMap& map = cells_[p];
+        for(size_t k=part_offsets[p];k<part_offsets[p+1];++k)
+        {
+            const uint32_t i = order_[k];
+            Cell& cell = map[keys_[i]];
+            const float* v = points + 3*i;
+            cell.p[0] += v[0];
+            cell.p[1] += v[1];
+            cell.p[2] += v[2];
+            if(normals)
+            {
+                const float* n = normals + 3*i;
+                cell.n[0] += n[0];
+                cell.n[1] += n[1];
+                cell.n[2] += n[2];
+            }
+            if(colors)
+            {
+                const uint8_t* c = colors + 3*i;
+                cell.c[0] += c[0];
+                cell.c[1] += c[1];
+                cell.c[2] += c[2];
+            }
+            ++cell.count;
+        }
+    }
+}
+
+template<typename M>
+arma::uword VoxelGrid<M>::size(void)const
+{
+    arma::uword K = 0;
+    for(typename std::vector<CellMap>::const_iterator iter=cells_.begin();iter!=cells_.end();++iter)K += iter->size();
+    return K;
+}
+
+template<typename M>
+void VoxelGrid<M>::output(float* points,float* normals,uint8_t* colors)const
+{
+    typedef std::pair<uint64_t,const Cell*> KeyCell;
+    std::vector<KeyCell> sorted;
+    sorted.reserve(size());
+    for(typename std::vector<CellMap>::const_iterator iter=cells_.begin();iter!=cells_.end();++iter)
+    {
+        for(typename CellMap::const_iterator c=iter->begin();c!=iter->end();++c)
+        {
+            sorted.push_back(KeyCell(c->first,&c->second));
+        }
+    }
+    //the hash order depends on the chunking, the key order does not
+    std::sort(sorted.begin(),sorted.end(),
+              [](const KeyCell& a,const KeyCell& b){return a.first<b.first;});
+    const bool with_normals = has_normals_ && normals;
+    const bool with_colors = has_colors_ && colors;
+    #pragma omp parallel for
+    for(int64_t k=0;k<int64_t(sorted.size());++k)
+    {
+        const Cell& cell = *sorted[k].second;
+        const double inv = 1.0 / double(cell.count);
+        float* p = points + 3*k;
+        p[0] = cell.p[0]*inv;
+        p[1] = cell.p[1]*inv;
+        p[2] = cell.p[2]*inv;
+        if(with_normals)
+        {
+            const double len = std::sqrt( cell.n[0]*cell.n[0] + cell.n[1]*cell.n[1] + cell.n[2]*cell.n[2] );
+            const double s = len > 0.0 ? 1.0 / len : 0.0;
+            float* n = normals + 3*k;
+            n[0] = cell.n[0]*s;
+            n[1] = cell.n[1]*s;
+            n[2] = cell.n[2]*s;
+        }
+        if(with_colors)
+        {
+            uint8_t* c = colors + 3*k;
+            c[0] = cell.c[0] / cell.count;
+            c[1] = cell.c[1] / cell.count;
+            c[2] = cell.c[2] / cell.count;
+        }
+    }
+}
+
+template<typename M>
+void VoxelGrid<M>::applyFilter(M&mesh)
+{
+    const arma::uword N = mesh.n_vertices();
+    reset(mesh.has_vertex_normals(),mesh.has_vertex_colors());
+    const float* v = (const float*)mesh.points();
+    const float* n = has_normals_ ? (const float*)mesh.vertex_normals() : 0;
+    const uint8_t* c = has_colors_ ? (const uint8_t*)mesh.vertex_colors() : 0;
+    const arma::uword step = chunk_size_ > 0 ? chunk_size_ : std::max<arma::uword>(N,1);
+    for( arma::uword s = 0 ; s < N ; s += step )
+    {
+        add( v + 3*s , n ? n + 3*s : 0 , c ? c + 3*s : 0 , std::min(step,N-s) );
+    }
+    //the output is written straight into the vertex arrays of the new mesh
+    M result;
+    result.resize(size(),0,0);
+    if(has_normals_)result.request_vertex_normals();
+    if(has_colors_)result.request_vertex_colors();
+    output(
+                (float*)result.points(),
+                has_normals_ ? (float*)result.vertex_normals() : 0,
+                has_colors_ ? (uint8_t*)result.vertex_colors() : 0
+                );
+    mesh = result;
+}
+}
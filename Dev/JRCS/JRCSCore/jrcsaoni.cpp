@@ -63,17 +63,9 @@ void JRCSAONI::computeOnce()
         if(iter_count_>0)prepare_alpha_operation(i);
         if( (iter_count_>0) || (!init_alpha_) )
         {
-            #pragma omp parallel for
-            for(int r = 0 ; r < alpha.n_rows ; ++r )
-            {
-                arma::mat tmpv = arma::conv_to<arma::mat>::from(xtv_.each_col() - vv_.col(r));
-                alpha.row(r)  = arma::sum(arma::square(tmpv));
-            }
-
-            alpha.each_row() %= (-0.5*x_invvar_);
-            alpha = arma::exp(alpha);
-            alpha.each_row() %= arma::pow(x_invvar_,1.5);
-            alpha.each_row() %= x_p_;
+            arma::frowvec k = arma::conv_to<arma::frowvec>::from(0.5*x_invvar_);
+            arma::frowvec w = arma::conv_to<arma::frowvec>::from(arma::pow(x_invvar_,1.5)%x_p_);
+            GMMKernel::weight(vv_,xtv_,k,w,alpha);
 
             #pragma omp parallel for
             for(int o = 0 ; o < obj_num_ ; ++o )
@@ -8,6 +8,7 @@ class JRCSCORESHARED_EXPORT JRCSAONI : public JRCSBase
 public:
     JRCSAONI();
     virtual std::string name()const{return "JRCSAONI";}
+    virtual inline bool supports_sparse(void)const{return false;}
 protected:
     virtual void computeOnce();
     virtual void alpha_operation(int i){}
@@ -3,6 +3,7 @@
 #include <strstream>
 #include "MeshColor.h"
 #include "densecrf3d.h"
+#include "nanoflann.hpp"
 
 namespace JRCS{
 
@@ -82,6 +83,23 @@ bool JRCSBase::configure(Config::Ptr config)
     {
         init_obj_scale_ = config_->getFloat("JRCS_init_obj_scale");
     }else init_obj_scale_ = 1.0;
+
+    if(config_->has("JRCS_sparse_k"))
+    {
+        sparse_k_ = config_->getInt("JRCS_sparse_k");
+    }else sparse_k_ = 0;
+
+    if(config_->has("JRCS_sparse_r"))
+    {
+        sparse_r_ = config_->getFloat("JRCS_sparse_r");
+    }else sparse_r_ = 0.0;
+
+    if( !supports_sparse() && ( ( sparse_k_ > 0 ) || ( sparse_r_ > 0.0 ) ) )
+    {
+        std::cerr<<name()<<" has no sparse E-step, JRCS_sparse_k and JRCS_sparse_r are ignored"<<std::endl;
+        sparse_k_ = 0;
+        sparse_r_ = 0.0;
+    }
     return true;
 }
 
@@ -102,6 +120,7 @@ void JRCSBase::input(
     vns_ptrlst_ = vn;
     vcs_ptrlst_ = vc;
     vls_ptrlst_ = vl;
+    crf_ptrlst_.clear();
 }
 
 void JRCSBase::input_with_label(
@@ -117,6 +136,7 @@ void JRCSBase::input_with_label(
     vcs_ptrlst_ = vc;
     vls_ptrlst_ = vlc;
     vll_ptrlst_ = vl;
+    crf_ptrlst_.clear();
 }
 
 void JRCSBase::resetw(
@@ -171,6 +191,8 @@ void JRCSBase::initx(
     xv_ptr_ = xv;
     xn_ptr_ = xn;
     xc_ptr_ = xc;
+    //the label number of the cached CRFs follows the latent model
+    crf_ptrlst_.clear();
     xtv_ = *xv_ptr_;
     xtn_ = *xn_ptr_;
     xtc_ = *xc_ptr_;
@@ -339,6 +361,11 @@ int JRCSBase::evaluate_k()
 
 void JRCSBase::computeOnce()
 {
+    if(sparse_enabled())
+    {
+        computeOnceSparse();
+        return;
+    }
     xv_sum_.fill(0.0);
     xn_sum_.fill(0.0);
     xc_sum_.fill(0.0);
@@ -360,6 +387,325 @@ void JRCSBase::computeOnce()
         mu_.save(muname.str(),arma::raw_ascii);
     }
 
+    //frames are independent given the latent model
+    //each frame is one task, the sums are reduced after all of them are done
+    const int F = vvs_ptrlst_.size();
+    std::vector<FrameSum> sums(F);
+    //sized before the tasks, each task only touches its own entry
+    if(crf_ptrlst_.size()!=F)crf_ptrlst_.resize(F);
+    #pragma omp parallel
+    {
+        #pragma omp single
+        {
+            for(int idx=0;idx<F;++idx)
+            {
+                #pragma omp task firstprivate(idx) shared(sums)
+                computeFrame(idx,sums[idx]);
+            }
+        }
+    }
+    //xn and xc are averaged over frames
+    float rate = F > 0 ? 1.0 / float(F) : 0.0;
+    for(int idx=0;idx<F;++idx)
+    {
+        const FrameSum& sum = sums[idx];
+        xv_sum_ += sum.xv;
+        xn_sum_ += rate*sum.xn;
+        xc_sum_ += rate*sum.xc;
+        var_sum += sum.var;
+        alpha_sum += sum.alpha;
+        alpha_sumij += sum.alphaij;
+    }
+    QCoreApplication::processEvents();
+    updateX();
+}
+
+void JRCSBase::computeFrame(int idx,FrameSum& sum)
+{
+    //transformed latent model of this frame
+    arma::fmat xtv = *xv_ptr_;
+    arma::fmat xtn = *xn_ptr_;
+
+    arma::fmat& vv_ = *vvs_ptrlst_[idx];
+    arma::fmat& vn_ = *vns_ptrlst_[idx];
+    arma::Mat<uint8_t>& vc_ = *vcs_ptrlst_[idx];
+    arma::mat& alpha = *alpha_ptrlst_[idx];
+    Ts& rt = rt_lst_[idx];
+
+    sum.xv = arma::fmat(xv_sum_.n_rows,xv_sum_.n_cols,arma::fill::zeros);
+    sum.xn = arma::fmat(xn_sum_.n_rows,xn_sum_.n_cols,arma::fill::zeros);
+    sum.xc = arma::fmat(xc_sum_.n_rows,xc_sum_.n_cols,arma::fill::zeros);
+
+    if(verbose_>0)std::cerr<<"step-E"<<std::endl;
+    if(verbose_>0)std::cerr<<"transform object"<<std::endl;
+    for(int o = 0 ; o < obj_num_ ; ++o )
+    {
+        arma::fmat R(rt[o].R,3,3,false,true);
+        arma::fvec t(rt[o].t,3,false,true);
+        arma::uword offset = objv_ptrlst_[o]->memptr() - xtv_.memptr();
+        arma::uword size = objv_ptrlst_[o]->n_cols;
+        arma::fmat objv(((float*)xtv.memptr())+offset,3,size,false,true);
+        arma::fmat objn(((float*)xtn.memptr())+offset,3,size,false,true);
+        objv = R*objv;
+        objv.each_col() += t;
+        objn = R*objn;
+    }
+
+    arma::mat tmpvc = arma::conv_to<arma::mat>::from(vc_);
+
+    if(verbose_>0)std::cerr<<"calculate alpha"<<std::endl;
+    if( (iter_count_>0) || (!init_alpha_) )
+    {
+        //after the objv is transformed the xtv is transformed
+        arma::frowvec k = arma::conv_to<arma::frowvec>::from(0.5*x_invvar_);
+        arma::frowvec w = arma::conv_to<arma::frowvec>::from(arma::pow(x_invvar_,1.5)%x_p_);
+        GMMKernel::weight(vv_,xtv,k,w,alpha);
+    }else{
+        if(verbose_>0)std::cerr<<"using init alpha"<<std::endl;
+    }
+
+    //normalise alpha
+    arma::vec alpha_rowsum = arma::sum(alpha,1) + beta_;
+    alpha.each_col() /= alpha_rowsum;
+    alpha_rowsum = arma::sum(alpha,1);
+
+    if(verbose_>1)
+    {
+        std::stringstream alphaname;
+        alphaname.str("");
+        alphaname<<debug_path_<<"alpha_"<<idx<<"_iter_"<<iter_count_<<".fmat.arma";
+        alpha.save(alphaname.str(),arma::raw_ascii);
+    }
+    //smoothing alpha
+    if(smooth_enabled_ && iter_count_ > max_init_iter_)
+    {
+        if(verbose_>0)std::cerr<<"smoothing alpha"<<std::endl;
+
+        std::shared_ptr<DenseCRF3D>& crf_ptr = crf_ptrlst_[idx];
+        if(!crf_ptr)
+        {
+            if(verbose_>0)std::cerr<<"building lattice"<<std::endl;
+            crf_ptr.reset(new DenseCRF3D(vv_,vn_,arma::conv_to<arma::fmat>::from(tmpvc),xv_ptr_->n_cols));
+            arma::fvec sxyz = { 0.05 , 0.05 , 0.05 } ;
+            crf_ptr->addPairwiseGaussian(sxyz,new MatrixCompatibility(mu_));
+            arma::fvec srgb = { 10 , 10 , 10 };
+            arma::fvec snxyz = { 0.05 , 0.05, 0.05 };
+            crf_ptr->addPairwiseBilateral(sxyz,snxyz,srgb,new MatrixCompatibility(mu_));
+        }else{
+            for(int k=0;k<crf_ptr->pairwiseNumber();++k)crf_ptr->setLabelCompatibility(k,new MatrixCompatibility(mu_));
+        }
+        DenseCRF3D& crf = *crf_ptr;
+        arma::mat unary = arma::conv_to<arma::mat>::from(-1.0*arma::log(alpha));
+        crf.setUnaryEnergy(unary.t());
+
+        if(verbose_>0)std::cerr<<"start smoothing"<<std::endl;
+        arma::mat Q = crf.startInference();
+        arma::mat t1,t2;
+        if(verbose_>0)std::cerr<<"kl = "<<crf.klDivergence(Q)<<std::endl;
+        for( int it=0; it<max_smooth_iter_; it++ ) {
+            crf.stepInference( Q, t1, t2 );
+            if(verbose_>0)std::cerr<<"kl = "<<crf.klDivergence(Q)<<std::endl;
+        }
+        alpha = arma::conv_to<arma::mat>::from(Q.t());
+        alpha_rowsum = ( 1.0 + beta_ ) * arma::sum(alpha,1);
+        alpha.each_col() /= alpha_rowsum;
+        alpha_rowsum = arma::sum(alpha,1);
+        if(verbose_>1)
+        {
+            std::stringstream alphaname;
+            alphaname.str("");
+            alphaname<<debug_path_<<"alpha_"<<idx<<"_iter_"<<iter_count_<<"_smooth.fmat.arma";
+            alpha.save(alphaname.str(),arma::raw_ascii);
+        }
+    }
+    //update RT
+    //#1 calculate weighted point cloud
+    if(verbose_>0)std::cerr<<"calculating the weighted point cloud"<<std::endl;
+    arma::fmat& wv = *wvs_ptrlst_[idx];
+    arma::fmat& wn = *wns_ptrlst_[idx];
+    arma::fmat wc = arma::conv_to<arma::fmat>::from(*wcs_ptrlst_[idx]);
+    arma::rowvec alpha_colsum = arma::sum( alpha );
+    arma::rowvec alpha_median = arma::median( alpha );
+    arma::mat trunc_alpha = alpha;
+
+    #pragma omp parallel for
+    for(int c=0;c<alpha.n_cols;++c)
+    {
+        arma::vec col = trunc_alpha.col(c);
+        col( col < alpha_median(c) ).fill(0.0);
+        trunc_alpha.col(c) = col;
+    }
+
+    trunc_alpha += std::numeric_limits<double>::epsilon(); //add eps for numerical stability
+
+    arma::rowvec trunc_alpha_colsum = arma::sum(trunc_alpha);
+
+    arma::frowvec square_lambda = arma::conv_to<arma::frowvec>::from(x_invvar_ % trunc_alpha_colsum);
+    arma::frowvec p(square_lambda.n_cols,arma::fill::ones);
+    arma::frowvec square_norm_lambda = square_lambda / arma::accu(square_lambda);
+    p -= square_norm_lambda;
+
+    wv = vv_*arma::conv_to<arma::fmat>::from(trunc_alpha);
+
+    wn = vn_*arma::conv_to<arma::fmat>::from(trunc_alpha);
+    wc = arma::conv_to<arma::fmat>::from(vc_)*arma::conv_to<arma::fmat>::from(trunc_alpha);
+
+    #pragma omp parallel for
+    for(int c=0;c<alpha.n_cols;++c)
+    {
+        if( 0 != trunc_alpha_colsum(c) )
+        {
+            wv.col(c) /= trunc_alpha_colsum(c);
+            wn.col(c) /= trunc_alpha_colsum(c);
+            wc.col(c) /= trunc_alpha_colsum(c);
+        }
+    }
+
+    wn = arma::normalise( wn );
+    *wcs_ptrlst_[idx] = arma::conv_to<arma::Mat<uint8_t>>::from(wc);
+
+//        arma::fmat closest_v = vv_.cols(closest_i);
+//        arma::fmat closest_n = vn_.cols(closest_i);
+//        arma::Mat<uint8_t> closest_c8 = vc_.cols(closest_i);
+//        arma::fmat closest_c = arma::conv_to<arma::fmat>::from(closest_c8);
+
+    if(verbose_>0)std::cerr<<"calculating R & t"<<std::endl;
+    #pragma omp parallel for
+    for(int o = 0 ; o < obj_num_ ; ++o )
+    {
+        arma::fmat A;
+        arma::fmat U,V;
+        arma::fvec s;
+        arma::fmat R(rt[o].R,3,3,false,true);
+        arma::fvec t(rt[o].t,3,false,true);
+        arma::fmat dR;
+        arma::fvec dt;
+        arma::uvec oidx = arma::find(obj_label_==(o+1));
+        arma::fmat objv = xtv.cols(oidx);
+        if(verbose_>1)std::cerr<<"(s,e)=("<<oidx.min()<<","<<oidx.max()<<")"<<std::endl;
+        arma::fmat v;
+        v = wv.cols(oidx);
+        arma::fmat cv = v.each_col() - arma::mean(v,1);
+        objv.each_col() -= arma::mean(objv,1);
+        objv.each_row() %= p.cols(oidx) % square_lambda.cols(oidx) ;
+        A = cv*objv.t();
+        switch(rttype_)
+        {
+        case Gamma:
+        {
+            arma::fmat B = A.submat(0,0,1,1);
+            dR = arma::fmat(3,3,arma::fill::eye);
+            if(arma::svd(U,s,V,B,"std"))
+            {
+                arma::fmat C(2,2,arma::fill::eye);
+                C(1,1) = arma::det( U * V.t() )>=0 ? 1.0 : -1.0;
+                arma::fmat dR2D = U*C*(V.t());
+                dR.submat(0,0,1,1) = dR2D;
+                arma::fmat ddt = v - dR*xtv.cols(oidx);
+                ddt.each_row() %= square_norm_lambda.cols(oidx);
+                dt = arma::sum(ddt,1);
+            }
+        }
+            break;
+        default: 
+        {
+            if(arma::svd(U,s,V,A,"std"))
+            {
+                arma::fmat C(3,3,arma::fill::eye);
+                C(2,2) = arma::det( U * V.t() )>=0 ? 1.0 : -1.0;
+                dR = U*C*(V.t());
+                arma::fmat ddt = v - dR*xtv.cols(oidx);
+                ddt.each_row() %= square_norm_lambda.cols(oidx);
+                dt = arma::sum(ddt,1);
+            }
+        }
+        }
+
+        //updating objv
+        //not needed since the transformed obj will be reset
+        /*
+        *objv_ptrlst_[o] = dR*(*objv_ptrlst_[o]);
+        (*objv_ptrlst_[o]).each_col() += dt;
+        *objn_ptrlst_[o] = dR*(*objn_ptrlst_[o]);
+        */
+
+        //updating R T
+        R = dR*R;
+        t = dR*t + dt;
+
+        //accumulate for updating X
+        arma::fmat tv = vv_.each_col() - t;
+        tv = R.i() * tv;
+        arma::fmat twv = tv*arma::conv_to<arma::fmat>::from(trunc_alpha);
+        sum.xv.cols(oidx) = twv.cols(oidx);
+        sum.xn.cols(oidx) = R.i()*wn.cols(oidx);
+        sum.xc.cols(oidx) = wc.cols(oidx);
+    }
+    //update var
+    sum.alpha = trunc_alpha_colsum;
+    arma::fmat alpha_2(alpha.n_rows,alpha.n_cols);
+    #pragma omp parallel for
+    for(int r=0;r<alpha_2.n_rows;++r)
+    {
+        alpha_2.row(r) = arma::sum(arma::square(xtv.each_col() - vv_.col(r)));
+    }
+    arma::rowvec tmpvar = arma::sum(alpha_2%alpha);
+    sum.var = tmpvar;
+    sum.alphaij = alpha_colsum;
+}
+
+void JRCSBase::updateX()
+{
+    if(verbose_>0)std::cerr<<"Updating X:"<<std::endl;
+//    float N =  vvs_ptrlst_.size();
+    assert(xv_sum_.is_finite());
+    xv_sum_.each_row() /= arma::conv_to<arma::frowvec>::from(alpha_sum);
+    *xv_ptr_ = xv_sum_;
+//    assert((*xv_ptr_).has_inf()||(*xv_ptr_).has_nan());
+    //fix the x center position
+//    std::cerr<<"xv:"<<xv_ptr_->n_cols<<std::endl;
+    #pragma omp parallel for
+    for(int o = 0 ; o < obj_num_ ; ++o )
+    {
+        arma::uvec oidx = arma::find(obj_label_==(o+1));
+        arma::fmat newxv = xv_ptr_->cols(oidx);
+        arma::fvec adjustt =  obj_pos_.col(o) - arma::mean(newxv,1);
+        xv_ptr_->cols(oidx) = newxv.each_col() + adjustt;
+        for(int idx=0;idx<vvs_ptrlst_.size();++idx)
+        {
+            arma::fvec t(rt_lst_[idx][o].t,3,false,true);
+            t += adjustt;
+        }
+    }
+
+    *xn_ptr_ = xn_sum_;
+    *xn_ptr_ = arma::normalise(*xn_ptr_);
+    *xc_ptr_ = arma::conv_to<arma::Mat<uint8_t>>::from( xc_sum_ );
+
+    x_invvar_ = ( (3.0*alpha_sum ) / ( var_sum + 1e-6 ) );//restore reciprocal fractions of variation
+    float mu = arma::accu(alpha_sum);
+    mu *= ( 1.0 + beta_ );
+    x_p_ = alpha_sum;
+    if( mu != 0)x_p_ /= mu;
+}
+
+void JRCSBase::computeOnceSparse()
+{
+    xv_sum_.fill(0.0);
+    xn_sum_.fill(0.0);
+    xc_sum_.fill(0.0);
+    var_sum.fill(0.0);
+    alpha_sum.fill(0.0);
+    alpha_sumij.fill(0.0);
+
+    //reset transformed latent center
+    if(verbose_>0)std::cerr<<"reset transformed latent color"<<std::endl;
+    xtc_ = *xc_ptr_;
+
+    if(smooth_enabled_&&verbose_>0)std::cerr<<"smoothing is skipped for sparse alpha"<<std::endl;
+
+    const double eps = std::numeric_limits<double>::epsilon();
+    const arma::uword K = xv_ptr_->n_cols;
     for(int idx=0;idx<vvs_ptrlst_.size();++idx)
     {
         //update rate for this frame
@@ -372,10 +718,11 @@ void JRCSBase::computeOnce()
         arma::fmat& vv_ = *vvs_ptrlst_[idx];
         arma::fmat& vn_ = *vns_ptrlst_[idx];
         arma::Mat<uint8_t>& vc_ = *vcs_ptrlst_[idx];
-        arma::mat& alpha = *alpha_ptrlst_[idx];
+        arma::sp_mat& alpha = *sp_alpha_ptrlst_[idx];
         Ts& rt = rt_lst_[idx];
+        const arma::uword N = vv_.n_cols;
 
-        if(verbose_>0)std::cerr<<"step-E"<<std::endl;
+        if(verbose_>0)std::cerr<<"step-E(sparse)"<<std::endl;
         if(verbose_>0)std::cerr<<"transform object"<<std::endl;
         #pragma omp parallel for
         for(int o = 0 ; o < obj_num_ ; ++o )
@@ -389,108 +736,104 @@ void JRCSBase::computeOnce()
             objn = R*objn;
         }
 
-        arma::mat tmpxc = arma::conv_to<arma::mat>::from(xtc_);
-        arma::mat tmpvc = arma::conv_to<arma::mat>::from(vc_);
-
         if(verbose_>0)std::cerr<<"calculate alpha"<<std::endl;
         if( (iter_count_>0) || (!init_alpha_) )
         {
-            #pragma omp parallel for
-            for(int r = 0 ; r < alpha.n_rows ; ++r )
-            {
-                arma::mat tmpv = arma::conv_to<arma::mat>::from(xtv_.each_col() - vv_.col(r)); //after the objv is transformed the xtv is transformed
-                alpha.row(r)  = arma::sum(arma::square(tmpv));
-            }
-
-            alpha.each_row() %= (-0.5*x_invvar_);
-            alpha = arma::trunc_exp(alpha);
-            alpha.each_row() %= arma::pow(x_invvar_,1.5);
-            alpha.each_row() %= x_p_;
+            sparse_step_e(vv_,alpha);
         }else{
             if(verbose_>0)std::cerr<<"using init alpha"<<std::endl;
+            arma::mat init_alpha = *alpha_ptrlst_[idx];
+            init_alpha.each_col() /= ( arma::sum(init_alpha,1) + beta_ );
+            alpha = arma::sp_mat(arma::mat(init_alpha.t()));
         }
 
-        //normalise alpha
-        arma::vec alpha_rowsum = arma::sum(alpha,1) + beta_;
-        alpha.each_col() /= alpha_rowsum;
-        alpha_rowsum = arma::sum(alpha,1);
-
-        if(verbose_>1)
+        //gather responsibilities per centroid, iteration is column major so point indices come out sorted
+        arma::rowvec alpha_colsum(K,arma::fill::zeros);
+        arma::rowvec tmpvar(K,arma::fill::zeros);
+        std::vector<std::vector<std::pair<arma::uword,double>>> xalpha(K);
+        for(arma::sp_mat::const_iterator it=alpha.begin();it!=alpha.end();++it)
         {
-            std::stringstream alphaname;
-            alphaname.str("");
-            alphaname<<debug_path_<<"alpha_"<<idx<<"_iter_"<<iter_count_<<".fmat.arma";
-            alpha.save(alphaname.str(),arma::raw_ascii);
+            const arma::uword x = it.row();
+            const arma::uword r = it.col();
+            const double a = (*it);
+            const float* px = xtv_.colptr(x);
+            const float* pv = vv_.colptr(r);
+            const double d0 = px[0] - pv[0];
+            const double d1 = px[1] - pv[1];
+            const double d2 = px[2] - pv[2];
+            alpha_colsum(x) += a;
+            tmpvar(x) += a*( d0*d0 + d1*d1 + d2*d2 );
+            xalpha[x].emplace_back(r,a);
         }
-        //smoothing alpha
-        if(smooth_enabled_ && iter_count_ > max_init_iter_)
-        {
-            if(verbose_>0)std::cerr<<"smoothing alpha"<<std::endl;
 
-            DenseCRF3D crf(vv_,vn_,arma::conv_to<arma::fmat>::from(tmpvc),xv_ptr_->n_cols);
-            arma::mat unary = arma::conv_to<arma::mat>::from(-1.0*arma::log(alpha));
-
-            crf.setUnaryEnergy(unary.t());
-            arma::fvec sxyz = { 0.05 , 0.05 , 0.05 } ;
-            crf.addPairwiseGaussian(sxyz,new MatrixCompatibility(mu_));
-            arma::fvec srgb = { 10 , 10 , 10 };
-            arma::fvec snxyz = { 0.05 , 0.05, 0.05 };
-            crf.addPairwiseBilateral(sxyz,snxyz,srgb,new MatrixCompatibility(mu_));
-
-            if(verbose_>0)std::cerr<<"start smoothing"<<std::endl;
-            arma::mat Q = crf.startInference();
-            arma::mat t1,t2;
-            if(verbose_>0)std::cerr<<"kl = "<<crf.klDivergence(Q)<<std::endl;
-            for( int it=0; it<max_smooth_iter_; it++ ) {
-                crf.stepInference( Q, t1, t2 );
-                if(verbose_>0)std::cerr<<"kl = "<<crf.klDivergence(Q)<<std::endl;
+        //update RT
+        //#1 calculate weighted point cloud
+        if(verbose_>0)std::cerr<<"calculating the weighted point cloud"<<std::endl;
+        //truncate below the column median, the implicit zeros take part in the median
+        arma::uvec trunc_colptr(K+1);
+        trunc_colptr(0) = 0;
+        #pragma omp parallel for
+        for(int x=0;x<K;++x)
+        {
+            std::vector<std::pair<arma::uword,double>>& col = xalpha[x];
+            const arma::uword zeros = N - col.size();
+            std::vector<double> vals(col.size());
+            for(size_t i=0;i<col.size();++i)vals[i] = col[i].second;
+            double median = 0.0;
+            const arma::uword m[2] = { ( N - 1 ) / 2 , N / 2 };
+            for(int j=0;j<2;++j)
+            {
+                if( m[j] < zeros )continue;
+                std::nth_element(vals.begin(),vals.begin()+(m[j]-zeros),vals.end());
+                median += 0.5*vals[m[j]-zeros];
             }
-            alpha = arma::conv_to<arma::mat>::from(Q.t());
-            alpha_rowsum = ( 1.0 + beta_ ) * arma::sum(alpha,1);
-            alpha.each_col() /= alpha_rowsum;
-            alpha_rowsum = arma::sum(alpha,1);
-            if(verbose_>1)
+            std::vector<std::pair<arma::uword,double>> kept;
+            kept.reserve(col.size());
+            for(size_t i=0;i<col.size();++i)
             {
-                std::stringstream alphaname;
-                alphaname.str("");
-                alphaname<<debug_path_<<"alpha_"<<idx<<"_iter_"<<iter_count_<<"_smooth.fmat.arma";
-                alpha.save(alphaname.str(),arma::raw_ascii);
+                if( col[i].second >= median )kept.push_back(col[i]);
             }
+            col.swap(kept);
+            trunc_colptr(x+1) = col.size();
         }
-        //update RT
-        //#1 calculate weighted point cloud
-        if(verbose_>0)std::cerr<<"calculating the weighted point cloud"<<std::endl;
-        arma::fmat& wv = *wvs_ptrlst_[idx];
-        arma::fmat& wn = *wns_ptrlst_[idx];
-        arma::fmat wc = arma::conv_to<arma::fmat>::from(*wcs_ptrlst_[idx]);
-        arma::rowvec alpha_colsum = arma::sum( alpha );
-        arma::rowvec alpha_median = arma::median( alpha );
-        arma::mat trunc_alpha = alpha;
-
+        trunc_colptr = arma::cumsum(trunc_colptr);
+        arma::uvec trunc_rowind(trunc_colptr(K));
+        arma::fvec trunc_values(trunc_colptr(K));
+        arma::rowvec trunc_alpha_colsum(K);
         #pragma omp parallel for
-        for(int c=0;c<alpha.n_cols;++c)
+        for(int x=0;x<K;++x)
         {
-            arma::vec col = trunc_alpha.col(c);
-            col( col < alpha_median(c) ).fill(0.0);
-            trunc_alpha.col(c) = col;
+            double sum = 0.0;
+            arma::uword s = trunc_colptr(x);
+            for(size_t i=0;i<xalpha[x].size();++i)
+            {
+                trunc_rowind(s+i) = xalpha[x][i].first;
+                trunc_values(s+i) = xalpha[x][i].second;
+                sum += xalpha[x][i].second;
+            }
+            //eps on every point as in the dense path, it is added once through eps*sum below
+            trunc_alpha_colsum(x) = sum + eps*double(N);
         }
-
-        trunc_alpha += std::numeric_limits<double>::epsilon(); //add eps for numerical stability
-
-        arma::rowvec trunc_alpha_colsum = arma::sum(trunc_alpha);
+        arma::sp_fmat trunc_alpha(trunc_rowind,trunc_colptr,trunc_values,N,K);
+        xalpha.clear();
 
         arma::frowvec square_lambda = arma::conv_to<arma::frowvec>::from(x_invvar_ % trunc_alpha_colsum);
         arma::frowvec p(square_lambda.n_cols,arma::fill::ones);
         arma::frowvec square_norm_lambda = square_lambda / arma::accu(square_lambda);
         p -= square_norm_lambda;
 
-        wv = vv_*arma::conv_to<arma::fmat>::from(trunc_alpha);
-
-        wn = vn_*arma::conv_to<arma::fmat>::from(trunc_alpha);
-        wc = arma::conv_to<arma::fmat>::from(vc_)*arma::conv_to<arma::fmat>::from(trunc_alpha);
+        arma::fmat& wv = *wvs_ptrlst_[idx];
+        arma::fmat& wn = *wns_ptrlst_[idx];
+        arma::fmat vcf = arma::conv_to<arma::fmat>::from(vc_);
+        wv = vv_*trunc_alpha;
+        wv.each_col() += float(eps)*arma::sum(vv_,1);
+        wn = vn_*trunc_alpha;
+        wn.each_col() += float(eps)*arma::sum(vn_,1);
+        arma::fmat wc = vcf*trunc_alpha;
+        wc.each_col() += float(eps)*arma::sum(vcf,1);
 
         #pragma omp parallel for
-        for(int c=0;c<alpha.n_cols;++c)
+        for(int c=0;c<K;++c)
         {
             if( 0 != trunc_alpha_colsum(c) )
             {
@@ -503,13 +846,7 @@ void JRCSBase::computeOnce()
         wn = arma::normalise( wn );
         *wcs_ptrlst_[idx] = arma::conv_to<arma::Mat<uint8_t>>::from(wc);
 
-//        arma::fmat closest_v = vv_.cols(closest_i);
-//        arma::fmat closest_n = vn_.cols(closest_i);
-//        arma::Mat<uint8_t> closest_c8 = vc_.cols(closest_i);
-//        arma::fmat closest_c = arma::conv_to<arma::fmat>::from(closest_c8);
-
         if(verbose_>0)std::cerr<<"calculating R & t"<<std::endl;
-        if(verbose_>0)std::cerr<<"rate0:"<<rate0<<","<<"rate1:"<<rate1<<std::endl;
         #pragma omp parallel for
         for(int o = 0 ; o < obj_num_ ; ++o )
         {
@@ -522,7 +859,6 @@ void JRCSBase::computeOnce()
             arma::fvec dt;
             arma::fmat objv = *objv_ptrlst_[o];
             arma::uvec oidx = arma::find(obj_label_==(o+1));
-            if(verbose_>1)std::cerr<<"(s,e)=("<<oidx.min()<<","<<oidx.max()<<")"<<std::endl;
             arma::fmat v;
             v = wv.cols(oidx);
             arma::fmat cv = v.each_col() - arma::mean(v,1);
@@ -547,7 +883,7 @@ void JRCSBase::computeOnce()
                 }
             }
                 break;
-            default: 
+            default:
             {
                 if(arma::svd(U,s,V,A,"std"))
                 {
@@ -561,14 +897,6 @@ void JRCSBase::computeOnce()
             }
             }
 
-            //updating objv
-            //not needed since the transformed obj will be reset
-            /*
-            *objv_ptrlst_[o] = dR*(*objv_ptrlst_[o]);
-            (*objv_ptrlst_[o]).each_col() += dt;
-            *objn_ptrlst_[o] = dR*(*objn_ptrlst_[o]);
-            */
-
             //updating R T
             R = dR*R;
             t = dR*t + dt;
@@ -576,56 +904,102 @@ void JRCSBase::computeOnce()
             //accumulate for updating X
             arma::fmat tv = vv_.each_col() - t;
             tv = R.i() * tv;
-            arma::fmat twv = tv*arma::conv_to<arma::fmat>::from(trunc_alpha);
+            arma::fmat twv = tv*trunc_alpha;
+            twv.each_col() += float(eps)*arma::sum(tv,1);
             xv_sum_.cols(oidx) +=  twv.cols(oidx);
             xn_sum_.cols(oidx) = rate0*xn_sum_.cols(oidx)+rate1*R.i()*wn.cols(oidx);
             xc_sum_.cols(oidx) = rate0*xc_sum_.cols(oidx)+rate1*wc.cols(oidx);
         }
         //update var
         alpha_sum += trunc_alpha_colsum;
-        arma::fmat alpha_2(alpha.n_rows,alpha.n_cols);
-        #pragma omp parallel for
-        for(int r=0;r<alpha_2.n_rows;++r)
-        {
-            alpha_2.row(r) = arma::sum(arma::square(xtv_.each_col() - vv_.col(r)));
-        }
-        arma::rowvec tmpvar = arma::sum(alpha_2%alpha);
         var_sum += tmpvar;
         alpha_sumij += alpha_colsum;
         QCoreApplication::processEvents();
     }
+    updateX();
+}
 
-    if(verbose_>0)std::cerr<<"Updating X:"<<std::endl;
-//    float N =  vvs_ptrlst_.size();
-    assert(xv_sum_.is_finite());
-    xv_sum_.each_row() /= arma::conv_to<arma::frowvec>::from(alpha_sum);
-    *xv_ptr_ = xv_sum_;
-//    assert((*xv_ptr_).has_inf()||(*xv_ptr_).has_nan());
-    //fix the x center position
-//    std::cerr<<"xv:"<<xv_ptr_->n_cols<<std::endl;
+void JRCSBase::sparse_step_e(
+        const arma::fmat& vv,
+        arma::sp_mat& alpha
+        )
+{
+    typedef nanoflann::KDTreeSingleIndexAdaptor<
+            nanoflann::L2_Simple_Adaptor<float,ArmaKDTreeInterface<arma::fmat>>,
+            ArmaKDTreeInterface<arma::fmat>,
+            3,arma::uword> XTree;
+    typedef std::vector<std::pair<arma::uword,float>> Neighbors;
+    //after the objv is transformed the xtv is transformed
+    ArmaKDTreeInterface<arma::fmat> points(xtv_);
+    XTree tree(3,points,nanoflann::KDTreeSingleIndexAdaptorParams(10));
+    tree.buildIndex();
+
+    const arma::uword N = vv.n_cols;
+    const arma::uword K = xtv_.n_cols;
+    const arma::uword k = ( sparse_k_ > 0 ) ? std::min(arma::uword(sparse_k_),K) : K;
+    const float r2 = sparse_r_*sparse_r_;
+    arma::rowvec scale = arma::pow(x_invvar_,1.5) % x_p_;
+
+    std::vector<Neighbors> nei(N);
     #pragma omp parallel for
-    for(int o = 0 ; o < obj_num_ ; ++o )
+    for(int r = 0 ; r < N ; ++r )
     {
-        arma::uvec oidx = arma::find(obj_label_==(o+1));
-        arma::fmat newxv = xv_ptr_->cols(oidx);
-        arma::fvec adjustt =  obj_pos_.col(o) - arma::mean(newxv,1);
-        xv_ptr_->cols(oidx) = newxv.each_col() + adjustt;
-        for(int idx=0;idx<vvs_ptrlst_.size();++idx)
+        Neighbors& n = nei[r];
+        const float* q = vv.colptr(r);
+        if( sparse_k_ > 0 )
         {
-            arma::fvec t(rt_lst_[idx][o].t,3,false,true);
-            t += adjustt;
+            std::vector<arma::uword> indices(k);
+            std::vector<float> dists(k);
+            tree.knnSearch(q,k,indices.data(),dists.data());
+            n.reserve(k);
+            for(arma::uword i = 0 ; i < k ; ++i )
+            {
+                if( ( r2 <= 0.0 ) || ( dists[i] <= r2 ) )n.emplace_back(indices[i],dists[i]);
+            }
+        }else{
+            tree.radiusSearch(q,r2,n,nanoflann::SearchParams(32,0,false));
         }
+        //row indices inside a column have to be ascending
+        std::sort(n.begin(),n.end());
     }
 
-    *xn_ptr_ = xn_sum_;
-    *xn_ptr_ = arma::normalise(*xn_ptr_);
-    *xc_ptr_ = arma::conv_to<arma::Mat<uint8_t>>::from( xc_sum_ );
+    arma::uvec colptr(N+1);
+    colptr(0) = 0;
+    for(arma::uword r = 0 ; r < N ; ++r )colptr(r+1) = colptr(r) + nei[r].size();
+    arma::uvec rowind(colptr(N));
+    arma::vec values(colptr(N));
+    #pragma omp parallel for
+    for(int r = 0 ; r < N ; ++r )
+    {
+        const Neighbors& n = nei[r];
+        const arma::uword s = colptr(r);
+        double sum = 0.0;
+        for(size_t i = 0 ; i < n.size() ; ++i )
+        {
+            const arma::uword x = n[i].first;
+            double a = arma::trunc_exp( -0.5*x_invvar_(x)*double(n[i].second) );
+            a *= scale(x);
+            rowind(s+i) = x;
+            values(s+i) = a;
+            sum += a;
+        }
+        //normalise alpha
+        sum += beta_;
+        for(size_t i = 0 ; i < n.size() ; ++i )values(s+i) /= sum;
+    }
+    alpha = arma::sp_mat(rowind,colptr,values,K,N);
+}
 
-    x_invvar_ = ( (3.0*alpha_sum ) / ( var_sum + 1e-6 ) );//restore reciprocal fractions of variation
-    float mu = arma::accu(alpha_sum);
-    mu *= ( 1.0 + beta_ );
-    x_p_ = alpha_sum;
-    if( mu != 0)x_p_ /= mu;
+void JRCSBase::sparse_obj_prob(
+        const arma::sp_mat& alpha,
+        arma::mat& obj_p
+        )
+{
+    obj_p = arma::mat(alpha.n_cols,obj_num_,arma::fill::zeros);
+    for(arma::sp_mat::const_iterator it=alpha.begin();it!=alpha.end();++it)
+    {
+        obj_p(it.col(),obj_label_(it.row())-1) += (*it);
+    }
 }
 
 void JRCSBase::obj_only(arma::mat& mu)
@@ -684,7 +1058,7 @@ void JRCSBase::reset_alpha()
     {
        assert(init_&&(init_.use_count()>0));
        init_->getAlpha(alpha_ptrlst_);
-    }else
+    }else if(!sparse_enabled())
     {
         if(verbose_>0)std::cerr<<"allocating alpha"<<std::endl;
         arma::fmat& xv_ = *xv_ptr_;
@@ -698,6 +1072,18 @@ void JRCSBase::reset_alpha()
         }
         if(verbose_>0)std::cerr<<"done allocating alpha"<<std::endl;
     }
+    if(sparse_enabled())
+    {
+        if(verbose_>0)std::cerr<<"allocating sparse alpha"<<std::endl;
+        arma::fmat& xv_ = *xv_ptr_;
+        int idx=0;
+        while( idx < vvs_ptrlst_.size() )
+        {
+            if(idx>=sp_alpha_ptrlst_.size())sp_alpha_ptrlst_.emplace_back(new arma::sp_mat(xv_.n_cols,vvs_ptrlst_[idx]->n_cols));
+            else sp_alpha_ptrlst_[idx].reset(new arma::sp_mat(xv_.n_cols,vvs_ptrlst_[idx]->n_cols));
+            ++idx;
+        }
+    }
 }
 
 void JRCSBase::reset_prob()
@@ -747,17 +1133,21 @@ void JRCSBase::update_color_label()
     if(verbose_>0)std::cerr<<"updating color label"<<std::endl;
     for(int idx=0;idx<vvs_ptrlst_.size();++idx)
     {
-        arma::mat& alpha = *alpha_ptrlst_[idx];
-        arma::mat obj_p(alpha.n_rows,obj_num_);
+        arma::mat obj_p;
         arma::Col<uint32_t>& vl = *vls_ptrlst_[idx];
-        #pragma omp parallel for
-        for(int o = 0 ; o < obj_num_ ; ++o )
-        {
-            arma::uvec oidx = arma::find(obj_label_==(o+1));
-            arma::mat sub_alpha = alpha.cols(oidx);
-            obj_p.col(o) = arma::sum(sub_alpha,1);
+        if(sparse_enabled())sparse_obj_prob(*sp_alpha_ptrlst_[idx],obj_p);
+        else{
+            arma::mat& alpha = *alpha_ptrlst_[idx];
+            obj_p = arma::mat(alpha.n_rows,obj_num_);
+            #pragma omp parallel for
+            for(int o = 0 ; o < obj_num_ ; ++o )
+            {
+                arma::uvec oidx = arma::find(obj_label_==(o+1));
+                arma::mat sub_alpha = alpha.cols(oidx);
+                obj_p.col(o) = arma::sum(sub_alpha,1);
+            }
         }
-        arma::uvec label(alpha.n_rows);
+        arma::uvec label(obj_p.n_rows);
         #pragma omp parallel for
         for(int r = 0 ; r < obj_p.n_rows ; ++r )
         {
@@ -778,17 +1168,21 @@ void JRCSBase::get_label(std::vector<arma::uvec>&lbl)
     }
     for(int idx=0;idx<vvs_ptrlst_.size();++idx)
     {
-        arma::mat& alpha = *alpha_ptrlst_[idx];
-        arma::mat obj_p(alpha.n_rows,obj_num_);
+        arma::mat obj_p;
         arma::Col<uint32_t>& vl = *vls_ptrlst_[idx];
-        #pragma omp parallel for
-        for(int o = 0 ; o < obj_num_ ; ++o )
-        {
-            arma::uvec oidx = arma::find(obj_label_==(o+1));
-            arma::mat sub_alpha = alpha.cols(oidx);
-            obj_p.col(o) = arma::sum(sub_alpha,1);
+        if(sparse_enabled())sparse_obj_prob(*sp_alpha_ptrlst_[idx],obj_p);
+        else{
+            arma::mat& alpha = *alpha_ptrlst_[idx];
+            obj_p = arma::mat(alpha.n_rows,obj_num_);
+            #pragma omp parallel for
+            for(int o = 0 ; o < obj_num_ ; ++o )
+            {
+                arma::uvec oidx = arma::find(obj_label_==(o+1));
+                arma::mat sub_alpha = alpha.cols(oidx);
+                obj_p.col(o) = arma::sum(sub_alpha,1);
+            }
         }
-        arma::uvec label(alpha.n_rows);
+        arma::uvec label(obj_p.n_rows);
         #pragma omp parallel for
         for(int r = 0 ; r < obj_p.n_rows ; ++r )
         {
@@ -846,6 +1240,22 @@ void JRCSBase::get_order(std::vector<arma::uvec>& orders)
     orders[0] = Xorder;
     for(int idx=0;idx<vvs_ptrlst_.size();++idx)
     {
+        if(sparse_enabled())
+        {
+            arma::sp_mat& alpha = *sp_alpha_ptrlst_[idx];
+            arma::uvec order(alpha.n_cols,arma::fill::zeros);
+            arma::vec max_prob(alpha.n_cols,arma::fill::zeros);
+            for(arma::sp_mat::const_iterator it=alpha.begin();it!=alpha.end();++it)
+            {
+                if( (*it) > max_prob(it.col()) )
+                {
+                    max_prob(it.col()) = (*it);
+                    order(it.col()) = Xorder(it.row());
+                }
+            }
+            orders[idx+1] = order;
+            continue;
+        }
         arma::mat& alpha = *alpha_ptrlst_[idx];
         arma::uvec order(alpha.n_rows);
         #pragma omp parallel for
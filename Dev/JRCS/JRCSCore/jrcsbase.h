@@ -5,6 +5,7 @@
 #include <memory>
 #include <QCoreApplication>
 #include "jrcsinitbase.h"
+class DenseCRF3D;
 namespace JRCS
 {
 class JRCSCORESHARED_EXPORT JRCSBase
@@ -14,6 +15,8 @@ public:
     typedef std::vector<MatPtr> MatPtrLst;
     typedef std::shared_ptr<arma::mat> DMatPtr;
     typedef std::vector<DMatPtr> DMatPtrLst;
+    typedef std::shared_ptr<arma::sp_mat> SpMatPtr;
+    typedef std::vector<SpMatPtr> SpMatPtrLst;
     typedef std::shared_ptr<arma::Mat<uint8_t>> CMatPtr;
     typedef std::vector<CMatPtr> CMatPtrLst;
     typedef std::shared_ptr<arma::Col<uint32_t>> LCMatPtr;
@@ -36,7 +39,7 @@ public:
         Beta,
         Gamma
     }RotationType;
-    JRCSBase():beta_(1e-5),max_init_iter_(0){arma::arma_rng::set_seed(std::time(NULL));}
+    JRCSBase():beta_(1e-5),max_init_iter_(0),sparse_k_(0),sparse_r_(0.0){arma::arma_rng::set_seed(std::time(NULL));}
     virtual ~JRCSBase(){}
     virtual std::string name()const{ return "JRCSBase";}
     virtual bool configure(Config::Ptr config);
@@ -50,6 +53,10 @@ public:
     virtual inline void set_debug_path(const std::string& path){debug_path_=path;}
     virtual inline void set_mu_type(const CompatibilityType& type){mu_type_=type;}
     virtual inline void set_rt_type(const RotationType& type){rttype_=type;}
+    virtual inline void set_sparse(int k,float r=0.0){sparse_k_=k;sparse_r_=r;}
+    virtual inline bool sparse_enabled(void){return supports_sparse() && ( ( sparse_k_ > 0 ) || ( sparse_r_ > 0.0 ) );}
+    //only computeOnce of JRCSBase has a sparse E-step, the subclasses keep the dense alpha
+    virtual inline bool supports_sparse(void)const{return true;}
     virtual inline int  get_iter_num(void){return iter_count_;}
     virtual inline int  get_max_init_iter(void){return max_init_iter_;}
     virtual inline int  get_max_iter(void){return max_iter_;}
@@ -111,7 +118,27 @@ protected:
     virtual void obj_only(arma::mat&mu);
     virtual void obj_point_dist(arma::mat&mu);
     virtual void computeCompatibility(arma::mat& mu);
+    //partial sums of one frame, reduced into the sums of latent model after all frames are done
+    typedef struct{
+        arma::fmat xv;
+        arma::fmat xn;
+        arma::fmat xc;
+        arma::rowvec var;
+        arma::rowvec alpha;
+        arma::rowvec alphaij;
+    }FrameSum;
     virtual void computeOnce();
+    virtual void computeFrame(int idx,FrameSum& sum);
+    virtual void computeOnceSparse();
+    virtual void sparse_step_e(
+            const arma::fmat& vv,
+            arma::sp_mat& alpha
+            );
+    virtual void sparse_obj_prob(
+            const arma::sp_mat& alpha,
+            arma::mat& obj_p
+            );
+    virtual void updateX();
     virtual bool isEnd();
     virtual void reset_obj_vn(
             float radius,
@@ -158,6 +185,12 @@ protected:
     //results
     DMatPtrLst alpha_ptrlst_;
 
+    //sparse results ( K x N , each column holds the responsibilities of one observed point )
+    SpMatPtrLst sp_alpha_ptrlst_;
+    //truncated neighborhood for sparse E-step
+    int sparse_k_;
+    float sparse_r_;
+
     //weighted V
     MatPtrLst  wvs_ptrlst_;
     MatPtrLst  wns_ptrlst_;
@@ -191,6 +224,11 @@ protected:
     CompatibilityType mu_type_;
     arma::mat mu_;
 
+    //smoothing CRF of each frame
+    //the observation does not change between iterations, so the lattices are built once
+    //and only the unary and the compatibility are replaced
+    std::vector<std::shared_ptr<DenseCRF3D>> crf_ptrlst_;
+
     //sum of latent model
     arma::fmat xv_sum_;
     arma::fmat xn_sum_;
@@ -17,11 +17,21 @@ void JRCSBox::add_boxes(std::vector<Cube::PtrLst>& cube_ptrlsts)
     cube_ptrlsts_ = cube_ptrlsts;
 }
 
-JRCSBox::JRCSBox()
+JRCSBox::JRCSBox():use_feature_alpha_(false)
 {
     ;
 }
 
+bool JRCSBox::configure(Config::Ptr config)
+{
+    if(!JRCSBilateral::configure(config))return false;
+    if(config_->has("JRCSBox_feature_alpha"))
+    {
+        use_feature_alpha_ = ( 0 != config_->getInt("JRCSBox_feature_alpha") );
+    }else use_feature_alpha_ = false;
+    return true;
+}
+
 void JRCSBox::get_label(std::vector<arma::uvec>& lbl)
 {
     if(verbose_)std::cerr<<"JRCSBox::get_label"<<std::endl;
@@ -502,51 +512,63 @@ void JRCSBox::step_a(int i)
     if(verbose_>1)std::cerr<<"calculate alpha"<<std::endl;
 
     arma::mat&  alpha = *alpha_ptrlst_[i];
-    double dim = double(f_dim_)/2.0f;
-    double w = double(iter_count_) / double(max_iter_);
-    for(int r = 0 ; r < alpha.n_rows ; ++r )
+    //position term, blocked over rows and vectorized in GMMKernel
+    arma::frowvec k = arma::conv_to<arma::frowvec>::from(0.5*xv_invvar_);
+    arma::frowvec w = arma::conv_to<arma::frowvec>::from(arma::pow(xv_invvar_,1.5));
+    GMMKernel::weight(vv_,xtv_,k,w,alpha);
+
+    //feature term and the priors are applied in one pass over the columns
+    const bool use_color = ( iter_count_ < max_init_iter_ );
+    const bool use_inbox = inbox_prob_lsts_[i] && ( ( iter_count_ < max_iter_ - 10 ) || ( iter_count_ < 10 ) );
+    const double* c_alpha = use_color ? color_prob_lsts_[i]->memptr() : 0;
+    const double* b_alpha = use_inbox ? inbox_prob_lsts_[i]->memptr() : 0;
+    arma::rowvec kf,wf;
+    if(use_feature_alpha_)
+    {
+        kf = -0.5*xf_invvar_;
+        wf = arma::pow(xf_invvar_,double(f_dim_)/2.0);
+    }
+    arma::uvec col_obj(alpha.n_cols);
+    for(int o = 0 ; o < obj_num_ ; ++o )
     {
-        arma::mat tmpf = arma::conv_to<arma::mat>::from( xf_.each_col() - vf_.col(r) );
-        arma::mat tmpv = arma::conv_to<arma::mat>::from( xtv_.each_col() - vv_.col(r) );
-
-        arma::rowvec alpha_f = arma::sum(arma::square(tmpf))%(-0.5*xf_invvar_) ;
-        arma::rowvec alpha_v = arma::sum(arma::square(tmpv))%(-0.5*xv_invvar_);
-
-        alpha_f = arma::trunc_exp(alpha_f);
-        alpha_f %= arma::pow(xf_invvar_,dim);
-
-        alpha_v = arma::trunc_exp(alpha_v);
-        alpha_v %= arma::pow(xv_invvar_,1.5);
-
-        alpha.row(r) = alpha_v;
+        col_obj.subvec(obj_range_[2*o],obj_range_[2*o+1]).fill(o);
     }
-
-    //applying terms of init alpha
-    if(iter_count_ < max_init_iter_)
+    const arma::uword N = alpha.n_rows;
+    const arma::uword fd = vf_.n_rows;
+    #pragma omp parallel for
+    for(int c = 0 ; c < alpha.n_cols ; ++c )
     {
-        arma::mat& c_alpha  = *color_prob_lsts_[i];
-        int o = 0;
-        for(int c = 0 ; c < alpha.n_cols ; ++c )
+        double* a = alpha.colptr(c);
+        if(use_feature_alpha_)
         {
-            alpha.col(c) %= c_alpha.col(o);
-            if( c == obj_range_[2*o+1] )++o;//reach end of this object
+            const float* x = xf_.colptr(c);
+            for(arma::uword r = 0 ; r < N ; ++r )
+            {
+                const float* f = vf_.colptr(r);
+                float d2 = 0.0;
+                for(arma::uword d = 0 ; d < fd ; ++d )
+                {
+                    float t = x[d] - f[d];
+                    d2 += t*t;
+                }
+                a[r] *= wf(c)*std::exp(kf(c)*d2);
+            }
         }
-    }
-
-    //applying terms of points in box constraint to alpha
-    if(inbox_prob_lsts_[i] && ( ( iter_count_ < max_iter_ - 10 ) || ( iter_count_ < 10 ) ) )
-    {
-        arma::mat& b_alpha  = *inbox_prob_lsts_[i];
-        int o = 0;
-        for(int c = 0 ; c < alpha.n_cols ; ++c )
+        const arma::uword o = col_obj(c);
+        if(c_alpha)
+        {
+            const double* p = c_alpha + o*N;
+            for(arma::uword r = 0 ; r < N ; ++r )a[r] *= p[r];
+        }
+        if(b_alpha)
         {
-            alpha.col(c) %= b_alpha.col(o);
-            if( c == obj_range_[2*o+1] )++o;//reach end of this object
+            const double* p = b_alpha + o*N;
+            for(arma::uword r = 0 ; r < N ; ++r )a[r] *= p[r];
         }
+        for(arma::uword r = 0 ; r < N ; ++r )a[r] += std::numeric_limits<double>::epsilon(); //add eps for numeric stability
     }
 
     if(verbose_>1)std::cerr<<"normalize alpha"<<std::endl;
-    alpha += std::numeric_limits<double>::epsilon(); //add eps for numeric stability
     arma::vec alpha_rowsum = arma::sum(alpha,1) + beta_;
     alpha.each_col() /= alpha_rowsum;
 
@@ -672,19 +694,49 @@ void JRCSBox::step_a(int i)
     }
     if(verbose_>1)std::cerr<<"#3 done RT for each object"<<std::endl;
 
-    arma::fmat alpha_v2(alpha.n_rows,alpha.n_cols);
-    for(int r=0;r<alpha_v2.n_rows;++r)
+    //weighted squared distances are reduced per column without a N x K temporary
+    #pragma omp parallel for
+    for(int c = 0 ; c < alpha.n_cols ; ++c )
     {
-        alpha_v2.row(r) = arma::sum(arma::square(xtv_.each_col() - vv_.col(r)));
+        const double* a = alpha.colptr(c);
+        const float* x = xtv_.colptr(c);
+        double s = 0.0;
+        for(arma::uword r = 0 ; r < N ; ++r )
+        {
+            const float* v = vv_.colptr(r);
+            float dx = x[0] - v[0];
+            float dy = x[1] - v[1];
+            float dz = x[2] - v[2];
+            s += a[r]*double( dx*dx + dy*dy + dz*dz );
+        }
+        vvar_(i,c) = s;
     }
-    vvar_.row(i) = arma::sum(alpha_v2%alpha);
 
-    arma::fmat alpha_f2(alpha.n_rows,alpha.n_cols);
-    for(int r=0;r<alpha_f2.n_rows;++r)
+    if(use_feature_alpha_)
     {
-        alpha_f2.row(r) = arma::sum(arma::square(xf_.each_col() - vf_.col(r)));
+        #pragma omp parallel for
+        for(int c = 0 ; c < alpha.n_cols ; ++c )
+        {
+            const double* a = alpha.colptr(c);
+            const float* x = xf_.colptr(c);
+            double s = 0.0;
+            for(arma::uword r = 0 ; r < N ; ++r )
+            {
+                const float* f = vf_.colptr(r);
+                float d2 = 0.0;
+                for(arma::uword d = 0 ; d < fd ; ++d )
+                {
+                    float t = x[d] - f[d];
+                    d2 += t*t;
+                }
+                s += a[r]*double(d2);
+            }
+            fvar_(i,c) = s;
+        }
+    }else{
+        //feature variance is held at its current value when the feature term is off
+        fvar_.row(i) = double(f_dim_)*arma::conv_to<arma::rowvec>::from(alpha_colsum) / xf_invvar_;
     }
-    fvar_.row(i) = arma::sum(alpha_f2%alpha);
 }
 
 void JRCSBox::debug_alpha(int i)
@@ -16,6 +16,9 @@ public:
     JRCSBox();
     virtual ~JRCSBox(){}
     virtual std::string name()const{return "JRCSBox";}
+    virtual bool configure(Config::Ptr);
+    //multiply the feature space kernel into alpha ( off by default, the box E-step only needs positions )
+    inline void enable_feature_alpha(bool enable=true){use_feature_alpha_=enable;}
     virtual void initx(
             const MatPtr& xv,
             const MatPtr& xn,
@@ -53,6 +56,7 @@ private:
     static std::vector<Cube::PtrLst> cube_ptrlsts_;
     static bool update_cube_;
     arma::uword cube_init_frame_;
+    bool use_feature_alpha_;
     std::vector<std::vector<arma::uword>> obj_cube_index;
     GMMPtrLst color_gmm_lsts_;
     DMatPtrLst color_prob_lsts_;
@@ -85,15 +85,9 @@ void SJRCSBase::step_a(int i)
     }
     //calculate alpha
     arma::mat&  alpha = *alpha_ptrlst_[i];
-    for(int r = 0 ; r < alpha.n_rows ; ++r )
-    {
-        arma::mat tmpv = arma::conv_to<arma::mat>::from(xtv_.each_col() - vv_.col(r));
-        alpha.row(r)  = arma::sum(arma::square(tmpv));
-    }
-    alpha.each_row() %= (-0.5*x_invvar_);
-    alpha = arma::trunc_exp(alpha);
-    alpha.each_row() %= arma::pow(x_invvar_,1.5);
-    alpha.each_row() %= x_p_;
+    arma::frowvec k = arma::conv_to<arma::frowvec>::from(0.5*x_invvar_);
+    arma::frowvec w = arma::conv_to<arma::frowvec>::from(arma::pow(x_invvar_,1.5)%x_p_);
+    GMMKernel::weight(vv_,xtv_,k,w,alpha);
     //normalise alpha
     arma::vec alpha_rowsum = ( 1.0 + beta_ ) * arma::sum(alpha,1);
     alpha.each_col() /= alpha_rowsum;
@@ -144,6 +138,7 @@ void SJRCSBase::step_b(void)
         }
         arma::rowvec res_err = arma::sum( arma::square( res_.each_col() - median_res_ ) );
         res_err.max(cir_frame_);
+        max_cir_cor(res_,median_res_,cir_best_);
         cir_value_.fill(0);
      }
     QCoreApplication::processEvents();
@@ -155,9 +150,8 @@ void SJRCSBase::step_c(int i)
 
     if( use_res_ && ( 0 == iter_count_% res_act_freq_ ) && ( i == cir_frame_ ) )
     {
-        arma::uword cir = std::numeric_limits<arma::uword>::max();
-        //max of circular correlation
-        max_cir_cor(res_.col(i),median_res_,cir);
+        //max of circular correlation ( computed for all frames in step_b )
+        arma::uword cir = cir_best_(i);
         //circulate the alpha accordingly
         cir_mat(cir,alpha);
         //recording cirvalue for debug
@@ -420,6 +414,7 @@ void SJRCSBase::prepare_for_residue_correlation(void)
     }
     std::cerr<<"b"<<std::endl;
     cir_value_ = arma::uvec(vvs_ptrlst_.size(),arma::fill::zeros);
+    cir_best_ = arma::uvec(vvs_ptrlst_.size(),arma::fill::zeros);
     res_ = arma::mat(cir_pos_.size(),vvs_ptrlst_.size(),arma::fill::zeros);
 }
 
@@ -530,19 +525,34 @@ void SJRCSBase::max_cir_cor(const arma::vec& func0,const arma::vec& func1,arma::
         std::cerr<<"func0.size()!=func1.size()"<<std::endl;
         return;
     }
-    arma::vec cor(func0.size(),arma::fill::zeros);
-    arma::uword N = func0.size();
-    double max = std::numeric_limits<double>::lowest();
-    for(arma::uword i=0 ; i<N ; ++i)//position of func0
-        for(arma::uword j=0 ; j<N ; ++j)//circulation
-        {
-            arma::uword k = (i+j) % N ;
-            cor(j) += func0(i)*func1(k);
-            if( cor(j) > max ){
-                max = cor(j);
-                max_cir = j;
-            }
-        }
+    //cor(j) = sum_i func0(i)*func1((i+j)%N) = ifft( conj(fft(func0)) % fft(func1) )
+    arma::cx_vec f0 = arma::fft(func0);
+    arma::cx_vec f1 = arma::fft(func1);
+    arma::vec cor = arma::real( arma::ifft( arma::conj(f0) % f1 ) );
+    cor.max(max_cir);
+}
+
+void SJRCSBase::max_cir_cor(const arma::mat& funcs,const arma::vec& func1,arma::uvec& max_cir)
+{
+    if(funcs.n_rows!=func1.size()){
+        std::cerr<<"funcs.n_rows!=func1.size()"<<std::endl;
+        return;
+    }
+    //fft on each col, the reference is transformed only once
+    arma::cx_mat f0 = arma::fft(funcs);
+    arma::cx_vec f1 = arma::fft(func1);
+    f0 = arma::conj(f0);
+    f0.each_col() %= f1;
+    arma::mat cor = arma::real( arma::ifft( f0 ) );
+    max_cir = arma::uvec(funcs.n_cols);
+    #pragma omp parallel for
+    for(int c = 0 ; c < cor.n_cols ; ++c )
+    {
+        arma::uword m;
+        arma::vec col = cor.col(c);
+        col.max(m);
+        max_cir(c) = m;
+    }
 }
 
 void SJRCSBase::cir_mat(const arma::uword& cir,arma::mat& alpha)
@@ -30,6 +30,7 @@ public:
     SJRCSBase();
     virtual ~SJRCSBase(){}
     virtual std::string name()const{return "SJRCSBase";}
+    virtual inline bool supports_sparse(void)const{return false;}
     virtual bool configure(Config::Ptr);
     virtual bool input_extra(
             const MeshBundle<DefaultMesh>::PtrList& inputs
@@ -100,6 +101,7 @@ protected:
     void to_model_func(const arma::mat&,const arma::vec&,const arma::vec&,arma::vec&);
     double res_energy(const arma::vec& func0,const arma::vec& func1);
     void max_cir_cor(const arma::vec&,const arma::vec&,arma::uword& max_cir);//maximum of circular correlation
+    void max_cir_cor(const arma::mat&,const arma::vec&,arma::uvec& max_cir);//maximum of circular correlation for each col
     void cir_mat(const arma::uword& cir,arma::mat& alpha);//perform cirulation on alpha
     void calc_weighted(
             const arma::fmat&vv,
@@ -149,6 +151,8 @@ protected:
     arma::uword cir_frame_;
     //cir value
     arma::uvec cir_value_;
+    //best circulation of every frame against median_res_
+    arma::uvec cir_best_;
 
     //residue function
     arma::mat res_;
@@ -9,6 +9,8 @@ QT       -= gui
 TARGET = Clustering
 TEMPLATE = lib
 CONFIG += c++11
+QMAKE_CXXFLAGS += -fopenmp
+LIBS += -lgomp -lpthread
 DEFINES += CLUSTERING_LIBRARY
 
 SOURCES += \
@@ -46,6 +46,7 @@ void PEAC::compute(
 
 void PEAC::compute()
 {
+    computeAdjacency();
     computeCandN();
     if(init_==0)initY_RandIndex();
     if(init_==1)initY_Random();
@@ -77,20 +78,45 @@ void PEAC::compute()
     }
 }
 
+void PEAC::computeAdjacency()
+{
+    //counting sort of the pair ends, the pairs of a node stay in the order of iP_
+    const arma::uword n = iE_.n_cols;
+    adj_offsets_ = arma::uvec(n+1,arma::fill::zeros);
+    for(arma::uword index=0;index<iP_.n_cols;++index)
+    {
+        ++adj_offsets_(iP_(0,index)+1);
+        ++adj_offsets_(iP_(1,index)+1);
+    }
+    for(arma::uword i=0;i<n;++i)adj_offsets_(i+1) += adj_offsets_(i);
+    adj_nodes_ = arma::uvec(adj_offsets_(n));
+    adj_pairs_ = arma::uvec(adj_offsets_(n));
+    arma::uvec pos = adj_offsets_.head(n);
+    for(arma::uword index=0;index<iP_.n_cols;++index)
+    {
+        const arma::uword i = iP_(0,index);
+        const arma::uword j = iP_(1,index);
+        adj_nodes_(pos(i)) = j;
+        adj_pairs_(pos(i)++) = index;
+        adj_nodes_(pos(j)) = i;
+        adj_pairs_(pos(j)++) = index;
+    }
+}
+
 void PEAC::computeCandN()
 {
-     N_ = iE_.n_rows;
-     C_ = arma::sp_mat(iE_.n_cols,iE_.n_cols);
-     #pragma omp parallel for
-     for(arma::uword index=0;index<iP_.n_cols;++index)
-     {
-         arma::uvec pair = iP_.col(index);
-         arma::uvec sig0 = iE_.col(pair(0));
-         arma::uvec sig1 = iE_.col(pair(1));
-         arma::uvec equal = arma::find( sig0 == sig1 );
-         C_(pair(0),pair(1)) = double(equal.size())/double(N_);
-         C_(pair(1),pair(0)) = C_(pair(0),pair(1));
-     }
+    N_ = iE_.n_rows;
+    C_ = arma::vec(iP_.n_cols);
+    const arma::uword N = iE_.n_rows;
+    #pragma omp parallel for
+    for(arma::uword index=0;index<iP_.n_cols;++index)
+    {
+        const arma::uword* sig0 = iE_.colptr(iP_(0,index));
+        const arma::uword* sig1 = iE_.colptr(iP_(1,index));
+        arma::uword equal = 0;
+        for(arma::uword r=0;r<N;++r)if(sig0[r]==sig1[r])++equal;
+        C_(index) = double(equal)/double(N_);
+    }
 }
 
 void PEAC::initY_Random()
@@ -195,15 +221,14 @@ void PEAC::initY_BestIndex()
 
 void PEAC::initA()
 {
-    oldA_.reset(new arma::sp_mat(iE_.n_cols,iE_.n_cols));
-    newA_.reset(new arma::sp_mat(iE_.n_cols,iE_.n_cols));
+    oldA_.reset(new arma::vec(iP_.n_cols));
+    newA_.reset(new arma::vec(iP_.n_cols));
+    #pragma omp parallel for
     for(arma::uword index=0;index<iP_.n_cols;++index)
     {
-        arma::uvec pair = iP_.col(index);
-        arma::uword i = pair(0);
-        arma::uword j = pair(1);
-        (*oldA_)(i,j) = arma::accu(oldY_->col(i)%oldY_->col(j));
-        (*oldA_)(j,i) = (*oldA_)(i,j);
+        arma::uword i = iP_(0,index);
+        arma::uword j = iP_(1,index);
+        (*oldA_)(index) = arma::dot(oldY_->col(i),oldY_->col(j));
     }
     *newA_ = *oldA_;
 }
@@ -211,13 +236,15 @@ void PEAC::initA()
 void PEAC::initG()
 {
     G_ = arma::mat(k_,iE_.n_cols,arma::fill::zeros);
-    for(arma::uword index=0;index<iP_.n_cols;++index)
+    //each column of G is gathered from the pairs of its node
+    #pragma omp parallel for
+    for(arma::uword i=0;i<iE_.n_cols;++i)
     {
-        arma::uvec pair = iP_.col(index);
-        arma::uword i = pair(0);
-        arma::uword j = pair(1);
-        G_.col(i) += N_*oldY_->col(j)*((*oldA_)(j,i) - C_(j,i));
-        G_.col(j) += N_*oldY_->col(i)*((*oldA_)(i,j) - C_(i,j));
+        for(arma::uword k=adj_offsets_(i);k<adj_offsets_(i+1);++k)
+        {
+            const arma::uword e = adj_pairs_(k);
+            G_.col(i) += N_*oldY_->col(adj_nodes_(k))*((*oldA_)(e) - C_(e));
+        }
     }
     std::cerr<<"G("<<G_.min()<<","<<G_.max()<<")"<<std::endl;
 }
@@ -226,38 +253,28 @@ void PEAC::initPQ()
 {
     pq_.resize(iE_.n_cols);
     #pragma omp parallel for
-    double max_prior = std::numeric_limits<double>::lowest();
     for(arma::uword i=0;i<iE_.n_cols;++i)
     {
         Triplet& tri = pq_[i];
         tri.index_ = i;
         computePrior(tri);
-        if(max_prior<tri.prior_)max_prior = tri.prior_;
     }
     std::make_heap(pq_.begin(),pq_.end(),std::less<Triplet>());
-//    std::cerr<<"max_prior:"<<max_prior<<std::endl;
 }
 
 void PEAC::getBestD()
 {
     bestDY_ = pq_.front().value_;
-    std::vector<arma::uword> Pgamma_vec;
-    Pgamma_vec.reserve(iE_.n_cols);
-    for(arma::uword index=0;index<iP_.n_cols;++index)
+    const arma::uword begin = adj_offsets_(bestDY_.gamma_);
+    const arma::uword end = adj_offsets_(bestDY_.gamma_+1);
+    if( end > begin )
     {
-        arma::uvec pair = iP_.col(index);
-        arma::uword i = pair(0);
-        arma::uword j = pair(1);
-        if(i==bestDY_.gamma_)
-        {
-            Pgamma_vec.push_back(j);
-        }
-        if(j==bestDY_.gamma_)
-        {
-            Pgamma_vec.push_back(i);
-        }
+        Pgamma_ = adj_nodes_.subvec(begin,end-1);
+        Pgamma_pairs_ = adj_pairs_.subvec(begin,end-1);
+    }else{
+        Pgamma_.reset();
+        Pgamma_pairs_.reset();
     }
-    Pgamma_ = arma::uvec(Pgamma_vec);
 }
 
 void PEAC::computeStep()
@@ -286,10 +303,7 @@ void PEAC::computeA()
     arma::rowvec dif = step_*(Ya - Yb);
     for(arma::uword index=0;index<Pgamma_.n_rows;++index)
     {
-        arma::uword i = bestDY_.gamma_;
-        arma::uword j = Pgamma_(index);
-        (*newA_)(i,j) += dif(j);
-        (*newA_)(j,i) = (*newA_)(i,j);
+        (*newA_)(Pgamma_pairs_(index)) += dif(Pgamma_(index));
     }
 }
 
@@ -297,17 +311,19 @@ void PEAC::computeG()
 {
     //if j \in P_{\gamma}
     G_.col(bestDY_.gamma_).fill(0.0);
-    for(arma::uvec::iterator iter=Pgamma_.begin();iter!=Pgamma_.end();++iter)
+    for(arma::uword index=0;index<Pgamma_.n_rows;++index)
     {
-        arma::uword j = *iter;
-        arma::vec a = (*newY_).col(bestDY_.gamma_)*( (*newA_)(bestDY_.gamma_,j) - C_(bestDY_.gamma_,j) );
-        arma::vec b = (*oldY_).col(bestDY_.gamma_)*( (*oldA_)(bestDY_.gamma_,j) - C_(bestDY_.gamma_,j) );
+        arma::uword j = Pgamma_(index);
+        arma::uword e = Pgamma_pairs_(index);
+        arma::vec a = (*newY_).col(bestDY_.gamma_)*( (*newA_)(e) - C_(e) );
+        arma::vec b = (*oldY_).col(bestDY_.gamma_)*( (*oldA_)(e) - C_(e) );
         G_.col(j) += N_*( a - b );
     }
-    for(arma::uvec::iterator iter=Pgamma_.begin();iter!=Pgamma_.end();++iter)
+    for(arma::uword index=0;index<Pgamma_.n_rows;++index)
     {
-        arma::uword i = *iter;
-        G_.col(bestDY_.gamma_) += N_*(*newY_).col(i)*( (*newA_)(i,bestDY_.gamma_) - C_(i,bestDY_.gamma_) );
+        arma::uword i = Pgamma_(index);
+        arma::uword e = Pgamma_pairs_(index);
+        G_.col(bestDY_.gamma_) += N_*(*newY_).col(i)*( (*newA_)(e) - C_(e) );
     }
 }
 
@@ -329,12 +345,12 @@ void PEAC::computePrior(Triplet& tri)
 double PEAC::computeObj()
 {
     double obj = 0.0;
+    #pragma omp parallel for reduction(+:obj)
     for(arma::uword index=0;index<iP_.n_cols;++index)
     {
-        arma::uvec pair = iP_.col(index);
-        arma::uword i = pair(0);
-        arma::uword j = pair(1);
-        double dif = C_(i,j) - arma::accu((*newY_).col(i)%(*newY_).col(j));
+        arma::uword i = iP_(0,index);
+        arma::uword j = iP_(1,index);
+        double dif = C_(index) - arma::dot((*newY_).col(i),(*newY_).col(j));
         obj += N_*(dif*dif);
     }
     return obj;
@@ -35,6 +35,7 @@ public:
             );
 protected:
     void compute();
+    void computeAdjacency();
     void computeCandN();
     void initY_Random();
     void initY_Mean();
@@ -57,12 +58,19 @@ private:
     arma::umat iP_;
     std::vector<Triplet> pq_;
     DY bestDY_;
+    //pairs of each node as CSR over the columns of iP_:
+    //for k in [adj_offsets_(i),adj_offsets_(i+1)) node i is paired with adj_nodes_(k) by pair adj_pairs_(k)
+    arma::uvec adj_offsets_;
+    arma::uvec adj_nodes_;
+    arma::uvec adj_pairs_;
     arma::uvec Pgamma_;
-    std::shared_ptr<arma::sp_mat> oldA_;
-    std::shared_ptr<arma::sp_mat> newA_;
+    arma::uvec Pgamma_pairs_;
+    //A and C are kept per pair, aligned with the columns of iP_
+    std::shared_ptr<arma::vec> oldA_;
+    std::shared_ptr<arma::vec> newA_;
     std::shared_ptr<arma::mat> newY_;
     std::shared_ptr<arma::mat> oldY_;
-    arma::sp_mat C_;
+    arma::vec C_;
     double N_;
     arma::mat G_;
     double step_;
@@ -8,6 +8,8 @@ QT       -= gui
 
 TARGET = DL
 TEMPLATE = lib
+QMAKE_CXXFLAGS += -fopenmp
+LIBS += -lgomp -lpthread
 
 DEFINES += DL_LIBRARY
 
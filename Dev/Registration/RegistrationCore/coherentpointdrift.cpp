@@ -1,8 +1,22 @@
 #include "coherentpointdrift.h"
 #include <cmath>
+#include "nanoflann.hpp"
 namespace Registration
 {
     void CPDBase::stepE()
+    {
+        switch(InfoPtr_->estep)
+        {
+        case KDTree:
+            stepE_kdtree();
+            if(InfoPtr_->check_estep)check_estep();
+            break;
+        default:
+            stepE_dense();
+        }
+    }
+
+    void CPDBase::stepE_dense()
     {
         //initialize the probability matrix
         arma::fmat& X_ = *X_ptr;
@@ -13,19 +27,107 @@ namespace Registration
         }
         //by default D = 3
         float c = std::pow(2*M_PI*var,1.5)*(InfoPtr_->omega/(1-InfoPtr_->omega))*(float(Y_.n_cols)/float(X_.n_cols));
-        float k = - 0.5 / var;
-        for(int r=0;r<P_.n_rows;++r)
-        {
-            arma::fmat tmpm = X_.each_col() - Y_.col(r);
-            P_.row(r) = arma::sum(arma::square(tmpm));
-        }
-        P_ = arma::exp(k*P_);
+        arma::frowvec k(X_.n_cols);
+        k.fill( 0.5 / var );
+        arma::frowvec w(X_.n_cols,arma::fill::ones);
+        GMMKernel::weight(Y_,X_,k,w,P_);
         arma::frowvec p_sum = arma::sum(P_) + c;
         for(int c=0;c<P_.n_cols;++c)
         {
             P_.col(c) /= p_sum(c);
         }
+        P1_ = arma::sum(P_,1);
+        Pt1_ = arma::sum(P_,0);
+        PX_ = X_*P_.t();
     }
-}
 
+    void CPDBase::stepE_kdtree()
+    {
+        typedef nanoflann::KDTreeSingleIndexAdaptor<
+                nanoflann::L2_Simple_Adaptor<float,ArmaKDTreeInterface<arma::fmat>>,
+                ArmaKDTreeInterface<arma::fmat>,
+                3,arma::uword> Tree;
+        typedef std::vector<std::pair<arma::uword,float>> Neighbors;
+        arma::fmat& X_ = *X_ptr;
+        arma::fmat& Y_ = *Y_ptr;
+        //the dense P is not kept in this mode
+        P_.reset();
+        //by default D = 3
+        float c = std::pow(2*M_PI*var,1.5)*(InfoPtr_->omega/(1-InfoPtr_->omega))*(float(Y_.n_cols)/float(X_.n_cols));
+        float k = - 0.5 / var;
+        //beyond this squared distance exp(k*d^2) < trunc_eps
+        float r2 = 2.0*var*std::log(1.0/InfoPtr_->trunc_eps);
+        nanoflann::SearchParams params(32,0,false);
+
+        //pass 1: normalization term of each point in X
+        arma::fvec p_sum(X_.n_cols);
+        {
+            ArmaKDTreeInterface<arma::fmat> points(Y_);
+            Tree tree(3,points,nanoflann::KDTreeSingleIndexAdaptorParams(10));
+            tree.buildIndex();
+            #pragma omp parallel for
+            for(int j=0;j<X_.n_cols;++j)
+            {
+                Neighbors nei;
+                tree.radiusSearch(X_.colptr(j),r2,nei,params);
+                double s = 0.0;
+                for(Neighbors::const_iterator iter=nei.begin();iter!=nei.end();++iter)
+                {
+                    s += std::exp(k*iter->second);
+                }
+                p_sum(j) = s + c;
+            }
+        }
+        Pt1_ = 1.0 - c / p_sum.t();
+
+        //pass 2: gather the normalized weights for each point in Y
+        P1_ = arma::fvec(Y_.n_cols);
+        PX_ = arma::fmat(3,Y_.n_cols);
+        {
+            ArmaKDTreeInterface<arma::fmat> points(X_);
+            Tree tree(3,points,nanoflann::KDTreeSingleIndexAdaptorParams(10));
+            tree.buildIndex();
+            #pragma omp parallel for
+            for(int i=0;i<Y_.n_cols;++i)
+            {
+                Neighbors nei;
+                tree.radiusSearch(Y_.colptr(i),r2,nei,params);
+                double s = 0.0;
+                double px[3] = {0.0,0.0,0.0};
+                for(Neighbors::const_iterator iter=nei.begin();iter!=nei.end();++iter)
+                {
+                    const arma::uword j = iter->first;
+                    const double p = std::exp(k*iter->second) / p_sum(j);
+                    const float* x = X_.colptr(j);
+                    s += p;
+                    px[0] += p*x[0];
+                    px[1] += p*x[1];
+                    px[2] += p*x[2];
+                }
+                P1_(i) = s;
+                PX_(0,i) = px[0];
+                PX_(1,i) = px[1];
+                PX_(2,i) = px[2];
+            }
+        }
+    }
 
+    void CPDBase::check_estep()
+    {
+        arma::fvec P1 = P1_;
+        arma::frowvec Pt1 = Pt1_;
+        arma::fmat PX = PX_;
+        stepE_dense();
+        float e1 = arma::norm(P1 - P1_) / std::max(arma::norm(P1_),std::numeric_limits<float>::epsilon());
+        float et1 = arma::norm(Pt1 - Pt1_) / std::max(arma::norm(Pt1_),std::numeric_limits<float>::epsilon());
+        float ex = arma::norm(PX - PX_,"fro") / std::max(arma::norm(PX_,"fro"),std::numeric_limits<float>::epsilon());
+        std::cerr<<"CPD iter "<<count<<" KDTree E-step relative error:"
+                 <<"P1("<<e1<<"),Pt1("<<et1<<"),PX("<<ex<<")"<<std::endl;
+        InfoPtr_->estep_error = std::max(e1,std::max(et1,ex));
+        //carry on with the accelerated result so the check does not change the iterations
+        P_.reset();
+        P1_ = P1;
+        Pt1_ = Pt1;
+        PX_ = PX;
+    }
+}
@@ -17,6 +17,10 @@ namespace Registration {
             VarBelowThreshold,
             Force
         }EndMode;
+        typedef enum{
+            Dense,//materialize P
+            KDTree//truncated gaussian sum over kd-tree neighbors, P is never materialized
+        }EStepMode;
         typedef struct Info{
             float omega = 0.1;// weight for uniform distribution
             int max_iter = 100;
@@ -25,6 +29,10 @@ namespace Registration {
             bool isApplyed = true;//is transform applied on input matrix source
             bool isScaled = false;
             EndMode mode;
+            EStepMode estep = Dense;
+            float trunc_eps = 1e-4;//gaussian below this ratio to its peak is ignored in KDTree mode
+            bool check_estep = false;//compare KDTree E-step against the dense one every iteration
+            float estep_error = 0.0;//max relative error of P1,Pt1,PX from the last check
             void* result = NULL;
         }Info;
         typedef std::shared_ptr<Info> InfoPtr;
@@ -55,15 +63,15 @@ namespace Registration {
             if(InfoPtr_->isApplyed)Y_ptr = std::shared_ptr<arma::fmat>(new arma::fmat((float*)(source.memptr()),source.n_rows,source.n_cols,false,true));
             else Y_ptr = std::shared_ptr<arma::fmat>(new arma::fmat((float*)(source.memptr()),source.n_rows,source.n_cols,true));
             X_ptr = std::shared_ptr<arma::fmat>(new arma::fmat((float*)(target.memptr()),target.n_rows,target.n_cols,false,true));
-            var = 0.0;
-            for( int idx = 0 ; idx < Y_ptr->n_cols ;++idx)
-            {
-                arma::fmat tmpa = X_ptr->each_col() - Y_ptr->col(idx);
-                arma::fmat tmpb = arma::square(tmpa);
-                arma::frowvec tmpc = arma::sum(tmpb);
-                var += arma::mean(tmpc);
-            }
-            var /= Y_ptr->n_cols;
+            //mean of all pairwise squared distances in closed form
+            //sum_ij|x_j-y_i|^2 = M*sum|x|^2 + N*sum|y|^2 - 2*sum(x).sum(y)
+            double M = Y_ptr->n_cols;
+            double N = X_ptr->n_cols;
+            arma::vec sx = arma::conv_to<arma::vec>::from(arma::sum(*X_ptr,1));
+            arma::vec sy = arma::conv_to<arma::vec>::from(arma::sum(*Y_ptr,1));
+            double xx = arma::accu(arma::square(arma::conv_to<arma::mat>::from(*X_ptr)));
+            double yy = arma::accu(arma::square(arma::conv_to<arma::mat>::from(*Y_ptr)));
+            var = ( M*xx + N*yy - 2.0*arma::dot(sx,sy) ) / ( M*N );
             count = 0;
         }
         void computeOnce(void)
@@ -74,12 +82,18 @@ namespace Registration {
         }
     protected:
         virtual void stepE();
+        virtual void stepE_dense();
+        virtual void stepE_kdtree();
+        virtual void check_estep();
         virtual void stepM()=0;
         virtual bool isEnd()=0;
     protected:
         int count;
         float var;
         arma::fmat P_;
+        arma::fvec P1_;    // P*1 , one for each point of Y
+        arma::frowvec Pt1_;// P.t()*1 , one for each point of X
+        arma::fmat PX_;    // X*P.t() , one col for each point of Y
         std::shared_ptr<arma::fmat> X_ptr;
         std::shared_ptr<arma::fmat> Y_ptr;
         std::shared_ptr<Info> InfoPtr_;
@@ -90,6 +104,9 @@ namespace Registration {
     {
     public:
         using CPDBase::P_;
+        using CPDBase::P1_;
+        using CPDBase::Pt1_;
+        using CPDBase::PX_;
         using CPDBase::X_ptr;
         using CPDBase::Y_ptr;
         using CPDBase::InfoPtr_;
@@ -20,14 +20,15 @@ void CPDRigid3D<M>::stepM()
     arma::fmat& X_ = *X_ptr;
     arma::fmat& Y_ = *Y_ptr;
     //update Center
-    dividebyNp_ = 1.0 / arma::accu(P_);
-    muX = dividebyNp_*arma::sum(X_*(P_.t()),1);
+    dividebyNp_ = 1.0 / arma::accu(Pt1_);
+    muX = dividebyNp_*( X_*Pt1_.t() );
     mX_ = X_.each_col() - muX;
-    muY = dividebyNp_*arma::sum(Y_*P_,1);
+    muY = dividebyNp_*( Y_*P1_ );
     mY_ = Y_.each_col() - muY;
 
     //update Rotation
-    A_ = mX_*P_.t()*mY_.t();
+    //mX_*P_.t()*mY_.t() expanded with the E-step sums
+    A_ = ( PX_ - muX*P1_.t() )*mY_.t();
     arma::fmat U;
     arma::fmat V;
     arma::fvec s;
@@ -46,15 +47,13 @@ void CPDRigid3D<M>::stepM()
     float trAtR = arma::accu(A_%dR);
 
     //trace( mY_ * d(P1) * mY_ )
-    arma::fvec P_SumRow_ = arma::sum(P_,1);
     arma::fmat square_mY_ = arma::square(mY_);
-    square_mY_.each_row() %= (P_SumRow_.t());
+    square_mY_.each_row() %= (P1_.t());
     float trYPY = arma::accu(square_mY_);
 
     //trace( mX.t() * d(P.t()1) * mX )
-    arma::frowvec P_SumCol_ = arma::sum(P_,0);
     arma::fmat square_mX_ = arma::square(mX_);
-    square_mX_.each_row() %= P_SumCol_;
+    square_mX_.each_row() %= Pt1_;
     float trXPX = arma::accu(square_mX_);
 
     //update Scale if required
@@ -128,7 +127,24 @@ bool CPDRigid3D<M>::configure(Config::Ptr& config, InfoPtr& info)
     {
         return true;
     }
-    return false;
+    if(config->has("CPD_estep"))
+    {
+        if(config->getString("CPD_estep")=="KDTree")info->estep = CPDBase::KDTree;
+        else if(config->getString("CPD_estep")=="Dense")info->estep = CPDBase::Dense;
+        else{
+            std::cerr<<"unknown CPD_estep "<<config->getString("CPD_estep")<<" ( Dense or KDTree )"<<std::endl;
+            return false;
+        }
+    }
+    if(config->has("CPD_trunc_eps"))
+    {
+        info->trunc_eps = config->getFloat("CPD_trunc_eps");
+    }
+    if(config->has("CPD_check_estep"))
+    {
+        info->check_estep = ( 0 != config->getInt("CPD_check_estep") );
+    }
+    return true;
 }
 
 template<typename M>
@@ -294,15 +294,9 @@ void JRMPC<M>::stepE()
             alpha_ptrs.emplace_back(new arma::fmat(V_.n_cols,X_.n_cols));
         }
         arma::fmat& alpha = *alpha_ptrs[idx];
-        for(int r=0;r<alpha.n_rows;++r)
-        {
-            arma::fmat tmpm = X_.each_col() - V_.col(r);
-            alpha.row(r) = arma::sum(arma::square(tmpm));
-        }
-        alpha.each_row()%=(-0.5*var);
-        alpha = arma::exp(alpha);
-        alpha.each_row()%=arma::pow(var,1.5);
-        alpha.each_row()%=P_.t();
+        arma::frowvec k = 0.5*var;
+        arma::frowvec w = arma::pow(var,1.5)%P_;
+        GMMKernel::weight(V_,X_,k,w,alpha);
         arma::fvec alpha_rowsum = arma::sum(alpha,1)+beta;
         alpha.each_col()/=alpha_rowsum;
         ++idx;
@@ -440,14 +434,9 @@ void JRMPC<M>::computeOnce(void)
         //allocate alpha
         //compute alpha(step-E)
         arma::fmat& alpha = *alpha_ptrs[idx];
-        #pragma omp parallel for
-        for(int r=0;r<alpha.n_rows;++r)
-        {
-            alpha.row(r) = arma::sum(arma::square(X_.each_col() - V_.col(r)));
-        }
-        alpha.each_row()%=(-0.5*var);
-        alpha = arma::trunc_exp(alpha);
-        alpha.each_row()%=arma::pow(var,1.5)%P_;
+        arma::frowvec k = 0.5*var;
+        arma::frowvec w = arma::pow(var,1.5)%P_;
+        GMMKernel::weight(V_,X_,k,w,alpha);
         alpha_rowsum = arma::sum(alpha,1)+beta;
         alpha.each_col() /= alpha_rowsum;
         //update R t
@@ -561,14 +550,9 @@ void JRMPC<M>::computeOnceJRCS(void)
         arma::fvec& t = *(res_ptr->ts[idx]);
         arma::fmat tX = R*X_;
         tX.each_col() += t;
-        #pragma omp parallel for
-        for(int r=0;r<alpha.n_rows;++r)
-        {
-            alpha.row(r) = arma::sum(arma::square(tX.each_col() - V_.col(r)));
-        }
-        alpha.each_row()%=(-0.5*var);
-        alpha = arma::trunc_exp(alpha);
-        alpha.each_row()%=arma::pow(var,1.5)%P_;
+        arma::frowvec k = 0.5*var;
+        arma::frowvec w = arma::pow(var,1.5)%P_;
+        GMMKernel::weight(V_,tX,k,w,alpha);
         alpha_rowsum = arma::sum(alpha,1)+beta;
         alpha.each_col() /= alpha_rowsum;
         //update R t
@@ -4,6 +4,8 @@ greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 TARGET = RegistrationTool
 CONFIG += console
 CONFIG += c++11
+QMAKE_CXXFLAGS += -fopenmp
+LIBS += -lgomp -lpthread
 DESTDIR = $$OUT_PWD/../../../Dev_RunTime/bin
 
 
@@ -51,7 +51,14 @@ int convertMain(int argc, char *argv[])
         arma::Mat<uint8_t> color((uint8_t*)mesh.vertex_colors(),3,mesh.n_vertices(),false,true);
         color = vc;
     }
-    if(!out_name.empty()&& 0 != mesh.n_vertices() )
+    if( out_name.size() > 7 && 0 == out_name.compare(out_name.size()-7,7,".bundle") && 0 != mesh.n_vertices() )
+    {
+        MeshBundle<DefaultMesh> bundle;
+        bundle.mesh_ = mesh;
+        if(!bundle.save(out_name)){
+            std::cerr<<"can't save to: "<<out_name<<std::endl;
+        }
+    }else if(!out_name.empty()&& 0 != mesh.n_vertices() )
     {
         OpenMesh::IO::Options opt;
         opt+=OpenMesh::IO::Options::Binary;
@@ -24,7 +24,7 @@ int print_usage(int argc, char *argv[] )
               << "     : input vertex with -p"
               << "  -n : input vertex normal\n"
               << "  -c : input vertex color\n"
-              << "  -o : output file\n";
+              << "  -o : output file ( *.bundle for the binary bundle with -p )\n";
 
    return 0;
 }
@@ -5,7 +5,8 @@
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow),
-    alg_thread(NULL)
+    alg_thread(NULL),
+    config_(new Config("./Default.config"))
 {
     ui->setupUi(this);
     MeshListViewerWidget* w = new MeshListViewerWidget(this);
@@ -56,8 +57,9 @@ void MainWindow::start_registration(void)
     if(s==ui->actionCPDRigid3D)
     {
         CPDR3D_DM_R_Thread* thread = new CPDR3D_DM_R_Thread();
-        Config::Ptr config_ptr;
-        if(!thread->init(w->list(),config_ptr))
+        //CPD_estep, CPD_trunc_eps and CPD_check_estep are read from the configure file
+        config_->reload();
+        if(!thread->init(w->list(),config_))
         {
             QString msg = "Fail to Initialize the Registration:\n '";
             msg += QString::fromStdString(thread->errorString());
@@ -86,8 +88,9 @@ void MainWindow::start_registration(void)
     if(s==ui->actionJRMPC)
     {
         JRMPC_Thread* thread = new JRMPC_Thread();
-        Config::Ptr config_ptr;
-        if(!thread->init(w->list(),config_ptr))
+        //JRMPC refuses to start without a configure, the Align_* keys fall back to the defaults
+        config_->reload();
+        if(!thread->init(w->list(),config_))
         {
             QString msg = "Fail to Initialize the Registration:\n '";
             msg += QString::fromStdString(thread->errorString());
@@ -8,6 +8,7 @@
 #include <QKeyEvent>
 #include <QTimer>
 #include <QTime>
+#include "configure.h"
 namespace Ui {
 class MainWindow;
 }
@@ -27,6 +28,7 @@ private:
     QTimer timer;
     QTime time;
     QThread* alg_thread;
+    Config::Ptr config_;
 };
 
 
@@ -24,15 +24,22 @@ int merge(const std::string& Tfile,const std::string& spath,DefaultMesh& result)
         in >> R(2,0); in >> R(2,1); in >> R(2,2); in >> t(2);
         if(file.front()!='#')return -1;
         file.erase(0,1);
-        in_name = spath+"/"+file+".ply";
-        OpenMesh::IO::Options opt;
-        opt+=OpenMesh::IO::Options::Binary;
-        opt+=OpenMesh::IO::Options::VertexColor;
-        opt+=OpenMesh::IO::Options::VertexNormal;
-        mesh.request_vertex_normals();
-        mesh.request_vertex_colors();
-        if(!OpenMesh::IO::read_mesh(mesh,in_name,opt,13)){
-            std::cerr<<"can't load: "<<in_name<<std::endl;
+        MeshBundle<DefaultMesh> bundle;
+        in_name = spath+"/"+file+".bundle";
+        if(bundle.load(in_name))
+        {
+            mesh = bundle.mesh_;
+        }else{
+            in_name = spath+"/"+file+".ply";
+            OpenMesh::IO::Options opt;
+            opt+=OpenMesh::IO::Options::Binary;
+            opt+=OpenMesh::IO::Options::VertexColor;
+            opt+=OpenMesh::IO::Options::VertexNormal;
+            mesh.request_vertex_normals();
+            mesh.request_vertex_colors();
+            if(!OpenMesh::IO::read_mesh(mesh,in_name,opt,13)){
+                std::cerr<<"can't load: "<<in_name<<std::endl;
+            }
         }
         arma::fmat v((float*)mesh.points(),3,mesh.n_vertices(),false,true);
         v = R*v;
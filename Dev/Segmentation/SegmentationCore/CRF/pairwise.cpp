@@ -35,6 +35,8 @@ protected:
 	KernelType ktype_;
 	Permutohedral lattice_;
     arma::vec norm_;
+    // single precision copy of norm_ used by filter
+    arma::frowvec fnorm_;
     arma::mat f_;
     arma::mat parameters_;
     void initLattice( const arma::mat & f ) {
@@ -59,24 +61,20 @@ protected:
 			for ( int i=0; i<N; i++ )
 				norm_[i] = 1.0 / (norm_[i]+1e-20);
 		}
+        fnorm_ = arma::conv_to<arma::frowvec>::from(norm_.t());
 	}
     void filter( arma::mat & out, const arma::mat & in, bool transpose ) const {
+        // The whole filter runs in single precision, the values are converted once each way
+        arma::fmat fout = arma::conv_to<arma::fmat>::from(in);
 		// Read in the values
 		if( ntype_ == NORMALIZE_SYMMETRIC || (ntype_ == NORMALIZE_BEFORE && !transpose) || (ntype_ == NORMALIZE_AFTER && transpose))
-            out = in*arma::diagmat(norm_);
-		else
-			out = in;
+            fout.each_row() %= fnorm_;
 		// Filter
-        arma::fmat fout = arma::conv_to<arma::fmat>::from(out);
-		if( transpose )
-            lattice_.compute( fout, fout, true );
-		else
-            lattice_.compute( fout, fout );
-        // lattice_.compute( out.data(), out.data(), out.rows() );
-        out = arma::conv_to<arma::mat>::from(fout);
+        lattice_.compute( fout, fout, transpose );
 		// Normalize again
 		if( ntype_ == NORMALIZE_SYMMETRIC || (ntype_ == NORMALIZE_BEFORE && transpose) || (ntype_ == NORMALIZE_AFTER && !transpose))
-        out = out*arma::diagmat(norm_);
+            fout.each_row() %= fnorm_;
+        out = arma::conv_to<arma::mat>::from(fout);
 	}
 	// Compute d/df a^T*K*b
     arma::mat kernelGradient( const arma::mat & a, const arma::mat & b ) const {
@@ -179,6 +177,11 @@ PairwisePotential::~PairwisePotential(){
 PairwisePotential::PairwisePotential(const arma::mat & features, LabelCompatibility * compatibility, KernelType ktype, NormalizationType ntype) : compatibility_(compatibility) {
 	kernel_ = new DenseKernel( features, ktype, ntype );
 }
+void PairwisePotential::setCompatibility( LabelCompatibility * compatibility ) {
+	if( compatibility_ != compatibility )
+		delete compatibility_;
+	compatibility_ = compatibility;
+}
 void PairwisePotential::apply(arma::mat & out, const arma::mat & Q) const {
 	kernel_->apply( out, Q );
 	// Apply the compatibility
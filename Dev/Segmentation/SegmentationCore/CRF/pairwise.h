@@ -62,6 +62,9 @@ public:
     PairwisePotential(const arma::mat & features, LabelCompatibility * compatibility, KernelType ktype=CONST_KERNEL, NormalizationType ntype=NORMALIZE_SYMMETRIC);
     void apply(arma::mat & out, const arma::mat & Q) const;
     void applyTranspose(arma::mat & out, const arma::mat & Q) const;
+	// Replace the label compatibility, the kernel and its lattice are kept
+	// (ownership of LabelCompatibility will be transfered to this class)
+	void setCompatibility( LabelCompatibility * compatibility );
 	
 	// Get the parameters
     virtual arma::vec parameters() const;
@@ -39,6 +39,12 @@ inline int round(double X) {
 # define SSE_PERMUTOHEDRAL
 #endif
 
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+// AVX Permutohedral lattice, selected at runtime
+# define AVX_PERMUTOHEDRAL
+# include <immintrin.h>
+#endif
+
 #if defined(SSE_PERMUTOHEDRAL)
 # include <emmintrin.h>
 # include <xmmintrin.h>
@@ -594,12 +600,93 @@ void Permutohedral::sseCompute ( float* out, const float* in, int value_size, bo
 	seqCompute( out, in, value_size, reverse );
 }
 #endif
+#ifdef AVX_PERMUTOHEDRAL
+// Same as sseCompute with 8 values per register, used for the wider label sets
+__attribute__((target("avx")))
+void Permutohedral::avxCompute ( float* out, const float* in, int value_size, bool reverse ) const
+{
+	const int avx_value_size = (value_size+7) / 8;
+	// Shift all values by 1 such that -1 -> 0 (used for blurring)
+	__m256 * avx_val    = (__m256*) _mm_malloc( avx_value_size*sizeof(__m256), 32 );
+	__m256 * values     = (__m256*) _mm_malloc( (M_+2)*avx_value_size*sizeof(__m256), 32 );
+	__m256 * new_values = (__m256*) _mm_malloc( (M_+2)*avx_value_size*sizeof(__m256), 32 );
+	
+	const __m256 Zero = _mm256_setzero_ps();
+	
+	for( int i=0; i<(M_+2)*avx_value_size; i++ )
+		values[i] = new_values[i] = Zero;
+	for( int i=0; i<avx_value_size; i++ )
+		avx_val[i] = Zero;
+	
+	// Splatting
+	for( int i=0;  i<N_; i++ ){
+		memcpy( avx_val, in+i*value_size, value_size*sizeof(float) );
+		for( int j=0; j<=d_; j++ ){
+			int o = offset_[i*(d_+1)+j]+1;
+			__m256 w = _mm256_set1_ps( barycentric_[i*(d_+1)+j] );
+			__m256 * v = values + o*avx_value_size;
+			for( int k=0; k<avx_value_size; k++ )
+				v[k] = _mm256_add_ps( v[k], _mm256_mul_ps( w, avx_val[k] ) );
+		}
+	}
+	// Blurring
+	const __m256 half = _mm256_set1_ps(0.5);
+	for( int j=reverse?d_:0; j<=d_ && j>=0; reverse?j--:j++ ){
+		for( int i=0; i<M_; i++ ){
+			__m256 * old_val = values + (i+1)*avx_value_size;
+			__m256 * new_val = new_values + (i+1)*avx_value_size;
+			
+			int n1 = blur_neighbors_[j*M_+i].n1+1;
+			int n2 = blur_neighbors_[j*M_+i].n2+1;
+			__m256 * n1_val = values + n1*avx_value_size;
+			__m256 * n2_val = values + n2*avx_value_size;
+			for( int k=0; k<avx_value_size; k++ )
+				new_val[k] = _mm256_add_ps( old_val[k], _mm256_mul_ps( half, _mm256_add_ps( n1_val[k], n2_val[k] ) ) );
+		}
+		std::swap( values, new_values );
+	}
+	// Alpha is a magic scaling constant (write Andrew if you really wanna understand this)
+	float alpha = 1.0f / (1+powf(2, -d_));
+	
+	// Slicing
+	for( int i=0; i<N_; i++ ){
+		for( int k=0; k<avx_value_size; k++ )
+			avx_val[ k ] = Zero;
+		for( int j=0; j<=d_; j++ ){
+			int o = offset_[i*(d_+1)+j]+1;
+			__m256 w = _mm256_set1_ps( barycentric_[i*(d_+1)+j] * alpha );
+			const __m256 * v = values + o*avx_value_size;
+			for( int k=0; k<avx_value_size; k++ )
+				avx_val[ k ] = _mm256_add_ps( avx_val[ k ], _mm256_mul_ps( w, v[k] ) );
+		}
+		memcpy( out+i*value_size, avx_val, value_size*sizeof(float) );
+	}
+	
+	_mm_free( avx_val );
+	_mm_free( values );
+	_mm_free( new_values );
+}
+static bool detect_avx()
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx");
+}
+static const bool has_avx_ = detect_avx();
+#else
+void Permutohedral::avxCompute ( float* out, const float* in, int value_size, bool reverse ) const
+{
+	sseCompute( out, in, value_size, reverse );
+}
+static const bool has_avx_ = false;
+#endif
 void Permutohedral::compute ( arma::fmat & out, const arma::fmat & in, bool reverse ) const
 {
     if( out.n_cols != in.n_cols || out.n_rows != in.n_rows )
         out = arma::fmat(in.n_rows,in.n_cols,arma::fill::zeros);
     if( in.n_rows <= 2 )
         seqCompute( (float*)out.memptr(), (float*)in.memptr(), in.n_rows, reverse );
+    else if( in.n_rows > 4 && has_avx_ )
+        avxCompute( (float*)out.memptr(), (float*)in.memptr(), in.n_rows, reverse );
 	else
         sseCompute( (float*)out.memptr(), (float*)in.memptr(), in.n_rows, reverse );
 }
@@ -52,6 +52,7 @@ protected:
 	int N_, M_, d_;
 	void sseCompute ( float* out, const float* in, int value_size, bool reverse=false ) const;
 	void seqCompute ( float* out, const float* in, int value_size, bool reverse=false ) const;
+	void avxCompute ( float* out, const float* in, int value_size, bool reverse=false ) const;
 public:
 	Permutohedral();
     void init ( const arma::fmat & features );
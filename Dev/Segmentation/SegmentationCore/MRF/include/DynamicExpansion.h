@@ -0,0 +1,156 @@
+/* DynamicExpansion.h */
+/* alpha-expansion on a graph that is kept between the moves                                     */
+/* The maxflow follows Boykov and Kolmogorov (see maxflow.cpp) with the search trees reused       */
+/* as in their version 3.0, the residual graphs are recycled as described in                     */
+/*     Dynamic Graph Cuts for Efficient Inference in Markov Random Fields                        */
+/*     Pushmeet Kohli and Philip H.S. Torr. PAMI, December 2007.                                 */
+
+#ifndef __DYNAMICEXPANSION_H__
+#define __DYNAMICEXPANSION_H__
+
+#include <vector>
+#include <deque>
+#include "GCoptimization.h"
+
+/* Nodes and arcs of the expansion moves on a general neighborhood system.                       */
+/* Every pixel is a node of every move, so the arcs are laid out once in compressed rows, with   */
+/* exactly the room counted from the edges that were given.                                      */
+/* For each label the residual graph and the search trees of its last move are kept, the next    */
+/* move on the label only pushes the change of the capacities through them.                      */
+/* The graph outlives the Expansion built on it. When the next problem has the same pixels,      */
+/* labels and edges (only the costs changed) the residuals and the last labeling are reused.     */
+class DynamicGraph
+{
+public:
+    typedef MRF::CostVal captype;
+
+    DynamicGraph();
+
+    /* Starts the neighborhood system of a new problem */
+    void begin(int nPixels, int nLabels);
+
+    /* Adds the edge pix1-pix2, only its weight is stored if it is the same edge as last time */
+    void addEdge(int pix1, int pix2, captype weight);
+
+    /* Ends the neighborhood system and lays out the arcs if it has changed.          */
+    /* Returns true if the residual graphs and the labeling of last time are kept     */
+    bool end();
+
+    int edgeNum(){return m_cursor;}
+    int edgeP(int e){return m_edgeP[e];}
+    int edgeQ(int e){return m_edgeQ[e];}
+    captype weight(int e){return m_weight[e];}
+
+    /* Minimum cut of the move on label. net[i] is the capacity of SOURCE->i minus the one of      */
+    /* i->SINK, cap[e] and rev_cap[e] the capacities of the arcs p->q and q->p of edge e.          */
+    /* The first cut of a label starts from scratch, the following ones from its last residuals    */
+    void cut(int label, const captype* net, const captype* cap, const captype* rev_cap);
+
+    /* Whether pixel i is on the SOURCE side of the last cut of label */
+    bool isSource(int label, int i){return m_trees[label].parent[i] != NONE && !m_trees[label].is_sink[i];}
+
+    void store(const int* labeling);
+    void restore(int* labeling);
+
+private:
+    /* parent of a node that is not in a tree, that hangs from a terminal or that lost its parent */
+    enum { NONE = -1, TERMINAL = -2, ORPHAN = -3 };
+
+    /* residual graph and search trees of the moves on one label */
+    typedef struct TreeStruct
+    {
+        bool valid;
+        int  time;
+        std::vector<captype> r_cap;   /* residual capacity of each arc                    */
+        std::vector<captype> cap;     /* capacity of each arc in the last move            */
+        std::vector<captype> tr_cap;  /* residual SOURCE->i if positive, i->SINK otherwise */
+        std::vector<captype> net;     /* terminal capacities of the last move             */
+        std::vector<int>     parent;  /* arc to the parent, or one of NONE,TERMINAL,ORPHAN */
+        std::vector<int>     ts;
+        std::vector<int>     dist;
+        std::vector<char>    is_sink;
+    } Tree;
+
+    int m_nNodes;
+    int m_nLabels;
+    int m_cursor;
+    bool m_changed;
+
+    std::vector<int> m_edgeP;
+    std::vector<int> m_edgeQ;
+    std::vector<captype> m_weight;
+
+    /* arcs of node i are m_first[i] ... m_first[i+1]-1, arc m_arc[e] goes from p to q of edge e */
+    std::vector<int> m_first;
+    std::vector<int> m_head;
+    std::vector<int> m_sister;
+    std::vector<int> m_arc;
+
+    std::vector<Tree> m_trees;
+    std::vector<int>  m_labeling;
+
+    /* active nodes, the list of node i continues at m_next[i], the last one points to itself */
+    std::vector<int>  m_next;
+    int m_queueFirst[2];
+    int m_queueLast[2];
+    std::deque<int>   m_orphans;
+    /* nodes whose terminal or incident arcs changed since the last cut of the label */
+    std::vector<char> m_marked;
+    std::vector<int>  m_markedList;
+
+    void build();
+    void mark(int i);
+    void setActive(int i);
+    int  nextActive(Tree& t);
+    void setOrphanFront(Tree& t, int i);
+    void setOrphanRear(Tree& t, int i);
+    void maxflowInit(Tree& t);
+    void maxflowReuseInit(Tree& t);
+    void maxflow(Tree& t);
+    void augment(Tree& t, int middle_arc);
+    void processSourceOrphan(Tree& t, int i);
+    void processSinkOrphan(Tree& t, int i);
+    void adopt(Tree& t);
+};
+
+
+/* Expansion for general graphs on a DynamicGraph, which is not owned.                           */
+/* Every move sets the capacities of the same graph instead of building a new one.               */
+class DynamicExpansion: public GCoptimization
+{
+public:
+    DynamicExpansion(PixelType nPixels, int num_labels, EnergyFunction *eng, DynamicGraph *graph);
+
+    void setNeighbors(PixelType pixel1, PixelType pixel2, EnergyTermType weight);
+
+    /* Returns Smooth Energy of current labeling */
+    EnergyType smoothnessEnergy();
+
+    /* Peforms expansion algorithm. Runs the number of iterations specified by max_num_iterations */
+    /* Returns the total energy of labeling   */
+    EnergyType expansion(int max_num_iterations);
+
+    /* Peforms one iteration (one pass over all labels)  of expansion algorithm.*/
+    EnergyType oneExpansionIteration();
+
+    /* Peforms  expansion on one label, specified by the input parameter alpha_label */
+    EnergyType alpha_expansion(LabelType alpha_label);
+
+protected:
+    void optimizeAlg(int nIterations);
+
+private:
+    DynamicGraph *m_graph;
+    std::vector<EnergyTermType> m_net;
+    std::vector<EnergyTermType> m_cap;
+    std::vector<EnergyTermType> m_revCap;
+
+    inline EnergyTermType smoothCost(int e, LabelType l1, LabelType l2)
+    {
+        if ( m_smoothType != FUNCTION ) return(m_smoothcost(l1,l2)*m_graph->weight(e));
+        return(smoothFnPix(m_graph->edgeP(e),m_graph->edgeQ(e),l1,l2));
+    }
+    void perform_alpha_expansion(LabelType alpha_label);
+};
+
+#endif
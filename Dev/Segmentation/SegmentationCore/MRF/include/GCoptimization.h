@@ -162,6 +162,10 @@ protected:
      /* (x,y) and (x,y+1) to have labels, respectively, label1 and label2 is f(x,y,label1,label2)            */
      void setSmoothness(SmoothCostGeneralFn cost);
 
+     /* The same two functions with a context pointer passed back to the cost functions                    */
+     void setData(DataCostFnExtra dataFn, void* extra);
+     void setSmoothness(SmoothCostGeneralFnExtra cost, void* extra);
+
 
     virtual void optimizeAlg(int nIterations) = 0;
 
@@ -189,6 +193,19 @@ protected:
     /* Pointers to function for energy terms */
     DataCostFn m_dataFnPix;
     SmoothCostGeneralFn m_smoothFnPix;
+    DataCostFnExtra m_dataFnExtra;
+    SmoothCostGeneralFnExtra m_smoothFnExtra;
+    void* m_dataExtra;
+    void* m_smoothExtra;
+
+    inline EnergyTermType dataFnPix(PixelType pix, LabelType l)
+    {
+        return m_dataFnExtra ? m_dataFnExtra(pix,l,m_dataExtra) : m_dataFnPix(pix,l);
+    }
+    inline EnergyTermType smoothFnPix(PixelType pix1, PixelType pix2, LabelType l1, LabelType l2)
+    {
+        return m_smoothFnExtra ? m_smoothFnExtra(pix1,pix2,l1,l2,m_smoothExtra) : m_smoothFnPix(pix1,pix2,l1,l2);
+    }
 
     void commonGridInitialization( PixelType width, PixelType height, int nLabels);
     void commonNonGridInitialization(PixelType num_pixels, int num_labels);
@@ -51,6 +51,12 @@ public:
     // Functional representation for the general cost function type 
     typedef CostVal (*SmoothCostGeneralFn)(int pix1, int pix2,  Label l1, Label l2); 
 
+    // The same two with a context pointer passed back on every call, so that the costs
+    // can live in an instance instead of globals and several MRFs can be optimized at once.
+    // Only the graph cut algorithms (Expansion and Swap) accept them
+    typedef CostVal (*DataCostFnExtra)(int pix, Label l, void* extra);
+    typedef CostVal (*SmoothCostGeneralFnExtra)(int pix1, int pix2, Label l1, Label l2, void* extra);
+
     // For general smoothness functions, some implementations try to cache all function values in an array
     // for efficiency.  To prevent this, call the following function before calling initialize():
     void dontCacheSmoothnessCosts() {m_allocateArrayForSmoothnessCostFn = false;}
@@ -117,6 +123,7 @@ protected:
     // Following 2 functions set the data costs
     virtual void setData(DataCostFn dcost)=0; 
     virtual void setData(CostVal* data)=0;   
+    virtual void setData(DataCostFnExtra dcost, void* extra);
 
     // *********** SET THE SMOOTHNESS COSTS 
     // following 3 functions set the smoothness costs 
@@ -130,6 +137,7 @@ protected:
     
     // General smoothness cost can be specified by passing pointer to a function 
     virtual  void setSmoothness(SmoothCostGeneralFn cost)=0;
+    virtual  void setSmoothness(SmoothCostGeneralFnExtra cost, void* extra);
 
     // To prevent implementations from caching all general smoothness costs values, the flag below
     // can be set to false by calling dontCacheSmoothnessCosts() before calling initialize():
@@ -174,9 +182,12 @@ public:
     typedef MRF::DataCostFn DataCostFn;
     DataCost(CostVal *cost){m_costArray = cost;m_type = MRF::ARRAY; }
     DataCost(DataCostFn costFn){m_costFn = costFn;m_type = MRF::FUNCTION;}
+    DataCost(MRF::DataCostFnExtra costFn, void* extra){m_costFnExtra = costFn;m_extra = extra;m_type = MRF::FUNCTION;}
 private:
     MRF::CostVal *m_costArray;
     MRF::DataCostFn m_costFn;
+    MRF::DataCostFnExtra m_costFnExtra = 0;
+    void* m_extra = 0;
     MRF::InputType m_type;     
 };
 
@@ -228,9 +239,15 @@ public:
     // Can be used 2D grids and for general graphs
     SmoothnessCost(MRF::SmoothCostGeneralFn costFn){m_costFn = costFn;m_type = MRF::FUNCTION;m_varWeights=false;}
 
+    // Can be used for general graphs with Expansion and Swap, extra is passed back to costFn
+    SmoothnessCost(MRF::SmoothCostGeneralFnExtra costFn, void* extra)
+        {m_costFnExtra = costFn;m_extra = extra;m_type = MRF::FUNCTION;m_varWeights=false;}
+
 private:
     CostVal *m_V,*m_hWeights, *m_vWeights;
     MRF::SmoothCostGeneralFn m_costFn;
+    MRF::SmoothCostGeneralFnExtra m_costFnExtra = 0;
+    void* m_extra = 0;
     MRF::InputType m_type;
     int m_smoothExp;
     CostVal m_smoothMax,m_lambda;
@@ -0,0 +1,798 @@
+#include "MRF/include/DynamicExpansion.h"
+#include <algorithm>
+#include <iostream>
+
+#define INFINITE_D ((int)(((unsigned)-1)/2))
+
+/**************************************************************************************/
+
+DynamicGraph::DynamicGraph()
+{
+    m_nNodes  = -1;
+    m_nLabels = -1;
+    m_cursor  = 0;
+    m_changed = true;
+}
+
+/**************************************************************************************/
+
+void DynamicGraph::begin(int nPixels, int nLabels)
+{
+    if ( nPixels != m_nNodes || nLabels != m_nLabels )
+    {
+        m_changed = true;
+        m_edgeP.clear();
+        m_edgeQ.clear();
+        m_weight.clear();
+    }
+    m_nNodes  = nPixels;
+    m_nLabels = nLabels;
+    m_cursor  = 0;
+}
+
+/**************************************************************************************/
+
+void DynamicGraph::addEdge(int pix1, int pix2, captype weight)
+{
+    if ( pix1 > pix2 ) std::swap(pix1,pix2);
+    if ( !m_changed && m_cursor < (int)m_edgeP.size() && m_edgeP[m_cursor] == pix1 && m_edgeQ[m_cursor] == pix2 )
+    {
+        m_weight[m_cursor++] = weight;
+        return;
+    }
+    if ( !m_changed )
+    {
+        /* the edges from here on differ from last time */
+        m_changed = true;
+        m_edgeP.resize(m_cursor);
+        m_edgeQ.resize(m_cursor);
+        m_weight.resize(m_cursor);
+    }
+    m_edgeP.push_back(pix1);
+    m_edgeQ.push_back(pix2);
+    m_weight.push_back(weight);
+    m_cursor++;
+}
+
+/**************************************************************************************/
+
+bool DynamicGraph::end()
+{
+    if ( m_cursor != (int)m_edgeP.size() )
+    {
+        m_changed = true;
+        m_edgeP.resize(m_cursor);
+        m_edgeQ.resize(m_cursor);
+        m_weight.resize(m_cursor);
+    }
+    if ( !m_changed ) return(true);
+    build();
+    return(false);
+}
+
+/**************************************************************************************/
+
+void DynamicGraph::build()
+{
+    int i,e;
+    const int nEdges = (int)m_edgeP.size();
+
+    /* count the arcs of each node, then fill the rows */
+    m_first.assign(m_nNodes+1,0);
+    for ( e = 0; e < nEdges; e++ )
+    {
+        m_first[m_edgeP[e]+1]++;
+        m_first[m_edgeQ[e]+1]++;
+    }
+    for ( i = 0; i < m_nNodes; i++ ) m_first[i+1] += m_first[i];
+
+    m_head.resize(2*nEdges);
+    m_sister.resize(2*nEdges);
+    m_arc.resize(nEdges);
+    m_next.assign(m_first.begin(),m_first.end()-1);
+    for ( e = 0; e < nEdges; e++ )
+    {
+        int a = m_next[m_edgeP[e]]++;
+        int b = m_next[m_edgeQ[e]]++;
+        m_head[a]   = m_edgeQ[e];
+        m_head[b]   = m_edgeP[e];
+        m_sister[a] = b;
+        m_sister[b] = a;
+        m_arc[e]    = a;
+    }
+
+    m_next.assign(m_nNodes,-1);
+    m_marked.assign(m_nNodes,0);
+    m_markedList.clear();
+    m_labeling.assign(m_nNodes,0);
+    m_trees.resize(m_nLabels);
+    for ( i = 0; i < m_nLabels; i++ ) m_trees[i].valid = false;
+    m_changed = false;
+}
+
+/**************************************************************************************/
+
+void DynamicGraph::store(const int* labeling)
+{
+    std::copy(labeling,labeling+m_nNodes,m_labeling.begin());
+}
+
+/**************************************************************************************/
+
+void DynamicGraph::restore(int* labeling)
+{
+    std::copy(m_labeling.begin(),m_labeling.end(),labeling);
+}
+
+/**************************************************************************************/
+
+void DynamicGraph::cut(int label, const captype* net, const captype* cap, const captype* rev_cap)
+{
+    Tree& t = m_trees[label];
+    const int nEdges = (int)m_arc.size();
+    int i,e;
+
+    if ( !t.valid )
+    {
+        t.r_cap.resize(2*nEdges);
+        for ( e = 0; e < nEdges; e++ )
+        {
+            t.r_cap[m_arc[e]]           = cap[e];
+            t.r_cap[m_sister[m_arc[e]]] = rev_cap[e];
+        }
+        t.cap = t.r_cap;
+        t.net.assign(net,net+m_nNodes);
+        t.tr_cap.assign(net,net+m_nNodes);
+        t.parent.resize(m_nNodes);
+        t.ts.resize(m_nNodes);
+        t.dist.resize(m_nNodes);
+        t.is_sink.resize(m_nNodes);
+        maxflowInit(t);
+        t.valid = true;
+        maxflow(t);
+        return;
+    }
+
+    /* a change of a terminal capacity goes to the residual one as it is */
+    for ( i = 0; i < m_nNodes; i++ )
+    {
+        if ( net[i] == t.net[i] ) continue;
+        t.tr_cap[i] += net[i] - t.net[i];
+        t.net[i] = net[i];
+        mark(i);
+    }
+
+    /* if an arc now carries more flow than its capacity the excess is taken off it */
+    /* and handed to the terminals of its two ends                                   */
+    for ( e = 0; e < 2*nEdges; e++ )
+    {
+        int a = ( e < nEdges ) ? m_arc[e] : m_sister[m_arc[e-nEdges]];
+        captype c = ( e < nEdges ) ? cap[e] : rev_cap[e-nEdges];
+        if ( c == t.cap[a] ) continue;
+        int from = m_head[m_sister[a]];
+        int to   = m_head[a];
+        captype r = t.r_cap[a] + c - t.cap[a];
+        t.cap[a] = c;
+        if ( r < 0 )
+        {
+            t.r_cap[m_sister[a]] += r;
+            if ( t.r_cap[m_sister[a]] < 0 ) t.r_cap[m_sister[a]] = 0;
+            t.tr_cap[from] -= r;
+            t.tr_cap[to]   += r;
+            r = 0;
+        }
+        t.r_cap[a] = r;
+        mark(from);
+        mark(to);
+    }
+
+    maxflowReuseInit(t);
+    maxflow(t);
+}
+
+/**************************************************************************************/
+
+void DynamicGraph::mark(int i)
+{
+    if ( m_marked[i] ) return;
+    m_marked[i] = 1;
+    m_markedList.push_back(i);
+}
+
+/**************************************************************************************/
+
+void DynamicGraph::setActive(int i)
+{
+    if ( m_next[i] >= 0 ) return;
+    if ( m_queueLast[1] >= 0 ) m_next[m_queueLast[1]] = i;
+    else                       m_queueFirst[1] = i;
+    m_queueLast[1] = i;
+    m_next[i] = i;
+}
+
+/**************************************************************************************/
+
+int DynamicGraph::nextActive(Tree& t)
+{
+    int i;
+    while ( 1 )
+    {
+        if ( (i = m_queueFirst[0]) < 0 )
+        {
+            m_queueFirst[0] = i = m_queueFirst[1];
+            m_queueLast[0]  = m_queueLast[1];
+            m_queueFirst[1] = -1;
+            m_queueLast[1]  = -1;
+            if ( i < 0 ) return(-1);
+        }
+        /* remove it from the active list */
+        if ( m_next[i] == i ) m_queueFirst[0] = m_queueLast[0] = -1;
+        else                  m_queueFirst[0] = m_next[i];
+        m_next[i] = -1;
+        /* a node in the list is active iff it has a parent */
+        if ( t.parent[i] != NONE ) return(i);
+    }
+}
+
+/**************************************************************************************/
+
+void DynamicGraph::setOrphanFront(Tree& t, int i)
+{
+    t.parent[i] = ORPHAN;
+    m_orphans.push_front(i);
+}
+
+/**************************************************************************************/
+
+void DynamicGraph::setOrphanRear(Tree& t, int i)
+{
+    t.parent[i] = ORPHAN;
+    m_orphans.push_back(i);
+}
+
+/**************************************************************************************/
+
+void DynamicGraph::maxflowInit(Tree& t)
+{
+    m_queueFirst[0] = m_queueLast[0] = -1;
+    m_queueFirst[1] = m_queueLast[1] = -1;
+    m_orphans.clear();
+    t.time = 0;
+
+    for ( int i = 0; i < m_nNodes; i++ )
+    {
+        m_next[i] = -1;
+        t.ts[i]   = t.time;
+        if ( t.tr_cap[i] > 0 )
+        {
+            /* i is connected to the source */
+            t.is_sink[i] = 0;
+            t.parent[i]  = TERMINAL;
+            setActive(i);
+            t.dist[i]    = 1;
+        }
+        else if ( t.tr_cap[i] < 0 )
+        {
+            /* i is connected to the sink */
+            t.is_sink[i] = 1;
+            t.parent[i]  = TERMINAL;
+            setActive(i);
+            t.dist[i]    = 1;
+        }
+        else t.parent[i] = NONE;
+    }
+}
+
+/**************************************************************************************/
+/* The trees of the last cut stay, only the marked nodes are hung from their terminal again */
+/* or, when they lost it, made orphans together with the children they can no longer feed   */
+
+void DynamicGraph::maxflowReuseInit(Tree& t)
+{
+    int i,j,a;
+
+    m_queueFirst[0] = m_queueLast[0] = -1;
+    m_queueFirst[1] = m_queueLast[1] = -1;
+    m_orphans.clear();
+    t.time++;
+
+    for ( size_t k = 0; k < m_markedList.size(); k++ )
+    {
+        i = m_markedList[k];
+        m_marked[i] = 0;
+        setActive(i);
+
+        if ( t.tr_cap[i] == 0 )
+        {
+            if ( t.parent[i] != NONE ) setOrphanRear(t,i);
+            continue;
+        }
+
+        if ( t.tr_cap[i] > 0 )
+        {
+            if ( t.parent[i] == NONE || t.is_sink[i] )
+            {
+                t.is_sink[i] = 0;
+                for ( a = m_first[i]; a < m_first[i+1]; a++ )
+                {
+                    j = m_head[a];
+                    if ( m_marked[j] ) continue;
+                    if ( t.parent[j] == m_sister[a] ) setOrphanRear(t,j);
+                    if ( t.parent[j] != NONE && t.is_sink[j] && t.r_cap[a] > 0 ) setActive(j);
+                }
+            }
+        }
+        else
+        {
+            if ( t.parent[i] == NONE || !t.is_sink[i] )
+            {
+                t.is_sink[i] = 1;
+                for ( a = m_first[i]; a < m_first[i+1]; a++ )
+                {
+                    j = m_head[a];
+                    if ( m_marked[j] ) continue;
+                    if ( t.parent[j] == m_sister[a] ) setOrphanRear(t,j);
+                    if ( t.parent[j] != NONE && !t.is_sink[j] && t.r_cap[m_sister[a]] > 0 ) setActive(j);
+                }
+            }
+        }
+        t.parent[i] = TERMINAL;
+        t.ts[i]     = t.time;
+        t.dist[i]   = 1;
+    }
+    m_markedList.clear();
+
+    adopt(t);
+}
+
+/**************************************************************************************/
+
+void DynamicGraph::adopt(Tree& t)
+{
+    while ( !m_orphans.empty() )
+    {
+        int i = m_orphans.front();
+        m_orphans.pop_front();
+        if ( t.is_sink[i] ) processSinkOrphan(t,i);
+        else                processSourceOrphan(t,i);
+    }
+}
+
+/**************************************************************************************/
+
+void DynamicGraph::maxflow(Tree& t)
+{
+    int i,j,a,current_node = -1;
+
+    while ( 1 )
+    {
+        if ( (i = current_node) >= 0 )
+        {
+            m_next[i] = -1; /* remove active flag */
+            if ( t.parent[i] == NONE ) i = -1;
+        }
+        if ( i < 0 )
+        {
+            if ( (i = nextActive(t)) < 0 ) break;
+        }
+
+        /* growth */
+        int middle_arc = -1;
+        if ( !t.is_sink[i] )
+        {
+            /* grow source tree */
+            for ( a = m_first[i]; a < m_first[i+1]; a++ )
+            if ( t.r_cap[a] > 0 )
+            {
+                j = m_head[a];
+                if ( t.parent[j] == NONE )
+                {
+                    t.is_sink[j] = 0;
+                    t.parent[j]  = m_sister[a];
+                    t.ts[j]      = t.ts[i];
+                    t.dist[j]    = t.dist[i] + 1;
+                    setActive(j);
+                }
+                else if ( t.is_sink[j] ) { middle_arc = a; break; }
+                else if ( t.ts[j] <= t.ts[i] && t.dist[j] > t.dist[i] )
+                {
+                    /* heuristic - trying to make the distance from j to the source shorter */
+                    t.parent[j] = m_sister[a];
+                    t.ts[j]     = t.ts[i];
+                    t.dist[j]   = t.dist[i] + 1;
+                }
+            }
+        }
+        else
+        {
+            /* grow sink tree */
+            for ( a = m_first[i]; a < m_first[i+1]; a++ )
+            if ( t.r_cap[m_sister[a]] > 0 )
+            {
+                j = m_head[a];
+                if ( t.parent[j] == NONE )
+                {
+                    t.is_sink[j] = 1;
+                    t.parent[j]  = m_sister[a];
+                    t.ts[j]      = t.ts[i];
+                    t.dist[j]    = t.dist[i] + 1;
+                    setActive(j);
+                }
+                else if ( !t.is_sink[j] ) { middle_arc = m_sister[a]; break; }
+                else if ( t.ts[j] <= t.ts[i] && t.dist[j] > t.dist[i] )
+                {
+                    /* heuristic - trying to make the distance from j to the sink shorter */
+                    t.parent[j] = m_sister[a];
+                    t.ts[j]     = t.ts[i];
+                    t.dist[j]   = t.dist[i] + 1;
+                }
+            }
+        }
+
+        t.time++;
+
+        if ( middle_arc >= 0 )
+        {
+            m_next[i] = i; /* set active flag */
+            current_node = i;
+            augment(t,middle_arc);
+            adopt(t);
+        }
+        else current_node = -1;
+    }
+}
+
+/**************************************************************************************/
+
+void DynamicGraph::augment(Tree& t, int middle_arc)
+{
+    int i,a;
+    captype bottleneck;
+
+    /* 1. Finding bottleneck capacity */
+    /* 1a - the source tree */
+    bottleneck = t.r_cap[middle_arc];
+    for ( i = m_head[m_sister[middle_arc]]; ; i = m_head[a] )
+    {
+        a = t.parent[i];
+        if ( a == TERMINAL ) break;
+        if ( bottleneck > t.r_cap[m_sister[a]] ) bottleneck = t.r_cap[m_sister[a]];
+    }
+    if ( bottleneck > t.tr_cap[i] ) bottleneck = t.tr_cap[i];
+    /* 1b - the sink tree */
+    for ( i = m_head[middle_arc]; ; i = m_head[a] )
+    {
+        a = t.parent[i];
+        if ( a == TERMINAL ) break;
+        if ( bottleneck > t.r_cap[a] ) bottleneck = t.r_cap[a];
+    }
+    if ( bottleneck > - t.tr_cap[i] ) bottleneck = - t.tr_cap[i];
+
+    /* 2. Augmenting */
+    /* 2a - the source tree */
+    t.r_cap[m_sister[middle_arc]] += bottleneck;
+    t.r_cap[middle_arc] -= bottleneck;
+    for ( i = m_head[m_sister[middle_arc]]; ; i = m_head[a] )
+    {
+        a = t.parent[i];
+        if ( a == TERMINAL ) break;
+        t.r_cap[a] += bottleneck;
+        t.r_cap[m_sister[a]] -= bottleneck;
+        if ( t.r_cap[m_sister[a]] <= 0 ) setOrphanFront(t,i);
+    }
+    t.tr_cap[i] -= bottleneck;
+    if ( t.tr_cap[i] <= 0 ) setOrphanFront(t,i);
+    /* 2b - the sink tree */
+    for ( i = m_head[middle_arc]; ; i = m_head[a] )
+    {
+        a = t.parent[i];
+        if ( a == TERMINAL ) break;
+        t.r_cap[m_sister[a]] += bottleneck;
+        t.r_cap[a] -= bottleneck;
+        if ( t.r_cap[a] <= 0 ) setOrphanFront(t,i);
+    }
+    t.tr_cap[i] += bottleneck;
+    if ( t.tr_cap[i] >= 0 ) setOrphanFront(t,i);
+}
+
+/**************************************************************************************/
+
+void DynamicGraph::processSourceOrphan(Tree& t, int i)
+{
+    int j,a,a0,a0_min = -1,d,d_min = INFINITE_D;
+
+    /* trying to find a new parent */
+    for ( a0 = m_first[i]; a0 < m_first[i+1]; a0++ )
+    if ( t.r_cap[m_sister[a0]] > 0 )
+    {
+        j = m_head[a0];
+        if ( !t.is_sink[j] && t.parent[j] != NONE )
+        {
+            /* checking the origin of j */
+            d = 0;
+            while ( 1 )
+            {
+                if ( t.ts[j] == t.time )
+                {
+                    d += t.dist[j];
+                    break;
+                }
+                a = t.parent[j];
+                d++;
+                if ( a == TERMINAL )
+                {
+                    t.ts[j]   = t.time;
+                    t.dist[j] = 1;
+                    break;
+                }
+                if ( a == ORPHAN ) { d = INFINITE_D; break; }
+                j = m_head[a];
+            }
+            if ( d < INFINITE_D ) /* j originates from the source - done */
+            {
+                if ( d < d_min )
+                {
+                    a0_min = a0;
+                    d_min  = d;
+                }
+                /* set marks along the path */
+                for ( j = m_head[a0]; t.ts[j] != t.time; j = m_head[t.parent[j]] )
+                {
+                    t.ts[j]   = t.time;
+                    t.dist[j] = d--;
+                }
+            }
+        }
+    }
+
+    if ( a0_min >= 0 )
+    {
+        t.parent[i] = a0_min;
+        t.ts[i]     = t.time;
+        t.dist[i]   = d_min + 1;
+        return;
+    }
+
+    /* no parent is found, process neighbors */
+    t.parent[i] = NONE;
+    for ( a0 = m_first[i]; a0 < m_first[i+1]; a0++ )
+    {
+        j = m_head[a0];
+        a = t.parent[j];
+        if ( !t.is_sink[j] && a != NONE )
+        {
+            if ( t.r_cap[m_sister[a0]] > 0 ) setActive(j);
+            if ( a != TERMINAL && a != ORPHAN && m_head[a] == i ) setOrphanRear(t,j);
+        }
+    }
+}
+
+/**************************************************************************************/
+
+void DynamicGraph::processSinkOrphan(Tree& t, int i)
+{
+    int j,a,a0,a0_min = -1,d,d_min = INFINITE_D;
+
+    /* trying to find a new parent */
+    for ( a0 = m_first[i]; a0 < m_first[i+1]; a0++ )
+    if ( t.r_cap[a0] > 0 )
+    {
+        j = m_head[a0];
+        if ( t.is_sink[j] && t.parent[j] != NONE )
+        {
+            /* checking the origin of j */
+            d = 0;
+            while ( 1 )
+            {
+                if ( t.ts[j] == t.time )
+                {
+                    d += t.dist[j];
+                    break;
+                }
+                a = t.parent[j];
+                d++;
+                if ( a == TERMINAL )
+                {
+                    t.ts[j]   = t.time;
+                    t.dist[j] = 1;
+                    break;
+                }
+                if ( a == ORPHAN ) { d = INFINITE_D; break; }
+                j = m_head[a];
+            }
+            if ( d < INFINITE_D ) /* j originates from the sink - done */
+            {
+                if ( d < d_min )
+                {
+                    a0_min = a0;
+                    d_min  = d;
+                }
+                /* set marks along the path */
+                for ( j = m_head[a0]; t.ts[j] != t.time; j = m_head[t.parent[j]] )
+                {
+                    t.ts[j]   = t.time;
+                    t.dist[j] = d--;
+                }
+            }
+        }
+    }
+
+    if ( a0_min >= 0 )
+    {
+        t.parent[i] = a0_min;
+        t.ts[i]     = t.time;
+        t.dist[i]   = d_min + 1;
+        return;
+    }
+
+    /* no parent is found, process neighbors */
+    t.parent[i] = NONE;
+    for ( a0 = m_first[i]; a0 < m_first[i+1]; a0++ )
+    {
+        j = m_head[a0];
+        a = t.parent[j];
+        if ( t.is_sink[j] && a != NONE )
+        {
+            if ( t.r_cap[a0] > 0 ) setActive(j);
+            if ( a != TERMINAL && a != ORPHAN && m_head[a] == i ) setOrphanRear(t,j);
+        }
+    }
+}
+
+/**************************************************************************************/
+
+DynamicExpansion::DynamicExpansion(PixelType nPixels, int num_labels, EnergyFunction *eng, DynamicGraph *graph):
+    GCoptimization(nPixels,num_labels,eng)
+{
+    m_graph = graph;
+    m_graph->begin(nPixels,num_labels);
+}
+
+/**************************************************************************************/
+
+void DynamicExpansion::setNeighbors(PixelType pixel1, PixelType pixel2, EnergyTermType weight)
+{
+    assert(pixel1 < m_nPixels && pixel1 >= 0 && pixel2 < m_nPixels && pixel2 >= 0);
+    m_graph->addEdge(pixel1,pixel2,weight);
+}
+
+/**************************************************************************************/
+
+GCoptimization::EnergyType DynamicExpansion::smoothnessEnergy()
+{
+    EnergyType eng = (EnergyType) 0;
+
+    for ( int e = 0; e < m_graph->edgeNum(); e++ )
+        eng = eng + smoothCost(e,m_labeling[m_graph->edgeP(e)],m_labeling[m_graph->edgeQ(e)]);
+
+    return(eng);
+}
+
+/**************************************************************************************/
+
+void DynamicExpansion::optimizeAlg(int nIterations)
+{
+    /* start from the answer of last time if only the costs changed */
+    if ( m_graph->end() ) m_graph->restore(m_labeling);
+    expansion(nIterations);
+    m_graph->store(m_labeling);
+}
+
+/**************************************************************************************/
+
+GCoptimization::EnergyType DynamicExpansion::expansion(int max_num_iterations)
+{
+    int curr_cycle = 1;
+    EnergyType new_energy,old_energy;
+
+    new_energy = dataEnergy()+smoothnessEnergy();
+    old_energy = new_energy;
+
+    std::cerr<<"starting expansion iteration"<<std::endl;
+    while ( curr_cycle == 1 || (old_energy > new_energy  && curr_cycle <= max_num_iterations) )
+    {
+        old_energy = new_energy;
+        new_energy = oneExpansionIteration();
+        std::cerr<<old_energy<<"->"<<new_energy<<std::endl;
+        curr_cycle++;
+    }
+
+    return(new_energy);
+}
+
+/**************************************************************************************/
+
+GCoptimization::EnergyType DynamicExpansion::oneExpansionIteration()
+{
+    terminateOnError( m_dataType == NONE,"You have to set up the data cost before running optimization");
+    terminateOnError( m_smoothType == NONE,"You have to set up the smoothness cost before running optimization");
+
+    if (m_random_label_order) scramble_label_table();
+
+    for ( int next = 0;  next < m_nLabels;  next++ )
+        perform_alpha_expansion(m_labelTable[next]);
+
+    return(dataEnergy()+smoothnessEnergy());
+}
+
+/**************************************************************************************/
+
+GCoptimization::EnergyType DynamicExpansion::alpha_expansion(LabelType label)
+{
+    terminateOnError( label < 0 || label >= m_nLabels,"Illegal Label to Expand On");
+    m_graph->end();
+    perform_alpha_expansion(label);
+    return(dataEnergy()+smoothnessEnergy());
+}
+
+/**************************************************************************************/
+/* Every pixel is a variable of the move, a pixel that already has alpha_label gets equal */
+/* costs for both values, so the graph is the same for all the moves                      */
+
+void DynamicExpansion::perform_alpha_expansion(LabelType alpha_label)
+{
+    int i,e,p,q;
+    const int nEdges = m_graph->edgeNum();
+    EnergyTermType A,B,C,D;
+
+    m_net.resize(m_nPixels);
+    m_cap.resize(nEdges);
+    m_revCap.resize(nEdges);
+
+    /* E(0) is the cost of taking alpha_label, E(1) the cost of keeping the label */
+    for ( i = 0; i < m_nPixels; i++ )
+    {
+        if ( m_dataType == ARRAY )
+            m_net[i] = m_datacost(i,m_labeling[i]) - m_datacost(i,alpha_label);
+        else
+            m_net[i] = dataFnPix(i,m_labeling[i]) - dataFnPix(i,alpha_label);
+    }
+
+    /* the same terms as Energy::add_term2() puts in a new graph */
+    for ( e = 0; e < nEdges; e++ )
+    {
+        p = m_graph->edgeP(e);
+        q = m_graph->edgeQ(e);
+        A = smoothCost(e,alpha_label,alpha_label);
+        B = smoothCost(e,alpha_label,m_labeling[q]);
+        C = smoothCost(e,m_labeling[p],alpha_label);
+        D = smoothCost(e,m_labeling[p],m_labeling[q]);
+
+        if ( (A+D) > (C+B) )
+        {
+            EnergyTermType delta = A+D-C-B;
+            EnergyTermType subtrA = delta/3;
+            A = A-subtrA;
+            C = C+subtrA;
+            B = B+(delta-subtrA*2);
+        }
+
+        m_net[p] += D - A;
+        B -= A; C -= D;
+        if ( B < 0 )
+        {
+            m_net[p]    -= B;
+            m_net[q]    += B;
+            m_cap[e]    = 0;
+            m_revCap[e] = B+C;
+        }
+        else if ( C < 0 )
+        {
+            m_net[p]    += C;
+            m_net[q]    -= C;
+            m_cap[e]    = B+C;
+            m_revCap[e] = 0;
+        }
+        else
+        {
+            m_cap[e]    = B;
+            m_revCap[e] = C;
+        }
+    }
+
+    m_graph->cut(alpha_label,m_net.data(),m_cap.data(),m_revCap.data());
+
+    for ( i = 0; i < m_nPixels; i++ )
+        if ( m_labeling[i] != alpha_label && m_graph->isSource(alpha_label,i) )
+            m_labeling[i] = alpha_label;
+}
@@ -72,6 +72,10 @@ void GCoptimization::commonInitialization()
 {
     m_needToFreeV        = 0;
     m_random_label_order = 1;
+    m_dataFnExtra        = 0;
+    m_smoothFnExtra      = 0;
+    m_dataExtra          = 0;
+    m_smoothExtra        = 0;
     initialize_memory();
 }
 
@@ -167,6 +171,22 @@ void GCoptimization::setSmoothness(SmoothCostGeneralFn cost)
 
 /**************************************************************************************/
 
+void GCoptimization::setData(DataCostFnExtra dataFn, void* extra)
+{
+    m_dataFnExtra = dataFn;
+    m_dataExtra   = extra;
+}
+
+/**************************************************************************************/
+
+void GCoptimization::setSmoothness(SmoothCostGeneralFnExtra cost, void* extra)
+{
+    m_smoothFnExtra = cost;
+    m_smoothExtra   = extra;
+}
+
+/**************************************************************************************/
+
 GCoptimization::EnergyType GCoptimization::dataEnergy()
 {
     
@@ -198,7 +218,7 @@ GCoptimization::EnergyType GCoptimization::giveDataEnergyFnPix()
     EnergyType eng = (EnergyType) 0;
 
     for ( int i = 0; i < m_nPixels; i++ )
-        eng = eng + m_dataFnPix(i,m_labeling[i]);
+        eng = eng + dataFnPix(i,m_labeling[i]);
 
     return(eng);
 }
@@ -243,7 +263,7 @@ GCoptimization::EnergyType GCoptimization::giveSmoothEnergy_NG_FnPix()
             {
                 temp = (Neighbor *) m_neighbors[i].next();
                 if ( i < temp->to_node )
-                    eng = eng + m_smoothFnPix(i,temp->to_node, m_labeling[i],m_labeling[temp->to_node]);
+                    eng = eng + smoothFnPix(i,temp->to_node, m_labeling[i],m_labeling[temp->to_node]);
             }
         }
         
@@ -342,14 +362,14 @@ GCoptimization::EnergyType GCoptimization::giveSmoothEnergy_G_FnPix()
         for ( x = 1; x < m_width; x++ )
         {
             pix = x+y*m_width;
-            eng = eng + m_smoothFnPix(pix,pix-1,m_labeling[pix],m_labeling[pix-1]);
+            eng = eng + smoothFnPix(pix,pix-1,m_labeling[pix],m_labeling[pix-1]);
         }
 
     for ( y = 1; y < m_height; y++ )
         for ( x = 0; x < m_width; x++ )
         {
             pix = x+y*m_width;
-            eng = eng + m_smoothFnPix(pix,pix-m_width,m_labeling[pix],m_labeling[pix-m_width]);
+            eng = eng + smoothFnPix(pix,pix-m_width,m_labeling[pix],m_labeling[pix-m_width]);
         }
 
     return(eng);
@@ -423,8 +443,8 @@ void GCoptimization::add_t_links_ARRAY(Energy *e,Energy::Var *variables,int size
 void GCoptimization::add_t_links_FnPix(Energy *e,Energy::Var *variables,int size,LabelType alpha_label)
 {
     for ( int i = 0; i < size; i++ )
-        e -> add_term1(variables[i], m_dataFnPix(m_lookupPixVar[i],alpha_label),
-                                     m_dataFnPix(m_lookupPixVar[i],m_labeling[m_lookupPixVar[i]]));
+        e -> add_term1(variables[i], dataFnPix(m_lookupPixVar[i],alpha_label),
+                                     dataFnPix(m_lookupPixVar[i],m_labeling[m_lookupPixVar[i]]));
 
 }
 /**************************************************************************************/
@@ -573,8 +593,8 @@ void Swap::add_t_links_FnPix_swap(Energy *e,Energy::Var *variables,int size,
                                             PixelType *pixels)
 {
     for ( int i = 0; i < size; i++ )
-        e -> add_term1(variables[i], m_dataFnPix(pixels[i],alpha_label),
-                                     m_dataFnPix(pixels[i],beta_label));
+        e -> add_term1(variables[i], dataFnPix(pixels[i],alpha_label),
+                                     dataFnPix(pixels[i],beta_label));
 
 }
 
@@ -707,14 +727,14 @@ void Swap::set_up_swap_energy_NG_FnPix(int size,LabelType alpha_label,LabelType
                 {
                     if ( pix < nPix )
                         e ->add_term2(variables[i],variables[m_lookupPixVar[nPix]],
-                                      m_smoothFnPix(pix,nPix,alpha_label,alpha_label),
-                                      m_smoothFnPix(pix,nPix,alpha_label,beta_label),
-                                      m_smoothFnPix(pix,nPix,beta_label,alpha_label),
-                                      m_smoothFnPix(pix,nPix,beta_label,beta_label) );
+                                      smoothFnPix(pix,nPix,alpha_label,alpha_label),
+                                      smoothFnPix(pix,nPix,alpha_label,beta_label),
+                                      smoothFnPix(pix,nPix,beta_label,alpha_label),
+                                      smoothFnPix(pix,nPix,beta_label,beta_label) );
                 }
                 else
-                    e ->add_term1(variables[i],m_smoothFnPix(pix,nPix,alpha_label,m_labeling[nPix]),
-                                               m_smoothFnPix(pix,nPix,beta_label,m_labeling[nPix]));
+                    e ->add_term1(variables[i],smoothFnPix(pix,nPix,alpha_label,m_labeling[nPix]),
+                                               smoothFnPix(pix,nPix,beta_label,m_labeling[nPix]));
             }
         }
     }
@@ -740,14 +760,14 @@ void Swap::set_up_swap_energy_G_FnPix(int size,LabelType alpha_label,LabelType b
     
             if ( m_labeling[nPix] == alpha_label || m_labeling[nPix] == beta_label)
                 e ->add_term2(variables[i],variables[m_lookupPixVar[nPix]],
-                              m_smoothFnPix(pix,nPix,alpha_label,alpha_label),
-                              m_smoothFnPix(pix,nPix,alpha_label,beta_label),
-                              m_smoothFnPix(pix,nPix,beta_label,alpha_label),
-                              m_smoothFnPix(pix,nPix,beta_label,beta_label) );
+                              smoothFnPix(pix,nPix,alpha_label,alpha_label),
+                              smoothFnPix(pix,nPix,alpha_label,beta_label),
+                              smoothFnPix(pix,nPix,beta_label,alpha_label),
+                              smoothFnPix(pix,nPix,beta_label,beta_label) );
     
                 else
-                    e ->add_term1(variables[i],m_smoothFnPix(pix,nPix,alpha_label,m_labeling[nPix]),
-                                           m_smoothFnPix(pix,nPix,beta_label,m_labeling[nPix]));
+                    e ->add_term1(variables[i],smoothFnPix(pix,nPix,alpha_label,m_labeling[nPix]),
+                                           smoothFnPix(pix,nPix,beta_label,m_labeling[nPix]));
     
         }   
         if ( y > 0 )
@@ -755,14 +775,14 @@ void Swap::set_up_swap_energy_G_FnPix(int size,LabelType alpha_label,LabelType b
             nPix = pix - m_width;
             if ( m_labeling[nPix] == alpha_label || m_labeling[nPix] == beta_label)
                 e ->add_term2(variables[i],variables[m_lookupPixVar[nPix]],
-                              m_smoothFnPix(pix,nPix,alpha_label,alpha_label),
-                              m_smoothFnPix(pix,nPix,alpha_label,beta_label),
-                              m_smoothFnPix(pix,nPix,beta_label,alpha_label),
-                              m_smoothFnPix(pix,nPix,beta_label,beta_label) );
+                              smoothFnPix(pix,nPix,alpha_label,alpha_label),
+                              smoothFnPix(pix,nPix,alpha_label,beta_label),
+                              smoothFnPix(pix,nPix,beta_label,alpha_label),
+                              smoothFnPix(pix,nPix,beta_label,beta_label) );
     
                 else
-                    e ->add_term1(variables[i],m_smoothFnPix(pix,nPix,alpha_label,m_labeling[nPix]),
-                                           m_smoothFnPix(pix,nPix,beta_label,m_labeling[nPix]));
+                    e ->add_term1(variables[i],smoothFnPix(pix,nPix,alpha_label,m_labeling[nPix]),
+                                           smoothFnPix(pix,nPix,beta_label,m_labeling[nPix]));
         }   
 
         if ( x < m_width - 1 )
@@ -770,8 +790,8 @@ void Swap::set_up_swap_energy_G_FnPix(int size,LabelType alpha_label,LabelType b
             nPix = pix + 1;
     
             if ( !(m_labeling[nPix] == alpha_label || m_labeling[nPix] == beta_label) )
-                    e ->add_term1(variables[i],m_smoothFnPix(pix,nPix,alpha_label,m_labeling[nPix]),
-                                               m_smoothFnPix(pix,nPix,beta_label,m_labeling[nPix]));
+                    e ->add_term1(variables[i],smoothFnPix(pix,nPix,alpha_label,m_labeling[nPix]),
+                                               smoothFnPix(pix,nPix,beta_label,m_labeling[nPix]));
         }   
 
         if ( y < m_height - 1 )
@@ -779,8 +799,8 @@ void Swap::set_up_swap_energy_G_FnPix(int size,LabelType alpha_label,LabelType b
             nPix = pix + m_width;
     
             if ( !(m_labeling[nPix] == alpha_label || m_labeling[nPix] == beta_label) )
-                e ->add_term1(variables[i],m_smoothFnPix(pix,nPix,alpha_label,m_labeling[nPix]),
-                                           m_smoothFnPix(pix,nPix,beta_label,m_labeling[nPix]));
+                e ->add_term1(variables[i],smoothFnPix(pix,nPix,alpha_label,m_labeling[nPix]),
+                                           smoothFnPix(pix,nPix,beta_label,m_labeling[nPix]));
 
         }
     }
@@ -1132,14 +1152,14 @@ void Expansion::set_up_expansion_energy_NG_FnPix(int size, LabelType alpha_label
                 {
                     if ( pix < nPix )
                         e ->add_term2(variables[i],variables[m_lookupPixVar[nPix]],
-                                      m_smoothFnPix(pix,nPix,alpha_label,alpha_label),
-                                      m_smoothFnPix(pix,nPix,alpha_label,m_labeling[nPix]),
-                                      m_smoothFnPix(pix,nPix,m_labeling[pix],alpha_label),
-                                      m_smoothFnPix(pix,nPix,m_labeling[pix],m_labeling[nPix]));
+                                      smoothFnPix(pix,nPix,alpha_label,alpha_label),
+                                      smoothFnPix(pix,nPix,alpha_label,m_labeling[nPix]),
+                                      smoothFnPix(pix,nPix,m_labeling[pix],alpha_label),
+                                      smoothFnPix(pix,nPix,m_labeling[pix],m_labeling[nPix]));
                 }
                 else
-                    e ->add_term1(variables[i],m_smoothFnPix(pix,nPix,alpha_label,m_labeling[nPix]),
-                                               m_smoothFnPix(pix,nPix,m_labeling[pix],alpha_label));
+                    e ->add_term1(variables[i],smoothFnPix(pix,nPix,alpha_label,m_labeling[nPix]),
+                                               smoothFnPix(pix,nPix,m_labeling[pix],alpha_label));
                 
             }
         }
@@ -1303,12 +1323,12 @@ void Expansion::set_up_expansion_energy_G_FnPix(int size, LabelType alpha_label,
 
             if ( m_labeling[nPix] != alpha_label )
                 e ->add_term2(variables[i],variables[m_lookupPixVar[nPix]],
-                              m_smoothFnPix(pix,nPix,alpha_label,alpha_label),
-                              m_smoothFnPix(pix,nPix,alpha_label,m_labeling[nPix]),
-                              m_smoothFnPix(pix,nPix,m_labeling[pix],alpha_label),
-                              m_smoothFnPix(pix,nPix,m_labeling[pix],m_labeling[nPix]));
-            else   e ->add_term1(variables[i],m_smoothFnPix(pix,nPix,alpha_label,m_labeling[nPix]),
-                                 m_smoothFnPix(pix,nPix,m_labeling[pix],alpha_label));
+                              smoothFnPix(pix,nPix,alpha_label,alpha_label),
+                              smoothFnPix(pix,nPix,alpha_label,m_labeling[nPix]),
+                              smoothFnPix(pix,nPix,m_labeling[pix],alpha_label),
+                              smoothFnPix(pix,nPix,m_labeling[pix],m_labeling[nPix]));
+            else   e ->add_term1(variables[i],smoothFnPix(pix,nPix,alpha_label,m_labeling[nPix]),
+                                 smoothFnPix(pix,nPix,m_labeling[pix],alpha_label));
         }   
 
         if ( y < m_height - 1 )
@@ -1317,20 +1337,20 @@ void Expansion::set_up_expansion_energy_G_FnPix(int size, LabelType alpha_label,
 
             if ( m_labeling[nPix] != alpha_label )
                 e ->add_term2(variables[i],variables[m_lookupPixVar[nPix]],
-                              m_smoothFnPix(pix,nPix,alpha_label,alpha_label) ,
-                              m_smoothFnPix(pix,nPix,alpha_label,m_labeling[nPix]),
-                              m_smoothFnPix(pix,nPix,m_labeling[pix],alpha_label) ,
-                              m_smoothFnPix(pix,nPix,m_labeling[pix],m_labeling[nPix]) );
-            else   e ->add_term1(variables[i],m_smoothFnPix(pix,nPix,alpha_label,m_labeling[nPix]),
-                                 m_smoothFnPix(pix,nPix,m_labeling[pix],alpha_label));
+                              smoothFnPix(pix,nPix,alpha_label,alpha_label) ,
+                              smoothFnPix(pix,nPix,alpha_label,m_labeling[nPix]),
+                              smoothFnPix(pix,nPix,m_labeling[pix],alpha_label) ,
+                              smoothFnPix(pix,nPix,m_labeling[pix],m_labeling[nPix]) );
+            else   e ->add_term1(variables[i],smoothFnPix(pix,nPix,alpha_label,m_labeling[nPix]),
+                                 smoothFnPix(pix,nPix,m_labeling[pix],alpha_label));
         }   
         if ( x > 0 )
         {
             nPix = pix - 1;
     
             if ( m_labeling[nPix] == alpha_label )
-               e ->add_term1(variables[i],m_smoothFnPix(pix,nPix,alpha_label,m_labeling[nPix]),
-                                 m_smoothFnPix(pix,nPix,m_labeling[pix],alpha_label) );
+               e ->add_term1(variables[i],smoothFnPix(pix,nPix,alpha_label,m_labeling[nPix]),
+                                 smoothFnPix(pix,nPix,m_labeling[pix],alpha_label) );
         }   
 
         if ( y > 0 )
@@ -1338,8 +1358,8 @@ void Expansion::set_up_expansion_energy_G_FnPix(int size, LabelType alpha_label,
             nPix = pix - m_width;
     
             if ( m_labeling[nPix] == alpha_label )
-               e ->add_term1(variables[i],m_smoothFnPix(pix,nPix,alpha_label,alpha_label),
-                                 m_smoothFnPix(pix,nPix,m_labeling[pix],alpha_label));
+               e ->add_term1(variables[i],smoothFnPix(pix,nPix,alpha_label,alpha_label),
+                                 smoothFnPix(pix,nPix,m_labeling[pix],alpha_label));
         }   
             
     }
@@ -13,10 +13,16 @@ void MRF::initialize()
 
     if ( m_dataType == ARRAY )
         setData(m_e->m_dataCost->m_costArray);
+    else if ( m_e->m_dataCost->m_costFnExtra )
+        setData(m_e->m_dataCost->m_costFnExtra,m_e->m_dataCost->m_extra);
     else  setData(m_e->m_dataCost->m_costFn);
 
     if ( m_smoothType == FUNCTION )
-        setSmoothness(m_e->m_smoothCost->m_costFn);
+    {
+        if ( m_e->m_smoothCost->m_costFnExtra )
+            setSmoothness(m_e->m_smoothCost->m_costFnExtra,m_e->m_smoothCost->m_extra);
+        else setSmoothness(m_e->m_smoothCost->m_costFn);
+    }
     else 
     {
         if ( m_smoothType == ARRAY )
@@ -51,6 +57,20 @@ void MRF::initialize()
 }
 
 
+void MRF::setData(DataCostFnExtra, void*)
+{
+    fprintf(stderr, "Data cost function with context is not supported by this algorithm!\n"); 
+    exit(1); 
+}
+
+
+void MRF::setSmoothness(SmoothCostGeneralFnExtra, void*)
+{
+    fprintf(stderr, "Smoothness cost function with context is not supported by this algorithm!\n"); 
+    exit(1); 
+}
+
+
 void MRF::commonInitialization(EnergyFunction *e)
 {
     m_dataType    = e->m_dataCost->m_type;
@@ -36,6 +36,7 @@ public:
         inputs_ = inputs;
         arma::uvec indices = arma::linspace<arma::uvec>(0,inputs_.n_cols-1,inputs_.n_cols);
         shuffled_indices_ = arma::shuffle(indices);
+        soa_inputs_ = inputs_.cols(arma::shuffle(indices)).t();
     }
     virtual inline void setAxis(const arma::fvec&){std::cerr<<"not implemented setAxis"<<std::endl;}
     virtual inline void setEpsAngle(const float&){std::cerr<<"not implemented setEpsAngle(float&)"<<std::endl;}
@@ -143,6 +144,8 @@ public:
                                const arma::vec& coeff,
                                arma::vec& optimized_coeff)=0;
     virtual uint64_t countWithinDistance(arma::vec& coeff,double threshold)=0;
+    //inliers of each model among the first n points of soa_inputs_ (a random subset of size n)
+    virtual void countWithinDistance(const std::vector<arma::vec>& coeffs,double threshold,uint64_t n,std::vector<uint64_t>& counts)=0;
     virtual void selectWithinDistance(arma::vec& coeff,double threshold,arma::uvec& inliers)=0;
     virtual Model type()=0;
 protected:
@@ -151,6 +154,9 @@ protected:
     virtual int  getSampleSize() const=0;
 protected:
     arma::fmat inputs_;
+    //the inputs as N x 3 in a random order, the columns are the x, y and z arrays
+    //and any leading rows are a random subset for preemptive scoring
+    arma::fmat soa_inputs_;
     arma::uvec shuffled_indices_;
     std::random_device rnd_d_;
     std::mt19937 rnd_gen_;
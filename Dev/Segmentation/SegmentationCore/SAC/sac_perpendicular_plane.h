@@ -9,6 +9,7 @@ public:
     SAC_Perpendicular_Plane():SAC_Plane(),axis_(3,arma::fill::zeros),eps_angle_(M_PI/180.0){}
     virtual inline void setAxis(const arma::fvec&axis){axis_= axis;}
     virtual inline void setEpsAngle(const float&eps){eps_angle_=eps;}
+    using SAC_Plane::countWithinDistance;
     virtual uint64_t countWithinDistance(arma::vec& coeff,double threshold);
     virtual void selectWithinDistance(arma::vec& coeff,double threshold,arma::uvec& inliers);
     virtual Model type(){return PERPENDICULLAR_PLANE;}
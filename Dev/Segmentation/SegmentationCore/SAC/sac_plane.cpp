@@ -1,5 +1,80 @@
 #include "sac_plane.h"
+#include <algorithm>
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define SAC_PLANE_X86
+#include <immintrin.h>
+#endif
 namespace Segmentation {
+//points of a block are scored against one plane per task
+static const uint64_t point_block_ = 16384;
+
+//number of points in [r0,r1) with |c0*x+c1*y+c2*z+c3| < th
+static uint64_t count_plane_scalar(
+        const float* x,const float* y,const float* z,uint64_t r0,uint64_t r1,
+        const float* c,float th
+        )
+{
+    uint64_t count = 0;
+    for(uint64_t r = r0 ; r < r1 ; ++r )
+    {
+        const float d = c[0]*x[r] + c[1]*y[r] + c[2]*z[r] + c[3];
+        count += ( std::abs(d) < th );
+    }
+    return count;
+}
+
+#ifdef SAC_PLANE_X86
+__attribute__((target("avx2,fma")))
+static uint64_t count_plane_avx2(
+        const float* x,const float* y,const float* z,uint64_t r0,uint64_t r1,
+        const float* c,float th
+        )
+{
+    const uint64_t r_simd = r0 + ( ( r1 - r0 ) / 8 ) * 8;
+    const __m256 c0 = _mm256_set1_ps(c[0]);
+    const __m256 c1 = _mm256_set1_ps(c[1]);
+    const __m256 c2 = _mm256_set1_ps(c[2]);
+    const __m256 c3 = _mm256_set1_ps(c[3]);
+    const __m256 t = _mm256_set1_ps(th);
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    //the comparison masks are -1 in the inlier lanes, so subtracting them counts the inliers
+    __m256i acc = _mm256_setzero_si256();
+    for(uint64_t r = r0 ; r < r_simd ; r += 8 )
+    {
+        __m256 d = _mm256_fmadd_ps(c0,_mm256_loadu_ps(x+r),c3);
+        d = _mm256_fmadd_ps(c1,_mm256_loadu_ps(y+r),d);
+        d = _mm256_fmadd_ps(c2,_mm256_loadu_ps(z+r),d);
+        const __m256 in = _mm256_cmp_ps(_mm256_andnot_ps(sign,d),t,_CMP_LT_OQ);
+        acc = _mm256_sub_epi32(acc,_mm256_castps_si256(in));
+    }
+    uint32_t lanes[8];
+    _mm256_storeu_si256((__m256i*)lanes,acc);
+    uint64_t count = 0;
+    for(int i = 0 ; i < 8 ; ++i )count += lanes[i];
+    if( r_simd < r1 )count += count_plane_scalar(x,y,z,r_simd,r1,c,th);
+    return count;
+}
+
+static bool detect_avx2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2")&&__builtin_cpu_supports("fma");
+}
+
+static const bool has_avx2_ = detect_avx2();
+#endif
+
+static inline uint64_t count_plane(
+        const float* x,const float* y,const float* z,uint64_t r0,uint64_t r1,
+        const float* c,float th
+        )
+{
+#ifdef SAC_PLANE_X86
+    if(has_avx2_)return count_plane_avx2(x,y,z,r0,r1,c,th);
+#endif
+    return count_plane_scalar(x,y,z,r0,r1,c,th);
+}
+
 bool SAC_Plane::isSampleGood (const std::vector<int> &samples)const
 {
     // Need an extra check in case the sample selection is empty
@@ -114,21 +189,40 @@ uint64_t SAC_Plane::countWithinDistance(arma::vec& coeff,double threshold)
       std::cerr<<"Invalid number of model coefficients given "<<coeff.size()<<std::endl;
       return (0);
     }
-
-    int nr_p = 0;
-
-    // Iterate through the 3d points and calculate the distances from them to the plane
-    for (size_t i = 0; i < inputs_.n_cols; ++i)
+    std::vector<arma::vec> coeffs(1,coeff);
+    std::vector<uint64_t> counts;
+    countWithinDistance(coeffs,threshold,soa_inputs_.n_rows,counts);
+    return counts[0];
+}
+void SAC_Plane::countWithinDistance(const std::vector<arma::vec>& coeffs,double threshold,uint64_t n,std::vector<uint64_t>& counts)
+{
+    const int64_t H = coeffs.size();
+    counts.assign(H,0);
+    n = std::min<uint64_t>(n,soa_inputs_.n_rows);
+    if( 0 == n || 0 == H )return;
+    std::vector<float> c(4*H,0.0f);
+    for(int64_t h = 0 ; h < H ; ++h )
     {
-      // Calculate the distance from the point to the plane normal as the dot product
-      // D = (P-A).N/|N|
-      arma::vec pt(4);
-      pt.head(3) = arma::conv_to<arma::vec>::from(inputs_.col(i));
-      pt(3) = 1.0;
-      if (std::abs (arma::dot(coeff,pt)) < threshold)
-        nr_p++;
+        if(coeffs[h].size()!=4)continue;
+        for(int i = 0 ; i < 4 ; ++i )c[4*h+i] = coeffs[h](i);
     }
-    return (nr_p);
+    const float* x = soa_inputs_.colptr(0);
+    const float* y = soa_inputs_.colptr(1);
+    const float* z = soa_inputs_.colptr(2);
+    //one task per block and model, so a single model over all the points
+    //and many models over a small subset are both spread over the threads
+    const int64_t block_num = ( n + point_block_ - 1 ) / point_block_;
+    std::vector<uint64_t> partial(block_num*H,0);
+    #pragma omp parallel for schedule(dynamic)
+    for(int64_t task = 0 ; task < block_num*H ; ++task )
+    {
+        const int64_t h = task % H;
+        if(coeffs[h].size()!=4)continue;
+        const uint64_t r0 = uint64_t(task / H)*point_block_;
+        const uint64_t r1 = std::min(n,r0+point_block_);
+        partial[task] = count_plane(x,y,z,r0,r1,&c[4*h],threshold);
+    }
+    for(int64_t task = 0 ; task < block_num*H ; ++task )counts[task%H] += partial[task];
 }
 void SAC_Plane::selectWithinDistance(arma::vec& coeff,double threshold,arma::uvec& inliers)
 {
@@ -139,29 +233,28 @@ void SAC_Plane::selectWithinDistance(arma::vec& coeff,double threshold,arma::uve
       return;
     }
 
-    int nr_p = 0;
+    const int64_t N = inputs_.n_cols;
+    std::vector<float> distance(N);
+    // Calculate the distance from the points to the plane as the dot product
+    // D = (P-A).N/|N|
+    #pragma omp parallel for
+    for (int64_t i = 0; i < N; ++i)
+    {
+        const float* p = inputs_.colptr(i);
+        distance[i] = std::abs( coeff[0]*p[0] + coeff[1]*p[1] + coeff[2]*p[2] + coeff[3] );
+    }
+
     std::vector<arma::uword> inliersvec;
-    inliersvec.reserve(inputs_.n_cols);
+    inliersvec.reserve(N);
     error_sqr_dists_.clear();
-    error_sqr_dists_.reserve(inputs_.n_cols);
-
-    // Iterate through the 3d points and calculate the distances from them to the plane
-    for (size_t i = 0; i < inputs_.n_cols; ++i)
+    error_sqr_dists_.reserve(N);
+    for (int64_t i = 0; i < N; ++i)
     {
-      // Calculate the distance from the point to the plane normal as the dot product
-      // D = (P-A).N/|N|
-        arma::vec pt(4);
-        pt.head(3) = arma::conv_to<arma::vec>::from(inputs_.col(i));
-        pt(3) = 1.0;
-
-      float distance = std::abs (arma::dot(coeff,pt));
-
-      if (distance < threshold)
+      if (distance[i] < threshold)
       {
         // Returns the indices of the points whose distances are smaller than the threshold
         inliersvec.push_back(i);
-        error_sqr_dists_.push_back(distance);
-        ++nr_p;
+        error_sqr_dists_.push_back(distance[i]);
       }
     }
     inliers = arma::conv_to<arma::uvec>::from(inliersvec);
@@ -8,6 +8,7 @@ class SEGMENTATIONCORESHARED_EXPORT SAC_Plane:public SAC_Model
 {
 public:
     using SAC_Model::inputs_;
+    using SAC_Model::soa_inputs_;
     using SAC_Model::shuffled_indices_;
     SAC_Plane():SAC_Model(){}
     virtual bool computeModel(arma::uvec&inliers,arma::vec& coeff);
@@ -15,6 +16,7 @@ public:
                                const arma::vec& coeff,
                                arma::vec& optimized_coeff);
     virtual uint64_t countWithinDistance(arma::vec& coeff,double threshold);
+    virtual void countWithinDistance(const std::vector<arma::vec>& coeffs,double threshold,uint64_t n,std::vector<uint64_t>& counts);
     virtual void selectWithinDistance(arma::vec& coeff,double threshold,arma::uvec& inliers);
     virtual Model type();
 protected:
@@ -17,6 +17,7 @@ SOURCES += segmentationcore.cpp \
     graphcut.cpp \
     MRF/src/BP-S.cpp \
     MRF/src/GCoptimization.cpp \
+    MRF/src/DynamicExpansion.cpp \
     MRF/src/graph.cpp \
     MRF/src/ICM.cpp \
     MRF/src/LinkedBlockList.cpp \
@@ -52,6 +53,7 @@ HEADERS += segmentationcore.h\
     MRF/include/BP-S.h \
     MRF/include/energy.h \
     MRF/include/GCoptimization.h \
+    MRF/include/DynamicExpansion.h \
     MRF/include/graph.h \
     MRF/include/ICM.h \
     MRF/include/LinkedBlockList.h \
@@ -58,6 +58,9 @@ void DenseCRF::addPairwiseEnergy (const arma::mat & features, LabelCompatibility
 void DenseCRF::addPairwiseEnergy ( PairwisePotential* potential ){
 	pairwise_.push_back( potential );
 }
+void DenseCRF::setLabelCompatibility ( int k, LabelCompatibility * function ){
+	pairwise_[k]->setCompatibility( function );
+}
 void DenseCRF2D::addPairwiseGaussian ( float sx, float sy, LabelCompatibility * function, KernelType kernel_type, NormalizationType normalization_type ) {
     arma::mat feature( 2, N_ );
 	for( int j=0; j<H_; j++ )
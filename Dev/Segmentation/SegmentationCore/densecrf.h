@@ -64,6 +64,13 @@ public:
 	// Add your own favorite pairwise potential (ownership will be transfered to this class)
 	void addPairwiseEnergy( PairwisePotential* potential );
 	
+	// Number of pairwise potentials added so far
+	int pairwiseNumber() const { return pairwise_.size(); }
+	
+	// Replace the label compatibility of the k-th pairwise potential without rebuilding its lattice
+	// (ownership of LabelCompatibility will be transfered to this class)
+	void setLabelCompatibility( int k, LabelCompatibility * function );
+	
 	// Set the unary potential (ownership will be transfered to this class)
 	void setUnaryEnergy( UnaryEnergy * unary );
 	// Add a constant unary term
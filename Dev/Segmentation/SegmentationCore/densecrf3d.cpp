@@ -22,7 +22,7 @@ void DenseCRF3D::addPairwiseGaussian(
         )
 {
     arma::fmat feature(3,xyz_.n_cols,arma::fill::zeros);
-    #pragma omp for
+    #pragma omp parallel for
     for(int idx=0;idx<xyz_.n_cols;++idx)
     {
         feature(0,idx) = xyz_(0,idx) / sxyz(0);
@@ -42,7 +42,7 @@ void DenseCRF3D::addPairwiseBilateral(
         )
 {
     arma::fmat feature(6,xyz_.n_cols,arma::fill::zeros);
-    #pragma omp for
+    #pragma omp parallel for
     for(int idx = 0 ; idx < xyz_.n_cols ; ++idx)
     {
         feature(0,idx) = xyz_(0,idx) / sxyz(0);
@@ -60,6 +60,10 @@ void GraphCut::init(Method method)
 //        std::cerr<<"BELIEF"<<std::endl;
         mrf_.reset(new MaxProdBP(numberofPixels,numberofLabels,eng_.get()));
         break;
+    case  DYNAMIC_EXPANSION:
+        if(!graph_)graph_.reset(new DynamicGraph());
+        mrf_.reset(new DynamicExpansion(numberofPixels,numberofLabels,eng_.get(),graph_.get()));
+        break;
     default:
 //        std::cerr<<"EXPANSION"<<std::endl;
         mrf_.reset(new Expansion(numberofPixels,numberofLabels,eng_.get()));
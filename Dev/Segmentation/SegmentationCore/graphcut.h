@@ -6,6 +6,7 @@
 #include "MRF/include/mrf.h"
 #include "MRF/include/GCoptimization.h"
 #include "MRF/include/MaxProdBP.h"
+#include "MRF/include/DynamicExpansion.h"
 namespace Segmentation{
 class SEGMENTATIONCORESHARED_EXPORT GraphCut
 {
@@ -14,7 +15,8 @@ public:
         ICM,
         EXPANSION,
         SWAP,
-        BELIEF
+        BELIEF,
+        DYNAMIC_EXPANSION
     }Method;
     GraphCut();
     ~GraphCut();
@@ -35,6 +37,9 @@ private:
     std::shared_ptr<SmoothnessCost> smooth_;
     std::shared_ptr<EnergyFunction> eng_;
     std::shared_ptr<MRF> mrf_;
+    //kept across init() for DYNAMIC_EXPANSION
+    //the next problem with the same pixels, labels and neighbors starts from the last answer
+    std::shared_ptr<DynamicGraph> graph_;
     std::string info_;
 };
 }
@@ -1,6 +1,7 @@
 #include "hierarchicalization.h"
 #include "pcaplaneequ.h"
 #include <queue>
+#include <limits>
 #include <hash_map>
 Hierarchicalization::Hierarchicalization()
 {
@@ -104,82 +105,164 @@ void Hierarchicalization::getPlaneLabel(arma::uvec&result)
     result = arma::conv_to<arma::uvec>::from(lbl);
 }
 
+//eigenvalues of a symmetric 3x3 matrix in ascending order and the eigenvector of the smallest one
+//A = { a00, a01, a02, a11, a12, a22 }
+static void eig_sym3(const double* A,float* eval,float* evec)
+{
+    const double p1 = A[1]*A[1] + A[2]*A[2] + A[4]*A[4];
+    const double q = ( A[0] + A[3] + A[5] ) / 3.0;
+    const double d0 = A[0] - q, d1 = A[3] - q, d2 = A[5] - q;
+    const double p2 = d0*d0 + d1*d1 + d2*d2 + 2.0*p1;
+    double e[3];
+    if( p2 <= std::numeric_limits<double>::min() )
+    {
+        e[0] = e[1] = e[2] = q;
+    }else{
+        const double p = std::sqrt( p2 / 6.0 );
+        const double b00 = d0 / p, b11 = d1 / p, b22 = d2 / p;
+        const double b01 = A[1] / p, b02 = A[2] / p, b12 = A[4] / p;
+        double r = 0.5*( b00*(b11*b22-b12*b12) - b01*(b01*b22-b12*b02) + b02*(b01*b12-b11*b02) );
+        r = std::max(-1.0,std::min(1.0,r));
+        const double phi = std::acos(r) / 3.0;
+        e[2] = q + 2.0*p*std::cos(phi);
+        e[0] = q + 2.0*p*std::cos(phi+2.0*M_PI/3.0);
+        e[1] = 3.0*q - e[0] - e[2];
+    }
+    eval[0] = e[0];
+    eval[1] = e[1];
+    eval[2] = e[2];
+    //the eigenvector is orthogonal to the rows of A - e0*I, take the best conditioned cross product
+    const double r0[3] = {A[0]-e[0],A[1],A[2]};
+    const double r1[3] = {A[1],A[3]-e[0],A[4]};
+    const double r2[3] = {A[2],A[4],A[5]-e[0]};
+    const double c[3][3] = {
+        {r0[1]*r1[2]-r0[2]*r1[1],r0[2]*r1[0]-r0[0]*r1[2],r0[0]*r1[1]-r0[1]*r1[0]},
+        {r0[1]*r2[2]-r0[2]*r2[1],r0[2]*r2[0]-r0[0]*r2[2],r0[0]*r2[1]-r0[1]*r2[0]},
+        {r1[1]*r2[2]-r1[2]*r2[1],r1[2]*r2[0]-r1[0]*r2[2],r1[0]*r2[1]-r1[1]*r2[0]}
+    };
+    int best = 0;
+    double best_norm = 0.0;
+    for(int i=0;i<3;++i)
+    {
+        const double n = c[i][0]*c[i][0] + c[i][1]*c[i][1] + c[i][2]*c[i][2];
+        if( n > best_norm )
+        {
+            best_norm = n;
+            best = i;
+        }
+    }
+    const double scale = A[0]*A[0] + A[3]*A[3] + A[5]*A[5] + 2.0*p1;
+    if( best_norm > 1e-12*scale*scale )
+    {
+        const double inv = 1.0 / std::sqrt(best_norm);
+        evec[0] = c[best][0]*inv;
+        evec[1] = c[best][1]*inv;
+        evec[2] = c[best][2]*inv;
+    }else{
+        //repeated smallest eigenvalue, any direction in its eigenspace is as good
+        arma::mat::fixed<3,3> m;
+        m(0,0) = A[0];m(0,1) = A[1];m(0,2) = A[2];
+        m(1,0) = A[1];m(1,1) = A[3];m(1,2) = A[4];
+        m(2,0) = A[2];m(2,1) = A[4];m(2,2) = A[5];
+        arma::vec::fixed<3> v;
+        arma::mat::fixed<3,3> vec;
+        arma::eig_sym(v,vec,m);
+        evec[0] = vec(0,0);
+        evec[1] = vec(1,0);
+        evec[2] = vec(2,0);
+    }
+}
+
 void Hierarchicalization::calneighbor(DefaultMesh& mesh)
 {
+    //one tree is built and shared by all the threads, the queries are read only
     MeshKDTreeInterface<DefaultMesh> tree_mesh_(mesh);
     KDTree tree(3,tree_mesh_,nanoflann::KDTreeSingleIndexAdaptorParams(3));
     tree.buildIndex();
-    arma::uword index;
-    float* pptr = (float*)mesh.points();
-    std::vector<std::pair<arma::uword,float>> search_result;
-    std::vector<std::pair<arma::uword,float>>::iterator riter;
-    for(index=0;index<mesh.n_vertices();++index)
+    const arma::uword N = mesh.n_vertices();
+    const float* pptr = (const float*)mesh.points();
+    nei_offsets_.assign(N+1,0);
+    nei_indices_.clear();
+    //search a block of vertices in parallel and append it to the CSR,
+    //so the temporary results never hold more than one block
+    const arma::uword block_size = 65536;
+    std::vector<std::vector<std::pair<arma::uword,float>>> search_result(std::min(block_size,N));
+    for(arma::uword block=0;block<N;block+=block_size)
     {
-        search_result.clear();
-        tree.radiusSearch(pptr,neighbor_radius_,search_result,nanoflann::SearchParams(2));
-        nei[index].index.clear();
-        for(riter=search_result.begin();riter!=search_result.end();++riter)
+        const arma::uword n = std::min(block_size,N-block);
+        #pragma omp parallel for schedule(dynamic,256)
+        for(int64_t i=0;i<int64_t(n);++i)
+        {
+            search_result[i].clear();
+            tree.radiusSearch(pptr+3*(block+i),neighbor_radius_,search_result[i],nanoflann::SearchParams(2));
+        }
+        for(arma::uword i=0;i<n;++i)
+        {
+            nei_offsets_[block+i+1] = nei_offsets_[block+i] + search_result[i].size();
+        }
+        nei_indices_.resize(nei_offsets_[block+n]);
+        #pragma omp parallel for
+        for(int64_t i=0;i<int64_t(n);++i)
         {
-            nei[index].index.push_back(riter->first);
+            uint32_t* dst = nei_indices_.data() + nei_offsets_[block+i];
+            for(size_t j=0;j<search_result[i].size();++j)dst[j] = search_result[i][j].first;
         }
-        pptr += 3;
     }
     if(mesh.has_vertex_normals()&&!force_new_normal_)
     {
         float* nptr = (float*)mesh.vertex_normals();
-        arma::fmat normals(nptr,3,mesh.n_vertices(),false,true);
-        for(index=0;index<mesh.n_vertices();++index)
-        {
-            nei[index].normal = normals.col(index);
-        }
+        nei_normals_ = arma::fmat(nptr,3,N,true,false);
     }else{
-        arma::fvec target, temp;
-        std::vector<arma::fvec> list;
-        long s=0;
-        pcaplaneequ plane;
-        arma::fmat cloud((float*)mesh.points(),3,mesh.n_vertices(),false,true);
-        for (long i=0; i<mesh.n_vertices(); i++)
-            if (nei[i].index.size()>=4)
+        //the plane is fitted to the vertex and its four nearest neighbors
+        //the neighborhoods are sorted by distance (the vertex itself comes first), so no sorting is needed here
+        const float* cloud = (const float*)mesh.points();
+        #pragma omp parallel for
+        for(int64_t i=0;i<int64_t(N);++i)
+        {
+            if(nei_size(i)<4)
             {
-                list.clear();
-                target = cloud.col(i);
-                for (long j=0; j<nei[i].index.size(); j++)
-                {
-                    temp = cloud.col(nei[i].index[j]);
-                    list.push_back(temp);
-                }
-                for (long j=0; j<nei[i].index.size()-1; j++)
-                {
-                    s = j;
-                    for (long k=j+1; k<nei[i].index.size(); k++)
-                        if ( arma::norm( target - list[k] ) < arma::norm( target - list[s]) )
-                            s=k;
-                    if (s!=j)
-                    {
-                        temp = list[j];
-                        list[j] = list[s];
-                        list[s] = temp;
-                    }
-                }
-                plane.clear();
-                plane.push_point(target);
-                for (long j=0; j<nei[i].index.size(); j++)
-                    if (j<4)
-                        plane.push_point(list[j]);
-                    else
-                        break;
-                nei[i].normal = plane.getnormal();
-            }
-            else
                 label_[i] = -1;
+                continue;
+            }
+            const float* target = cloud + 3*i;
+            double mean[3] = {target[0],target[1],target[2]};
+            for(arma::uword j=0;j<4;++j)
+            {
+                const float* p = cloud + 3*nei_at(i,j);
+                mean[0] += p[0];
+                mean[1] += p[1];
+                mean[2] += p[2];
+            }
+            mean[0] /= 5.0;
+            mean[1] /= 5.0;
+            mean[2] /= 5.0;
+            double cov[6] = {0.0,0.0,0.0,0.0,0.0,0.0};
+            for(arma::uword j=0;j<5;++j)
+            {
+                const float* p = 0==j ? target : cloud + 3*nei_at(i,j-1);
+                const double x = p[0] - mean[0];
+                const double y = p[1] - mean[1];
+                const double z = p[2] - mean[2];
+                cov[0] += x*x;
+                cov[1] += x*y;
+                cov[2] += x*z;
+                cov[3] += y*y;
+                cov[4] += y*z;
+                cov[5] += z*z;
+            }
+            for(int k=0;k<6;++k)cov[k] /= 5.0;
+            eig_sym3(cov,nei_evals_.colptr(i),nei_normals_.colptr(i));
+        }
     }
 }
 
 void Hierarchicalization::reset(const DefaultMesh& mesh)
 {
     label_ = arma::ivec(mesh.n_vertices(),arma::fill::zeros);
-    nei.clear();
-    nei.resize(mesh.n_vertices());
+    nei_offsets_.clear();
+    nei_indices_.clear();
+    nei_normals_ = arma::fmat(3,mesh.n_vertices(),arma::fill::zeros);
+    nei_evals_ = arma::fmat(3,mesh.n_vertices(),arma::fill::zeros);
     //set root
     IdNode tempid;
     tempid.id_ = 0;
@@ -336,11 +419,11 @@ void Hierarchicalization::regiongrow(const arma::fmat& cloud,const arma::uword t
             list.push_back(i);
             t[i] = false;
 
-            for (j=0; j<nei[i].index.size(); j++)
-                if ((label_[nei[i].index[j]]==targetid)&&(t[nei[i].index[j]]))
+            for (j=0; j<nei_size(i); j++)
+                if ((label_[nei_at(i,j)]==targetid)&&(t[nei_at(i,j)]))
                 {
-                    list.push_back(nei[i].index[j]);
-                    temp_point = cloud.col(nei[i].index[j]);
+                    list.push_back(nei_at(i,j));
+                    temp_point = cloud.col(nei_at(i,j));
 
                     if (temp_point(0)<x_min) x_min = temp_point(0);
                     if (temp_point(0)>x_max) x_max = temp_point(0);
@@ -350,20 +433,20 @@ void Hierarchicalization::regiongrow(const arma::fmat& cloud,const arma::uword t
                     if (temp_point(2)>z_max) z_max = temp_point(2);
 
                     plane.push_point(temp_point);
-                    t[nei[i].index[j]] = false;
+                    t[nei_at(i,j)] = false;
                     r++;
                 }
 
             while (f<r)
             {
-                for (j=0; j<nei[list[f]].index.size(); j++)
+                for (j=0; j<nei_size(list[f]); j++)
                 {
-                    temp_point = cloud.col(nei[list[f]].index[j]);
+                    temp_point = cloud.col(nei_at(list[f],j));
 
-                    if ((label_[nei[list[f]].index[j]]==targetid)&&	//这个点没被找过
-                            (t[nei[list[f]].index[j]])&&	// 这个点不在队列内
-                            ( ((plane.getsize()<=6)&&(angle(plane.getnormal(), nei[nei[list[f]].index[j]].normal)<anglethres_tight_)) // 这个点的法向和平面法向相差anglethres度
-                              ||((plane.getsize()>6)&&(plane.dist(temp_point)<point2plane_th_)&&(angle(plane.getnormal(), nei[nei[list[f]].index[j]].normal)<anglethres_relax_))))
+                    if ((label_[nei_at(list[f],j)]==targetid)&&	//这个点没被找过
+                            (t[nei_at(list[f],j)])&&	// 这个点不在队列内
+                            ( ((plane.getsize()<=6)&&(angle(plane.getnormal(), nei_normal(nei_at(list[f],j)))<anglethres_tight_)) // 这个点的法向和平面法向相差anglethres度
+                              ||((plane.getsize()>6)&&(plane.dist(temp_point)<point2plane_th_)&&(angle(plane.getnormal(), nei_normal(nei_at(list[f],j)))<anglethres_relax_))))
                     {
                         if (temp_point(0)<x_min) x_min = temp_point(0);
                         if (temp_point(0)>x_max) x_max = temp_point(0);
@@ -371,9 +454,9 @@ void Hierarchicalization::regiongrow(const arma::fmat& cloud,const arma::uword t
                         if (temp_point(1)>y_max) y_max = temp_point(1);
                         if (temp_point(2)<z_min) z_min = temp_point(2);
                         if (temp_point(2)>z_max) z_max = temp_point(2);
-                        list.push_back(nei[list[f]].index[j]);
+                        list.push_back(nei_at(list[f],j));
                         plane.push_point(temp_point);
-                        t[nei[list[f]].index[j]] = false;
+                        t[nei_at(list[f],j)] = false;
                         r++;
                     }
                 }
@@ -420,11 +503,11 @@ void Hierarchicalization::regiongrow(const arma::fmat& cloud,const arma::uword t
             list.push_back(i);
             while (f<r)
             {
-                for (j=0; j<nei[list[f]].index.size(); j++)
-                    if ((label_[nei[list[f]].index[j]]==targetid)&&
-                            (t[nei[list[f]].index[j]]))
+                for (j=0; j<nei_size(list[f]); j++)
+                    if ((label_[nei_at(list[f],j)]==targetid)&&
+                            (t[nei_at(list[f],j)]))
                     {
-                        temp_point = cloud.col(nei[list[f]].index[j]);
+                        temp_point = cloud.col(nei_at(list[f],j));
 
                         if (temp_point(0)<x_min) x_min = temp_point(0);
                         if (temp_point(0)>x_max) x_max = temp_point(0);
@@ -433,8 +516,8 @@ void Hierarchicalization::regiongrow(const arma::fmat& cloud,const arma::uword t
                         if (temp_point(2)<z_min) z_min = temp_point(2);
                         if (temp_point(2)>z_max) z_max = temp_point(2);
 
-                        list.push_back(nei[list[f]].index[j]);
-                        t[nei[list[f]].index[j]]=false;
+                        list.push_back(nei_at(list[f],j));
+                        t[nei_at(list[f],j)]=false;
                         r++;
 
                     }
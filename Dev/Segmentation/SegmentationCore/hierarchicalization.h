@@ -4,14 +4,6 @@
 #include "segmentationcore_global.h"
 #include <armadillo>
 #include <nanoflann.hpp>
-typedef struct
-{
-    arma::fvec::fixed<3> normal;
-    std::vector<arma::uword> index;	// The neighborhood
-    arma::fvec::fixed<3> eval;
-    bool candidate;
-}Neighbor;
-
 typedef struct
 {
     arma::fmat boxmat;
@@ -61,11 +53,19 @@ protected:
     void regiongrow(const arma::fmat& cloud,const arma::uword);
     arma::uvec withinNode(arma::uword);
     arma::uvec withinBox(const arma::fmat&);
+    inline arma::uword nei_size(arma::uword i)const{return nei_offsets_[i+1]-nei_offsets_[i];}
+    inline arma::uword nei_at(arma::uword i,arma::uword j)const{return nei_indices_[nei_offsets_[i]+j];}
+    inline arma::fvec nei_normal(arma::uword i){return nei_normals_.unsafe_col(i);}
 private:
     uint32_t iden;
     uint32_t planenum;
     std::vector<IdNode> idtree_;
-    std::vector<Neighbor> nei;	//output, every voxel's neighborhood
+    //every vertex's neighborhood in CSR, sorted by distance
+    //nei_indices_[nei_offsets_[i]] to nei_indices_[nei_offsets_[i+1]-1] are the neighbors of vertex i
+    std::vector<arma::uword> nei_offsets_;
+    std::vector<uint32_t> nei_indices_;
+    arma::fmat nei_normals_;
+    arma::fmat nei_evals_;
     arma::fmat cloud_;
     arma::ivec label_;
     bool  force_new_normal_;
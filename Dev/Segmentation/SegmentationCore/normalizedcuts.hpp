@@ -308,11 +308,11 @@ void NormalizedCuts<Mesh>::computeW_Graph(typename MeshBundle<Mesh>::Ptr m)
     *W_ = arma::speye(N,N);
     double d_scale = 0;
     double cnt = 0;
-    for(arma::Mat<uint16_t>::iterator niter=graph->voxel_neighbors.begin();niter!=graph->voxel_neighbors.end();   )
+    for(arma::Mat<uint32_t>::iterator niter=graph->voxel_neighbors.begin();niter!=graph->voxel_neighbors.end();   )
     {
-        uint16_t wi = *niter;
+        uint32_t wi = *niter;
         ++niter;
-        uint16_t wj = *niter;
+        uint32_t wj = *niter;
         ++niter;
         arma::fvec p = graph->voxel_centers.col(wi) - graph->voxel_centers.col(wj);
         d_scale += std::sqrt(arma::dot(p,p));
@@ -320,11 +320,11 @@ void NormalizedCuts<Mesh>::computeW_Graph(typename MeshBundle<Mesh>::Ptr m)
     }
     d_scale /= cnt;
     d_scale *= d_scale;
-    for(arma::Mat<uint16_t>::iterator niter=graph->voxel_neighbors.begin();niter!=graph->voxel_neighbors.end();   )
+    for(arma::Mat<uint32_t>::iterator niter=graph->voxel_neighbors.begin();niter!=graph->voxel_neighbors.end();   )
     {
-        uint16_t wi = *niter;
+        uint32_t wi = *niter;
         ++niter;
-        uint16_t wj = *niter;
+        uint32_t wj = *niter;
         ++niter;
         double affinity = vecAffinity<arma::fvec>(
                     graph->voxel_centers.col(wi),
@@ -353,11 +353,11 @@ void NormalizedCuts<Mesh>::debug_convexity(typename MeshBundle<Mesh>::Ptr m)
     graph.voxel_edge_colors = arma::Mat<uint8_t>(4,graph.voxel_neighbors.n_cols,arma::fill::zeros);
     arma::vec conv(graph.voxel_edge_colors.n_cols,arma::fill::zeros);
     arma::vec::iterator conv_iter = conv.begin();
-    for(arma::Mat<uint16_t>::iterator niter=graph.voxel_neighbors.begin();niter!=graph.voxel_neighbors.end();   )
+    for(arma::Mat<uint32_t>::iterator niter=graph.voxel_neighbors.begin();niter!=graph.voxel_neighbors.end();   )
     {
-        uint16_t wi = *niter;
+        uint32_t wi = *niter;
         ++niter;
-        uint16_t wj = *niter;
+        uint32_t wj = *niter;
         ++niter;
         double affinity = convexity<arma::fvec>(
                     graph.voxel_centers.col(wi),
@@ -392,11 +392,11 @@ void NormalizedCuts<Mesh>::debug_color(typename MeshBundle<Mesh>::Ptr m)
     arma::fmat ab = Lab.rows(0,1);
     arma::vec wv(graph.voxel_edge_colors.n_cols,arma::fill::zeros);
     arma::vec::iterator wv_iter = wv.begin();
-    for(arma::Mat<uint16_t>::iterator niter=graph.voxel_neighbors.begin();niter!=graph.voxel_neighbors.end();   )
+    for(arma::Mat<uint32_t>::iterator niter=graph.voxel_neighbors.begin();niter!=graph.voxel_neighbors.end();   )
     {
-        uint16_t wi = *niter;
+        uint32_t wi = *niter;
         ++niter;
-        uint16_t wj = *niter;
+        uint32_t wj = *niter;
         ++niter;
         double affinity = vecAffinity<arma::fvec>(
                     ab.col(wi),
@@ -425,11 +425,11 @@ void NormalizedCuts<Mesh>::debug_dist(typename MeshBundle<Mesh>::Ptr m)
     graph.voxel_edge_colors = arma::Mat<uint8_t>(4,graph.voxel_neighbors.n_cols,arma::fill::zeros);
     arma::vec wv(graph.voxel_edge_colors.n_cols,arma::fill::zeros);
     arma::vec::iterator wv_iter = wv.begin();
-    for(arma::Mat<uint16_t>::iterator niter=graph.voxel_neighbors.begin();niter!=graph.voxel_neighbors.end();   )
+    for(arma::Mat<uint32_t>::iterator niter=graph.voxel_neighbors.begin();niter!=graph.voxel_neighbors.end();   )
     {
-        uint16_t wi = *niter;
+        uint32_t wi = *niter;
         ++niter;
-        uint16_t wj = *niter;
+        uint32_t wj = *niter;
         ++niter;
         double affinity = vecAffinity<arma::fvec>(
                     graph.voxel_centers.col(wi),
@@ -458,11 +458,11 @@ void NormalizedCuts<Mesh>::debug_W(typename MeshBundle<Mesh>::Ptr m)
     graph.voxel_edge_colors = arma::Mat<uint8_t>(4,graph.voxel_neighbors.n_cols,arma::fill::zeros);
     arma::vec wv(graph.voxel_edge_colors.n_cols,arma::fill::zeros);
     arma::vec::iterator wv_iter = wv.begin();
-    for(arma::Mat<uint16_t>::iterator niter=graph.voxel_neighbors.begin();niter!=graph.voxel_neighbors.end();   )
+    for(arma::Mat<uint32_t>::iterator niter=graph.voxel_neighbors.begin();niter!=graph.voxel_neighbors.end();   )
     {
-        uint16_t wi = *niter;
+        uint32_t wi = *niter;
         ++niter;
-        uint16_t wj = *niter;
+        uint32_t wj = *niter;
         ++niter;
         double affinity = vecAffinity<arma::fvec>(
                     graph.voxel_centers.col(wi),
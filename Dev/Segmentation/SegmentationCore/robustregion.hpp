@@ -66,7 +66,7 @@ void RobustRegionDetection<Mesh>::solve_consensus_segment(typename MeshBundle<Me
     //using neighbor and neighbor's neighbor
     std::vector<arma::uword> edge_vec;
     std::vector<std::vector<arma::uword>> nbs(m->graph_.voxel_centers.n_cols);
-    arma::Mat<uint16_t>::iterator iter;
+    arma::Mat<uint32_t>::iterator iter;
     //neighbor
     for(iter=m->graph_.voxel_neighbors.begin();iter!=m->graph_.voxel_neighbors.end();)
     {
@@ -8,7 +8,9 @@ SegmentationRANSAC::SegmentationRANSAC(SAC_Model::Model m):
     probability_(0.99),
     iterations_(0),
     threshold_(0.05),
-    max_iterations_ (1000)
+    max_iterations_ (1000),
+    batch_size_(32),
+    preemptive_size_(1024)
 {
     switch(m)
     {
@@ -32,64 +34,100 @@ bool SegmentationRANSAC::computeModel(void)
     }
 
     iterations_ = 0;
-    int n_best_inliers_count = -INT_MAX;
+    int64_t n_best_inliers_count = -1;
     double k = 1.0;
 
     arma::uvec selection;
     arma::vec model_coefficients;
+    std::vector<arma::uvec> selections;
+    std::vector<arma::vec> coefficients;
+    std::vector<arma::vec> promising;
+    std::vector<size_t> promising_index;
+    std::vector<uint64_t> counts;
 
+    const uint64_t input_size = sac_model_->getInputSize();
     double log_probability  = std::log (1.0 - probability_);
-    double one_over_indices = 1.0 / static_cast<double> (sac_model_->getInputSize());
+    double one_over_indices = 1.0 / static_cast<double> (input_size);
+    // the subset test only pays off when the subset is much smaller than the input
+    const uint64_t preemptive_size = ( 4*preemptive_size_ < input_size ) ? preemptive_size_ : 0;
 
-    int n_inliers_count = 0;
     unsigned skipped_count = 0;
     // supress infinite loops by just allowing 10 x maximum allowed iterations for invalid model parameters!
     const unsigned max_skip = max_iterations_ * 10;
-//    std::cerr<<"Iterate"<<std::endl;
-    while (iterations_ < k && skipped_count < max_skip)
+    bool no_sample = false;
+    while (iterations_ < k && skipped_count < max_skip && !no_sample)
     {
-//      std::cerr<<"Get X samples which satisfy the model criteria"<<std::endl;
-      sac_model_->getSamples (iterations_, selection);
-//      std::cerr<<"Get "<<selection.size()<<" samples which satisfy the model criteria"<<std::endl;
-      if (selection.is_empty ())
+      // the hypotheses of a batch are scored together, the batch never goes beyond the current bound on iterations
+      const double remained = std::min( k - iterations_ , double( max_iterations_ + 1 - iterations_ ) );
+      const size_t batch = size_t( std::max( 1.0 , std::min( double(batch_size_) , std::ceil(remained) ) ) );
+
+      // sampling stays serial since it draws from the random state of the model
+      selections.clear();
+      coefficients.clear();
+      while (selections.size() < batch && skipped_count < max_skip)
       {
-        std::cerr<<"No samples could be selected!"<<std::endl;
-        break;
+        sac_model_->getSamples (iterations_, selection);
+        if (selection.is_empty ())
+        {
+          std::cerr<<"No samples could be selected!"<<std::endl;
+          no_sample = true;
+          break;
+        }
+        if (!sac_model_->computeModel (selection, model_coefficients))
+        {
+          ++skipped_count;
+          continue;
+        }
+        selections.push_back(selection);
+        coefficients.push_back(model_coefficients);
       }
+      if (selections.empty())break;
 
-//      std::cerr<<"Search for inliers in the point cloud for the current plane model M"<<std::endl;
-      if (!sac_model_->computeModel (selection, model_coefficients))
+      // preemptive scoring: a hypothesis is only scored on all the points
+      // if its inlier ratio on the random subset could still beat the best one
+      promising.clear();
+      promising_index.clear();
+      if ( preemptive_size > 0 && n_best_inliers_count >= 0 )
       {
-        //++iterations_;
-        ++skipped_count;
-        continue;
+        sac_model_->countWithinDistance (coefficients, threshold_, preemptive_size, counts);
+        const double w_best = static_cast<double> (n_best_inliers_count) * one_over_indices;
+        for (size_t h = 0; h < coefficients.size(); ++h)
+        {
+          const double w = double(counts[h]) / double(preemptive_size);
+          const double sigma = std::sqrt( std::max( w*(1.0-w) , 1.0 / double(preemptive_size) ) / double(preemptive_size) );
+          if ( w + 3.0*sigma < w_best )continue;
+          promising.push_back(coefficients[h]);
+          promising_index.push_back(h);
+        }
+      }else{
+        promising = coefficients;
+        for (size_t h = 0; h < coefficients.size(); ++h)promising_index.push_back(h);
       }
+      sac_model_->countWithinDistance (promising, threshold_, input_size, counts);
 
-      // Select the inliers that are within threshold_ from the model
-      //sac_model_->selectWithinDistance (model_coefficients, threshold_, inliers);
-      //if (inliers.empty () && k > 1.0)
-      //  continue;
-
-      n_inliers_count = sac_model_->countWithinDistance (model_coefficients, threshold_);
-
-      // Better match ?
-      if (n_inliers_count > n_best_inliers_count)
+      // the hypotheses are compared in the order they are drawn
+      for (size_t i = 0; i < promising.size(); ++i)
       {
-        n_best_inliers_count = n_inliers_count;
+        const int64_t n_inliers_count = counts[i];
+        // Better match ?
+        if (n_inliers_count > n_best_inliers_count)
+        {
+          n_best_inliers_count = n_inliers_count;
 
-//        std::cerr<<"Save the current model/inlier/coefficients selection as being the best so far"<<std::endl;
-        model_              = selection;
-        model_coefficients_ = model_coefficients;
+          // Save the current model/inlier/coefficients selection as being the best so far
+          model_              = selections[promising_index[i]];
+          model_coefficients_ = promising[i];
 
-//        std::cerr<<"Compute the k parameter (k=log(z)/log(1-w^n))"<<std::endl;
-        double w = static_cast<double> (n_best_inliers_count) * one_over_indices;
-        double p_no_outliers = 1.0 - pow (w, static_cast<double> (selection.size ()));
-        p_no_outliers = (std::max) (std::numeric_limits<double>::epsilon (), p_no_outliers);       // Avoid division by -Inf
-        p_no_outliers = (std::min) (1.0 - std::numeric_limits<double>::epsilon (), p_no_outliers);   // Avoid division by 0.
-        k = log_probability / log (p_no_outliers);
+          // Compute the k parameter (k=log(z)/log(1-w^n))
+          double w = static_cast<double> (n_best_inliers_count) * one_over_indices;
+          double p_no_outliers = 1.0 - pow (w, static_cast<double> (model_.size ()));
+          p_no_outliers = (std::max) (std::numeric_limits<double>::epsilon (), p_no_outliers);       // Avoid division by -Inf
+          p_no_outliers = (std::min) (1.0 - std::numeric_limits<double>::epsilon (), p_no_outliers);   // Avoid division by 0.
+          k = log_probability / log (p_no_outliers);
+        }
       }
 
-      ++iterations_;
+      iterations_ += selections.size();
       if (iterations_ > max_iterations_)
       {
         break;
@@ -101,11 +139,7 @@ bool SegmentationRANSAC::computeModel(void)
       inliers_.clear ();
       return (false);
     }
-//    std::cerr<<"Get the set of inliers that correspond to the best model found so far"<<std::endl;
-//    std::cerr<<"n_best_inliers_count:"<<n_best_inliers_count<<std::endl;
     sac_model_->selectWithinDistance (model_coefficients_, threshold_, inliers_);
-//    std::cerr<<"Inliers:"<<inliers_.size()<<std::endl;
     return (true);
 }
 }
-
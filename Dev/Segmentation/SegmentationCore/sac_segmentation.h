@@ -41,6 +41,8 @@ public:
     inline void setThreshold(const float& th){threshold_=th;}
     inline void setAxis(const arma::fvec&axis){sac_model_->setAxis(axis);}
     inline void setEpsAngle(const float&eps){sac_model_->setEpsAngle(eps);}
+    //hypotheses are first scored on this many random points, 0 to always score them on all points
+    inline void setPreemptiveSize(const uint64_t& n){preemptive_size_=n;}
 protected:
     bool computeModel(void);
 private:
@@ -52,6 +54,8 @@ private:
     int max_iterations_;
     int iterations_;
     double probability_;
+    int batch_size_;
+    uint64_t preemptive_size_;
     arma::uvec inliers_;
     arma::uvec model_;
 };
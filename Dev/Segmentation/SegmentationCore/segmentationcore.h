@@ -13,7 +13,6 @@
 namespace Segmentation
 {
 template class SEGMENTATIONCORESHARED_EXPORT  Voxel<DefaultMesh>;
-template class SEGMENTATIONCORESHARED_EXPORT  SuperVoxel<DefaultMesh>;
 template class SEGMENTATIONCORESHARED_EXPORT  DefaultVoxelDistFunctor<DefaultMesh>;
 template class SEGMENTATIONCORESHARED_EXPORT  SuperVoxelClustering<DefaultMesh>;
 template class SEGMENTATIONCORESHARED_EXPORT  RegionGrowing<DefaultMesh>;
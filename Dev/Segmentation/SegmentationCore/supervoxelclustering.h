@@ -7,112 +7,24 @@
 #include "segmentationbase.h"
 #include "common.h"
 namespace Segmentation{
-template<typename M>
-class SuperVoxel;
-
 template<typename M>
 class SuperVoxelClustering;
 
+//read-only view of one voxel ( or one supervoxel centroid ) inside the flat feature arrays
 template<typename M>
 class Voxel
 {
 public:
-    typedef std::shared_ptr<Voxel> Ptr;
-    typedef std::vector<Ptr> PtrList;
-    Voxel(const M&mesh,arma::uvec& indices):
-        mesh_(mesh),
-        points_((float*)mesh.points(),3,mesh.n_vertices(),false,true),
-        normals_((float*)mesh.vertex_normals(),3,mesh.n_vertices(),false,true),
-        colors_((uint8_t*)mesh.vertex_colors(),3,mesh.n_vertices(),false,true),
-        indices_(indices),
-        dist2parent_(std::numeric_limits<float>::max())
-    {
-        xyz_ = arma::mean(points_.cols(indices_),1);
-        normal_ = arma::mean(normals_.cols(indices_),1);
-        normal_ = arma::normalise(normal_);
-        arma::Mat<uint8_t> c = colors_.cols(indices_);
-        arma::fmat fc = arma::conv_to<arma::fmat>::from(c);
-        rgb_ = arma::mean(fc,1);
-        parent_.reset();
-    }
-
-    Voxel(const M& mesh):
-        xyz_(arma::fvec(3,arma::fill::zeros)),
-        rgb_(arma::fvec(3,arma::fill::zeros)),
-        normal_(arma::fvec(3,arma::fill::zeros)),
-        mesh_(mesh),
-        dist2parent_(std::numeric_limits<float>::max())
-    {parent_.reset();}
-
-    inline arma::fvec& xyz(){return xyz_;}
-    inline arma::fvec& normal(){return normal_;}
-    inline arma::fvec& color() {return rgb_;}
-
-    arma::fmat voxels(){return points_.cols(indices_);}
-    arma::fmat normals(){return normals_.cols(indices_);}
-    arma::Mat<uint8_t> colors(){return colors_.cols(indices_);}
-    const arma::uvec& indices()const{return indices_;}
-    void add_neighbor(Ptr n){
-        if(n&&0!=n.use_count())neighbors_.emplace_back(n);
-    }
-    void print_neighbors(void)
-    {
-        typename PtrList::iterator iter;
-        std::clog<<Id_<<":";
-        for(iter=neighbors_.begin();iter!=neighbors_.end();++iter)
-        {
-            std::clog<<(*iter)->Id_<<",";
-        }
-        std::clog<<std::endl;
-        std::clog.flush();
-    }
-
-    std::vector<Ptr> neighbors_;
-    uint32_t Id_;
-    typename SuperVoxel<M>::Ptr parent_;
-    float dist2parent_;
+    Voxel(const float* xyz,const float* normal,const float* rgb):
+        xyz_(xyz),normal_(normal),rgb_(rgb)
+    {}
+    inline const float* xyz()const{return xyz_;}
+    inline const float* normal()const{return normal_;}
+    inline const float* color()const{return rgb_;}
 protected:
-    arma::fvec xyz_;
-    arma::fvec normal_;
-    arma::fvec rgb_;
-
-    const arma::fmat normals_;
-    const arma::fmat points_;
-    const arma::Mat<uint8_t> colors_;
-    const arma::uvec indices_;
-private:
-    const M& mesh_;
-};
-
-template<typename M>
-class SuperVoxel
-{
-public:
-    typedef typename std::vector<typename Voxel<M>::Ptr> VoxelVec;
-    typedef typename std::vector<typename Voxel<M>::Ptr>::iterator VoxelIter;
-    typedef std::shared_ptr<SuperVoxel> Ptr;
-    typedef SuperVoxelClustering<M> Parent;
-    SuperVoxel(const Parent& p,uint32_t l):parent_(p),label_(l){centroid_.reset(new Voxel<M>(*p.input_));}
-    size_t size(){return voxels.size();}
-    void updateCentroid();
-    void expand();
-    void removeVoxel(typename Voxel<M>::Ptr);
-    void addVoxel(typename Voxel<M>::Ptr);
-    void getPointIndices(std::vector<uint32_t>&indices);
-    void getPointIndices(arma::uvec&indices);
-    void getNeighbors(std::vector<uint32_t>&indices);
-    typename Voxel<M>::Ptr centeroid(){return centroid_;}
-    uint32_t getLabel(){return label_;}
-    bool operator()(Ptr& a,Ptr& b)
-    {
-        return b->size() < a->size();
-    }
-
-private:
-    const uint32_t label_;
-    typename Voxel<M>::Ptr centroid_;
-    std::vector<typename Voxel<M>::Ptr> voxels;
-    const Parent& parent_;
+    const float* xyz_;
+    const float* normal_;
+    const float* rgb_;
 };
 
 template<typename M>
@@ -120,11 +32,19 @@ class DefaultVoxelDistFunctor
 {
 public:
     DefaultVoxelDistFunctor():normal_importance_(0.2),color_importance_(0.8),spatial_importance_(0.4){}
-    float dist(const typename Voxel<M>::Ptr& v1,const typename Voxel<M>::Ptr& v2,float seed_res)
+    float dist(const Voxel<M>& v1,const Voxel<M>& v2,float seed_res)
     {
-        float spatial_dist = arma::norm( v1->xyz() - v2->xyz() ) / seed_res;
-        float color_dist = arma::norm( v1->color() - v2->color() ) / 255.0f;
-        float cos_angle_normal = 1.0f - std::abs ( arma::dot( v1->normal() , v2->normal() ) );
+        const float* p1 = v1.xyz();
+        const float* p2 = v2.xyz();
+        const float* c1 = v1.color();
+        const float* c2 = v2.color();
+        const float* n1 = v1.normal();
+        const float* n2 = v2.normal();
+        float dp[3] = { p1[0] - p2[0] , p1[1] - p2[1] , p1[2] - p2[2] };
+        float dc[3] = { c1[0] - c2[0] , c1[1] - c2[1] , c1[2] - c2[2] };
+        float spatial_dist = std::sqrt( dp[0]*dp[0] + dp[1]*dp[1] + dp[2]*dp[2] ) / seed_res;
+        float color_dist = std::sqrt( dc[0]*dc[0] + dc[1]*dc[1] + dc[2]*dc[2] ) / 255.0f;
+        float cos_angle_normal = 1.0f - std::abs ( n1[0]*n2[0] + n1[1]*n2[1] + n1[2]*n2[2] );
         return  cos_angle_normal * normal_importance_ + color_dist * color_importance_+ spatial_dist * spatial_importance_;
     }
     float normal_importance_;
@@ -132,18 +52,18 @@ public:
     float spatial_importance_;
 };
 
+//voxels and supervoxels are kept as structure of arrays:
+//one column per voxel for the features, CSR for the voxel adjacency and the voxel points,
+//and one owner entry per voxel instead of pointer links
 template<typename M>
 class SuperVoxelClustering:public SegmentationBase
 {
 public:
-    typedef std::function<float(const typename Voxel<M>::Ptr&,const typename Voxel<M>::Ptr&)> DistFunc;
+    typedef std::function<float(const Voxel<M>&,const Voxel<M>&)> DistFunc;
     typedef __gnu_cxx::hash_multimap<uint32_t,uint32_t> SuperVoxelsMap;
     typedef __gnu_cxx::hash_multimap<uint32_t,uint32_t> SuperVoxelAdjacency;
     typedef std::shared_ptr<M> MeshPtr;
-    typedef unibn::Octree<arma::fvec,MeshOctreeContainer<M>> SuperVoxelOctree;
-    typedef typename std::vector<typename Voxel<M>::Ptr>::iterator VoxelIter;
-    typedef Voxel<M> Vox;
-    typedef typename std::vector<typename SuperVoxel<M>::Ptr>::iterator SuperVoxelIter;
+    typedef unibn::LinearOctree<arma::fvec,MeshOctreeContainer<M>> SuperVoxelOctree;
     SuperVoxelClustering(float v_res,float seed_res);
     virtual ~SuperVoxelClustering();
 
@@ -152,7 +72,7 @@ public:
     void extract(arma::uvec&labels);
     void extract(SuperVoxelsMap&supervoxel_clusters);
     void getSupervoxelAdjacency(SuperVoxelAdjacency&label_adjacency);
-    void getSupervoxelAdjacency(arma::Mat<uint16_t>&);
+    void getSupervoxelAdjacency(arma::Mat<uint32_t>&);
     void getCentroids(M&cmesh);
     void getCentroids(arma::fmat&);
     void getCentroidColors(arma::Mat<uint8_t>&);
@@ -171,17 +91,41 @@ protected:
     void expandSupervoxels(int depth);
     void makeSupervoxels(SuperVoxelsMap&);
     void makeLabels(arma::uvec&);
+    inline Voxel<M> voxel(uint32_t v)const
+    {
+        return Voxel<M>(voxel_xyz_.colptr(v),voxel_normal_.colptr(v),voxel_rgb_.colptr(v));
+    }
+    inline Voxel<M> centroid(uint32_t s)const
+    {
+        return Voxel<M>(sv_xyz_.colptr(s),sv_normal_.colptr(s),sv_rgb_.colptr(s));
+    }
 protected:
     std::shared_ptr<SuperVoxelOctree> adjacency_octree_;
-    std::vector<typename Voxel<M>::Ptr> voxels_;
-    std::vector<typename SuperVoxel<M>::Ptr> supervoxels_;
     MeshPtr voxel_centroids_;
     M* input_;
+    //voxel features, one column per voxel
+    arma::fmat voxel_xyz_;
+    arma::fmat voxel_normal_;
+    arma::fmat voxel_rgb_;
+    //points of voxel v are voxel_points_[voxel_point_offsets_[v]] ... [voxel_point_offsets_[v+1]-1]
+    arma::Col<uint32_t> voxel_point_offsets_;
+    arma::Col<uint32_t> voxel_points_;
+    //voxel adjacency
+    arma::Col<uint32_t> voxel_adj_offsets_;
+    arma::Col<uint32_t> voxel_adj_indices_;
+    //owning supervoxel of each voxel ( npos if none ) and distance to its centroid
+    arma::Col<uint32_t> voxel_owner_;
+    arma::fvec voxel_dist_;
+    //supervoxel centroids and labels, in output order after expandSupervoxels
+    arma::fmat sv_xyz_;
+    arma::fmat sv_normal_;
+    arma::fmat sv_rgb_;
+    arma::Col<uint32_t> sv_label_;
+    static const uint32_t npos = std::numeric_limits<uint32_t>::max();
 private:
     float seed_resolution_;
     float voxel_resolution_;
     DistFunc dist_;
-    friend class SuperVoxel<M>;
 };
 }
 #include "supervoxelclustering.hpp"
@@ -3,6 +3,9 @@
 #include "nanoflann.hpp"
 #include <utility>
 namespace Segmentation{
+template<typename M>
+const uint32_t SuperVoxelClustering<M>::npos;
+
 template<typename M>
 SuperVoxelClustering<M>::SuperVoxelClustering(float v_res,float seed_res)
     :voxel_resolution_(v_res),seed_resolution_(seed_res)
@@ -71,147 +74,79 @@ void SuperVoxelClustering<M>::extract(SuperVoxelsMap&supervoxel_clusters)
 template<typename M>
 void SuperVoxelClustering<M>::getSupervoxelAdjacency(SuperVoxelAdjacency&label_adjacency)
 {
-    SuperVoxelIter iter;
-    for(iter=supervoxels_.begin();iter!=supervoxels_.end();++iter)
+    arma::Mat<uint32_t> neighbors;
+    getSupervoxelAdjacency(neighbors);
+    for(arma::uword i=0;i<neighbors.n_cols;++i)
     {
-        SuperVoxel<M>& supervoxel = **iter;
-        std::vector<uint32_t> neighbors;
-        supervoxel.getNeighbors(neighbors);
-        uint32_t label = supervoxel.getLabel();
-        std::vector<uint32_t>::iterator labeliter;
-        for(labeliter=neighbors.begin();labeliter!=neighbors.end();++labeliter)
-        {
-            std::pair<uint32_t,uint32_t> p;
-            p.first = label;
-            p.second = *labeliter;
-            label_adjacency.insert(p);
-        }
+        uint32_t s = sv_label_(neighbors(0,i));
+        uint32_t b = sv_label_(neighbors(1,i));
+        label_adjacency.insert(std::make_pair(s,b));
+        label_adjacency.insert(std::make_pair(b,s));
     }
 }
+
 template<typename M>
-void SuperVoxelClustering<M>::getSupervoxelAdjacency(arma::Mat<uint16_t>&neighbors)
+void SuperVoxelClustering<M>::getSupervoxelAdjacency(arma::Mat<uint32_t>&neighbors)
 {
-    SuperVoxelIter iter;
-    std::vector<uint16_t> result;
-    result.reserve(9*supervoxels_.size());
-    arma::sp_umat mem(supervoxels_.size(),supervoxels_.size());
-    __gnu_cxx::hash_map<uint32_t,uint32_t> labeltoindex;
-    uint32_t index = 0;
-    for(iter=supervoxels_.begin();iter!=supervoxels_.end();++iter)
+    //one pair per adjacent voxels with different owners, then sorted and made unique
+    std::vector<uint64_t> pairs;
+    pairs.reserve(voxel_adj_indices_.size()/2);
+    for(uint32_t v=0;v<voxel_owner_.size();++v)
     {
-        SuperVoxel<M>& supervoxel = **iter;
-        std::vector<uint32_t> neighbors;
-        supervoxel.getNeighbors(neighbors);
-        uint32_t label = supervoxel.getLabel();
-//        std::cerr<<label<<std::endl;
-        if(labeltoindex.find(label)==labeltoindex.end());
+        const uint32_t s = voxel_owner_(v);
+        if(npos==s)continue;
+        for(uint32_t i=voxel_adj_offsets_(v);i<voxel_adj_offsets_(v+1);++i)
         {
-            labeltoindex[label] = index;
-            ++index;
-        }
-        std::vector<uint32_t>::iterator labeliter;
-        for(labeliter=neighbors.begin();labeliter!=neighbors.end();++labeliter)
-        {
-            uint32_t s,b;
-            if(label < *labeliter){
-                s = label;
-                b = *labeliter;
-            }else if(label==*labeliter)
-            {
-                continue;
-            }else{
-                b = label;
-                s = *labeliter;
-            }
-            if(0==mem(s,b))
-            {
-                mem(s,b)=1;
-                result.push_back(uint16_t(label));
-                result.push_back(uint16_t(*labeliter));
-            }
+            const uint32_t b = voxel_owner_(voxel_adj_indices_(i));
+            if( npos==b || b <= s )continue;
+            pairs.push_back( ( uint64_t(s) << 32 ) | b );
         }
     }
-
-    std::vector<uint16_t>::iterator riter;
-    for(riter=result.begin();riter!=result.end();++riter)
+    std::sort(pairs.begin(),pairs.end());
+    pairs.erase(std::unique(pairs.begin(),pairs.end()),pairs.end());
+    neighbors = arma::Mat<uint32_t>(2,pairs.size());
+    for(size_t i=0;i<pairs.size();++i)
     {
-        *riter = uint16_t(labeltoindex[uint32_t(*riter)]);
+        neighbors(0,i) = pairs[i] >> 32;
+        neighbors(1,i) = pairs[i] & 0xffffffff;
     }
-    neighbors = arma::Mat<uint16_t>(result.data(),2,result.size()/2,true,true);
 }
 
 template<typename M>
 void SuperVoxelClustering<M>::getCentroids(M&cmesh)
 {
-    std::vector<typename M::VertexHandle> vhandle;
-    SuperVoxelIter iter;
-    for(iter=supervoxels_.begin();iter!=supervoxels_.end();++iter)
+    for(arma::uword s=0;s<sv_xyz_.n_cols;++s)
     {
-        SuperVoxel<M>& supervoxel = **iter;
-        Voxel<M>& center = *supervoxel.centeroid();
-        arma::fvec& c = center.xyz();
-        vhandle.push_back( cmesh.add_vertex( typename M::Point( c(0),c(1),c(2) ) ) );
+        cmesh.add_vertex( typename M::Point( sv_xyz_(0,s),sv_xyz_(1,s),sv_xyz_(2,s) ) );
     }
 }
 
 template<typename M>
 void SuperVoxelClustering<M>::getCentroids(arma::fmat& centers)
 {
-    SuperVoxelIter iter;
-    centers = arma::fmat(3,supervoxels_.size(),arma::fill::ones);
-    int idx = 0;
-    for(iter=supervoxels_.begin();iter!=supervoxels_.end();++iter)
-    {
-        SuperVoxel<M>& supervoxel = **iter;
-        Voxel<M>& center = *supervoxel.centeroid();
-        centers.col(idx) = center.xyz();
-        ++idx;
-    }
+    centers = sv_xyz_;
 }
 
 template<typename M>
 void SuperVoxelClustering<M>::getCentroidNormals(arma::fmat& normals)
 {
-    SuperVoxelIter iter;
-    normals = arma::fmat(3,supervoxels_.size(),arma::fill::ones);
-    int idx = 0;
-    for(iter=supervoxels_.begin();iter!=supervoxels_.end();++iter)
-    {
-        SuperVoxel<M>& supervoxel = **iter;
-        Voxel<M>& center = *supervoxel.centeroid();
-        normals.col(idx) = center.normal();
-        ++idx;
-    }
+    normals = sv_normal_;
 }
 
 template<typename M>
 void SuperVoxelClustering<M>::getCentroidColors(arma::Mat<uint8_t>& colors)
 {
-    SuperVoxelIter iter;
-    colors = arma::Mat<uint8_t>(3,supervoxels_.size(),arma::fill::ones);
-    int idx = 0;
-    for(iter=supervoxels_.begin();iter!=supervoxels_.end();++iter)
-    {
-        SuperVoxel<M>& supervoxel = **iter;
-        Voxel<M>& center = *supervoxel.centeroid();
-        colors.col(idx) = arma::conv_to<arma::Mat<uint8_t>>::from(center.color());
-        ++idx;
-    }
+    colors = arma::conv_to<arma::Mat<uint8_t>>::from(sv_rgb_);
 }
 
 template<typename M>
 void SuperVoxelClustering<M>::getSizes(arma::uvec& sizes)
 {
-    SuperVoxelIter iter;
-    sizes = arma::uvec(supervoxels_.size(),arma::fill::zeros);
-    int idx = 0;
-    for(iter=supervoxels_.begin();iter!=supervoxels_.end();++iter)
+    sizes = arma::uvec(sv_xyz_.n_cols,arma::fill::zeros);
+    for(uint32_t v=0;v<voxel_owner_.size();++v)
     {
-        SuperVoxel<M>& supervoxel = **iter;
-        arma::uvec pointindices;
-        supervoxel.getPointIndices(pointindices);
-        sizes(idx) = pointindices.size();
-        ++idx;
+        if(npos==voxel_owner_(v))continue;
+        sizes(voxel_owner_(v)) += voxel_point_offsets_(v+1) - voxel_point_offsets_(v);
     }
 }
 
@@ -233,30 +168,66 @@ bool SuperVoxelClustering<M>::initCompute()
 template<typename M>
 void SuperVoxelClustering<M>::computeVoxelData()
 {
-    voxels_.clear();
-    voxels_.reserve(adjacency_octree_->getLeafNum());
-    for(int i=0;i<adjacency_octree_->getLeafNum();++i)
+    SuperVoxelOctree& octree = *adjacency_octree_;
+    const int V = octree.getLeafNum();
+    //points of each voxel laid out back to back
+    voxel_point_offsets_ = arma::Col<uint32_t>(V+1);
+    voxel_point_offsets_(0) = 0;
+    std::vector<arma::uvec> leaf_points(V);
+    #pragma omp parallel for
+    for(int v=0;v<V;++v)
     {
-        arma::uvec indices;
-        adjacency_octree_->getPointofLeafAt(i,indices);
-        if(!indices.is_empty())voxels_.emplace_back(new Vox(*input_,indices));
-        else{ std::cerr<<"encounter an empty voxel in octree"<<std::endl; }
+        octree.getPointofLeafAt(v,leaf_points[v]);
     }
-//    std::cerr<<"Compute Voxel Data N:"<<voxels_.size()<<std::endl;
-    OctreeVoxelAdjacency<SuperVoxelOctree> adjacency(*adjacency_octree_);
-    adjacency.template computeNeighbor<Vox>( voxels_ );
-    int min_neighbor_n = 1000;
-    int max_neighbor_n = 0;
-    VoxelIter iter;
-    size_t num = 0;
-    for(iter=voxels_.begin();iter!=voxels_.end();++iter)
+    for(int v=0;v<V;++v)
     {
-        int n = (*iter)->neighbors_.size();
+        voxel_point_offsets_(v+1) = voxel_point_offsets_(v) + leaf_points[v].size();
+    }
+    voxel_points_ = arma::Col<uint32_t>(voxel_point_offsets_(V));
+    const float* points = (const float*)input_->points();
+    const float* normals = (const float*)input_->vertex_normals();
+    const uint8_t* colors = (const uint8_t*)input_->vertex_colors();
+    voxel_xyz_ = arma::fmat(3,V);
+    voxel_normal_ = arma::fmat(3,V);
+    voxel_rgb_ = arma::fmat(3,V);
+    #pragma omp parallel for
+    for(int v=0;v<V;++v)
+    {
+        const arma::uvec& indices = leaf_points[v];
+        uint32_t* out = voxel_points_.memptr() + voxel_point_offsets_(v);
+        double p[3] = {0.0,0.0,0.0};
+        double n[3] = {0.0,0.0,0.0};
+        double c[3] = {0.0,0.0,0.0};
+        for(arma::uword i=0;i<indices.size();++i)
+        {
+            const arma::uword idx = indices(i);
+            out[i] = idx;
+            for(int d=0;d<3;++d)
+            {
+                p[d] += points[3*idx+d];
+                n[d] += normals[3*idx+d];
+                c[d] += colors[3*idx+d];
+            }
+        }
+        const double inv = 1.0 / double(indices.size());
+        const double nn = std::sqrt( n[0]*n[0] + n[1]*n[1] + n[2]*n[2] );
+        for(int d=0;d<3;++d)
+        {
+            voxel_xyz_(d,v) = p[d]*inv;
+            voxel_normal_(d,v) = nn > 0.0 ? n[d] / nn : 0.0;
+            voxel_rgb_(d,v) = c[d]*inv;
+        }
+    }
+    OctreeVoxelAdjacency<SuperVoxelOctree> adjacency(octree);
+    adjacency.computeNeighbor(voxel_adj_offsets_,voxel_adj_indices_);
+    uint32_t min_neighbor_n = 1000;
+    uint32_t max_neighbor_n = 0;
+    for(int v=0;v<V;++v)
+    {
+        uint32_t n = voxel_adj_offsets_(v+1) - voxel_adj_offsets_(v);
         if(n<min_neighbor_n)min_neighbor_n=n;
         if(n>max_neighbor_n)max_neighbor_n=n;
-        num += (*iter)->indices().size();
     }
-//    std::cerr<<"num points:"<<num<<std::endl;
     std::cerr<<"Neighbor N("<<min_neighbor_n<<","<<max_neighbor_n<<")"<<std::endl;
 }
 
@@ -275,271 +246,190 @@ void SuperVoxelClustering<M>::selectInitialSupervoxelSeeds(std::vector<uint32_t>
     M seed_mesh;
     MeshOctreeContainer<M> seed_container(seed_mesh);
     int num_seeds = seed_octree.getLeafCenters(seed_container);
-
-    MeshKDTreeInterface<M> points(*voxel_centroids_);
-    nanoflann::KDTreeSingleIndexAdaptor<
-            nanoflann::L2_Simple_Adaptor<float,MeshKDTreeInterface<M>>,
-            MeshKDTreeInterface<M>,
-            3,arma::uword>
-            kdtree(3,points,nanoflann::KDTreeSingleIndexAdaptorParams(3));
-    kdtree.buildIndex();
     if(num_seeds!=seed_mesh.n_vertices())std::logic_error("the seed_mesh size doesn't add up");
-    arma::uvec seed_indices_orig(num_seeds,arma::fill::ones);
-    arma::fvec seed_distance(num_seeds,arma::fill::zeros);
-    float* seeds_ptr = (float*)seed_mesh.points();
-    arma::uword* out_indices = (arma::uword*)seed_indices_orig.memptr();
-    float* out_dist = (float*)seed_distance.memptr();
-    for(int i = 0 ; i < seed_mesh.n_vertices() ; ++i )
-    {
-        kdtree.knnSearch(&(seeds_ptr[3*i]),1,&(out_indices[i]),&(out_dist[i]));
-    }
+    //the seed octree also answers the nearest voxel and density queries, no separate KD-tree is built
+    MeshOctreeContainer<M> seed_points(seed_mesh);
+    arma::Mat<uint32_t> seed_indices_orig;
+    arma::fmat seed_distance;
+    seed_octree.template batchKnnNeighbors<unibn::L2Distance<arma::fvec>>(seed_points,1,seed_indices_orig,seed_distance);
     float search_radius = 0.5f*seed_resolution_;
     float min_points = 0.05f*(search_radius)*(search_radius)*M_PI/(voxel_resolution_*voxel_resolution_);
-    indices_vec.reserve(seed_indices_orig.size());
-    float* points_ptr = (float*)voxel_centroids_->points();
-    std::vector<std::pair<arma::uword,float>> neighbors;
-    for(int i = 0 ; i < seed_indices_orig.size() ; ++i)
+    //the KD-tree search took search_radius as a squared distance, keep the same neighborhood
+    float density_radius = std::sqrt(search_radius);
+    std::vector<uint8_t> keep(seed_indices_orig.n_cols,0);
+    #pragma omp parallel for
+    for(int i = 0 ; i < seed_indices_orig.n_cols ; ++i)
     {
-        int num = kdtree.radiusSearch(
-                    &(points_ptr[3*seed_indices_orig[i]]),
-                    search_radius,
-                    neighbors,nanoflann::SearchParams(3)
+        std::vector<uint32_t> neighbors;
+        seed_octree.template radiusNeighbors<unibn::L2Distance<arma::fvec>>(
+                    container[seed_indices_orig(0,i)],
+                    density_radius,
+                    neighbors
                     );
-        if( num > min_points )
-        {
-           indices_vec.push_back(seed_indices_orig(i));
-        }
+        keep[i] = ( neighbors.size() > min_points );
+    }
+    indices_vec.reserve(seed_indices_orig.n_cols);
+    for(int i = 0 ; i < seed_indices_orig.n_cols ; ++i)
+    {
+        if(keep[i])indices_vec.push_back(seed_indices_orig(0,i));
     }
 }
 
 template<typename M>
 void SuperVoxelClustering<M>::createSupervoxels(std::vector<uint32_t> &seed_indices)
 {
-    supervoxels_.clear();
+    const uint32_t V = voxel_xyz_.n_cols;
+    voxel_owner_ = arma::Col<uint32_t>(V);
+    voxel_owner_.fill(npos);
+    voxel_dist_ = arma::fvec(V);
+    voxel_dist_.fill(std::numeric_limits<float>::max());
+    std::vector<uint32_t> seeds;
+    seeds.reserve(seed_indices.size());
     std::vector<uint32_t>::iterator iter;
-    uint32_t label = 0;
     for(iter=seed_indices.begin();iter!=seed_indices.end();++iter)
     {
-        if(voxels_[*iter]->neighbors_.size()<6)continue;
-        supervoxels_.emplace_back(new SuperVoxel<M>(*this,label));
-        voxels_[*iter]->dist2parent_ = 0.0;
-        supervoxels_.back()->addVoxel(voxels_[*iter]);
-        voxels_[*iter]->parent_ = supervoxels_.back();
-        supervoxels_.back()->updateCentroid();
-        ++label;
+        if( voxel_adj_offsets_(*iter+1) - voxel_adj_offsets_(*iter) < 6 )continue;
+        seeds.push_back(*iter);
     }
-}
-
-template<typename M>
-void SuperVoxelClustering<M>::expandSupervoxels(int depth)
-{
-    SuperVoxelIter iter;
-    for(int i = 0;i < depth ;++i)
+    //the centroid of a supervoxel is its seed voxel
+    const uint32_t S = seeds.size();
+    sv_xyz_ = arma::fmat(3,S);
+    sv_normal_ = arma::fmat(3,S);
+    sv_rgb_ = arma::fmat(3,S);
+    sv_label_ = arma::Col<uint32_t>(S);
+    for(uint32_t s=0;s<S;++s)
     {
-        for(iter=supervoxels_.begin();iter!=supervoxels_.end();++iter)
-        {
-            (*iter)->expand();
-        }
-        std::sort(supervoxels_.begin(), supervoxels_.end(),SuperVoxel<M>(*this,0));
-        while(0==supervoxels_.back()->size())
-        {
-            supervoxels_.pop_back();
-        }
+        const uint32_t v = seeds[s];
+        sv_xyz_.col(s) = voxel_xyz_.col(v);
+        sv_normal_.col(s) = arma::normalise(voxel_normal_.col(v));
+        sv_rgb_.col(s) = voxel_rgb_.col(v);
+        sv_label_(s) = s;
+        voxel_owner_(v) = s;
     }
-}
-
-template<typename M>
-void SuperVoxelClustering<M>::makeSupervoxels(SuperVoxelsMap& supervoxelsmap)
-{
-    typename std::vector<typename SuperVoxel<M>::Ptr>::iterator iter;
-    for(iter=supervoxels_.begin();iter!=supervoxels_.end();++iter)
+    for(uint32_t s=0;s<S;++s)
     {
-        std::vector<uint32_t> indices;
-        (*iter)->getPointIndices(indices);
-        std::vector<uint32_t>::iterator piter;
-        for(piter=indices.begin();piter!=indices.end();++piter)
-        {
-            supervoxelsmap.insert(
-                        std::make_pair(
-                            (*iter)->getLabel(),
-                            *piter
-                            )
-                        );
-        }
+        const uint32_t v = seeds[s];
+        if( s == voxel_owner_(v) )voxel_dist_(v) = dist_(centroid(s),voxel(v));
     }
 }
 
 template<typename M>
-void SuperVoxelClustering<M>::makeLabels(arma::uvec&labels)
+void SuperVoxelClustering<M>::expandSupervoxels(int depth)
 {
-    typename std::vector<typename SuperVoxel<M>::Ptr>::iterator iter;
-    labels = arma::uvec(input_->n_vertices());
-    labels.fill(0);
-    arma::uword sindex = 0;
-    for(iter=supervoxels_.begin();iter!=supervoxels_.end();++iter)
+    const uint32_t V = voxel_owner_.size();
+    //the frontier holds the voxels next to a voxel whose owner changed in the last round
+    std::vector<uint32_t> frontier;
+    for(uint32_t v=0;v<V;++v)
     {
-        arma::uvec indices;
-        (*iter)->getPointIndices(indices);
-        labels.elem(indices).fill(sindex+1);
-        ++sindex;
+        if(npos==voxel_owner_(v))continue;
+        for(uint32_t i=voxel_adj_offsets_(v);i<voxel_adj_offsets_(v+1);++i)
+            frontier.push_back(voxel_adj_indices_(i));
     }
-}
-
-template<typename M>
-void SuperVoxel<M>::getPointIndices(std::vector<uint32_t>&indices)
-{
-    VoxelIter voxeliter;
-    for ( voxeliter = voxels.begin (); voxeliter != voxels.end (); ++voxeliter)
+    std::vector<uint32_t> new_owner;
+    std::vector<float> new_dist;
+    std::vector<uint32_t> changed;
+    for(int round = 0 ; round < depth && !frontier.empty() ; ++round)
     {
-        const arma::uvec& vindices = (*voxeliter)->indices();
-        for(int i=0;i<vindices.n_cols;++i)
+        std::sort(frontier.begin(),frontier.end());
+        frontier.erase(std::unique(frontier.begin(),frontier.end()),frontier.end());
+        //every frontier voxel pulls the nearest neighboring supervoxel,
+        //reading only the owners of the previous round, so the result does not depend on the thread order
+        new_owner.resize(frontier.size());
+        new_dist.resize(frontier.size());
+        #pragma omp parallel for schedule(dynamic,256)
+        for(int64_t f=0;f<int64_t(frontier.size());++f)
         {
-            indices.push_back(vindices(i));
-        }
-    }
-}
-
-template<typename M>
-void SuperVoxel<M>::getPointIndices(arma::uvec&indices)
-{
-    VoxelIter voxeliter;
-    for ( voxeliter = voxels.begin (); voxeliter != voxels.end (); ++voxeliter)
-    {
-        const arma::uvec& vindices = (*voxeliter)->indices();
-        indices = arma::join_cols(vindices,indices);
-    }
-}
-
-template<typename M>
-void SuperVoxel<M>::updateCentroid()
-{
-    centroid_.reset(new Voxel<M>(*parent_.input_));
-    VoxelIter iter;
-    for(iter=voxels.begin();iter!=voxels.end();++iter)
-    {
-        centroid_->color() += (*iter)->color();
-        centroid_->normal() += (*iter)->normal();
-        centroid_->xyz() += (*iter)->xyz();
-    }
-    centroid_->color() /= float(voxels.size());
-    centroid_->xyz() /= float(voxels.size());
-    centroid_->normal() /= float(voxels.size());
-    centroid_->normal() = arma::normalise(centroid_->normal());
-    for(iter=voxels.begin();iter!=voxels.end();++iter)
-    {
-        (*iter)->dist2parent_ = parent_.dist_(centroid_,(*iter));
-    }
-}
-
-template<typename M>
-void SuperVoxel<M>::expand()
-{
-    VoxelVec new_owned;
-    new_owned.reserve(9*voxels.size());
-    //For each leaf belonging to this supervoxel
-    VoxelIter voxeliter;
-    VoxelIter neighborIter;
-    VoxelIter vbegin = voxels.begin ();
-    for ( voxeliter = voxels.begin (); voxeliter != voxels.end (); ++voxeliter)
-    {
-        VoxelIter nbegin = (*voxeliter)->neighbors_.begin();
-        VoxelIter nend = (*voxeliter)->neighbors_.end();
-
-        for(neighborIter=nbegin;neighborIter!=nend;++neighborIter)
-        { 
-//            std::cerr<<"address:"<<(*neighborIter).get()<<std::endl;
-//            std::cerr<<"count:"<<(*neighborIter).use_count()<<std::endl;
-            //TODO this is a shortcut, really we should always recompute distance
-            if(0!=(*neighborIter)->parent_.use_count()&&(*neighborIter)->parent_)
-            {
-                if((*neighborIter)->parent_.get()==this)continue;
-            }
-            //Compute distance to the neighbor
-            float dist = parent_.dist_(centroid_,(*neighborIter));
-            //If distance is less than previous, we remove it from its owner's list
-            //and change the owner to this and distance (we *steal* it!)
-            if (dist < (*neighborIter)->dist2parent_)
+            const uint32_t v = frontier[f];
+            uint32_t best = voxel_owner_(v);
+            float best_dist = voxel_dist_(v);
+            for(uint32_t i=voxel_adj_offsets_(v);i<voxel_adj_offsets_(v+1);++i)
             {
-                (*neighborIter)->dist2parent_ = dist;
-                if (0!=(*neighborIter)->parent_.use_count()&&(*neighborIter)->parent_)
+                const uint32_t s = voxel_owner_(voxel_adj_indices_(i));
+                if( npos==s || s==voxel_owner_(v) )continue;
+                float d = dist_(centroid(s),voxel(v));
+                //ties go to the lower supervoxel
+                if( d < best_dist || ( d == best_dist && best != voxel_owner_(v) && s < best ) )
                 {
-                    (*neighborIter)->parent_ -> removeVoxel(*neighborIter);
+                    best = s;
+                    best_dist = d;
                 }
-                (*neighborIter)->parent_ = voxels.front()->parent_;
-                new_owned.push_back(*neighborIter);
             }
+            new_owner[f] = best;
+            new_dist[f] = best_dist;
         }
+        changed.clear();
+        for(size_t f=0;f<frontier.size();++f)
+        {
+            const uint32_t v = frontier[f];
+            if(new_owner[f]==voxel_owner_(v))continue;
+            voxel_owner_(v) = new_owner[f];
+            voxel_dist_(v) = new_dist[f];
+            changed.push_back(v);
+        }
+        frontier.clear();
+        for(std::vector<uint32_t>::iterator iter=changed.begin();iter!=changed.end();++iter)
+        {
+            for(uint32_t i=voxel_adj_offsets_(*iter);i<voxel_adj_offsets_(*iter+1);++i)
+                frontier.push_back(voxel_adj_indices_(i));
+        }
+    }
+    //drop the empty supervoxels and order the rest by decreasing size ( ties by seed order )
+    const uint32_t S = sv_xyz_.n_cols;
+    std::vector<uint32_t> counts(S,0);
+    for(uint32_t v=0;v<V;++v)
+    {
+        if(npos!=voxel_owner_(v))++counts[voxel_owner_(v)];
     }
-    //Push all new owned onto the owned leaf set
-    VoxelIter new_owned_itr;
-    for ( new_owned_itr = new_owned.begin (); new_owned_itr!=new_owned.end (); ++new_owned_itr)
+    std::vector<uint32_t> order;
+    order.reserve(S);
+    for(uint32_t s=0;s<S;++s)
     {
-        voxels.push_back(*new_owned_itr);
+        if(counts[s]>0)order.push_back(s);
+    }
+    std::stable_sort(order.begin(),order.end(),[&counts](uint32_t a,uint32_t b){return counts[b] < counts[a];});
+    std::vector<uint32_t> rank(S,npos);
+    for(uint32_t r=0;r<order.size();++r)rank[order[r]] = r;
+    arma::uvec keep(order.size());
+    for(uint32_t r=0;r<order.size();++r)keep(r) = order[r];
+    sv_xyz_ = arma::fmat(sv_xyz_.cols(keep));
+    sv_normal_ = arma::fmat(sv_normal_.cols(keep));
+    sv_rgb_ = arma::fmat(sv_rgb_.cols(keep));
+    sv_label_ = arma::Col<uint32_t>(sv_label_.elem(keep));
+    #pragma omp parallel for
+    for(int64_t v=0;v<int64_t(V);++v)
+    {
+        if(npos!=voxel_owner_(v))voxel_owner_(v) = rank[voxel_owner_(v)];
     }
 }
 
 template<typename M>
-void SuperVoxel<M>::removeVoxel(typename Voxel<M>::Ptr ptr)
+void SuperVoxelClustering<M>::makeSupervoxels(SuperVoxelsMap& supervoxelsmap)
 {
-    if(voxels.empty()){
-        std::cerr<<"try to remove from an empty supervoxel"<<std::endl;
-        return;
-    }
-    bool find = false;
-    VoxelIter iter;
-    if(ptr!=voxels.back())
+    for(uint32_t v=0;v<voxel_owner_.size();++v)
     {
-        for(iter=voxels.begin();iter!=voxels.end();++iter)
-        {
-            if(ptr==*iter)
-            {
-                (*iter)->parent_.reset();
-                *iter = voxels.back();
-                find = true;
-                break;
-            }
-        }
-    }else find = true;
-    if(find){
-        voxels.pop_back();
-    }
-    else {
-        std::cerr<<"try to remove a voxel("<<ptr->Id_<<") with parent("<<ptr->parent_->getLabel()<<") but not recorded by supervoxel("<<label_<<")"<<std::endl;
-        std::cerr<<"who has:"<<std::endl;
-        for(iter=voxels.begin();iter!=voxels.end();++iter)
+        if(npos==voxel_owner_(v))continue;
+        const uint32_t label = sv_label_(voxel_owner_(v));
+        for(uint32_t i=voxel_point_offsets_(v);i<voxel_point_offsets_(v+1);++i)
         {
-            std::cerr<<(*iter)->Id_<<",";
+            supervoxelsmap.insert(std::make_pair(label,voxel_points_(i)));
         }
     }
 }
 
 template<typename M>
-void SuperVoxel<M>::addVoxel(typename Voxel<M>::Ptr ptr)
-{
-//    if(label_==40){
-//        std::cerr<<"40add"<<ptr->Id_<<std::endl;
-//    }
-    voxels.push_back(ptr);
-}
-
-template<typename M>
-void SuperVoxel<M>::getNeighbors(std::vector<uint32_t>&indices)
+void SuperVoxelClustering<M>::makeLabels(arma::uvec&labels)
 {
-    VoxelIter voxeliter;
-    VoxelIter neighborIter;
-    for ( voxeliter = voxels.begin (); voxeliter != voxels.end (); ++voxeliter)
+    //label 0 is left to the points without supervoxel, the others follow the output order
+    labels = arma::uvec(input_->n_vertices(),arma::fill::zeros);
+    const int64_t V = voxel_owner_.size();
+    #pragma omp parallel for
+    for(int64_t v=0;v<V;++v)
     {
-        //for each neighbor of the leaf
-        for(neighborIter=(*voxeliter)->neighbors_.begin();neighborIter!=(*voxeliter)->neighbors_.end();++neighborIter)
+        if(npos==voxel_owner_(v))continue;
+        const arma::uword label = voxel_owner_(v) + 1;
+        for(uint32_t i=voxel_point_offsets_(v);i<voxel_point_offsets_(v+1);++i)
         {
-            //Get a reference to the data contained in the leaf
-            Voxel<M>& neighbor_voxel = **neighborIter;
-            //TODO this is a shortcut, really we should always recompute distance
-            if(neighbor_voxel.parent_.get() == this)
-                continue;
-            if (neighbor_voxel.parent_){
-                indices.push_back(neighbor_voxel.parent_->getLabel());
-            }
+            labels(voxel_points_(i)) = label;
         }
     }
 }
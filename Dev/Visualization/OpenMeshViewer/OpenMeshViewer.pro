@@ -11,6 +11,8 @@ greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 TARGET = OpenMeshViewer
 TEMPLATE = app
 CONFIG += c++11
+QMAKE_CXXFLAGS += -fopenmp
+LIBS += -lgomp -lpthread
 #DEFINES += OM_STATIC_BUILD
 DESTDIR = $$OUT_PWD/../../../Dev_RunTime/bin
 
@@ -1,10 +1,10 @@
 #include "computeoctreethread.h"
 void ComputeOctreeThread::run()
 {
-    DefaultOctree octree;
+    DefaultLinearOctree octree;
     DefaultOctreeContainer container(input_);
     octree.initialize(container,unibn::OctreeParams(float(0.05)));
-    OctreeMeshInterface<DefaultOctree> oct_interface(octree,output_);
+    OctreeMeshInterface<DefaultLinearOctree> oct_interface(octree,output_);
     oct_interface.getLeafMesh(true);
 }
 
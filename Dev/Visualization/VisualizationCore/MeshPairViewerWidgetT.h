@@ -10,6 +10,7 @@
 #include <OpenMesh/Tools/Utils/Timer.hh>
 #include "MeshType.h"
 #include "QGLViewerWidget.h"
+#include "pointcloudvbo.h"
 #include "MeshColor.h"
 #include "cube.h"
 template <typename M>
@@ -36,7 +37,9 @@ public:
       second_(new MeshBundle<Mesh>()),
       normal_scale_(0.05),
       cube_flag_(false),
-      cube_dim_(0)
+      cube_dim_(0),
+      point_budget_(0),
+      point_ratio_(1.0)
   {
     QAction* a = add_draw_mode("Points");
     add_draw_mode("Hidden-Line");
@@ -48,7 +51,12 @@ public:
   }
 
   /// destructor
-  virtual ~MeshPairViewerWidgetT() {}
+  virtual ~MeshPairViewerWidgetT()
+  {
+      //the buffers belong to the context of this widget
+      makeCurrent();
+      vbo_.release();
+  }
 
 public:
 
@@ -66,6 +74,8 @@ public:
   void disable_strips();
 
   inline void set_normal_scale(float s){normal_scale_=s;}
+  //at most n points are drawn over both meshes ( 0 for no limit )
+  inline void set_point_budget(uint32_t n){point_budget_=n;updateGL();}
 
   MeshBundle<Mesh>& first() { return *first_; }
   const MeshBundle<Mesh>& first() const { return *first_; }
@@ -194,7 +204,9 @@ protected:
   bool                   show_fnormals_;
   float                  normal_scale_;
   OpenMesh::FPropHandleT< typename Mesh::Point > fp_normal_base_;
-
+  PointCloudVBOCache     vbo_;
+  uint32_t               point_budget_;
+  float                  point_ratio_;
 };
 
 //=============================================================================
@@ -572,31 +572,25 @@ MeshPairViewerWidgetT<M>::draw_openmesh(MeshBundle<Mesh>& b,const std::string& _
   else if( _draw_mode == "Points" ) // -----------------------------------------
   {
     glEnable( GL_POINT_SMOOTH );
-    glEnableClientState(GL_VERTEX_ARRAY);
-    glVertexPointer(3, GL_FLOAT, 0, mesh_.points());
-
-    if(mesh_.has_vertex_normals())
-    {
-        glEnableClientState(GL_NORMAL_ARRAY);
-        glNormalPointer(GL_FLOAT, 0, mesh_.vertex_normals());
-    }
-
+    const float* normals = 0;
+    if(mesh_.has_vertex_normals())normals = (const float*)mesh_.vertex_normals();
+    const uint8_t* colors = 0;
+    int color_dim = 0;
     if ( use_color_)
     {
         if( mesh_.has_vertex_colors() && !custom_color_)
         {
-            glEnableClientState(GL_COLOR_ARRAY);
-            glColorPointer(3, GL_UNSIGNED_BYTE, 0, mesh_.vertex_colors());
+            colors = (const uint8_t*)mesh_.vertex_colors();
+            color_dim = 3;
         }else{
-            glEnableClientState(GL_COLOR_ARRAY);
-            glColorPointer(4, GL_UNSIGNED_BYTE, 0, color_.vertex_colors());
+            colors = (const uint8_t*)color_.vertex_colors();
+            color_dim = 4;
         }
     }
+    PointCloudVBO& vbo = vbo_.get(&b);
+    vbo.update((const float*)mesh_.points(),normals,colors,color_dim,mesh_.n_vertices());
     glPointSize(point_size_);
-    glDrawArrays( GL_POINTS, 0, static_cast<GLsizei>(mesh_.n_vertices()) );
-    glDisableClientState(GL_NORMAL_ARRAY);
-    glDisableClientState(GL_VERTEX_ARRAY);
-    glDisableClientState(GL_COLOR_ARRAY);
+    vbo.drawPoints( uint32_t( std::ceil( point_ratio_*float(mesh_.n_vertices()) ) ) );
     glDisable( GL_POINT_SMOOTH );
   }else if( _draw_mode == "VoxelGraph" )
   {
@@ -605,7 +599,7 @@ MeshPairViewerWidgetT<M>::draw_openmesh(MeshBundle<Mesh>& b,const std::string& _
       if( !b.graph_.voxel_edge_colors.empty() && ( b.graph_.voxel_neighbors.n_cols == b.graph_.voxel_edge_colors.n_cols ) )
       {
           GLubyte* c_ptr = (GLubyte*)b.graph_.voxel_edge_colors.memptr();
-          arma::Mat<uint16_t>::iterator iter;
+          arma::Mat<uint32_t>::iterator iter;
           glBegin(GL_LINES);
           for(iter=b.graph_.voxel_neighbors.begin();iter!=b.graph_.voxel_neighbors.end();++(++iter))
           {
@@ -635,7 +629,7 @@ MeshPairViewerWidgetT<M>::draw_openmesh(MeshBundle<Mesh>& b,const std::string& _
       {
           glEnableClientState(GL_VERTEX_ARRAY);
           glVertexPointer(3,GL_FLOAT,0,static_cast<GLfloat*>(b.graph_.voxel_centers.memptr()));
-          glDrawElements(GL_LINES,b.graph_.voxel_neighbors.size(),GL_UNSIGNED_SHORT,static_cast<GLushort*>(b.graph_.voxel_neighbors.memptr()));
+          glDrawElements(GL_LINES,b.graph_.voxel_neighbors.size(),GL_UNSIGNED_INT,static_cast<GLuint*>(b.graph_.voxel_neighbors.memptr()));
           glDisableClientState(GL_VERTEX_ARRAY);
       }
   }
@@ -656,6 +650,14 @@ MeshPairViewerWidgetT<M>::draw_scene(const std::string& _draw_mode)
   if ( (!first_->mesh_.n_vertices()) && (!second_->mesh_.n_vertices()) )
     return;
 
+  std::vector<const void*> keys;
+  keys.push_back(first_.get());
+  keys.push_back(second_.get());
+  vbo_.keep(keys);
+  const uint64_t visible_points = first_->mesh_.n_vertices() + second_->mesh_.n_vertices();
+  if( point_budget_ > 0 && visible_points > point_budget_ )point_ratio_ = float(point_budget_) / float(visible_points);
+  else point_ratio_ = 1.0;
+
 #if defined(OM_USE_OSG) && OM_USE_OSG
   else if ( _draw_mode == "OpenSG Indices")
   {
@@ -789,18 +791,12 @@ MeshPairViewerWidgetT<M>::draw_scene(const std::string& _draw_mode)
     setDefaultMaterial();
   }
 
-  if (show_vnormals_)
+  if (show_vnormals_ && first_->mesh_.has_vertex_normals())
   {
-    typename Mesh::VertexIter vit;
+    Mesh& m = first_->mesh_;
     glDisable(GL_LIGHTING);
-    glBegin(GL_LINES);
     glColor3f(1.000f, 0.803f, 0.027f); // orange
-    for(vit=first_->mesh_.vertices_begin(); vit!=first_->mesh_.vertices_end(); ++vit)
-    {
-      glVertex( first_->mesh_ , *vit );
-      glVertex( first_->mesh_.point( *vit ) + normal_scale_*first_->mesh_.normal( *vit ) );
-    }
-    glEnd();
+    vbo_.get(first_.get()).drawNormals((const float*)m.points(),(const float*)m.vertex_normals(),m.n_vertices(),normal_scale_);
   }
   if (show_fnormals_)
   {
@@ -383,7 +383,7 @@ QGLViewerWidget::mouseMoveEvent( QMouseEvent* _event )
   makeCurrent();
   if(rect_selecting_)
   {
-      if(_event->button() == LeftButton && _event->modifiers() == ShiftModifier)
+      if(_event->buttons() == LeftButton && _event->modifiers() == ShiftModifier)
       {
           arma::fmat::fixed<3,4> rect;
           Vec3f  tmp3d;
@@ -480,6 +480,12 @@ QGLViewerWidget::mouseMoveEvent( QMouseEvent* _event )
 void
 QGLViewerWidget::mouseReleaseEvent( QMouseEvent* _event )
 {  
+    if( rect_selecting_ && !selections_.empty() )
+    {
+        BoxPointsSelection* box_select =  dynamic_cast<BoxPointsSelection*>(selections_.back().get());
+        if(box_select)box_select->setFinished();
+        updateGL();
+    }
     rect_selecting_ = false;
     last_point_ok_ = false;
 }
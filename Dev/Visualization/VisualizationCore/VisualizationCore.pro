@@ -9,6 +9,8 @@ QT       += widgets opengl
 TARGET = VisualizationCore
 TEMPLATE = lib
 CONFIG += c++11
+QMAKE_CXXFLAGS += -fopenmp
+LIBS += -lgomp -lpthread
 
 DEFINES += VISUALIZATIONCORE_LIBRARY
 DESTDIR = $$OUT_PWD/../../../Dev_RunTime/bin
@@ -17,6 +19,8 @@ SOURCES += visualizationcore.cpp \
     QGLViewerWidget.cpp \
     labspace.cpp \
     qglpointselection.cpp \
+    pointindex.cpp \
+    pointcloudvbo.cpp \
     featureviewerwidget.cpp \
     segview.cpp \
     MeshLabelViewerWidget.cpp \
@@ -37,6 +41,8 @@ HEADERS += visualizationcore.h\
     labspace.h \
     qglpointselection.h \
     qglpointselection.hpp \
+    pointindex.h \
+    pointcloudvbo.h \
     featureviewerwidget.h \
     segview.h \
     MeshLabelViewerWidget.h \
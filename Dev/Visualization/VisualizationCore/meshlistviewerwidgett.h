@@ -12,6 +12,7 @@
 #include <OpenMesh/Tools/Utils/Timer.hh>
 #include "MeshType.h"
 #include "QGLViewerWidget.h"
+#include "pointcloudvbo.h"
 #include "MeshColor.h"
 #include <QColor>
 template <typename M>
@@ -35,7 +36,9 @@ public:
       show_vnormals_(false),
       show_fnormals_(false),
       current_mesh_start_(0),
-      current_visible_num_(1)
+      current_visible_num_(1),
+      point_budget_(0),
+      point_ratio_(1.0)
   {
     QAction* a = add_draw_mode("Points");
     slotDrawMode(a);
@@ -43,7 +46,12 @@ public:
   }
 
   /// destructor
-  ~MeshListViewerWidgetT() {}
+  ~MeshListViewerWidgetT()
+  {
+      //the buffers belong to the context of this widget
+      makeCurrent();
+      vbo_.release();
+  }
 
 public:
 
@@ -64,6 +72,8 @@ public:
   const std::vector< typename MeshBundle<Mesh>::Ptr >& list() const { return mesh_list_; }
   uint32_t visible_index() {return current_mesh_start_;}
   uint32_t visible_num(){return current_visible_num_;}
+  //at most n points are drawn over all the visible meshes ( 0 for no limit )
+  void set_point_budget(uint32_t n){point_budget_=n;updateGL();}
 
   void show_back(){
       current_mesh_start_ = mesh_list_.size() - 1;
@@ -177,6 +187,9 @@ protected:
   bool                   show_fnormals_;
   float                  normal_scale_;
   OpenMesh::FPropHandleT< typename Mesh::Point > fp_normal_base_;
+  PointCloudVBOCache     vbo_;
+  uint32_t               point_budget_;
+  float                  point_ratio_;
 };
 //=============================================================================
 #include "MeshListViewerWidgetT.hpp"
@@ -514,23 +514,23 @@ MeshListViewerWidgetT<M>::draw_openmesh(MeshBundle<Mesh>& b,const std::string& _
       else if( _draw_mode == "Points" ) // -----------------------------------------
       {
           glEnable( GL_POINT_SMOOTH );
-          glEnableClientState(GL_VERTEX_ARRAY);
-          glVertexPointer(3, GL_FLOAT, 0, mesh_.points());
+          const uint8_t* colors = 0;
+          int color_dim = 0;
           if ( use_color_)
           {
               if( mesh_.has_vertex_colors() && !custom_color_)
               {
-                  glEnableClientState(GL_COLOR_ARRAY);
-                  glColorPointer(3, GL_UNSIGNED_BYTE, 0, mesh_.vertex_colors());
+                  colors = (const uint8_t*)mesh_.vertex_colors();
+                  color_dim = 3;
               }else{
-                  glEnableClientState(GL_COLOR_ARRAY);
-                  glColorPointer(4, GL_UNSIGNED_BYTE, 0, color_.vertex_colors());
+                  colors = (const uint8_t*)color_.vertex_colors();
+                  color_dim = 4;
               }
           }
+          PointCloudVBO& vbo = vbo_.get(&b);
+          vbo.update((const float*)mesh_.points(),0,colors,color_dim,mesh_.n_vertices());
           glPointSize(point_size_);
-          glDrawArrays( GL_POINTS, 0, static_cast<GLsizei>(mesh_.n_vertices()) );
-          glDisableClientState(GL_VERTEX_ARRAY);
-          glDisableClientState(GL_COLOR_ARRAY);
+          vbo.drawPoints( uint32_t( std::ceil( point_ratio_*float(mesh_.n_vertices()) ) ) );
           glDisable( GL_POINT_SMOOTH );
       }
 }
@@ -565,6 +565,19 @@ MeshListViewerWidgetT<M>::draw_scene(const std::string& _draw_mode)
     return;
   M& mesh_ = (*(mesh_list_.begin() + current_mesh_start_))->mesh_;
 
+  //buffers are kept for every mesh in the list so browsing does not upload again
+  std::vector<const void*> keys;
+  keys.reserve(mesh_list_.size());
+  uint64_t visible_points = 0;
+  for(size_t i = 0 ; i < mesh_list_.size() ; ++i )keys.push_back(mesh_list_[i].get());
+  for(uint32_t cnt = 0 ; cnt < current_visible_num_ ; ++cnt )
+  {
+      visible_points += mesh_list_[ ( current_mesh_start_ + cnt ) % mesh_list_.size() ]->mesh_.n_vertices();
+  }
+  vbo_.keep(keys);
+  if( point_budget_ > 0 && visible_points > point_budget_ )point_ratio_ = float(point_budget_) / float(visible_points);
+  else point_ratio_ = 1.0;
+
 //#if defined(OM_USE_OSG) && OM_USE_OSG
 //  else if ( _draw_mode == "OpenSG Indices")
 //  {
@@ -731,25 +744,21 @@ MeshListViewerWidgetT<M>::draw_scene(const std::string& _draw_mode)
 
   if (show_vnormals_)
   {
-    typename Mesh::VertexIter vit;
     glDisable(GL_LIGHTING);
-    glBegin(GL_LINES);
     glColor3f(1.000f, 0.803f, 0.027f); // orange
     typename std::vector<typename MeshBundle<Mesh>::Ptr>::iterator iter;
     int cnt = 0;
     for( iter = ( mesh_list_.begin() + current_mesh_start_ ); cnt < current_visible_num_ ;  )
     {
-        if((*iter)->mesh_.n_vertices())
-        for(vit=(*iter)->mesh_.vertices_begin(); vit!=(*iter)->mesh_.vertices_end(); ++vit)
+        Mesh& m = (*iter)->mesh_;
+        if( m.n_vertices() && m.has_vertex_normals() )
         {
-          glVertex( (*iter)->mesh_ , *vit );
-          glVertex( (*iter)->mesh_.point( *vit ) + normal_scale_*(*iter)->mesh_.normal( *vit ) );
+            vbo_.get(iter->get()).drawNormals((const float*)m.points(),(const float*)m.vertex_normals(),m.n_vertices(),normal_scale_);
         }
         ++cnt;
         ++iter;
         if(iter==mesh_list_.end())iter=mesh_list_.begin();
     }
-    glEnd();
   }
 
 //  if (show_fnormals_)
@@ -0,0 +1,280 @@
+#include "pointcloudvbo.h"
+#include <QOpenGLContext>
+#include <algorithm>
+#include <cstring>
+#include <random>
+//arrays are compared and uploaded in chunks of this size
+static const size_t chunk_bytes_ = 1 << 18;
+
+//FNV style hash on 4 interleaved lanes so the multiplies do not wait on each other
+static uint64_t hash_chunk(const uint8_t* p,size_t n)
+{
+    const uint64_t prime = 1099511628211ULL;
+    uint64_t h[4] = {14695981039346656037ULL,1,2,3};
+    size_t i = 0;
+    for( ; i + 32 <= n ; i += 32 )
+    {
+        uint64_t w[4];
+        std::memcpy(w,p+i,32);
+        h[0] = ( h[0] ^ w[0] ) * prime;
+        h[1] = ( h[1] ^ w[1] ) * prime;
+        h[2] = ( h[2] ^ w[2] ) * prime;
+        h[3] = ( h[3] ^ w[3] ) * prime;
+    }
+    uint64_t r = ( ( ( h[0] * prime ) ^ h[1] ) * prime ^ h[2] ) * prime ^ h[3];
+    for( ; i < n ; ++i )r = ( r ^ p[i] ) * prime;
+    return r;
+}
+
+PointCloudVBO::PointCloudVBO():
+    init_(false),use_buffers_(false),N_(0),
+    points_(0),normals_(0),colors_(0),color_dim_(0),
+    lines_dirty_(true),lines_scale_(0.0)
+{
+    ;
+}
+
+void PointCloudVBO::init()
+{
+    if(init_)return;
+    //nothing to resolve without a context, client side arrays are used meanwhile
+    if(!QOpenGLContext::currentContext())return;
+    initializeOpenGLFunctions();
+    use_buffers_ = hasOpenGLFeature(QOpenGLFunctions::Buffers);
+    init_ = true;
+}
+
+bool PointCloudVBO::sync(Buffer& b,GLenum target,const void* data,size_t bytes)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    const int n_chunk = int( ( bytes + chunk_bytes_ - 1 ) / chunk_bytes_ );
+    std::vector<uint64_t> h(n_chunk);
+    #pragma omp parallel for
+    for(int c = 0 ; c < n_chunk ; ++c )
+    {
+        const size_t offset = size_t(c)*chunk_bytes_;
+        h[c] = hash_chunk(p+offset,std::min(chunk_bytes_,bytes-offset));
+    }
+    if( 0 == b.id_ )glGenBuffers(1,&b.id_);
+    glBindBuffer(target,b.id_);
+    bool changed = false;
+    if( bytes != b.bytes_ )
+    {
+        glBufferData(target,bytes,data,GL_STATIC_DRAW);
+        b.bytes_ = bytes;
+        changed = true;
+    }else{
+        //consecutive dirty chunks are sent in one call
+        int c = 0;
+        while( c < n_chunk )
+        {
+            if( h[c] == b.hash_[c] )
+            {
+                ++c;
+                continue;
+            }
+            int e = c + 1;
+            while( e < n_chunk && h[e] != b.hash_[e] )++e;
+            const size_t offset = size_t(c)*chunk_bytes_;
+            const size_t end = std::min(size_t(e)*chunk_bytes_,bytes);
+            glBufferSubData(target,offset,end-offset,p+offset);
+            changed = true;
+            c = e;
+        }
+    }
+    glBindBuffer(target,0);
+    b.hash_.swap(h);
+    return changed;
+}
+
+void PointCloudVBO::free(Buffer& b)
+{
+    if(b.id_)glDeleteBuffers(1,&b.id_);
+    b.id_ = 0;
+    b.bytes_ = 0;
+    b.hash_.clear();
+}
+
+void PointCloudVBO::buildLOD()
+{
+    lod_index_.resize(N_);
+    for(uint32_t i = 0 ; i < N_ ; ++i )lod_index_[i] = i;
+    //fixed seed so the subset does not flicker between frames
+    std::mt19937 gen(N_);
+    std::shuffle(lod_index_.begin(),lod_index_.end(),gen);
+    if(use_buffers_)
+    {
+        if( 0 == lod_buf_.id_ )glGenBuffers(1,&lod_buf_.id_);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,lod_buf_.id_);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER,N_*sizeof(uint32_t),lod_index_.data(),GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,0);
+        lod_buf_.bytes_ = N_*sizeof(uint32_t);
+    }
+}
+
+void PointCloudVBO::update(const float* points,const float* normals,const uint8_t* colors,int color_dim,uint32_t N)
+{
+    init();
+    if( N != N_ )
+    {
+        lod_index_.clear();
+        lines_dirty_ = true;
+    }
+    N_ = N;
+    points_ = points;
+    normals_ = normals;
+    colors_ = colors;
+    color_dim_ = color_dim;
+    if( !use_buffers_ || 0 == N_ )return;
+    if(sync(points_buf_,GL_ARRAY_BUFFER,points_,3*sizeof(float)*N_))lines_dirty_ = true;
+    if( normals_ && sync(normals_buf_,GL_ARRAY_BUFFER,normals_,3*sizeof(float)*N_) )lines_dirty_ = true;
+    if( colors_ && 3 == color_dim_ )sync(rgb_buf_,GL_ARRAY_BUFFER,colors_,3*N_);
+    if( colors_ && 4 == color_dim_ )sync(rgba_buf_,GL_ARRAY_BUFFER,colors_,4*N_);
+}
+
+void PointCloudVBO::drawPoints(uint32_t n)
+{
+    if( 0 == N_ )return;
+    if( 0 == n || n > N_ )n = N_;
+    if( n < N_ && lod_index_.size() != N_ )buildLOD();
+    glEnableClientState(GL_VERTEX_ARRAY);
+    if(normals_)glEnableClientState(GL_NORMAL_ARRAY);
+    if(colors_)glEnableClientState(GL_COLOR_ARRAY);
+    if(use_buffers_)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER,points_buf_.id_);
+        glVertexPointer(3,GL_FLOAT,0,0);
+        if(normals_)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER,normals_buf_.id_);
+            glNormalPointer(GL_FLOAT,0,0);
+        }
+        if(colors_)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, 3 == color_dim_ ? rgb_buf_.id_ : rgba_buf_.id_ );
+            glColorPointer(color_dim_,GL_UNSIGNED_BYTE,0,0);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER,0);
+        if( n < N_ )
+        {
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,lod_buf_.id_);
+            glDrawElements(GL_POINTS,static_cast<GLsizei>(n),GL_UNSIGNED_INT,0);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,0);
+        }else glDrawArrays(GL_POINTS,0,static_cast<GLsizei>(n));
+    }else{
+        glVertexPointer(3,GL_FLOAT,0,points_);
+        if(normals_)glNormalPointer(GL_FLOAT,0,normals_);
+        if(colors_)glColorPointer(color_dim_,GL_UNSIGNED_BYTE,0,colors_);
+        if( n < N_ )::glDrawElements(GL_POINTS,static_cast<GLsizei>(n),GL_UNSIGNED_INT,lod_index_.data());
+        else ::glDrawArrays(GL_POINTS,0,static_cast<GLsizei>(n));
+    }
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+}
+
+void PointCloudVBO::drawNormals(const float* points,const float* normals,uint32_t N,float scale)
+{
+    init();
+    if( 0 == N || !points || !normals )return;
+    if(!use_buffers_)
+    {
+        glBegin(GL_LINES);
+        for(uint32_t i = 0 ; i < N ; ++i )
+        {
+            const float* p = points + 3*i;
+            const float* n = normals + 3*i;
+            glVertex3fv(p);
+            glVertex3f(p[0]+scale*n[0],p[1]+scale*n[1],p[2]+scale*n[2]);
+        }
+        glEnd();
+        return;
+    }
+    if( N != N_ )
+    {
+        lod_index_.clear();
+        lines_dirty_ = true;
+        N_ = N;
+        points_ = points;
+    }
+    if(sync(points_buf_,GL_ARRAY_BUFFER,points,3*sizeof(float)*N))lines_dirty_ = true;
+    if(sync(normals_buf_,GL_ARRAY_BUFFER,normals,3*sizeof(float)*N))lines_dirty_ = true;
+    if( 0 == lines_buf_.id_ )glGenBuffers(1,&lines_buf_.id_);
+    glBindBuffer(GL_ARRAY_BUFFER,lines_buf_.id_);
+    if( lines_dirty_ || scale != lines_scale_ )
+    {
+        std::vector<float> lines(6*size_t(N));
+        #pragma omp parallel for
+        for(int i = 0 ; i < int(N) ; ++i )
+        {
+            const float* p = points + 3*i;
+            const float* n = normals + 3*i;
+            float* l = lines.data() + 6*i;
+            l[0] = p[0];
+            l[1] = p[1];
+            l[2] = p[2];
+            l[3] = p[0] + scale*n[0];
+            l[4] = p[1] + scale*n[1];
+            l[5] = p[2] + scale*n[2];
+        }
+        glBufferData(GL_ARRAY_BUFFER,lines.size()*sizeof(float),lines.data(),GL_STATIC_DRAW);
+        lines_buf_.bytes_ = lines.size()*sizeof(float);
+        lines_dirty_ = false;
+        lines_scale_ = scale;
+    }
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3,GL_FLOAT,0,0);
+    glBindBuffer(GL_ARRAY_BUFFER,0);
+    glDrawArrays(GL_LINES,0,static_cast<GLsizei>(2*N));
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+void PointCloudVBO::release()
+{
+    if( init_ && use_buffers_ )
+    {
+        free(points_buf_);
+        free(normals_buf_);
+        free(rgb_buf_);
+        free(rgba_buf_);
+        free(lod_buf_);
+        free(lines_buf_);
+    }
+    lod_index_.clear();
+    N_ = 0;
+    points_ = 0;
+    normals_ = 0;
+    colors_ = 0;
+    lines_dirty_ = true;
+}
+
+PointCloudVBO& PointCloudVBOCache::get(const void* key)
+{
+    for(std::vector<std::pair<const void*,PointCloudVBO::Ptr>>::iterator iter=vbos_.begin();iter!=vbos_.end();++iter)
+    {
+        if( iter->first == key )return *iter->second;
+    }
+    vbos_.emplace_back(key,std::make_shared<PointCloudVBO>());
+    return *vbos_.back().second;
+}
+
+void PointCloudVBOCache::keep(const std::vector<const void*>& keys)
+{
+    for(std::vector<std::pair<const void*,PointCloudVBO::Ptr>>::iterator iter=vbos_.begin();iter!=vbos_.end();)
+    {
+        if( keys.end() == std::find(keys.begin(),keys.end(),iter->first) )
+        {
+            iter->second->release();
+            iter = vbos_.erase(iter);
+        }else ++iter;
+    }
+}
+
+void PointCloudVBOCache::release()
+{
+    for(std::vector<std::pair<const void*,PointCloudVBO::Ptr>>::iterator iter=vbos_.begin();iter!=vbos_.end();++iter)
+    {
+        iter->second->release();
+    }
+    vbos_.clear();
+}
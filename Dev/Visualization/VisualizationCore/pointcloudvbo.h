@@ -0,0 +1,68 @@
+#ifndef POINTCLOUDVBO_H
+#define POINTCLOUDVBO_H
+#include "visualizationcore_global.h"
+#include <QOpenGLFunctions>
+#include <memory>
+#include <vector>
+#include <cstdint>
+//retained vertex buffers for drawing a point cloud
+//the arrays are hashed in chunks on each update and only the chunks that changed are uploaded again
+//falls back to client side arrays when the context has no buffer objects
+class VISUALIZATIONCORESHARED_EXPORT PointCloudVBO:protected QOpenGLFunctions
+{
+public:
+    typedef std::shared_ptr<PointCloudVBO> Ptr;
+    PointCloudVBO();
+    //normals and colors may be 0, colors have color_dim ( 3 or 4 ) bytes per vertex
+    void update(const float* points,const float* normals,const uint8_t* colors,int color_dim,uint32_t N);
+    //draw at most n points of the last update ( 0 for all ), a fixed random subset is drawn when n < N
+    void drawPoints(uint32_t n=0);
+    //a line from each point along scale times its normal
+    void drawNormals(const float* points,const float* normals,uint32_t N,float scale);
+    //free the buffers, the context they were created in has to be current
+    void release();
+    uint32_t size()const{return N_;}
+protected:
+    struct Buffer
+    {
+        Buffer():id_(0),bytes_(0){}
+        GLuint id_;
+        size_t bytes_;
+        std::vector<uint64_t> hash_;
+    };
+    void init();
+    bool sync(Buffer&,GLenum target,const void* data,size_t bytes);
+    void free(Buffer&);
+    void buildLOD();
+private:
+    bool init_;
+    bool use_buffers_;
+    uint32_t N_;
+    const float* points_;
+    const float* normals_;
+    const uint8_t* colors_;
+    int color_dim_;
+    Buffer points_buf_;
+    Buffer normals_buf_;
+    Buffer rgb_buf_;
+    Buffer rgba_buf_;
+    Buffer lod_buf_;
+    Buffer lines_buf_;
+    std::vector<uint32_t> lod_index_;
+    bool lines_dirty_;
+    float lines_scale_;
+};
+
+//buffers of the meshes shown in a viewer, keyed by the address of the mesh bundle
+class VISUALIZATIONCORESHARED_EXPORT PointCloudVBOCache
+{
+public:
+    PointCloudVBO& get(const void* key);
+    //release the buffers of every key that is not listed
+    void keep(const std::vector<const void*>& keys);
+    void release();
+private:
+    std::vector<std::pair<const void*,PointCloudVBO::Ptr>> vbos_;
+};
+
+#endif // POINTCLOUDVBO_H
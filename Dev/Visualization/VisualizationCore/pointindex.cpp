@@ -0,0 +1,261 @@
+#include "pointindex.h"
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <limits>
+//points per leaf, a leaf is tested point by point
+static const uint32_t leaf_size_ = 32;
+//points compared by match() to tell whether the mesh has been changed in place
+static const uint32_t sample_num_ = 256;
+
+static inline bool same(const arma::fmat& a,const arma::fmat& b)
+{
+    if( a.n_rows != b.n_rows || a.n_cols != b.n_cols || a.is_empty() )return false;
+    return 0 == std::memcmp(a.memptr(),b.memptr(),a.n_elem*sizeof(float));
+}
+
+//the line o + t*d ( any t ) comes closer than r to the box only if it crosses the box grown by r
+static inline bool hit_line(const float* bmin,const float* bmax,const float* o,const float* d,float r)
+{
+    float tmin = -std::numeric_limits<float>::max();
+    float tmax = std::numeric_limits<float>::max();
+    for(int k = 0 ; k < 3 ; ++k )
+    {
+        const float lo = bmin[k] - r;
+        const float hi = bmax[k] + r;
+        if( std::abs(d[k]) < std::numeric_limits<float>::epsilon() )
+        {
+            if( o[k] < lo || o[k] > hi )return false;
+            continue;
+        }
+        float t1 = ( lo - o[k] ) / d[k];
+        float t2 = ( hi - o[k] ) / d[k];
+        if( t1 > t2 )std::swap(t1,t2);
+        tmin = std::max(tmin,t1);
+        tmax = std::min(tmax,t2);
+        if( tmin > tmax )return false;
+    }
+    return true;
+}
+
+PointIndex::PointIndex()
+{
+    ;
+}
+
+void PointIndex::build(const float* pts,arma::uword N)
+{
+    nodes_.clear();
+    last_apex_.reset();
+    last_rect_.reset();
+    last_selected_.reset();
+    perm_.resize(N);
+    for(arma::uword i = 0 ; i < N ; ++i )perm_[i] = i;
+    points_ = arma::fmat((float*)pts,3,N,true,false);
+    sample_index_.clear();
+    const arma::uword step = std::max<arma::uword>(1,N/sample_num_);
+    for(arma::uword i = 0 ; i < N ; i += step )sample_index_.push_back(i);
+    sample_ = arma::fmat(3,sample_index_.size());
+    for(size_t i = 0 ; i < sample_index_.size() ; ++i )sample_.col(i) = points_.col(sample_index_[i]);
+    if( 0 == N )return;
+    nodes_.reserve( 2*( N / leaf_size_ + 1 ) );
+    buildNode(0,N);
+    //store the points in leaf order
+    arma::fmat leaf_points(3,N);
+    #pragma omp parallel for
+    for(int i = 0 ; i < int(N) ; ++i )
+    {
+        const float* src = points_.colptr(perm_[i]);
+        float* dst = leaf_points.colptr(i);
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = src[2];
+    }
+    points_.swap(leaf_points);
+}
+
+uint32_t PointIndex::buildNode(uint32_t begin,uint32_t end)
+{
+    const uint32_t idx = nodes_.size();
+    nodes_.push_back(Node());
+    Node node;
+    node.begin_ = begin;
+    node.end_ = end;
+    node.left_ = 0;
+    node.right_ = 0;
+    for(int k = 0 ; k < 3 ; ++k )
+    {
+        node.min_[k] = std::numeric_limits<float>::max();
+        node.max_[k] = std::numeric_limits<float>::lowest();
+    }
+    for(uint32_t i = begin ; i < end ; ++i )
+    {
+        const float* p = points_.colptr(perm_[i]);
+        for(int k = 0 ; k < 3 ; ++k )
+        {
+            node.min_[k] = std::min(node.min_[k],p[k]);
+            node.max_[k] = std::max(node.max_[k],p[k]);
+        }
+    }
+    if( end - begin > leaf_size_ )
+    {
+        //median split on the longest side
+        int axis = 0;
+        for(int k = 1 ; k < 3 ; ++k )
+        {
+            if( node.max_[k] - node.min_[k] > node.max_[axis] - node.min_[axis] )axis = k;
+        }
+        const uint32_t mid = begin + ( end - begin ) / 2;
+        const arma::fmat& p = points_;
+        std::nth_element(
+                    perm_.begin()+begin,perm_.begin()+mid,perm_.begin()+end,
+                    [&p,axis](uint32_t a,uint32_t b){return p(axis,a) < p(axis,b);}
+                    );
+        node.left_ = buildNode(begin,mid);
+        node.right_ = buildNode(mid,end);
+    }
+    nodes_[idx] = node;
+    return idx;
+}
+
+bool PointIndex::match(const float* pts,arma::uword N)const
+{
+    if( N != perm_.size() || 0 == N )return false;
+    for(size_t i = 0 ; i < sample_index_.size() ; ++i )
+    {
+        if( 0 != std::memcmp(pts+3*sample_index_[i],sample_.colptr(i),3*sizeof(float)) )return false;
+    }
+    return true;
+}
+
+bool PointIndex::pickRay(const arma::fvec& from,const arma::fvec& toward,float dist,arma::uword& index)const
+{
+    if(nodes_.empty())return false;
+    arma::fvec dir = arma::normalise(toward - from);
+    const float* o = from.memptr();
+    const float* d = dir.memptr();
+    const float d2max = dist*dist;
+    float best = std::numeric_limits<float>::max();
+    uint32_t best_index = 0;
+    bool found = false;
+    std::vector<uint32_t> stack;
+    stack.push_back(0);
+    while(!stack.empty())
+    {
+        const Node& node = nodes_[stack.back()];
+        stack.pop_back();
+        if(!hit_line(node.min_,node.max_,o,d,dist))continue;
+        if( 0 != node.left_ )
+        {
+            stack.push_back(node.right_);
+            stack.push_back(node.left_);
+            continue;
+        }
+        for(uint32_t i = node.begin_ ; i < node.end_ ; ++i )
+        {
+            const float* p = points_.colptr(i);
+            const float qx = p[0] - o[0];
+            const float qy = p[1] - o[1];
+            const float qz = p[2] - o[2];
+            const float a = qx*qx + qy*qy + qz*qz;
+            const float b = qx*d[0] + qy*d[1] + qz*d[2];
+            if( a <= 0.0 || a - b*b >= d2max )continue;
+            //cosine between the line and the direction from the point back to "from"
+            const float v = - b / std::sqrt(a);
+            const uint32_t id = perm_[i];
+            if( v < best || ( v == best && id < best_index ) )
+            {
+                best = v;
+                best_index = id;
+                found = true;
+            }
+        }
+    }
+    if(found)index = best_index;
+    return found;
+}
+
+void PointIndex::selectPyramid(const arma::fvec& apex,const arma::fmat& rect,arma::uvec& indices)const
+{
+    indices.reset();
+    if( nodes_.empty() || apex.n_elem != 3 || rect.n_rows != 3 || rect.n_cols != 4 )return;
+    if( same(apex,last_apex_) && same(rect,last_rect_) )
+    {
+        indices = last_selected_;
+        return;
+    }
+    last_apex_ = apex;
+    last_rect_ = rect;
+    last_selected_.reset();
+    //side planes n*x >= c through the apex, oriented toward the center of the base
+    float n[4][3];
+    float c[4];
+    arma::fvec center = arma::mean(rect,1);
+    for(int k = 0 ; k < 4 ; ++k )
+    {
+        arma::fvec nk = arma::cross( rect.col(k) - apex , rect.col((k+1)%4) - apex );
+        if( arma::norm(nk) <= std::numeric_limits<float>::epsilon() )return;
+        if( arma::dot(nk,center - apex) < 0 )nk *= -1.0;
+        n[k][0] = nk(0);
+        n[k][1] = nk(1);
+        n[k][2] = nk(2);
+        c[k] = arma::dot(nk,apex);
+    }
+    std::vector<arma::uword> selected;
+    std::vector<uint32_t> stack;
+    stack.push_back(0);
+    while(!stack.empty())
+    {
+        const Node& node = nodes_[stack.back()];
+        stack.pop_back();
+        bool outside = false;
+        bool inside = true;
+        for(int k = 0 ; k < 4 ; ++k )
+        {
+            float mx = 0.0;
+            float mn = 0.0;
+            for(int j = 0 ; j < 3 ; ++j )
+            {
+                if( n[k][j] > 0 )
+                {
+                    mx += n[k][j]*node.max_[j];
+                    mn += n[k][j]*node.min_[j];
+                }else{
+                    mx += n[k][j]*node.min_[j];
+                    mn += n[k][j]*node.max_[j];
+                }
+            }
+            if( mx < c[k] )
+            {
+                outside = true;
+                break;
+            }
+            if( mn < c[k] )inside = false;
+        }
+        if(outside)continue;
+        if(inside)
+        {
+            selected.insert(selected.end(),perm_.begin()+node.begin_,perm_.begin()+node.end_);
+            continue;
+        }
+        if( 0 != node.left_ )
+        {
+            stack.push_back(node.right_);
+            stack.push_back(node.left_);
+            continue;
+        }
+        for(uint32_t i = node.begin_ ; i < node.end_ ; ++i )
+        {
+            const float* p = points_.colptr(i);
+            bool in = true;
+            for(int k = 0 ; k < 4 && in ; ++k )
+            {
+                in = ( n[k][0]*p[0] + n[k][1]*p[1] + n[k][2]*p[2] >= c[k] );
+            }
+            if(in)selected.push_back(perm_[i]);
+        }
+    }
+    std::sort(selected.begin(),selected.end());
+    last_selected_ = arma::uvec(selected);
+    indices = last_selected_;
+}
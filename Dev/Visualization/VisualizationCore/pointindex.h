@@ -0,0 +1,47 @@
+#ifndef POINTINDEX_H
+#define POINTINDEX_H
+#include "visualizationcore_global.h"
+#include <armadillo>
+#include <memory>
+#include <vector>
+#include <cstdint>
+//bounding volume hierarchy over the vertices of a displayed mesh
+//the points are copied once in leaf order so a query only touches the nodes it hits
+class VISUALIZATIONCORESHARED_EXPORT PointIndex
+{
+public:
+    typedef std::shared_ptr<PointIndex> Ptr;
+    PointIndex();
+    void build(const float* pts,arma::uword N);
+    //whether the index still describes these points ( checked on a fixed sample of them )
+    bool match(const float* pts,arma::uword N)const;
+    arma::uword size()const{return perm_.size();}
+    //among the points closer than dist to the line from->toward
+    //pick the one that makes the smallest angle with the line seen from "from"
+    bool pickRay(const arma::fvec& from,const arma::fvec& toward,float dist,arma::uword& index)const;
+    //points inside the pyramid with its apex at "apex" and the four columns of rect as its base
+    //the last result is reused while the camera and the rect stay the same
+    void selectPyramid(const arma::fvec& apex,const arma::fmat& rect,arma::uvec& indices)const;
+protected:
+    struct Node
+    {
+        float min_[3];
+        float max_[3];
+        uint32_t begin_;
+        uint32_t end_;
+        uint32_t left_;
+        uint32_t right_;
+    };
+    uint32_t buildNode(uint32_t begin,uint32_t end);
+private:
+    std::vector<Node> nodes_;
+    arma::fmat points_;
+    std::vector<uint32_t> perm_;
+    std::vector<uint32_t> sample_index_;
+    arma::fmat sample_;
+    mutable arma::fvec last_apex_;
+    mutable arma::fmat last_rect_;
+    mutable arma::uvec last_selected_;
+};
+
+#endif // POINTINDEX_H
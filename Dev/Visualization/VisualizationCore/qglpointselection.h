@@ -3,6 +3,7 @@
 #include <armadillo>
 #include <memory>
 #include <vector>
+#include "pointindex.h"
 class PointSelectionBase
 {
 public:
@@ -30,7 +31,14 @@ public:
     inline bool selectAt(size_t,Mesh&,arma::uvec&,double);
     template<typename Mesh>
     inline bool selectAt(PointSelections::iterator,Mesh&,arma::uvec&,double);
+    //spatial index of the mesh, rebuilt when the mesh is changed
+    template<typename Mesh>
+    inline const PointIndex& spatialIndex(Mesh&);
+    inline void invalidate(){indices_.clear();}
     void debugSelections();
+private:
+    //indices of the latest meshes that have been picked on
+    std::vector<std::pair<const void*,PointIndex::Ptr>> indices_;
 };
 
 class RayPointSelection:public PointSelectionBase
@@ -41,8 +49,7 @@ public:
         PointSelectionBase(PointSelectionBase::RayPoint),from_(from),toward_(toward)
     {
     }
-    template<typename Mesh>
-    inline void select(Mesh&,arma::uvec&,double);
+    inline void select(const PointIndex&,arma::uvec&,double);
     virtual void debugSelection();
 private:
     arma::fvec from_;
@@ -55,18 +62,22 @@ public:
     typedef std::shared_ptr<BoxPointsSelection> Ptr;
     BoxPointsSelection():
         PointSelectionBase(PointSelectionBase::BoxPoints),
-        rect_w_(3,4,arma::fill::zeros)
+        rect_w_(3,4,arma::fill::zeros),
+        finished_(false)
     {
         ;
     }
-    template<typename Mesh>
-    inline void select(Mesh&,arma::uvec&,double);
+    inline void select(const PointIndex&,arma::uvec&,double);
     virtual void debugSelection();
     inline void setNear(const arma::fvec& v){near_=v;}
     inline void setRect(const arma::fmat& rect){rect_w_=rect;}
+    //the rect is only applied once the mouse is released
+    inline void setFinished(){finished_=true;}
+    inline bool finished()const{return finished_;}
 private:
     arma::fvec near_;
     arma::fmat rect_w_;
+    bool finished_;
 };
 
 #include "qglpointselection.hpp"
@@ -29,15 +29,18 @@ inline bool PointSelections::selectAt(size_t index,Mesh&m,arma::uvec&indices,dou
         case PointSelectionBase::RayPoint:
             {
                 RayPointSelection::Ptr p = std::dynamic_pointer_cast<RayPointSelection>(ptr);
-                p->select<Mesh>(m,indices,radius);
+                p->select(spatialIndex<Mesh>(m),indices,radius);
             }
             break;
         case PointSelectionBase::BoxPoints:
             {
                 BoxPointsSelection::Ptr p = std::dynamic_pointer_cast<BoxPointsSelection>(ptr);
-                p->debugSelection();
-
-                return false;
+                if(!p->finished())
+                {
+                    p->debugSelection();
+                    return false;
+                }
+                p->select(spatialIndex<Mesh>(m),indices,radius);
             }
             break;
         default:
@@ -58,14 +61,18 @@ inline bool PointSelections::selectAt(PointSelections::iterator iter,Mesh&m,arma
         case PointSelectionBase::RayPoint:
             {
                 RayPointSelection::Ptr p = std::dynamic_pointer_cast<RayPointSelection>(ptr);
-                p->select<Mesh>(m,indices,radius);
+                p->select(spatialIndex<Mesh>(m),indices,radius);
             }
             break;
         case PointSelectionBase::BoxPoints:
             {
                 BoxPointsSelection::Ptr p = std::dynamic_pointer_cast<BoxPointsSelection>(ptr);
-                p->debugSelection();
-                return false;
+                if(!p->finished())
+                {
+                    p->debugSelection();
+                    return false;
+                }
+                p->select(spatialIndex<Mesh>(m),indices,radius);
             }
             break;
         default:
@@ -75,27 +82,37 @@ inline bool PointSelections::selectAt(PointSelections::iterator iter,Mesh&m,arma
     return true;
 }
 
-
 template<typename Mesh>
-void RayPointSelection::select(Mesh& m,arma::uvec& indices,double radius )
+inline const PointIndex& PointSelections::spatialIndex(Mesh& m)
+{
+    const void* key = &m;
+    const float* pts = (const float*)m.points();
+    const arma::uword N = m.n_vertices();
+    for(std::vector<std::pair<const void*,PointIndex::Ptr>>::iterator iter=indices_.begin();iter!=indices_.end();++iter)
+    {
+        if( iter->first != key )continue;
+        if(!iter->second->match(pts,N))iter->second->build(pts,N);
+        return *iter->second;
+    }
+    //only the few latest meshes keep their index
+    if( indices_.size() >= 4 )indices_.erase(indices_.begin());
+    indices_.emplace_back(key,std::make_shared<PointIndex>());
+    indices_.back().second->build(pts,N);
+    return *indices_.back().second;
+}
+
+void RayPointSelection::select(const PointIndex& index,arma::uvec& indices,double radius )
 {
     indices.reset();
-    arma::fmat p((float*)m.points(),3,m.n_vertices(),true,true);
-    arma::fvec dir = toward_ - from_;
-    dir = arma::normalise(dir);
-    p.each_col() -= from_;
-    arma::frowvec distsa = arma::sum(arma::square(p));
-    arma::frowvec distsb = arma::square( dir.t()*p );
-    arma::frowvec dists = arma::sqrt( distsa - distsb );
-    p*=-1.0;
-    p = arma::normalise(p);
-    arma::frowvec vars = dir.t()*p;
-    arma::uvec within = arma::find( dists < 0.05*radius );
-    if(within.is_empty())return;
-    arma::uword select;
-    vars(within).min(select);
+    arma::uword picked;
+    if(!index.pickRay(from_,toward_,0.05*radius,picked))return;
     indices = arma::uvec(1);
-    indices(0) = within(select);
+    indices(0) = picked;
+}
+
+void BoxPointsSelection::select(const PointIndex& index,arma::uvec& indices,double)
+{
+    index.selectPyramid(near_,rect_w_,indices);
 }
 
 #endif // QGLPOINTSELECTION_HPP